@@ -63,6 +63,9 @@
 #include "exit_dialog.h"
 #include "dialib.h"
 #include "dia-layer.h"
+#include "dia-trace.h"
+#include "dia-object-profile.h"
+#include "dia-memory-usage.h"
 #include "dia-version-info.h"
 
 static gboolean         handle_initial_diagram (const char *input_file_name,
@@ -82,6 +85,8 @@ static gboolean         handle_all_diagrams    (GSList     *files,
                                                 const char *output_dir);
 static void             print_credits          (void);
 static void             print_filters_list     (gboolean verbose);
+static void             print_memory_report    (GSList     *files,
+                                                const char *input_dir);
 
 static gboolean dia_is_interactive = FALSE;
 
@@ -303,6 +308,7 @@ do_convert (const char      *infname,
   DiaImportFilter *inf;
   DiagramData     *diagdata = NULL;
   DiaContext      *ctx;
+  gint64           span;
 
   inf = filter_guess_import_filter (infname);
   if (!inf) {
@@ -347,6 +353,7 @@ do_convert (const char      *infname,
    * too much for it. It _must not_ be changed after initialization and there
    * are quite some filter selecting their output format by it. --hb
    */
+  span = dia_trace_begin ();
   if (size) {
     g_warning ("--size parameter unsupported for %s filter",
                ef->unique_name ? ef->unique_name : "selected");
@@ -354,6 +361,8 @@ do_convert (const char      *infname,
   } else {
     ef->export_func (diagdata, ctx, outfname, infname, ef->user_data);
   }
+  dia_trace_end (span, DIA_TRACE_EXPORT,
+                 ef->unique_name ? ef->unique_name : "export", outfname);
   /* if (!quiet) */
   g_printerr (_("%s --> %s\n"), infname, outfname);
   g_clear_object (&diagdata);
@@ -564,6 +573,7 @@ app_init (int argc, char **argv)
   static gboolean version = FALSE;
   static gboolean verbose = FALSE;
   static gboolean log_to_stderr = FALSE;
+  static gboolean memory_report = FALSE;
   static char *export_file_name = NULL;
   static char *export_file_format = NULL;
   static char *size = NULL;
@@ -603,6 +613,8 @@ app_init (int argc, char **argv)
      N_("Generate verbose output"), NULL },
     {"version", 'v', 0, G_OPTION_ARG_NONE, &version,
      N_("Display version and exit"), NULL },
+    {"memory-report", 0, 0, G_OPTION_ARG_NONE, &memory_report,
+     N_("Print the memory used by the loaded files and exit"), NULL },
     { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, NULL /* &filenames */,
       NULL, NULL },
     { NULL }
@@ -616,8 +628,8 @@ app_init (int argc, char **argv)
   options[1].arg_data = &export_file_format;
   options[3].arg_data = &size;
   options[4].arg_data = &show_layers;
-  g_return_if_fail (g_strcmp0 (options[14].long_name, G_OPTION_REMAINING) == 0);
-  options[14].arg_data = (void*)&filenames;
+  g_return_if_fail (g_strcmp0 (options[15].long_name, G_OPTION_REMAINING) == 0);
+  options[15].arg_data = (void*)&filenames;
 
   argv0 = (argc > 0) ? argv[0] : "(none)";
 
@@ -693,7 +705,7 @@ app_init (int argc, char **argv)
       }
     }
     /* given some files to output (or something;)), we are not starting up the UI */
-    if (export_file_name || export_file_format || size || credits || version || list_filters) {
+    if (export_file_name || export_file_format || size || credits || version || list_filters || memory_report) {
       dia_is_interactive = FALSE;
     }
   }
@@ -831,6 +843,11 @@ app_init (int argc, char **argv)
     /*autosave_restore_documents();*/
   }
 
+  if (memory_report) {
+    print_memory_report (files, input_directory);
+    exit (0);
+  }
+
   dia_log_message ("diagrams");
   made_conversions = handle_all_diagrams (files,
                                           export_file_name,
@@ -1075,6 +1092,105 @@ create_user_dirs (void)
   g_clear_pointer (&dir, g_free);
 }
 
+/* the first use starts counting, every further one reports and restarts */
+static DiaObjectChange *
+_object_profile_callback (DiagramData *data,
+                          const char  *filename,
+                          guint        flags,
+                          void        *user_data)
+{
+  DDisplay *ddisp = ddisplay_active ();
+  char *report;
+
+  if (!dia_object_profile_enabled ()) {
+    dia_object_profile_set_enabled (TRUE);
+    message_notice (_("Object operations are counted from now on.\n"
+                      "Choose this again for the report."));
+    return NULL;
+  }
+
+  /* the toolbox menu doesn't pass the diagram */
+  report = dia_object_profile_report (ddisp ? ddisp->diagram->data : NULL);
+  message_notice ("%s", report);
+  dia_object_profile_reset ();
+  g_free (report);
+
+  return NULL;
+}
+
+static DiaCallbackFilter cb_object_profile = {
+  "ObjectProfile",
+  N_("Object _Profile"),
+  "/ToolboxMenu/Debug/ObjectProfile",
+  _object_profile_callback,
+  NULL
+};
+
+/* a new report each time, for comparing before and after */
+static DiaObjectChange *
+_memory_usage_callback (DiagramData *data,
+                        const char  *filename,
+                        guint        flags,
+                        void        *user_data)
+{
+  DDisplay *ddisp = ddisplay_active ();
+  DiaMemoryUsage *usage;
+  GtkWidget *dialog;
+  GtkWidget *scrolled;
+  GtkWidget *view;
+  char *report;
+  char *name;
+  char *title;
+
+  /* the toolbox menu doesn't pass the diagram */
+  if (!ddisp) {
+    message_notice (_("There is no diagram to measure."));
+    return NULL;
+  }
+
+  usage = dia_memory_usage_new (ddisp->diagram->data);
+  usage->undo = undo_get_memory_size (ddisp->diagram->undo, usage->shared);
+  report = dia_memory_usage_to_string (usage);
+  dia_memory_usage_free (usage);
+
+  name = diagram_get_name (ddisp->diagram);
+  title = g_strdup_printf (_("Memory Usage of %s"), name);
+  dialog = gtk_dialog_new_with_buttons (title,
+                                        GTK_WINDOW (gtk_widget_get_toplevel (ddisp->shell)),
+                                        0,
+                                        _("_Close"), GTK_RESPONSE_CLOSE,
+                                        NULL);
+  gtk_window_set_default_size (GTK_WINDOW (dialog), 640, 480);
+  g_signal_connect (dialog, "response",
+                    G_CALLBACK (gtk_widget_destroy), NULL);
+
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_vexpand (scrolled, TRUE);
+  view = gtk_text_view_new ();
+  gtk_text_view_set_editable (GTK_TEXT_VIEW (view), FALSE);
+  gtk_text_view_set_monospace (GTK_TEXT_VIEW (view), TRUE);
+  gtk_text_buffer_set_text (gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)),
+                            report, -1);
+  gtk_container_add (GTK_CONTAINER (scrolled), view);
+  gtk_container_add (GTK_CONTAINER (gtk_dialog_get_content_area (GTK_DIALOG (dialog))),
+                     scrolled);
+  gtk_widget_show_all (dialog);
+
+  g_free (title);
+  g_free (name);
+  g_free (report);
+
+  return NULL;
+}
+
+static DiaCallbackFilter cb_memory_usage = {
+  "MemoryUsage",
+  N_("_Memory Usage"),
+  "/ToolboxMenu/Debug/MemoryUsage",
+  _memory_usage_callback,
+  NULL
+};
+
 static PluginInitResult
 internal_plugin_init (PluginInfo *info)
 {
@@ -1096,6 +1212,10 @@ internal_plugin_init (PluginInfo *info)
   /* Standard Dia format */
   filter_register_export (&dia_export_filter);
 
+  /* development tools */
+  filter_register_callback (&cb_object_profile);
+  filter_register_callback (&cb_memory_usage);
+
   return DIA_PLUGIN_INIT_OK;
 }
 
@@ -1127,6 +1247,35 @@ handle_all_diagrams (GSList     *files,
   return made_conversions;
 }
 
+/* --memory-report option, for sizing machines processing diagrams */
+static void
+print_memory_report (GSList *files, const char *input_dir)
+{
+  GSList *node;
+
+  for (node = files; node; node = node->next) {
+    char *inpath = input_dir ? g_build_filename (input_dir, node->data, NULL) : node->data;
+    Diagram *diagram = diagram_load (inpath, NULL);
+
+    if (diagram) {
+      DiaMemoryUsage *usage = dia_memory_usage_new (DIA_DIAGRAM_DATA (diagram));
+      char *report;
+
+      usage->undo = undo_get_memory_size (diagram->undo, usage->shared);
+      report = dia_memory_usage_to_string (usage);
+      g_print ("%s\n%s\n", inpath, report);
+
+      g_free (report);
+      dia_memory_usage_free (usage);
+      g_clear_object (&diagram);
+    }
+
+    if (inpath != node->data) {
+      g_clear_pointer (&inpath, g_free);
+    }
+  }
+}
+
 /* --credits option. Added by Andrew Ferrier.
 
    Hopefully we're not ignoring anything too crucial by
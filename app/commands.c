@@ -98,6 +98,7 @@ ShellExecuteA (long        hwnd,
 #include "object.h"
 #include "dia-guide-dialog.h"
 #include "dia-version-info.h"
+#include "dia-trace.h"
 
 
 void
@@ -211,7 +212,7 @@ insert_text (DDisplay *ddisp, Focus *focus, const gchar *text)
     {
       /* Make sure object updates its data: */
       Point p = obj->position;
-      (obj->ops->move) (obj, &p);
+      dia_object_move (obj, &p);
     }
 
     /* Perhaps this can be improved */
@@ -510,17 +511,22 @@ _clipboard_get_data_callback (GtkClipboard     *clipboard,
   g_clear_pointer (&tmplate, g_free);
 
   if (ef) {
+    gint64 span;
+
     /* for png use alpha-rendering if available */
     if (strcmp (ext, "png") == 0 &&
         filter_export_get_by_name ("cairo-alpha-png") != NULL) {
       ef = filter_export_get_by_name ("cairo-alpha-png");
     }
     dia_context_set_filename (ctx, outfname);
+    span = dia_trace_begin ();
     ef->export_func (DIA_DIAGRAM_DATA (dia),
                      ctx,
                      outfname,
                      "clipboard-copy",
                      ef->user_data);
+    dia_trace_end (span, DIA_TRACE_EXPORT,
+                   ef->unique_name ? ef->unique_name : "export", outfname);
     /* If we have a vector format, don't convert it to pixbuf.
      * Or even better: only use pixbuf transport when asked
      * for 'OS native bitmaps' BMP (win32), TIFF(osx), ...?
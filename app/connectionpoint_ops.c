@@ -26,6 +26,7 @@
 #include "object.h"
 #include "connectionpoint.h"
 #include "diainteractiverenderer.h"
+#include "dia-trace.h"
 
 #define CONNECTIONPOINT_SIZE 7
 #define CHANGED_TRESHOLD 0.001
@@ -128,16 +129,8 @@ diagram_update_connections_selection(Diagram *dia)
   }
 }
 
-/* Updates all objects connected to the 'obj' object.
-   Calls this function recursively for objects modified.
-
-   If update_nonmoved is TRUE, also objects that have not
-   moved since last time is updated. This is not propagated
-   in the recursion.
- */
-void
-diagram_update_connections_object(Diagram *dia, DiaObject *obj,
-				  int update_nonmoved)
+static void
+_update_connections_object (Diagram *dia, DiaObject *obj, int update_nonmoved)
 {
   int i,j;
   GList *list;
@@ -155,8 +148,8 @@ diagram_update_connections_object(Diagram *dia, DiaObject *obj,
 	  if (connected_obj->handles[j]->connected_to == cp) {
 	    Handle *handle = connected_obj->handles[j];
 	    if (distance_point_point_manhattan(&cp->pos, &handle->pos) > CHANGED_TRESHOLD) {
-	      connected_obj->ops->move_handle(connected_obj, handle, &cp->pos,
-					      cp, HANDLE_MOVE_CONNECTED,0);
+	      dia_object_move_handle (connected_obj, handle, &cp->pos,
+				      cp, HANDLE_MOVE_CONNECTED, 0);
 	      any_move = TRUE;
 	    }
 	  }
@@ -164,7 +157,7 @@ diagram_update_connections_object(Diagram *dia, DiaObject *obj,
 	if (update_nonmoved || any_move) {
 	  object_add_updates(connected_obj, dia);
 
-	  diagram_update_connections_object(dia, connected_obj, FALSE);
+	  _update_connections_object (dia, connected_obj, FALSE);
 	}
 	list = g_list_next(list);
       }
@@ -174,11 +167,28 @@ diagram_update_connections_object(Diagram *dia, DiaObject *obj,
     GList *child;
     for (child = obj->children; child != NULL; child = child->next) {
       DiaObject *child_obj = (DiaObject *)child->data;
-      diagram_update_connections_object(dia, child_obj, update_nonmoved);
+      _update_connections_object (dia, child_obj, update_nonmoved);
     }
   }
 }
 
+/* Updates all objects connected to the 'obj' object.
+   Calls this function recursively for objects modified.
+
+   If update_nonmoved is TRUE, also objects that have not
+   moved since last time is updated. This is not propagated
+   in the recursion.
+ */
+void
+diagram_update_connections_object(Diagram *dia, DiaObject *obj,
+				  int update_nonmoved)
+{
+  gint64 span = dia_trace_begin ();
+
+  _update_connections_object (dia, obj, update_nonmoved);
+  dia_trace_end (span, DIA_TRACE_EDIT, "update_connections", obj->type->name);
+}
+
 void
 ddisplay_connect_selected(DDisplay *ddisp)
 {
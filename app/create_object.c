@@ -85,7 +85,7 @@ create_object_button_press(CreateObjectTool *tool, GdkEventButton *event,
     connectionpoint =
       object_find_connectpoint_display(ddisp, &origpoint, obj, TRUE);
     if (connectionpoint != NULL) {
-      (obj->ops->move)(obj, &origpoint);
+      dia_object_move (obj, &origpoint);
     }
   }
 
@@ -148,8 +148,8 @@ create_object_button_release(CreateObjectTool *tool, GdkEventButton *event,
     gdk_device_ungrab (gdk_event_get_device ((GdkEvent*)event), event->time);
 
     object_add_updates(tool->obj, ddisp->diagram);
-    tool->obj->ops->move_handle(tool->obj, tool->handle, &tool->last_to,
-				NULL, HANDLE_MOVE_CREATE_FINAL, 0);
+    dia_object_move_handle (tool->obj, tool->handle, &tool->last_to,
+                            NULL, HANDLE_MOVE_CREATE_FINAL, 0);
     object_add_updates(tool->obj, ddisp->diagram);
 
   }
@@ -253,8 +253,8 @@ create_object_motion(CreateObjectTool *tool, GdkEventMotion *event,
   }
 
   object_add_updates(tool->obj, ddisp->diagram);
-  tool->obj->ops->move_handle(tool->obj, tool->handle, &to, connectionpoint,
-			      HANDLE_MOVE_CREATE, 0);
+  dia_object_move_handle (tool->obj, tool->handle, &to, connectionpoint,
+                          HANDLE_MOVE_CREATE, 0);
   object_add_updates(tool->obj, ddisp->diagram);
 
   /* Put current mouse position in status bar */
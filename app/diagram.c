@@ -212,6 +212,20 @@ _object_add (Diagram   *dia,
 }
 
 
+static void
+_objects_added (Diagram   *dia,
+                DiaLayer  *layer,
+                GList     *objects,
+                gpointer   user_data)
+{
+  GList *list;
+
+  for (list = objects; list != NULL; list = g_list_next (list)) {
+    object_add_updates (list->data, dia);
+  }
+}
+
+
 static void
 _object_remove (Diagram   *dia,
                 DiaLayer  *layer,
@@ -224,6 +238,18 @@ _object_remove (Diagram   *dia,
 }
 
 
+static void
+_object_changed (Diagram   *dia,
+                 DiaLayer  *layer,
+                 DiaObject *obj,
+                 gpointer   user_data)
+{
+  /* not part of an operation somebody else flushes */
+  object_add_updates (obj, dia);
+  diagram_flush (dia);
+}
+
+
 static void
 dia_diagram_init (Diagram *self)
 {
@@ -264,6 +290,8 @@ dia_diagram_init (Diagram *self)
 
   g_signal_connect (G_OBJECT (self), "object_add", G_CALLBACK (_object_add), self);
   g_signal_connect (G_OBJECT (self), "object_remove", G_CALLBACK (_object_remove), self);
+  g_signal_connect (G_OBJECT (self), "objects-added", G_CALLBACK (_objects_added), self);
+  g_signal_connect (G_OBJECT (self), "object-changed", G_CALLBACK (_object_changed), self);
 }
 
 
@@ -52,7 +52,8 @@ typedef struct _DiagramTreeModelClass
 typedef struct _DiagramTreeModel
 {
   GObject parent;
-  /* no need to store anything */
+  /* the rows are not stored, only the object names for sorting */
+  GHashTable *names;
 } DiagramTreeModel;
 
 static GType _dtm_get_type (void);
@@ -243,9 +244,7 @@ _dtm_iter_next (GtkTreeModel *tree_model,
   if (NODE_OBJECT(iter)) {
     if (!NODE_LAYER(iter))
       return FALSE;
-    i = dia_layer_object_get_index (NODE_LAYER(iter), NODE_OBJECT(iter));
-    ++i;
-    NODE_OBJECT(iter) = dia_layer_object_get_nth (NODE_LAYER (iter), i);
+    NODE_OBJECT(iter) = dia_layer_object_get_next (NODE_LAYER (iter), NODE_OBJECT (iter));
     return NODE_OBJECT(iter) != NULL;
   } else if (NODE_LAYER(iter)) {
     if (!NODE_DIAGRAM(iter))
@@ -396,12 +395,21 @@ _dtm_iface_init (GtkTreeModelIface *iface)
  * No matter if we are wrapped in the SortModel change signals are always
  * sent to this model. In the sortable case the GtkTreeModelSort translates
  * them to the right coordinates for the tree view.
+ *
+ * For a new diagram only the layers are announced, the objects are asked
+ * for when a layer gets expanded. A diagram with 100k objects would
+ * otherwise be 100k row-inserted signals.
  */
 static gboolean
 _recurse_row_inserted (GtkTreeModel *model, GtkTreeIter *parent)
 {
   GtkTreeIter iter;
   int n = 0;
+
+  if (parent && NODE_LAYER (parent)) {
+    return dia_layer_object_count (NODE_LAYER (parent)) > 0;
+  }
+
   while (_dtm_iter_nth_child (model, &iter, parent, n)) {
     GtkTreePath *path = _dtm_get_path (model, &iter);
     gtk_tree_model_row_inserted (model, path, &iter);
@@ -465,6 +473,8 @@ _object_remove (DiagramData      *dia,
   NODE_LAYER(iter)   = layer;
   NODE_OBJECT(iter)  = obj;
 
+  g_hash_table_remove (dtm->names, obj);
+
   path = _dtm_get_path (GTK_TREE_MODEL (dtm), iter);
   gtk_tree_model_row_deleted (GTK_TREE_MODEL (dtm), path);
   gtk_tree_path_free (path);
@@ -476,6 +486,41 @@ _object_remove (DiagramData      *dia,
     gtk_tree_path_free (path);
   }
 }
+static void
+_objects_added (DiagramData      *dia,
+                DiaLayer         *layer,
+                GList            *objects,
+                DiagramTreeModel *dtm)
+{
+  GList *sorted;
+  GList *list;
+
+  /* without rows before nobody can have expanded the layer, it's enough
+   * to tell that it has some now */
+  if (dia_layer_object_count (layer) == g_list_length (objects)) {
+    GtkTreeIter _iter;
+    GtkTreeIter *iter = &_iter;
+    GtkTreePath *path;
+
+    NODE_DIAGRAM(iter) = dia;
+    NODE_LAYER(iter)   = layer;
+    NODE_OBJECT(iter)  = NULL;
+
+    path = _dtm_get_path (GTK_TREE_MODEL (dtm), iter);
+    if (path) {
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (dtm), path, iter);
+      gtk_tree_path_free (path);
+    }
+    return;
+  }
+
+  /* the rows must appear top to bottom */
+  sorted = dia_layer_sort_objects (layer, objects);
+  for (list = sorted; list != NULL; list = g_list_next (list)) {
+    _object_add (dia, layer, list->data, dtm);
+  }
+  g_list_free (sorted);
+}
 /* start listening for diagram specific object changes */
 static void
 _dtm_listen_on_diagram (DiagramTreeModel *dtm,
@@ -483,6 +528,7 @@ _dtm_listen_on_diagram (DiagramTreeModel *dtm,
 {
   g_signal_connect (G_OBJECT(dia), "object_add", G_CALLBACK(_object_add), dtm);
   g_signal_connect (G_OBJECT(dia), "object_remove", G_CALLBACK(_object_remove), dtm);
+  g_signal_connect (G_OBJECT(dia), "objects-added", G_CALLBACK(_objects_added), dtm);
 }
 /* listen to diagram creation */
 static void
@@ -524,9 +570,13 @@ _diagram_change (DiaApplication   *app,
     /* nothing special */;
   if (flags & DIAGRAM_CHANGE_LAYER)
     NODE_LAYER(iter) = object;
-  if (flags & DIAGRAM_CHANGE_OBJECT) {
+  if ((flags & DIAGRAM_CHANGE_OBJECT) && object) {
     NODE_OBJECT(iter) = object;
     NODE_LAYER(iter) = dia_object_get_parent_layer (object);
+    g_hash_table_remove (dtm->names, object);
+  } else if (flags & DIAGRAM_CHANGE_OBJECT) {
+    /* some objects changed, we don't know which */
+    g_hash_table_remove_all (dtm->names);
   }
 
   path = _dtm_get_path (GTK_TREE_MODEL (dtm), iter);
@@ -553,11 +603,17 @@ _diagram_remove (DiaApplication   *app,
   /* stop listening on this diagram */
   g_signal_handlers_disconnect_by_func (dia, _object_add, dtm);
   g_signal_handlers_disconnect_by_func (dia, _object_remove, dtm);
+  g_signal_handlers_disconnect_by_func (dia, _objects_added, dtm);
+
+  /* its objects go without object_remove, the addresses get reused */
+  g_hash_table_remove_all (dtm->names);
 }
 
 static void
 _dtm_init (DiagramTreeModel *dtm)
 {
+  dtm->names = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
   /* connect to interesting state changes */
   g_signal_connect (G_OBJECT (dia_application_get_default ()),
                     "diagram_add", G_CALLBACK (_diagram_add), dtm);
@@ -585,6 +641,8 @@ _dtm_finalize (GObject *object)
   g_signal_handlers_disconnect_by_func (G_OBJECT (dia_application_get_default ()), _diagram_change, dtm);
   g_signal_handlers_disconnect_by_func (G_OBJECT (dia_application_get_default ()), _diagram_remove, dtm);
 
+  g_clear_pointer (&dtm->names, g_hash_table_destroy);
+
   G_OBJECT_CLASS(_dtm_parent_class)->finalize (object);
 }
 
@@ -605,7 +663,7 @@ cmp_diagram (GtkTreeIter *a,
   }
 
   na = diagram_get_name (DIA_DIAGRAM (pa));
-  nb = diagram_get_name (DIA_DIAGRAM (pa));
+  nb = diagram_get_name (DIA_DIAGRAM (pb));
 
   if (!na || !nb) {
     return (na > nb) ? -1 : 1;
@@ -639,14 +697,34 @@ cmp_layer (GtkTreeIter  *a,
 }
 
 
+/* sorting compares every name several times, so they are kept */
+static const char *
+_dtm_get_object_name (DiagramTreeModel *dtm,
+                      DiaObject        *obj)
+{
+  char *name = g_hash_table_lookup (dtm->names, obj);
+
+  if (!name) {
+    name = object_get_displayname (obj);
+    if (!name) {
+      return NULL;
+    }
+    g_hash_table_insert (dtm->names, obj, name);
+  }
+
+  return name;
+}
+
+
 static int
 name_sort_func (GtkTreeModel *model,
                 GtkTreeIter  *a,
                 GtkTreeIter  *b,
                 gpointer      user_data)
 {
+  DiagramTreeModel *dtm = user_data;
   DiaObject *pa = NODE_OBJECT (a), *pb = NODE_OBJECT (b);
-  char *na, *nb;
+  const char *na, *nb;
   int ret = cmp_diagram (a, b);
 
   if (ret) {
@@ -665,19 +743,14 @@ name_sort_func (GtkTreeModel *model,
     return (pa > pb) ? -1 : 1;
   }
 
-  na = object_get_displayname (pa);
-  nb = object_get_displayname (pb);
+  na = _dtm_get_object_name (dtm, pa);
+  nb = _dtm_get_object_name (dtm, pb);
 
   if (!na || !nb) {
     return (na > nb) ? -1 : 1;
   }
 
-  ret = strcmp (na, nb);
-
-  g_clear_pointer (&na, g_free);
-  g_clear_pointer (&nb, g_free);
-
-  return ret;
+  return strcmp (na, nb);
 }
 
 
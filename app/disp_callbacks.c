@@ -576,7 +576,7 @@ handle_key_event (DDisplay   *ddisp,
 
   /* Make sure object updates its data and its connected: */
   p = obj->position;
-  (obj->ops->move)(obj,&p);
+  dia_object_move (obj, &p);
   diagram_update_connections_object(ddisp->diagram,obj,TRUE);
 
   object_add_updates(obj, ddisp->diagram);
@@ -1093,6 +1093,9 @@ ddisplay_canvas_events (GtkWidget *canvas,
               set_zoom_out (active_tool);
             break;
           case GDK_KEY_Escape:
+            if (active_tool->abort_func) {
+              (*active_tool->abort_func) (active_tool, event, ddisp);
+            }
             view_unfullscreen ();
             break;
           case GDK_KEY_F2:
@@ -1137,6 +1140,12 @@ ddisplay_canvas_events (GtkWidget *canvas,
       }
       break;
 
+    case GDK_GRAB_BROKEN:
+      if (active_tool->abort_func) {
+        (*active_tool->abort_func) (active_tool, event, ddisp);
+      }
+      break;
+
     case GDK_NOTHING:
     case GDK_DELETE:
     case GDK_DESTROY:
@@ -1164,7 +1173,6 @@ ddisplay_canvas_events (GtkWidget *canvas,
     case GDK_WINDOW_STATE:
     case GDK_SETTING:
     case GDK_OWNER_CHANGE:
-    case GDK_GRAB_BROKEN:
     case GDK_DAMAGE:
     case GDK_EVENT_LAST:
     case GDK_TOUCH_BEGIN:
@@ -1324,7 +1332,7 @@ ddisplay_drop_object (DDisplay      *ddisp,
     if (hadjust || vadjust) {
       new_pos.x = droppoint.x + hadjust;
       new_pos.y = droppoint.y + vadjust;
-      obj->ops->move(obj, &new_pos);
+      dia_object_move (obj, &new_pos);
     }
   }
 
@@ -48,6 +48,7 @@
 #include "filedlg.h"
 #include "dia-layer.h"
 #include "exit_dialog.h"
+#include "dia-trace.h"
 
 
 static GdkCursor *current_cursor = NULL;
@@ -493,6 +494,70 @@ ddisplay_flush(DDisplay *ddisp)
   gtk_widget_queue_draw (ddisp->canvas);
 }
 
+/**
+ * ddisplay_set_preview:
+ * @ddisp: the #DDisplay
+ * @objects: (element-type DiaObject) (nullable): the objects being dragged
+ *
+ * Take @objects out of the regular rendering and show a snapshot of them
+ * instead, which ddisplay_move_preview() can move around without touching
+ * the diagram. Call again after scrolling to refresh the snapshot, or with
+ * %NULL to show the objects where they really are.
+ *
+ * Returns: %FALSE if the renderer doesn't support previews
+ */
+gboolean
+ddisplay_set_preview (DDisplay *ddisp, GList *objects)
+{
+  GList *list;
+
+  if (ddisp->preview_objects) {
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init (&iter, ddisp->preview_objects);
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+      ddisplay_add_update (ddisp, &DIA_OBJECT (key)->bounding_box);
+    }
+    g_clear_pointer (&ddisp->preview_objects, g_hash_table_destroy);
+  }
+
+  if (!dia_interactive_renderer_set_preview (DIA_INTERACTIVE_RENDERER (ddisp->renderer),
+                                             objects)) {
+    return FALSE;
+  }
+
+  if (objects) {
+    ddisp->preview_objects = g_hash_table_new (NULL, NULL);
+  }
+  for (list = objects; list != NULL; list = g_list_next (list)) {
+    DiaObject *obj = DIA_OBJECT (list->data);
+
+    g_hash_table_add (ddisp->preview_objects, obj);
+    ddisplay_add_update (ddisp, &obj->bounding_box);
+  }
+
+  ddisplay_flush (ddisp);
+
+  return TRUE;
+}
+
+/**
+ * ddisplay_move_preview:
+ * @ddisp: the #DDisplay
+ * @delta: offset from where the objects are, in diagram coordinates
+ *
+ * Only repaints the display, nothing is rendered again.
+ */
+void
+ddisplay_move_preview (DDisplay *ddisp, const Point *delta)
+{
+  dia_interactive_renderer_move_preview (DIA_INTERACTIVE_RENDERER (ddisp->renderer),
+                                         ddisplay_transform_length (ddisp, delta->x),
+                                         ddisplay_transform_length (ddisp, delta->y));
+  ddisplay_flush (ddisp);
+}
+
 static void
 ddisplay_obj_render (DiaObject   *obj,
                      DiaRenderer *renderer,
@@ -500,7 +565,14 @@ ddisplay_obj_render (DiaObject   *obj,
                      gpointer     data)
 {
   DDisplay *ddisp = (DDisplay *) data;
-  DiaHighlightType hltype = data_object_get_highlight (DIA_DIAGRAM_DATA (ddisp->diagram), obj);
+  DiaHighlightType hltype;
+
+  /* it's in the preview overlay */
+  if (ddisp->preview_objects && g_hash_table_contains (ddisp->preview_objects, obj)) {
+    return;
+  }
+
+  hltype = data_object_get_highlight (DIA_DIAGRAM_DATA (ddisp->diagram), obj);
 
   if (hltype != DIA_HIGHLIGHT_NONE) {
     dia_interactive_renderer_draw_object_highlighted (DIA_INTERACTIVE_RENDERER (renderer),
@@ -524,9 +596,7 @@ ddisplay_render_pixmap (DDisplay     *ddisp,
   GList *list;
   DiaObject *obj;
   int i;
-#ifdef TRACES
-  GTimer *timer;
-#endif
+  gint64 span;
 
   if (ddisp->renderer==NULL) {
     g_critical ("ERROR! Renderer was NULL!!");
@@ -560,22 +630,27 @@ ddisplay_render_pixmap (DDisplay     *ddisp,
   pagebreak_draw (ddisp, update);
   guidelines_draw (ddisp, update);
 
-#ifdef TRACES
-  timer = g_timer_new();
-#endif
+  span = dia_trace_begin ();
   data_render (ddisp->diagram->data,
                ddisp->renderer, update,
                ddisplay_obj_render,
                (gpointer) ddisp);
-#ifdef TRACES
-  g_printerr ("data_render(%g%%) took %g seconds\n", ddisp->zoom_factor * 5.0, g_timer_elapsed (timer, NULL));
-  g_timer_destroy (timer);
-#endif
+  if (span) {
+    char *zoom = g_strdup_printf ("%g%%", ddisp->zoom_factor * 5.0);
+
+    dia_trace_end (span, DIA_TRACE_RENDER, "ddisplay_render_pixmap", zoom);
+    g_clear_pointer (&zoom, g_free);
+  }
   /* Draw handles for all selected objects */
   list = ddisp->diagram->data->selected;
   while (list!=NULL) {
     obj = (DiaObject *) list->data;
 
+    if (ddisp->preview_objects && g_hash_table_contains (ddisp->preview_objects, obj)) {
+      list = g_list_next (list);
+      continue;
+    }
+
     for (i=0;i<obj->num_handles;i++) {
       handle_draw(obj->handles[i], ddisp);
     }
@@ -1327,7 +1402,10 @@ ddisplay_do_update_menu_sensitivity (DDisplay *ddisp)
     Diagram *dia;
 
     if (ddisp == NULL) {
-      gtk_action_group_set_sensitive (menus_get_display_actions (), FALSE);
+      /* no menus without the user interface, e.g. in scripts or dia-bench */
+      if (menus_get_display_actions ()) {
+        gtk_action_group_set_sensitive (menus_get_display_actions (), FALSE);
+      }
       return;
     }
     gtk_action_group_set_sensitive (menus_get_display_actions (), TRUE);
@@ -1350,6 +1428,7 @@ ddisplay_really_destroy (DDisplay *ddisp)
   }
 
   g_clear_object (&ddisp->renderer);
+  g_clear_pointer (&ddisp->preview_objects, g_hash_table_destroy);
 
   /* Free update_areas list: */
   ddisplay_free_update_areas(ddisp);
@@ -119,6 +119,9 @@ struct _DDisplay {
   gboolean is_dragging_new_guideline;
   gdouble dragged_new_guideline_position;
   GtkOrientation dragged_new_guideline_orientation;
+
+  /* Objects only shown in the renderer's drag preview overlay */
+  GHashTable *preview_objects;
 };
 
 extern GdkCursor *default_cursor;
@@ -153,6 +156,8 @@ void ddisplay_add_update_with_border(DDisplay *ddisp, const DiaRectangle *rect,
 				     int pixel_border);
 void ddisplay_add_update(DDisplay *ddisp, const DiaRectangle *rect);
 void ddisplay_flush(DDisplay *ddisp);
+gboolean ddisplay_set_preview (DDisplay *ddisp, GList *objects);
+void ddisplay_move_preview (DDisplay *ddisp, const Point *delta);
 void ddisplay_update_scrollbars(DDisplay *ddisp);
 void     ddisplay_set_origo               (DDisplay *ddisp,
                                            double    x,
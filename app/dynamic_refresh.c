@@ -57,7 +57,7 @@ static void foreach_dynobj(DiaObject* obj, gpointer data) {
 
         if (dia->data == obj_ddata) {
             if (!moved) {
-                obj->ops->move(obj,&obj->position);
+                dia_object_move (obj, &obj->position);
                 moved = TRUE;
             }
             object_add_updates(obj,dia);
@@ -37,6 +37,7 @@
 #include "recent_files.h"
 #include "confirm.h"
 #include "diacontext.h"
+#include "dia-trace.h"
 
 #include "filedlg.h"
 
@@ -764,6 +765,7 @@ file_export_response_callback (GtkWidget *fs,
     }
     if (ef) {
       DiaContext *ctx = dia_context_new (_("Export"));
+      gint64 span = dia_trace_begin ();
 
       g_object_ref (dia->data);
       dia_context_set_filename (ctx, filename);
@@ -772,6 +774,8 @@ file_export_response_callback (GtkWidget *fs,
                        filename,
                        dia->filename,
                        ef->user_data);
+      dia_trace_end (span, DIA_TRACE_EXPORT,
+                     ef->unique_name ? ef->unique_name : "export", filename);
       g_object_unref (dia->data);
       dia_context_release (ctx);
     } else {
@@ -52,6 +52,8 @@
 #include "autosave.h"
 #include "display.h"
 #include "dia-layer.h"
+#include "text.h"
+#include "dia-trace.h"
 
 #ifdef G_OS_WIN32
 #include <io.h>
@@ -171,7 +173,10 @@ read_objects (xmlNodePtr objects,
           g_hash_table_insert (unknown_objects_hash, g_strdup (typestr), 0);
         }
       } else {
+        gint64 span = dia_trace_begin ();
+
         obj = type->ops->load (obj_node, version, ctx);
+        dia_trace_end (span, DIA_TRACE_LOAD, type->name, NULL);
         list = g_list_append (list, obj);
 
         if (parent) {
@@ -319,12 +324,12 @@ read_connections(GList *objects, xmlNodePtr layer_node,
          */
         if (!broken && obj && obj->ops->set_props && wants_update) {
 	  /* called for it's side-effect of update_data */
-	  obj->ops->move(obj,&obj->position);
+	  dia_object_move (obj, &obj->position);
 
 	  for (handle = 0; handle < obj->num_handles; ++handle) {
 	    if (obj->handles[handle]->connected_to)
-	      obj->ops->move_handle(obj, obj->handles[handle], &obj->handles[handle]->pos,
-				    obj->handles[handle]->connected_to, HANDLE_MOVE_CONNECTED,0);
+	      dia_object_move_handle (obj, obj->handles[handle], &obj->handles[handle]->pos,
+				      obj->handles[handle]->connected_to, HANDLE_MOVE_CONNECTED, 0);
 	  }
 	}
       }
@@ -388,10 +393,10 @@ _get_bool_prop (xmlNodePtr node, const char *name, gboolean preset)
 
 
 static gboolean
-diagram_data_load (const char  *filename,
-                   DiagramData *data,
-                   DiaContext  *ctx,
-                   void        *user_data)
+_diagram_data_load (const char  *filename,
+                    DiagramData *data,
+                    DiaContext  *ctx,
+                    void        *user_data)
 {
   GHashTable *objects_hash;
   int fd;
@@ -409,6 +414,7 @@ diagram_data_load (const char  *filename,
   DiaLayer *active_layer = NULL;
   GHashTable* unknown_objects_hash = g_hash_table_new(g_str_hash, g_str_equal);
   int num_layers_added = 0;
+  DiaFontPrefetch *prefetch;
 
   g_return_val_if_fail (data != NULL, FALSE);
 
@@ -709,6 +715,14 @@ diagram_data_load (const char  *filename,
       }
     }
   }
+  /* images shared by objects, referenced from data_pixbuf() */
+  data_begin_pixbuf_table (find_node_named (root->xmlChildrenNode, "images"),
+                           ctx);
+
+  /* measure all text on worker threads while the objects get created */
+  prefetch = dia_font_prefetch_new ();
+  data_text_prefetch (root, prefetch);
+
   /* Read in all layers: */
   layer_node =
     find_node_named (root->xmlChildrenNode, "layer");
@@ -779,6 +793,8 @@ diagram_data_load (const char  *filename,
   }
 
   g_clear_object (&active_layer);
+  dia_font_prefetch_finish (prefetch);
+  data_end_pixbuf_table (ctx);
   xmlFreeDoc (doc);
 
   g_hash_table_foreach (objects_hash, hash_free_string, NULL);
@@ -806,6 +822,22 @@ diagram_data_load (const char  *filename,
 }
 
 
+static gboolean
+diagram_data_load (const char  *filename,
+                   DiagramData *data,
+                   DiaContext  *ctx,
+                   void        *user_data)
+{
+  gint64 span = dia_trace_begin ();
+  gboolean ret;
+
+  ret = _diagram_data_load (filename, data, ctx, user_data);
+  dia_trace_end (span, DIA_TRACE_LOAD, "diagram_data_load", filename);
+
+  return ret;
+}
+
+
 static gboolean
 write_objects(GList *objects, xmlNodePtr objects_node,
 	      GHashTable *objects_hash, int *obj_nr,
@@ -957,6 +989,7 @@ diagram_data_write_doc(DiagramData *data, const char *filename, DiaContext *ctx)
   xmlNodePtr tree;
   xmlNodePtr pageinfo, gridinfo, guideinfo;
   xmlNodePtr layer_node;
+  xmlNodePtr images_node;
   GHashTable *objects_hash;
   gboolean res;
   int obj_nr;
@@ -1070,6 +1103,12 @@ diagram_data_write_doc(DiagramData *data, const char *filename, DiaContext *ctx)
     }
   }
 
+  /* every distinct image is written once, objects reference it */
+  images_node = xmlNewChild (doc->xmlRootNode,
+                             name_space,
+                             (const xmlChar *) "images", NULL);
+  data_begin_pixbuf_table (images_node, ctx);
+
   objects_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
 
   obj_nr = 0;
@@ -1130,6 +1169,12 @@ diagram_data_write_doc(DiagramData *data, const char *filename, DiaContext *ctx)
 
   g_hash_table_destroy (objects_hash);
 
+  if (data_end_pixbuf_table (ctx) == 0) {
+    /* keep image-less diagrams readable for older versions */
+    xmlUnlinkNode (images_node);
+    xmlFreeNode (images_node);
+  }
+
   if (data->is_compressed) {
     xmlSetDocCompressMode (doc, 9);
   } else {
@@ -1335,8 +1380,10 @@ static gpointer
 _autosave_in_thread (gpointer data)
 {
   AutoSaveInfo *asi = (AutoSaveInfo *)data;
+  gint64 span = dia_trace_begin ();
 
   diagram_data_raw_save(asi->clone, asi->filename, asi->ctx);
+  dia_trace_end (span, DIA_TRACE_SAVE, "autosave", asi->filename);
   g_clear_object (&asi->clone);
   g_clear_pointer (&asi->filename, g_free);
   /* FIXME: this is throwing away potential messages ... */
@@ -1395,8 +1442,10 @@ diagram_autosave (Diagram *dia)
 #else
       {
         DiaContext *ctx = dia_context_new (_("Auto save"));
+        gint64 span = dia_trace_begin ();
         dia_context_set_filename (ctx, save_filename);
         diagram_data_raw_save (dia->data, save_filename, ctx);
+        dia_trace_end (span, DIA_TRACE_SAVE, "autosave", save_filename);
         dia->autosaved = TRUE;
         dia_context_release (ctx);
       }
@@ -62,6 +62,8 @@ static void modify_motion(ModifyTool *tool, GdkEventMotion *event,
 			  DDisplay *ddisp);
 static void modify_double_click(ModifyTool *tool, GdkEventButton *event,
 				DDisplay *ddisp);
+static void modify_preview_commit(ModifyTool *tool, DDisplay *ddisp);
+static void modify_abort(ModifyTool *tool, GdkEvent *event, DDisplay *ddisp);
 
 struct _ModifyTool {
   Tool tool;
@@ -83,6 +85,10 @@ struct _ModifyTool {
   /* Undo info: */
   Point *orig_pos;
 
+  /* Drag preview: a snapshot follows the pointer, objects move on release */
+  GList *preview;
+  Point preview_delta;
+
   /* Guide info: */
   DiaGuide *guide;
 };
@@ -100,6 +106,7 @@ create_modify_tool(void)
   tool->tool.button_release_func = (ButtonReleaseFunc) &modify_button_release;
   tool->tool.motion_func = (MotionFunc) &modify_motion;
   tool->tool.double_click_func = (DoubleClickFunc) &modify_double_click;
+  tool->tool.abort_func = (AbortFunc) &modify_abort;
   tool->state = STATE_NONE;
   tool->break_connections = FALSE;
   tool->auto_scrolled = FALSE;
@@ -369,6 +376,9 @@ modify_button_hold(ModifyTool *tool, GdkEventButton *event,
       if (textedit_activate_object(ddisp, tool->object, &clickedpoint)) {
 	/* Return tool to normal state - object is text and is in edit */
 	gdk_device_ungrab (gdk_event_get_device((GdkEvent*)event), event->time);
+	if (tool->preview) {
+	  modify_preview_commit (tool, ddisp);
+	}
 	tool->orig_pos = NULL;
 	tool->state = STATE_NONE;
 	/* Activate Text Edit */
@@ -415,6 +425,100 @@ modify_double_click(ModifyTool *tool, GdkEventButton *event,
 
 #define MIN_PIXELS 10
 
+/* Moving fewer objects is done exactly, on every motion event */
+#define PREVIEW_MIN_OBJECTS 200
+
+/*
+ * The objects shown in the drag preview: the moved ones and the
+ * connectors attached to them.
+ */
+static GList *
+modify_preview_objects (GList *affected)
+{
+  GHashTable *seen = g_hash_table_new (NULL, NULL);
+  GList *objects = NULL;
+  GList *list;
+  int i;
+
+  for (list = affected; list != NULL; list = g_list_next (list)) {
+    g_hash_table_add (seen, list->data);
+    objects = g_list_prepend (objects, list->data);
+  }
+
+  for (list = affected; list != NULL; list = g_list_next (list)) {
+    DiaObject *obj = DIA_OBJECT (list->data);
+
+    for (i = 0; i < obj->num_connections; i++) {
+      GList *connected;
+
+      for (connected = obj->connections[i]->connected;
+           connected != NULL;
+           connected = g_list_next (connected)) {
+        if (g_hash_table_add (seen, connected->data)) {
+          objects = g_list_prepend (objects, connected->data);
+        }
+      }
+    }
+  }
+
+  g_hash_table_destroy (seen);
+
+  return g_list_reverse (objects);
+}
+
+/*
+ * End the drag preview by doing the move it was showing, as a single
+ * change with a single connection update.
+ */
+static void
+modify_preview_commit (ModifyTool *tool, DDisplay *ddisp)
+{
+  DiaObjectChange *objchange;
+
+  ddisplay_set_preview (ddisp, NULL);
+  g_clear_pointer (&tool->preview, g_list_free);
+
+  object_add_updates_list (ddisp->diagram->data->selected, ddisp->diagram);
+  objchange = object_list_move_delta (ddisp->diagram->data->selected,
+                                      &tool->preview_delta);
+  if (objchange != NULL) {
+    dia_object_change_change_new (ddisp->diagram, tool->object, objchange);
+  }
+  object_add_updates_list (ddisp->diagram->data->selected, ddisp->diagram);
+
+  diagram_update_connections_selection (ddisp->diagram);
+  diagram_flush (ddisp->diagram);
+}
+
+/*
+ * The drag was cancelled with Escape or lost its grab: there will be no
+ * release, so drop the preview and leave the objects where they were.
+ */
+static void
+modify_abort (ModifyTool *tool, GdkEvent *event, DDisplay *ddisp)
+{
+  GtkStatusbar *statusbar;
+  guint context_id;
+
+  if (tool->state != STATE_MOVE_OBJECT || !tool->preview) {
+    return;
+  }
+
+  gdk_device_ungrab (gdk_event_get_device (event), gdk_event_get_time (event));
+  ddisplay_set_all_cursor (default_cursor);
+
+  statusbar = GTK_STATUSBAR (ddisp->modified_status);
+  context_id = gtk_statusbar_get_context_id (statusbar, "ObjectPos");
+  gtk_statusbar_pop (statusbar, context_id);
+
+  ddisplay_set_preview (ddisp, NULL);
+  g_clear_pointer (&tool->preview, g_list_free);
+  g_clear_pointer (&tool->orig_pos, g_free);
+
+  tool->break_connections = FALSE;
+  tool->state = STATE_NONE;
+}
+
 /*
  * Makes sure that objects aren't accidentally moved when double-clicking
  * for properties.  Objects do not move unless double click time has passed
@@ -514,6 +618,15 @@ modify_motion (ModifyTool     *tool,
         tool->orig_pos[i] = obj->position;
         list = g_list_next(list); i++;
       }
+
+      /* too much to move on every event, just drag a snapshot around */
+      if (i >= PREVIEW_MIN_OBJECTS) {
+        tool->preview = modify_preview_objects (pla);
+        tool->preview_delta.x = tool->preview_delta.y = 0.0;
+        if (!ddisplay_set_preview (ddisp, tool->preview)) {
+          g_clear_pointer (&tool->preview, g_list_free);
+        }
+      }
       g_list_free (pla);
     }
 
@@ -543,26 +656,45 @@ modify_motion (ModifyTool     *tool,
       }
     }
 
-    object_add_updates_list(ddisp->diagram->data->selected, ddisp->diagram);
-    objchange = object_list_move_delta(ddisp->diagram->data->selected, &delta);
-    if (objchange != NULL) {
-      dia_object_change_change_new (ddisp->diagram, tool->object, objchange);
-    }
-    object_add_updates_list(ddisp->diagram->data->selected, ddisp->diagram);
+    if (tool->preview) {
+      /* the objects stay where they are, delta is from the start */
+      tool->preview_delta = delta;
+      if (auto_scroll) {
+        /* the snapshot was taken of the previously visible area */
+        ddisplay_set_preview (ddisp, tool->preview);
+      }
+      ddisplay_move_preview (ddisp, &delta);
+    } else {
+      object_add_updates_list(ddisp->diagram->data->selected, ddisp->diagram);
+      objchange = object_list_move_delta(ddisp->diagram->data->selected, &delta);
+      if (objchange != NULL) {
+        dia_object_change_change_new (ddisp->diagram, tool->object, objchange);
+      }
+      object_add_updates_list(ddisp->diagram->data->selected, ddisp->diagram);
 
-    object_add_updates(tool->object, ddisp->diagram);
+      object_add_updates(tool->object, ddisp->diagram);
+    }
 
     /* Put current mouse position in status bar */
     {
       gchar *postext;
       GtkStatusbar *statusbar = GTK_STATUSBAR (ddisp->modified_status);
       guint context_id = gtk_statusbar_get_context_id (statusbar, "ObjectPos");
+      DiaRectangle bb = tool->object->bounding_box;
+
+      if (tool->preview) {
+        bb.left += delta.x;
+        bb.right += delta.x;
+        bb.top += delta.y;
+        bb.bottom += delta.y;
+      }
+
       gtk_statusbar_pop (statusbar, context_id);
       postext = g_strdup_printf("%.3f, %.3f - %.3f, %.3f",
-			        tool->object->bounding_box.left,
-			        tool->object->bounding_box.top,
-			        tool->object->bounding_box.right,
-			        tool->object->bounding_box.bottom);
+			        bb.left,
+			        bb.top,
+			        bb.right,
+			        bb.bottom);
 
       gtk_statusbar_pop (statusbar, context_id);
       gtk_statusbar_push (statusbar, context_id, postext);
@@ -570,8 +702,10 @@ modify_motion (ModifyTool     *tool,
       g_clear_pointer (&postext, g_free);
     }
 
-    diagram_update_connections_selection(ddisp->diagram);
-    diagram_flush(ddisp->diagram);
+    if (!tool->preview) {
+      diagram_update_connections_selection(ddisp->diagram);
+      diagram_flush(ddisp->diagram);
+    }
     break;
   case STATE_MOVE_HANDLE:
     full_delta = to;
@@ -753,6 +887,10 @@ modify_button_release (ModifyTool     *tool,
     /* Return to normal state */
     gdk_device_ungrab (gdk_event_get_device((GdkEvent*)event), event->time);
 
+    if (tool->preview) {
+      modify_preview_commit (tool, ddisp);
+    }
+
     ddisplay_untransform_coords(ddisp, event->x, event->y, &to.x, &to.y);
     if (!modify_move_already(tool, ddisp, &to)) {
       tool->orig_pos = NULL;
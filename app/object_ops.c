@@ -371,7 +371,7 @@ object_list_align_v(GList *objects, Diagram *dia, int align)
     orig_pos[i] = obj->position;
     dest_pos[i] = pos;
 
-    obj->ops->move(obj, &pos);
+    dia_object_move (obj, &pos);
 
     i++;
     list = g_list_next(list);
@@ -530,7 +530,7 @@ object_list_align_h(GList *objects, Diagram *dia, int align)
     orig_pos[i] = obj->position;
     dest_pos[i] = pos;
 
-    obj->ops->move(obj, &pos);
+    dia_object_move (obj, &pos);
 
     i++;
     list = g_list_next(list);
@@ -721,7 +721,7 @@ object_list_nudge(GList *objects, Diagram *dia, Direction dir, real step)
     dest_pos[i].x = orig_pos[i].x + inc_x;
     dest_pos[i].y = orig_pos[i].y + inc_y;
 
-    obj->ops->move(obj, &dest_pos[i]);
+    dia_object_move (obj, &dest_pos[i]);
     ++i;
     list = g_list_next(list);
   }
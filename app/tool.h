@@ -32,6 +32,7 @@ typedef void (* ButtonHoldFunc)    (Tool *, GdkEventButton *, DDisplay *ddisp);
 typedef void (* DoubleClickFunc)   (Tool *, GdkEventButton *, DDisplay *ddisp);
 typedef void (* ButtonReleaseFunc) (Tool *, GdkEventButton *, DDisplay *ddisp);
 typedef void (* MotionFunc)        (Tool *, GdkEventMotion *, DDisplay *ddisp);
+typedef void (* AbortFunc)         (Tool *, GdkEvent *, DDisplay *ddisp);
 
 enum _ToolType {
   CREATE_OBJECT_TOOL,
@@ -51,6 +52,7 @@ struct _Tool {
   ButtonReleaseFunc  button_release_func;
   MotionFunc         motion_func;
   DoubleClickFunc    double_click_func;
+  AbortFunc          abort_func; /* Escape or lost grab while dragging */
 };
 
 struct _ToolState {
@@ -383,6 +383,75 @@ undo_remove_to (UndoStack *stack, GType type)
 }
 
 
+
+/**
+ * undo_get_memory_size:
+ * @stack: the #UndoStack
+ * @shared: (nullable): the shared data already counted
+ *
+ * The memory used by all changes on @stack, including objects only kept
+ * alive for undo or redo. Pass the set used for the diagram to not count
+ * images or fonts the diagram still uses again.
+ *
+ * Returns: the size in bytes
+ */
+gsize
+undo_get_memory_size (UndoStack *stack, GHashTable *shared)
+{
+  DiaChange *change;
+  gsize size = sizeof (UndoStack);
+
+  for (change = stack->last_change; change != NULL; change = change->prev) {
+    size += dia_change_get_memory_size (change, shared);
+  }
+
+  return size;
+}
+
+
+/* the objects of a list owned by a change */
+static gsize
+_object_list_memory_size (GList *list, GHashTable *shared)
+{
+  gsize size = 0;
+
+  for (; list != NULL; list = g_list_next (list)) {
+    size += sizeof (GList) + dia_object_get_memory_size (list->data, shared);
+  }
+
+  return size;
+}
+
+
+/* a group without its children, which are in the diagram */
+static gsize
+_group_shell_memory_size (DiaObject *group, GHashTable *shared)
+{
+  GHashTable *counted = g_hash_table_new (g_direct_hash, g_direct_equal);
+  gsize children, size;
+
+  /* what the children share is theirs, in the diagram, so it's only
+   * counted on a copy of the caller's set */
+  if (shared) {
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init (&iter, shared);
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+      g_hash_table_add (counted, key);
+    }
+  }
+
+  /* after the first round everything shared is counted already */
+  _object_list_memory_size (group_objects (group), counted);
+  children = _object_list_memory_size (group_objects (group), counted);
+  size = dia_object_get_memory_size (group, counted);
+
+  g_hash_table_destroy (counted);
+
+  return size > children ? size - children : 0;
+}
+
 /****************************************************************/
 /****************************************************************/
 /*****************                          *********************/
@@ -726,7 +795,7 @@ struct _DiaDeleteObjectsChange {
   int applied;
 };
 
-DIA_DEFINE_CHANGE (DiaDeleteObjectsChange, dia_delete_objects_change)
+DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE (DiaDeleteObjectsChange, dia_delete_objects_change)
 
 
 static void
@@ -800,6 +869,23 @@ dia_delete_objects_change_free (DiaChange *self)
 }
 
 
+static gsize
+dia_delete_objects_change_get_memory_size (DiaChange *self, GHashTable *shared)
+{
+  DiaDeleteObjectsChange *change = DIA_DELETE_OBJECTS_CHANGE (self);
+  gsize size = sizeof (DiaDeleteObjectsChange);
+
+  size += g_list_length (change->original_objects) * sizeof (GList);
+  if (change->applied) {
+    size += _object_list_memory_size (change->obj_list, shared);
+  } else {
+    size += g_list_length (change->obj_list) * sizeof (GList);
+  }
+
+  return size;
+}
+
+
 /*
   This function deletes specified objects along with any children
   they might have.
@@ -839,7 +925,7 @@ struct _DiaInsertObjectsChange {
   int applied;
 };
 
-DIA_DEFINE_CHANGE (DiaInsertObjectsChange, dia_insert_objects_change)
+DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE (DiaInsertObjectsChange, dia_insert_objects_change)
 
 
 static void
@@ -893,6 +979,22 @@ dia_insert_objects_change_free (DiaChange *self)
 }
 
 
+static gsize
+dia_insert_objects_change_get_memory_size (DiaChange *self, GHashTable *shared)
+{
+  DiaInsertObjectsChange *change = DIA_INSERT_OBJECTS_CHANGE (self);
+  gsize size = sizeof (DiaInsertObjectsChange);
+
+  if (!change->applied) {
+    size += _object_list_memory_size (change->obj_list, shared);
+  } else {
+    size += g_list_length (change->obj_list) * sizeof (GList);
+  }
+
+  return size;
+}
+
+
 DiaChange *
 dia_insert_objects_change_new (Diagram *dia, GList *obj_list, int applied)
 {
@@ -1018,12 +1120,15 @@ dia_object_change_change_apply (DiaChange   *self,
     object_add_updates (change->obj, DIA_DIAGRAM (dia));
     diagram_update_connections_object (DIA_DIAGRAM (dia), change->obj, TRUE);
     properties_update_if_shown (DIA_DIAGRAM (dia), change->obj);
+    /* e.g. the name shown in the diagram tree */
+    diagram_object_modified (DIA_DIAGRAM (dia), change->obj);
   } else {
     /* pretty big hammer - update all connections */
     data_foreach_object (DIA_DIAGRAM_DATA (dia),
                          _connections_update_func,
                          DIA_DIAGRAM (dia));
     diagram_add_update_all (DIA_DIAGRAM (dia));
+    diagram_object_modified (DIA_DIAGRAM (dia), NULL);
   }
 }
 
@@ -1048,11 +1153,14 @@ dia_object_change_change_revert (DiaChange   *self,
     object_add_updates(change->obj, DIA_DIAGRAM (dia));
     diagram_update_connections_object (DIA_DIAGRAM (dia), change->obj, TRUE);
     properties_update_if_shown (DIA_DIAGRAM (dia), change->obj);
+    /* e.g. the name shown in the diagram tree */
+    diagram_object_modified (DIA_DIAGRAM (dia), change->obj);
   } else {
     data_foreach_object (DIA_DIAGRAM_DATA (dia),
                          _connections_update_func,
                          DIA_DIAGRAM (dia));
     diagram_add_update_all (DIA_DIAGRAM (dia));
+    diagram_object_modified (DIA_DIAGRAM (dia), NULL);
   }
 }
 
@@ -1113,7 +1221,7 @@ struct _DiaGroupObjectsChange {
   int applied;
 };
 
-DIA_DEFINE_CHANGE (DiaGroupObjectsChange, dia_group_objects_change)
+DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE (DiaGroupObjectsChange, dia_group_objects_change)
 
 
 static void
@@ -1182,6 +1290,21 @@ dia_group_objects_change_free (DiaChange *self)
 }
 
 
+static gsize
+dia_group_objects_change_get_memory_size (DiaChange *self, GHashTable *shared)
+{
+  DiaGroupObjectsChange *change = DIA_GROUP_OBJECTS_CHANGE (self);
+  gsize size = sizeof (DiaGroupObjectsChange);
+
+  size += g_list_length (change->orig_list) * sizeof (GList);
+  if (!change->applied && change->group) {
+    size += _group_shell_memory_size (change->group, shared);
+  }
+
+  return size;
+}
+
+
 DiaChange *
 dia_group_objects_change_new (Diagram   *dia,
                               GList     *obj_list,
@@ -1214,7 +1337,7 @@ struct _DiaUngroupObjectsChange {
   int applied;
 };
 
-DIA_DEFINE_CHANGE (DiaUngroupObjectsChange, dia_ungroup_objects_change)
+DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE (DiaUngroupObjectsChange, dia_ungroup_objects_change)
 
 
 static void
@@ -1280,6 +1403,20 @@ dia_ungroup_objects_change_free (DiaChange *self)
 }
 
 
+static gsize
+dia_ungroup_objects_change_get_memory_size (DiaChange *self, GHashTable *shared)
+{
+  DiaUngroupObjectsChange *change = DIA_UNGROUP_OBJECTS_CHANGE (self);
+  gsize size = sizeof (DiaUngroupObjectsChange);
+
+  if (change->applied && change->group) {
+    size += _group_shell_memory_size (change->group, shared);
+  }
+
+  return size;
+}
+
+
 DiaChange *
 dia_ungroup_objects_change_new (Diagram   *dia,
                                 GList     *obj_list,
@@ -1599,6 +1736,22 @@ _import_object_add (DiagramData     *dia,
 }
 
 
+static void
+_import_objects_added (DiagramData     *dia,
+                       DiaLayer        *layer,
+                       GList           *objects,
+                       DiaImportChange *change)
+{
+  GList *list;
+
+  g_return_if_fail (change->dia == DIA_DIAGRAM (dia));
+
+  for (list = objects; list != NULL; list = g_list_next (list)) {
+    change->objects = g_list_prepend (change->objects, list->data);
+  }
+}
+
+
 /**
  * undo_import_change_setup:
  * @dia: the #Diagram to watch
@@ -1618,6 +1771,10 @@ dia_import_change_new (Diagram *dia)
                     "object_add",
                     G_CALLBACK (_import_object_add),
                     change);
+  g_signal_connect (G_OBJECT (dia),
+                    "objects-added",
+                    G_CALLBACK (_import_objects_added),
+                    change);
 
   return DIA_CHANGE (change);
 }
@@ -1645,6 +1802,7 @@ dia_import_change_done (Diagram *dia, DiaChange *chg)
 
   /* stop listening on this diagram */
   g_signal_handlers_disconnect_by_func (change->dia, _import_object_add, change);
+  g_signal_handlers_disconnect_by_func (change->dia, _import_objects_added, change);
 
   if (change->layers != NULL || change->objects != NULL) {
     undo_push_change (dia->undo, chg);
@@ -1664,7 +1822,7 @@ struct _DiaMemSwapChange {
   guint8 *mem;
 };
 
-DIA_DEFINE_CHANGE (DiaMemSwapChange, dia_mem_swap_change)
+DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE (DiaMemSwapChange, dia_mem_swap_change)
 
 
 static void
@@ -1708,6 +1866,15 @@ dia_mem_swap_change_free (DiaChange *change)
 }
 
 
+static gsize
+dia_mem_swap_change_get_memory_size (DiaChange *change, GHashTable *shared)
+{
+  DiaMemSwapChange *self = DIA_MEM_SWAP_CHANGE (change);
+
+  return sizeof (DiaMemSwapChange) + self->size;
+}
+
+
 /**
  * dia_mem_swap_change_new:
  * @dia: the Diagram to record the change for
@@ -43,6 +43,7 @@ void undo_revert_to_last_tp(UndoStack *stack);
 void undo_apply_to_next_tp(UndoStack *stack);
 void undo_clear(UndoStack *stack);
 void undo_mark_save(UndoStack *stack);
+gsize undo_get_memory_size(UndoStack *stack, GHashTable *shared);
 gboolean undo_is_saved(UndoStack *stack);
 gboolean undo_available(UndoStack *stack, gboolean undo);
 DiaChange* undo_remove_to(UndoStack *stack, GType type);
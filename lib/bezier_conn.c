@@ -1013,6 +1013,30 @@ bezierconn_destroy (BezierConn *bezier)
 }
 
 
+/**
+ * bezierconn_get_memory_size:
+ * @bezier: the #BezierConn
+ * @struct_size: sizeof the object's structure
+ *
+ * The memory used by @bezier as a #BezierConn: on top of
+ * object_get_memory_size() the points, corner types and handles.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+bezierconn_get_memory_size (BezierConn *bezier, gsize struct_size)
+{
+  gsize size = object_get_memory_size (&bezier->object, struct_size);
+
+  size += bezier->bezier.num_points * (sizeof (BezPoint) + sizeof (BezCornerType));
+  size += bezier->object.num_handles * sizeof (Handle);
+
+  return size;
+}
+
+
 /**
  * bezierconn_save:
  * @bezier: The object to save.
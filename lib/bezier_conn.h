@@ -58,6 +58,8 @@ void             bezierconn_update_boundingbox   (BezierConn       *bezier);
 void             bezierconn_init                 (BezierConn       *bezier,
                                                   int               num_points);
 void             bezierconn_destroy              (BezierConn       *bezier);
+gsize            bezierconn_get_memory_size      (BezierConn       *bezier,
+                                                  gsize             struct_size);
 void             bezierconn_copy                 (BezierConn       *from,
                                                   BezierConn       *to);
 void             bezierconn_save                 (BezierConn       *bezier,
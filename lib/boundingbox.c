@@ -26,6 +26,7 @@
 
 #include "geometry.h"
 #include "boundingbox.h"
+#include "dia-geometry-kernels.h"
 
 /**
  * bernstein_develop:
@@ -342,6 +343,136 @@ free_polybezier_space (BezPoint *points)
 }
 
 
+/*
+ * Enlarges a little the bounding box (if necessary) to account with the
+ * "pointy corners" X (and PS) add when DIA_LINE_JOIN_MITER mode is in
+ * force at vertex vx between vp and vn.
+ */
+static void
+add_miter_overshoot (DiaRectangle *rect,
+                     const Point  *vp,
+                     const Point  *vx,
+                     const Point  *vn,
+                     double        trans)
+{
+  Point vpx,vxn;
+  double co,alpha;
+
+  point_copy_add_scaled (&vpx, vx, vp, -1);
+  point_normalize (&vpx);
+  point_copy_add_scaled (&vxn, vn, vx, -1);
+  point_normalize (&vxn);
+
+  co = point_dot (&vpx, &vxn);
+  alpha = dia_acos (-co);
+  if (co > -0.9816) { /* 0.9816 = cos(11deg) */
+    /* we have a pointy join. */
+    double overshoot;
+    Point vovs,pto;
+
+    if (alpha > 0.0 && alpha < M_PI)
+      overshoot = trans / sin (alpha / 2.0);
+    else /* perpendicular? */
+      overshoot = trans;
+
+    point_copy_add_scaled (&vovs, &vpx, &vxn, -1);
+    point_normalize (&vovs);
+    point_copy_add_scaled (&pto, vx, &vovs, overshoot);
+
+    rectangle_add_point (rect, &pto);
+  } else {
+    /* we don't have a pointy join. */
+#if 0
+    /* so nothing to do really - this code would be growing the
+     * bounding box arbitrarily. See e.g with bezier-extreme.dia
+     */
+    Point vpxt,vxnt,tmp;
+
+    point_get_perp(&vpxt,&vpx);
+    point_get_perp(&vxnt,&vxn);
+
+    point_copy_add_scaled(&tmp,&vx,&vpxt,1);
+    rectangle_add_point(rect,&tmp);
+    point_copy_add_scaled(&tmp,&vx,&vpxt,-1);
+    rectangle_add_point(rect,&tmp);
+    point_copy_add_scaled(&tmp,&vx,&vxnt,1);
+    rectangle_add_point(rect,&tmp);
+    point_copy_add_scaled(&tmp,&vx,&vxnt,-1);
+    rectangle_add_point(rect,&tmp);
+#endif
+  }
+}
+
+
+/* below that the setup costs more than the vectorized loops gain */
+#define POLYLINE_KERNEL_MIN_POINTS 8
+
+/*
+ * The same result as the polybezier_bbox() based calculation, but with the
+ * segments and inner joins done by the geometry kernels. Only the first and
+ * last segment of an open polyline carry the start and end extras, for
+ * closed ones all segments are the same and just the joins at the first
+ * and last vertex need special treatment. Closed polylines with arrow
+ * like extras are left to the generic code.
+ */
+static gboolean
+polyline_bbox_kernel (const Point        *pts,
+                      int                 numpoints,
+                      const PolyBBExtras *extra,
+                      gboolean            closed,
+                      DiaRectangle       *rect)
+{
+  const DiaGeometryKernels *kernels = dia_geometry_kernels_get ();
+  LineBBExtras lextra;
+  DiaRectangle rt;
+  int n = numpoints;
+
+  if (closed) {
+    double trans = MAX (extra->start_trans, extra->middle_trans);
+
+    if (extra->start_long != 0 || extra->end_long != 0 ||
+        trans != MAX (extra->end_trans, extra->middle_trans)) {
+      return FALSE;
+    }
+
+    rect->left = rect->right = pts[0].x;
+    rect->top = rect->bottom = pts[0].y;
+
+    kernels->polyline_extents (pts, n, trans, extra->middle_trans, rect);
+
+    lextra.start_long = lextra.end_long = 0;
+    lextra.start_trans = lextra.end_trans = trans;
+    line_bbox (&pts[n - 1], &pts[0], &lextra, &rt);
+    rectangle_union (rect, &rt);
+
+    add_miter_overshoot (rect, &pts[n - 2], &pts[n - 1], &pts[0], extra->middle_trans);
+    add_miter_overshoot (rect, &pts[n - 1], &pts[0], &pts[1], extra->middle_trans);
+  } else {
+    rect->left = rect->right = pts[0].x;
+    rect->top = rect->bottom = pts[0].y;
+
+    /* the first and last segment get covered again with their extras */
+    kernels->polyline_extents (pts, n, extra->middle_trans, extra->middle_trans, rect);
+
+    lextra.start_long = extra->start_long;
+    lextra.start_trans = MAX (extra->start_trans, extra->middle_trans);
+    lextra.end_long = 0;
+    lextra.end_trans = extra->middle_trans;
+    line_bbox (&pts[0], &pts[1], &lextra, &rt);
+    rectangle_union (rect, &rt);
+
+    lextra.start_long = 0;
+    lextra.start_trans = extra->middle_trans;
+    lextra.end_long = extra->end_long;
+    lextra.end_trans = MAX (extra->end_trans, extra->middle_trans);
+    line_bbox (&pts[n - 2], &pts[n - 1], &lextra, &rt);
+    rectangle_union (rect, &rt);
+  }
+
+  return TRUE;
+}
+
+
 /**
  * polyline_bbox:
  * @pts: Array of points.
@@ -362,7 +493,15 @@ polyline_bbox (const Point        *pts,
 {
   /* It's much easier to re-use the Bezier code... */
   int i;
-  BezPoint *bpts = alloc_polybezier_space (numpoints + 1);
+  BezPoint *bpts;
+
+  /* ... but long polylines are worth the batch version */
+  if (numpoints >= POLYLINE_KERNEL_MIN_POINTS &&
+      polyline_bbox_kernel (pts, numpoints, extra, closed, rect)) {
+    return;
+  }
+
+  bpts = alloc_polybezier_space (numpoints + 1);
 
   bpts[0].type = BEZ_MOVE_TO;
   bpts[0].p1 = pts[0];
@@ -600,52 +739,7 @@ polybezier_bbox (const BezPoint     *pts,
        in force. */
 
     if (!end) { /* only the last segment might not produce overshoot. */
-      Point vpx,vxn;
-      double co,alpha;
-
-      point_copy_add_scaled (&vpx, &vx, &vp, -1);
-      point_normalize (&vpx);
-      point_copy_add_scaled (&vxn, &vn, &vx, -1);
-      point_normalize (&vxn);
-
-      co = point_dot (&vpx, &vxn);
-      alpha = dia_acos (-co);
-      if (co > -0.9816) { /* 0.9816 = cos(11deg) */
-        /* we have a pointy join. */
-        double overshoot;
-        Point vovs,pto;
-
-        if (alpha > 0.0 && alpha < M_PI)
-          overshoot = extra->middle_trans / sin (alpha / 2.0);
-        else /* perpendicular? */
-          overshoot = extra->middle_trans;
-
-        point_copy_add_scaled (&vovs, &vpx, &vxn, -1);
-        point_normalize (&vovs);
-        point_copy_add_scaled (&pto, &vx, &vovs, overshoot);
-
-        rectangle_add_point (rect, &pto);
-      } else {
-        /* we don't have a pointy join. */
-#if 0
-	/* so nothing to do really - this code would be growing the
-	 * bounding box arbitrarily. See e.g with bezier-extreme.dia
-	 */
-        Point vpxt,vxnt,tmp;
-
-        point_get_perp(&vpxt,&vpx);
-        point_get_perp(&vxnt,&vxn);
-
-        point_copy_add_scaled(&tmp,&vx,&vpxt,1);
-        rectangle_add_point(rect,&tmp);
-        point_copy_add_scaled(&tmp,&vx,&vpxt,-1);
-        rectangle_add_point(rect,&tmp);
-        point_copy_add_scaled(&tmp,&vx,&vxnt,1);
-        rectangle_add_point(rect,&tmp);
-        point_copy_add_scaled(&tmp,&vx,&vxnt,-1);
-        rectangle_add_point(rect,&tmp);
-#endif
-      }
+      add_miter_overshoot (rect, &vp, &vx, &vn, extra->middle_trans);
     }
   }
 }
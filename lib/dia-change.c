@@ -49,12 +49,25 @@ dia_change_real_free (DiaChange *self)
 }
 
 
+static gsize
+dia_change_real_get_memory_size (DiaChange  *self,
+                                 GHashTable *shared)
+{
+  GTypeQuery query;
+
+  g_type_query (DIA_CHANGE_TYPE (self), &query);
+
+  return query.instance_size;
+}
+
+
 static void
 dia_change_base_class_init (DiaChangeClass *klass)
 {
   klass->apply = dia_change_real_apply;
   klass->revert = dia_change_real_revert;
   klass->free = dia_change_real_free;
+  klass->get_memory_size = dia_change_real_get_memory_size;
 }
 
 
@@ -342,3 +355,26 @@ dia_change_revert (DiaChange   *self,
 
   DIA_CHANGE_GET_CLASS (self)->revert (self, diagram);
 }
+
+
+/**
+ * dia_change_get_memory_size:
+ * @self: a #DiaChange
+ * @shared: (nullable): the shared data already counted
+ *
+ * The memory kept alive by @self, e.g. by the objects it holds while
+ * they are not in the diagram. Data shared with the diagram is only
+ * counted if not in @shared yet, see dia_object_get_memory_size()
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+dia_change_get_memory_size (DiaChange  *self,
+                            GHashTable *shared)
+{
+  g_return_val_if_fail (self && DIA_IS_CHANGE (self), 0);
+
+  return DIA_CHANGE_GET_CLASS (self)->get_memory_size (self, shared);
+}
@@ -83,6 +83,37 @@ typedef struct _DiaChangeClass DiaChangeClass;
  * Since: 0.98
  */
 #define DIA_DEFINE_CHANGE(TypeName, type_name)                               \
+  _DIA_DEFINE_CHANGE_WITH_CODE (TypeName, type_name, {})
+
+
+/**
+ * DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE:
+ * @TypeName: CamelCase name of the type
+ * @type_name: python_case name of the type
+ *
+ * Like DIA_DEFINE_CHANGE() for changes holding more than their instance,
+ * e.g. objects removed from the diagram. Additionally you provide
+ *
+ * |[<!-- language="C" -->
+ * static gsize
+ * some_change_get_memory_size (DiaChange  *change,
+ *                              GHashTable *shared)
+ * {
+ * }
+ * ]|
+ *
+ * Since: 0.98
+ */
+#define DIA_DEFINE_CHANGE_WITH_MEMORY_SIZE(TypeName, type_name)              \
+  static gsize type_name##_get_memory_size  (DiaChange        *change,       \
+                                             GHashTable       *shared);      \
+                                                                             \
+  _DIA_DEFINE_CHANGE_WITH_CODE (TypeName, type_name, {                       \
+    change_class->get_memory_size = type_name##_get_memory_size;             \
+  })
+
+
+#define _DIA_DEFINE_CHANGE_WITH_CODE(TypeName, type_name, _C_)               \
   G_DEFINE_TYPE (TypeName, type_name, DIA_TYPE_CHANGE)                       \
                                                                              \
   static void type_name##_apply             (DiaChange        *change,       \
@@ -99,6 +130,7 @@ typedef struct _DiaChangeClass DiaChangeClass;
     change_class->apply = type_name##_apply;                                 \
     change_class->revert = type_name##_revert;                               \
     change_class->free = type_name##_free;                                   \
+    { _C_ ; }                                                                \
   }                                                                          \
                                                                              \
   static void                                                                \
@@ -123,6 +155,9 @@ struct _DiaChangeClass {
   void (*revert) (DiaChange   *change,
                   DiagramData *dia);
   void (*free)   (DiaChange   *change);
+
+  gsize (*get_memory_size) (DiaChange  *change,
+                            GHashTable *shared);
 };
 
 void     dia_change_unref  (gpointer     self);
@@ -132,6 +167,9 @@ void     dia_change_apply  (DiaChange   *self,
                             DiagramData *diagram);
 void     dia_change_revert (DiaChange   *self,
                             DiagramData *diagram);
+gsize    dia_change_get_memory_size
+                           (DiaChange   *self,
+                            GHashTable  *shared);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (DiaChange, dia_change_unref)
 
@@ -0,0 +1,690 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include "dia-geometry-kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+/* the vector versions evaluate exactly the same expressions, so they
+ * match the scalar reference bit by bit (no FMA contraction allowed) */
+
+/* cos (11deg), below that a join doesn't get pointy */
+#define MITER_LIMIT_COS -0.9816
+
+
+static inline void
+grow_rect (DiaRectangle *rect, double left, double top, double right, double bottom)
+{
+  rect->left = MIN (rect->left, left);
+  rect->top = MIN (rect->top, top);
+  rect->right = MAX (rect->right, right);
+  rect->bottom = MAX (rect->bottom, bottom);
+}
+
+
+static double
+scalar_segments_distance (const Point *pts,
+                          guint        npoints,
+                          double       line_width,
+                          const Point *point,
+                          guint       *crossings)
+{
+  double dist = G_MAXFLOAT;
+  guint i;
+
+  for (i = 1; i < npoints; i++) {
+    double d = distance_line_point (&pts[i - 1], &pts[i], line_width, point);
+
+    dist = MIN (dist, d);
+    if (crossings) {
+      *crossings += line_crosses_ray (&pts[i - 1], &pts[i], point);
+    }
+  }
+
+  return dist;
+}
+
+
+static void
+scalar_segment_extents (const Point  *p1,
+                        const Point  *p2,
+                        double        trans,
+                        DiaRectangle *rect)
+{
+  Point vl;
+  double ax, ay;
+
+  point_copy_add_scaled (&vl, p1, p2, -1);
+  point_normalize (&vl);
+  /* the perpendicular of vl is (-vl.y, vl.x) */
+  ax = fabs (vl.y) * trans;
+  ay = fabs (vl.x) * trans;
+
+  grow_rect (rect,
+             MIN (p1->x, p2->x) - ax,
+             MIN (p1->y, p2->y) - ay,
+             MAX (p1->x, p2->x) + ax,
+             MAX (p1->y, p2->y) + ay);
+}
+
+
+/*
+ * The same as the pointy corner handling in polybezier_bbox() with
+ * sin (acos (-co) / 2) written as sqrt ((1 + co) / 2)
+ */
+static void
+scalar_join_extents (const Point  *vp,
+                     const Point  *vx,
+                     const Point  *vn,
+                     double        trans,
+                     DiaRectangle *rect)
+{
+  Point vpx, vxn, vovs, pto;
+  double co, overshoot;
+
+  point_copy_add_scaled (&vpx, vx, vp, -1);
+  point_normalize (&vpx);
+  point_copy_add_scaled (&vxn, vn, vx, -1);
+  point_normalize (&vxn);
+
+  co = point_dot (&vpx, &vxn);
+  if (!(co > MITER_LIMIT_COS)) {
+    return;
+  }
+
+  if (co > -1.0 && co < 1.0) {
+    overshoot = trans / sqrt ((1.0 + co) / 2.0);
+  } else {
+    overshoot = trans;
+  }
+
+  point_copy_add_scaled (&vovs, &vpx, &vxn, -1);
+  point_normalize (&vovs);
+  point_copy_add_scaled (&pto, vx, &vovs, overshoot);
+
+  grow_rect (rect, pto.x, pto.y, pto.x, pto.y);
+}
+
+
+static void
+scalar_polyline_extents (const Point  *pts,
+                         guint         npoints,
+                         double        seg_trans,
+                         double        join_trans,
+                         DiaRectangle *rect)
+{
+  guint i;
+
+  for (i = 1; i < npoints; i++) {
+    scalar_segment_extents (&pts[i - 1], &pts[i], seg_trans, rect);
+  }
+  for (i = 1; i + 1 < npoints; i++) {
+    scalar_join_extents (&pts[i - 1], &pts[i], &pts[i + 1], join_trans, rect);
+  }
+}
+
+
+static const DiaGeometryKernels scalar_kernels = {
+  "scalar",
+  scalar_segments_distance,
+  scalar_polyline_extents,
+};
+
+
+#ifdef HAVE_X86_KERNELS
+
+/*
+ * SSE2: two segments per step. Loading consecutive points and
+ * unpacking them gives the x and y coordinates of two neighbours.
+ */
+
+#define SSE2 __attribute__ ((target ("sse2")))
+
+static inline SSE2 __m128d
+sse2_blend (__m128d a, __m128d b, __m128d mask)
+{
+  return _mm_or_pd (_mm_and_pd (mask, b), _mm_andnot_pd (mask, a));
+}
+
+static inline SSE2 __m128d
+sse2_length (__m128d x, __m128d y)
+{
+  return _mm_sqrt_pd (_mm_add_pd (_mm_mul_pd (x, x), _mm_mul_pd (y, y)));
+}
+
+/* point_normalize() for two vectors */
+static inline SSE2 void
+sse2_normalize (__m128d *x, __m128d *y)
+{
+  __m128d len = sse2_length (*x, *y);
+  __m128d valid = _mm_cmpgt_pd (len, _mm_setzero_pd ());
+
+  *x = _mm_and_pd (valid, _mm_div_pd (*x, len));
+  *y = _mm_and_pd (valid, _mm_div_pd (*y, len));
+}
+
+static inline SSE2 void
+sse2_load (const Point *pts, __m128d *x, __m128d *y)
+{
+  __m128d a = _mm_loadu_pd (&pts[0].x);
+  __m128d b = _mm_loadu_pd (&pts[1].x);
+
+  *x = _mm_unpacklo_pd (a, b);
+  *y = _mm_unpackhi_pd (a, b);
+}
+
+static SSE2 double
+sse2_segments_distance (const Point *pts,
+                        guint        npoints,
+                        double       line_width,
+                        const Point *point,
+                        guint       *crossings)
+{
+  const __m128d px = _mm_set1_pd (point->x);
+  const __m128d py = _mm_set1_pd (point->y);
+  const __m128d half = _mm_set1_pd (line_width / 2.0);
+  const __m128d zero = _mm_setzero_pd ();
+  const __m128d one = _mm_set1_pd (1.0);
+  const __m128d eps = _mm_set1_pd (0.000001);
+  __m128d vmin = _mm_set1_pd (G_MAXFLOAT);
+  double mins[2], dist;
+  guint count = 0;
+  guint k;
+
+  for (k = 0; k + 2 < npoints; k += 2) {
+    __m128d sx, sy, ex, ey;
+    __m128d v1x, v1y, v2x, v2y, v3x, v3y, wx, wy;
+    __m128d lensq, proj, d, at_start, at_end;
+
+    sse2_load (&pts[k], &sx, &sy);
+    sse2_load (&pts[k + 1], &ex, &ey);
+
+    v1x = _mm_sub_pd (ex, sx);
+    v1y = _mm_sub_pd (ey, sy);
+    v2x = _mm_sub_pd (px, sx);
+    v2y = _mm_sub_pd (py, sy);
+    v3x = _mm_sub_pd (px, ex);
+    v3y = _mm_sub_pd (py, ey);
+
+    lensq = _mm_add_pd (_mm_mul_pd (v1x, v1x), _mm_mul_pd (v1y, v1y));
+    proj = _mm_div_pd (_mm_add_pd (_mm_mul_pd (v1x, v2x), _mm_mul_pd (v1y, v2y)),
+                       lensq);
+
+    wx = _mm_sub_pd (_mm_mul_pd (v1x, proj), v2x);
+    wy = _mm_sub_pd (_mm_mul_pd (v1y, proj), v2y);
+
+    at_start = _mm_or_pd (_mm_cmplt_pd (lensq, eps), _mm_cmplt_pd (proj, zero));
+    at_end = _mm_andnot_pd (at_start, _mm_cmpgt_pd (proj, one));
+
+    /* pick the squared distance first, so there is only one sqrt */
+    d = _mm_add_pd (_mm_mul_pd (wx, wx), _mm_mul_pd (wy, wy));
+    d = sse2_blend (d, _mm_add_pd (_mm_mul_pd (v3x, v3x), _mm_mul_pd (v3y, v3y)), at_end);
+    d = sse2_blend (d, _mm_add_pd (_mm_mul_pd (v2x, v2x), _mm_mul_pd (v2y, v2y)), at_start);
+    d = _mm_sqrt_pd (d);
+    /* only the perpendicular distance considers the line width */
+    d = sse2_blend (_mm_max_pd (_mm_sub_pd (d, half), zero), d,
+                    _mm_or_pd (at_start, at_end));
+    vmin = _mm_min_pd (vmin, d);
+
+    if (crossings) {
+      __m128d up = _mm_and_pd (_mm_cmple_pd (sy, py), _mm_cmpgt_pd (ey, py));
+      __m128d down = _mm_and_pd (_mm_cmpgt_pd (sy, py), _mm_cmple_pd (ey, py));
+      __m128d spans = _mm_or_pd (up, down);
+
+      /* most segments don't span the ray, save the division then */
+      if (_mm_movemask_pd (spans)) {
+        __m128d vt = _mm_div_pd (_mm_sub_pd (py, sy), _mm_sub_pd (ey, sy));
+        __m128d ix = _mm_add_pd (sx, _mm_mul_pd (vt, _mm_sub_pd (ex, sx)));
+        int mask = _mm_movemask_pd (_mm_and_pd (spans, _mm_cmplt_pd (px, ix)));
+
+        count += (mask & 1) + ((mask >> 1) & 1);
+      }
+    }
+  }
+
+  _mm_storeu_pd (mins, vmin);
+  dist = MIN (mins[0], mins[1]);
+
+  if (crossings) {
+    *crossings += count;
+  }
+  /* the remaining segments */
+  if (k + 1 < npoints) {
+    double rest = scalar_segments_distance (&pts[k], npoints - k,
+                                            line_width, point, crossings);
+    dist = MIN (dist, rest);
+  }
+
+  return dist;
+}
+
+static SSE2 void
+sse2_polyline_extents (const Point  *pts,
+                       guint         npoints,
+                       double        seg_trans,
+                       double        join_trans,
+                       DiaRectangle *rect)
+{
+  const __m128d strans = _mm_set1_pd (seg_trans);
+  const __m128d jtrans = _mm_set1_pd (join_trans);
+  const __m128d abs_mask = _mm_castsi128_pd (_mm_set1_epi64x (0x7fffffffffffffffLL));
+  const __m128d one = _mm_set1_pd (1.0);
+  const __m128d two = _mm_set1_pd (2.0);
+  const __m128d minus_one = _mm_set1_pd (-1.0);
+  const __m128d limit = _mm_set1_pd (MITER_LIMIT_COS);
+  __m128d left = _mm_set1_pd (rect->left);
+  __m128d top = _mm_set1_pd (rect->top);
+  __m128d right = _mm_set1_pd (rect->right);
+  __m128d bottom = _mm_set1_pd (rect->bottom);
+  double v[2];
+  guint k;
+
+  /* segments */
+  for (k = 0; k + 2 < npoints; k += 2) {
+    __m128d sx, sy, ex, ey, nx, ny, ax, ay;
+
+    sse2_load (&pts[k], &sx, &sy);
+    sse2_load (&pts[k + 1], &ex, &ey);
+
+    nx = _mm_sub_pd (sx, ex);
+    ny = _mm_sub_pd (sy, ey);
+    sse2_normalize (&nx, &ny);
+    ax = _mm_mul_pd (_mm_and_pd (ny, abs_mask), strans);
+    ay = _mm_mul_pd (_mm_and_pd (nx, abs_mask), strans);
+
+    left = _mm_min_pd (left, _mm_sub_pd (_mm_min_pd (sx, ex), ax));
+    top = _mm_min_pd (top, _mm_sub_pd (_mm_min_pd (sy, ey), ay));
+    right = _mm_max_pd (right, _mm_add_pd (_mm_max_pd (sx, ex), ax));
+    bottom = _mm_max_pd (bottom, _mm_add_pd (_mm_max_pd (sy, ey), ay));
+  }
+  for (k = k + 1; k < npoints; k++) {
+    scalar_segment_extents (&pts[k - 1], &pts[k], seg_trans, rect);
+  }
+
+  /* joins */
+  for (k = 0; k + 3 < npoints; k += 2) {
+    __m128d vpx, vpy, vxx, vxy, vnx, vny;
+    __m128d ux, uy, wx, wy, ox, oy, co, over, pointy, inner, tx, ty;
+
+    sse2_load (&pts[k], &vpx, &vpy);
+    sse2_load (&pts[k + 1], &vxx, &vxy);
+    sse2_load (&pts[k + 2], &vnx, &vny);
+
+    ux = _mm_sub_pd (vxx, vpx);
+    uy = _mm_sub_pd (vxy, vpy);
+    sse2_normalize (&ux, &uy);
+    wx = _mm_sub_pd (vnx, vxx);
+    wy = _mm_sub_pd (vny, vxy);
+    sse2_normalize (&wx, &wy);
+
+    co = _mm_add_pd (_mm_mul_pd (ux, wx), _mm_mul_pd (uy, wy));
+    pointy = _mm_cmpgt_pd (co, limit);
+    inner = _mm_and_pd (_mm_cmpgt_pd (co, minus_one), _mm_cmplt_pd (co, one));
+    over = _mm_div_pd (jtrans, _mm_sqrt_pd (_mm_div_pd (_mm_add_pd (one, co), two)));
+    over = sse2_blend (jtrans, over, inner);
+
+    ox = _mm_sub_pd (ux, wx);
+    oy = _mm_sub_pd (uy, wy);
+    sse2_normalize (&ox, &oy);
+    tx = sse2_blend (vxx, _mm_add_pd (vxx, _mm_mul_pd (ox, over)), pointy);
+    ty = sse2_blend (vxy, _mm_add_pd (vxy, _mm_mul_pd (oy, over)), pointy);
+
+    left = _mm_min_pd (left, tx);
+    top = _mm_min_pd (top, ty);
+    right = _mm_max_pd (right, tx);
+    bottom = _mm_max_pd (bottom, ty);
+  }
+  for (k = k + 1; k + 1 < npoints; k++) {
+    scalar_join_extents (&pts[k - 1], &pts[k], &pts[k + 1], join_trans, rect);
+  }
+
+  _mm_storeu_pd (v, left);
+  rect->left = MIN (rect->left, MIN (v[0], v[1]));
+  _mm_storeu_pd (v, top);
+  rect->top = MIN (rect->top, MIN (v[0], v[1]));
+  _mm_storeu_pd (v, right);
+  rect->right = MAX (rect->right, MAX (v[0], v[1]));
+  _mm_storeu_pd (v, bottom);
+  rect->bottom = MAX (rect->bottom, MAX (v[0], v[1]));
+}
+
+static const DiaGeometryKernels sse2_kernels = {
+  "sse2",
+  sse2_segments_distance,
+  sse2_polyline_extents,
+};
+
+
+/*
+ * AVX2: four segments per step. Unpacking works per 128 bit lane, so the
+ * order of the segments is (k, k+2, k+1, k+3) for starts and ends alike.
+ */
+
+#define AVX2 __attribute__ ((target ("avx2")))
+
+static inline AVX2 __m256d
+avx2_blend (__m256d a, __m256d b, __m256d mask)
+{
+  return _mm256_blendv_pd (a, b, mask);
+}
+
+static inline AVX2 __m256d
+avx2_length (__m256d x, __m256d y)
+{
+  return _mm256_sqrt_pd (_mm256_add_pd (_mm256_mul_pd (x, x), _mm256_mul_pd (y, y)));
+}
+
+static inline AVX2 void
+avx2_normalize (__m256d *x, __m256d *y)
+{
+  __m256d len = avx2_length (*x, *y);
+  __m256d valid = _mm256_cmp_pd (len, _mm256_setzero_pd (), _CMP_GT_OQ);
+
+  *x = _mm256_and_pd (valid, _mm256_div_pd (*x, len));
+  *y = _mm256_and_pd (valid, _mm256_div_pd (*y, len));
+}
+
+static inline AVX2 void
+avx2_load (const Point *pts, __m256d *x, __m256d *y)
+{
+  __m256d a = _mm256_loadu_pd (&pts[0].x);
+  __m256d b = _mm256_loadu_pd (&pts[2].x);
+
+  *x = _mm256_unpacklo_pd (a, b);
+  *y = _mm256_unpackhi_pd (a, b);
+}
+
+static inline AVX2 double
+avx2_hmin (__m256d v)
+{
+  __m128d m = _mm_min_pd (_mm256_castpd256_pd128 (v), _mm256_extractf128_pd (v, 1));
+
+  return MIN (_mm_cvtsd_f64 (m), _mm_cvtsd_f64 (_mm_unpackhi_pd (m, m)));
+}
+
+static inline AVX2 double
+avx2_hmax (__m256d v)
+{
+  __m128d m = _mm_max_pd (_mm256_castpd256_pd128 (v), _mm256_extractf128_pd (v, 1));
+
+  return MAX (_mm_cvtsd_f64 (m), _mm_cvtsd_f64 (_mm_unpackhi_pd (m, m)));
+}
+
+static AVX2 double
+avx2_segments_distance (const Point *pts,
+                        guint        npoints,
+                        double       line_width,
+                        const Point *point,
+                        guint       *crossings)
+{
+  const __m256d px = _mm256_set1_pd (point->x);
+  const __m256d py = _mm256_set1_pd (point->y);
+  const __m256d half = _mm256_set1_pd (line_width / 2.0);
+  const __m256d zero = _mm256_setzero_pd ();
+  const __m256d one = _mm256_set1_pd (1.0);
+  const __m256d eps = _mm256_set1_pd (0.000001);
+  __m256d vmin = _mm256_set1_pd (G_MAXFLOAT);
+  double dist;
+  guint count = 0;
+  guint k;
+
+  for (k = 0; k + 4 < npoints; k += 4) {
+    __m256d sx, sy, ex, ey;
+    __m256d v1x, v1y, v2x, v2y, v3x, v3y, wx, wy;
+    __m256d lensq, proj, d, at_start, at_end;
+
+    avx2_load (&pts[k], &sx, &sy);
+    avx2_load (&pts[k + 1], &ex, &ey);
+
+    v1x = _mm256_sub_pd (ex, sx);
+    v1y = _mm256_sub_pd (ey, sy);
+    v2x = _mm256_sub_pd (px, sx);
+    v2y = _mm256_sub_pd (py, sy);
+    v3x = _mm256_sub_pd (px, ex);
+    v3y = _mm256_sub_pd (py, ey);
+
+    lensq = _mm256_add_pd (_mm256_mul_pd (v1x, v1x), _mm256_mul_pd (v1y, v1y));
+    proj = _mm256_div_pd (_mm256_add_pd (_mm256_mul_pd (v1x, v2x),
+                                         _mm256_mul_pd (v1y, v2y)),
+                          lensq);
+
+    wx = _mm256_sub_pd (_mm256_mul_pd (v1x, proj), v2x);
+    wy = _mm256_sub_pd (_mm256_mul_pd (v1y, proj), v2y);
+
+    at_start = _mm256_or_pd (_mm256_cmp_pd (lensq, eps, _CMP_LT_OQ),
+                             _mm256_cmp_pd (proj, zero, _CMP_LT_OQ));
+    at_end = _mm256_andnot_pd (at_start, _mm256_cmp_pd (proj, one, _CMP_GT_OQ));
+
+    d = _mm256_add_pd (_mm256_mul_pd (wx, wx), _mm256_mul_pd (wy, wy));
+    d = avx2_blend (d, _mm256_add_pd (_mm256_mul_pd (v3x, v3x),
+                                      _mm256_mul_pd (v3y, v3y)), at_end);
+    d = avx2_blend (d, _mm256_add_pd (_mm256_mul_pd (v2x, v2x),
+                                      _mm256_mul_pd (v2y, v2y)), at_start);
+    d = _mm256_sqrt_pd (d);
+    d = avx2_blend (_mm256_max_pd (_mm256_sub_pd (d, half), zero), d,
+                    _mm256_or_pd (at_start, at_end));
+    vmin = _mm256_min_pd (vmin, d);
+
+    if (crossings) {
+      __m256d up = _mm256_and_pd (_mm256_cmp_pd (sy, py, _CMP_LE_OQ),
+                                  _mm256_cmp_pd (ey, py, _CMP_GT_OQ));
+      __m256d down = _mm256_and_pd (_mm256_cmp_pd (sy, py, _CMP_GT_OQ),
+                                    _mm256_cmp_pd (ey, py, _CMP_LE_OQ));
+      __m256d spans = _mm256_or_pd (up, down);
+
+      if (_mm256_movemask_pd (spans)) {
+        __m256d vt = _mm256_div_pd (_mm256_sub_pd (py, sy), _mm256_sub_pd (ey, sy));
+        __m256d ix = _mm256_add_pd (sx, _mm256_mul_pd (vt, _mm256_sub_pd (ex, sx)));
+        int mask = _mm256_movemask_pd (_mm256_and_pd (spans,
+                                                      _mm256_cmp_pd (px, ix, _CMP_LT_OQ)));
+
+        count += __builtin_popcount (mask);
+      }
+    }
+  }
+
+  dist = avx2_hmin (vmin);
+
+  if (crossings) {
+    *crossings += count;
+  }
+  if (k + 1 < npoints) {
+    double rest = scalar_segments_distance (&pts[k], npoints - k,
+                                            line_width, point, crossings);
+    dist = MIN (dist, rest);
+  }
+
+  return dist;
+}
+
+static AVX2 void
+avx2_polyline_extents (const Point  *pts,
+                       guint         npoints,
+                       double        seg_trans,
+                       double        join_trans,
+                       DiaRectangle *rect)
+{
+  const __m256d strans = _mm256_set1_pd (seg_trans);
+  const __m256d jtrans = _mm256_set1_pd (join_trans);
+  const __m256d abs_mask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffLL));
+  const __m256d one = _mm256_set1_pd (1.0);
+  const __m256d two = _mm256_set1_pd (2.0);
+  const __m256d minus_one = _mm256_set1_pd (-1.0);
+  const __m256d limit = _mm256_set1_pd (MITER_LIMIT_COS);
+  __m256d left = _mm256_set1_pd (rect->left);
+  __m256d top = _mm256_set1_pd (rect->top);
+  __m256d right = _mm256_set1_pd (rect->right);
+  __m256d bottom = _mm256_set1_pd (rect->bottom);
+  guint k;
+
+  for (k = 0; k + 4 < npoints; k += 4) {
+    __m256d sx, sy, ex, ey, nx, ny, ax, ay;
+
+    avx2_load (&pts[k], &sx, &sy);
+    avx2_load (&pts[k + 1], &ex, &ey);
+
+    nx = _mm256_sub_pd (sx, ex);
+    ny = _mm256_sub_pd (sy, ey);
+    avx2_normalize (&nx, &ny);
+    ax = _mm256_mul_pd (_mm256_and_pd (ny, abs_mask), strans);
+    ay = _mm256_mul_pd (_mm256_and_pd (nx, abs_mask), strans);
+
+    left = _mm256_min_pd (left, _mm256_sub_pd (_mm256_min_pd (sx, ex), ax));
+    top = _mm256_min_pd (top, _mm256_sub_pd (_mm256_min_pd (sy, ey), ay));
+    right = _mm256_max_pd (right, _mm256_add_pd (_mm256_max_pd (sx, ex), ax));
+    bottom = _mm256_max_pd (bottom, _mm256_add_pd (_mm256_max_pd (sy, ey), ay));
+  }
+  for (k = k + 1; k < npoints; k++) {
+    scalar_segment_extents (&pts[k - 1], &pts[k], seg_trans, rect);
+  }
+
+  for (k = 0; k + 5 < npoints; k += 4) {
+    __m256d vpx, vpy, vxx, vxy, vnx, vny;
+    __m256d ux, uy, wx, wy, ox, oy, co, over, pointy, inner, tx, ty;
+
+    avx2_load (&pts[k], &vpx, &vpy);
+    avx2_load (&pts[k + 1], &vxx, &vxy);
+    avx2_load (&pts[k + 2], &vnx, &vny);
+
+    ux = _mm256_sub_pd (vxx, vpx);
+    uy = _mm256_sub_pd (vxy, vpy);
+    avx2_normalize (&ux, &uy);
+    wx = _mm256_sub_pd (vnx, vxx);
+    wy = _mm256_sub_pd (vny, vxy);
+    avx2_normalize (&wx, &wy);
+
+    co = _mm256_add_pd (_mm256_mul_pd (ux, wx), _mm256_mul_pd (uy, wy));
+    pointy = _mm256_cmp_pd (co, limit, _CMP_GT_OQ);
+    inner = _mm256_and_pd (_mm256_cmp_pd (co, minus_one, _CMP_GT_OQ),
+                           _mm256_cmp_pd (co, one, _CMP_LT_OQ));
+    over = _mm256_div_pd (jtrans,
+                          _mm256_sqrt_pd (_mm256_div_pd (_mm256_add_pd (one, co), two)));
+    over = avx2_blend (jtrans, over, inner);
+
+    ox = _mm256_sub_pd (ux, wx);
+    oy = _mm256_sub_pd (uy, wy);
+    avx2_normalize (&ox, &oy);
+    tx = avx2_blend (vxx, _mm256_add_pd (vxx, _mm256_mul_pd (ox, over)), pointy);
+    ty = avx2_blend (vxy, _mm256_add_pd (vxy, _mm256_mul_pd (oy, over)), pointy);
+
+    left = _mm256_min_pd (left, tx);
+    top = _mm256_min_pd (top, ty);
+    right = _mm256_max_pd (right, tx);
+    bottom = _mm256_max_pd (bottom, ty);
+  }
+  for (k = k + 1; k + 1 < npoints; k++) {
+    scalar_join_extents (&pts[k - 1], &pts[k], &pts[k + 1], join_trans, rect);
+  }
+
+  rect->left = MIN (rect->left, avx2_hmin (left));
+  rect->top = MIN (rect->top, avx2_hmin (top));
+  rect->right = MAX (rect->right, avx2_hmax (right));
+  rect->bottom = MAX (rect->bottom, avx2_hmax (bottom));
+}
+
+static const DiaGeometryKernels avx2_kernels = {
+  "avx2",
+  avx2_segments_distance,
+  avx2_polyline_extents,
+};
+
+#endif /* HAVE_X86_KERNELS */
+
+
+/**
+ * dia_geometry_kernels_list:
+ *
+ * All kernel implementations usable on this CPU, starting with the
+ * scalar reference and ordered by preference
+ *
+ * Returns: (transfer none): %NULL terminated array
+ *
+ * Since: 0.98
+ */
+const DiaGeometryKernels **
+dia_geometry_kernels_list (void)
+{
+  static const DiaGeometryKernels *list[4];
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    int n = 0;
+
+    list[n++] = &scalar_kernels;
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("sse2")) {
+      list[n++] = &sse2_kernels;
+    }
+    if (__builtin_cpu_supports ("avx2")) {
+      list[n++] = &avx2_kernels;
+    }
+#endif
+    list[n] = NULL;
+
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return list;
+}
+
+
+/**
+ * dia_geometry_kernels_get:
+ *
+ * The best kernels for this CPU. Setting DIA_GEOMETRY_KERNELS to the
+ * name of another supported implementation, e.g. "scalar", overrides
+ * the choice.
+ *
+ * Returns: (transfer none): the kernels to use
+ *
+ * Since: 0.98
+ */
+const DiaGeometryKernels *
+dia_geometry_kernels_get (void)
+{
+  static const DiaGeometryKernels *kernels = NULL;
+
+  if (g_once_init_enter (&kernels)) {
+    const DiaGeometryKernels **list = dia_geometry_kernels_list ();
+    const char *name = g_getenv ("DIA_GEOMETRY_KERNELS");
+    const DiaGeometryKernels *best = NULL;
+    int i;
+
+    for (i = 0; list[i] != NULL; i++) {
+      best = list[i];
+    }
+    for (i = 0; name && list[i] != NULL; i++) {
+      if (g_strcmp0 (list[i]->name, name) == 0) {
+        best = list[i];
+        break;
+      }
+    }
+
+    g_once_init_leave (&kernels, best);
+  }
+
+  return kernels;
+}
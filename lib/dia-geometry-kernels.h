@@ -0,0 +1,63 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "geometry.h"
+
+G_BEGIN_DECLS
+
+/**
+ * DiaGeometryKernels:
+ * @name: identifies the implementation, e.g. "scalar" or "avx2"
+ * @segments_distance: the minimum of distance_line_point() over the
+ *    segments of the polyline @pts. If @crossings is not %NULL it gets
+ *    incremented for every segment crossing the ray from (-Inf, point.y)
+ *    to @point
+ * @polyline_extents: grow @rect by every segment of @pts widened by
+ *    @seg_trans to both sides and by the miter overshoot of every inner
+ *    vertex given the @join_trans
+ *
+ * Batch versions of the geometry functions working on point arrays.
+ * Besides the scalar reference there are vectorized implementations,
+ * dia_geometry_kernels_get() picks the best one the CPU supports.
+ *
+ * Since: 0.98
+ */
+typedef struct _DiaGeometryKernels DiaGeometryKernels;
+struct _DiaGeometryKernels {
+  const char *name;
+
+  double (*segments_distance) (const Point  *pts,
+                               guint         npoints,
+                               double        line_width,
+                               const Point  *point,
+                               guint        *crossings);
+  void   (*polyline_extents)  (const Point  *pts,
+                               guint         npoints,
+                               double        seg_trans,
+                               double        join_trans,
+                               DiaRectangle *rect);
+};
+
+const DiaGeometryKernels  *dia_geometry_kernels_get        (void);
+const DiaGeometryKernels **dia_geometry_kernels_list       (void);
+
+G_END_DECLS
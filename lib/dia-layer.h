@@ -50,6 +50,8 @@ int          dia_layer_object_get_index                    (DiaLayer         *la
                                                             DiaObject        *obj);
 DiaObject   *dia_layer_object_get_nth                      (DiaLayer         *layer,
                                                             guint             index);
+DiaObject   *dia_layer_object_get_next                     (DiaLayer         *layer,
+                                                            DiaObject        *obj);
 int          dia_layer_object_count                        (DiaLayer         *layer);
 const char  *dia_layer_get_name                            (DiaLayer         *layer);
 void         dia_layer_add_object                          (DiaLayer         *layer,
@@ -65,6 +67,8 @@ void         dia_layer_remove_object                       (DiaLayer         *la
                                                             DiaObject        *obj);
 void         dia_layer_remove_objects                      (DiaLayer         *layer,
                                                             GList            *obj_list);
+GList       *dia_layer_sort_objects                        (DiaLayer         *layer,
+                                                            GList            *obj_list);
 GList       *dia_layer_find_objects_intersecting_rectangle (DiaLayer         *layer,
                                                             DiaRectangle     *rect);
 GList       *dia_layer_find_objects_in_rectangle           (DiaLayer         *layer,
@@ -0,0 +1,248 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include "dia-memory-usage.h"
+#include "object.h"
+#include "group.h"
+#include "diagramdata.h"
+#include "dia-layer.h"
+#include "dia_image.h"
+#include "font.h"
+
+/*
+ * Data shared between objects, e.g. images or fonts, is accounted to the
+ * first object using it. Objects in groups are accounted to their own
+ * type, the group only keeps what it holds itself.
+ */
+
+
+static void
+_item_free (gpointer data)
+{
+  DiaMemoryUsageItem *item = data;
+
+  g_clear_pointer (&item->name, g_free);
+  g_free (item);
+}
+
+
+static DiaMemoryUsageItem *
+_item_new (const char *name)
+{
+  DiaMemoryUsageItem *item = g_new0 (DiaMemoryUsageItem, 1);
+
+  item->name = g_strdup (name);
+
+  return item;
+}
+
+
+static void
+_add_to_type (DiaMemoryUsage      *usage,
+              GHashTable          *types,
+              const DiaObjectType *type,
+              gsize                size)
+{
+  DiaMemoryUsageItem *item = g_hash_table_lookup (types, type);
+
+  if (!item) {
+    item = _item_new (type->name);
+    g_hash_table_insert (types, (gpointer) type, item);
+    g_ptr_array_add (usage->types, item);
+  }
+  item->n_objects++;
+  item->size += size;
+}
+
+
+/* returns the size of @obj including its children */
+static gsize
+_add_object (DiaMemoryUsage *usage, GHashTable *types, DiaObject *obj)
+{
+  GList *list;
+  gsize children = 0;
+  gsize first = 0;
+  gsize size;
+
+  usage->n_objects++;
+
+  if (!IS_GROUP (obj)) {
+    size = dia_object_get_memory_size (obj, usage->shared);
+    _add_to_type (usage, types, obj->type, size);
+
+    return size;
+  }
+
+  for (list = group_objects (obj); list != NULL; list = g_list_next (list)) {
+    first += _add_object (usage, types, list->data);
+  }
+  /* with all shared data counted the remainder is the group itself */
+  for (list = group_objects (obj); list != NULL; list = g_list_next (list)) {
+    children += dia_object_get_memory_size (list->data, usage->shared);
+  }
+  size = dia_object_get_memory_size (obj, usage->shared);
+  size = size > children ? size - children : 0;
+  _add_to_type (usage, types, obj->type, size);
+
+  return first + size;
+}
+
+
+static int
+_cmp_size (gconstpointer a, gconstpointer b)
+{
+  const DiaMemoryUsageItem *ia = *(DiaMemoryUsageItem **) a;
+  const DiaMemoryUsageItem *ib = *(DiaMemoryUsageItem **) b;
+
+  return ia->size < ib->size ? 1 : (ia->size > ib->size ? -1 : 0);
+}
+
+
+/**
+ * dia_memory_usage_new:
+ * @data: the diagram
+ *
+ * Measure the memory used by the objects of @data, by layer and by
+ * object type. Shared data is counted once, for the first object using it.
+ *
+ * Returns: (transfer full): the #DiaMemoryUsage, free with
+ *          dia_memory_usage_free()
+ *
+ * Since: 0.98
+ */
+DiaMemoryUsage *
+dia_memory_usage_new (DiagramData *data)
+{
+  DiaMemoryUsage *usage;
+  GHashTable *types;
+
+  g_return_val_if_fail (DIA_IS_DIAGRAM_DATA (data), NULL);
+
+  usage = g_new0 (DiaMemoryUsage, 1);
+  usage->layers = g_ptr_array_new_with_free_func (_item_free);
+  usage->types = g_ptr_array_new_with_free_func (_item_free);
+  usage->shared = g_hash_table_new (g_direct_hash, g_direct_equal);
+  /* the items are owned by usage->types */
+  types = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  DIA_FOR_LAYER_IN_DIAGRAM (data, layer, l, {
+    DiaMemoryUsageItem *item = _item_new (dia_layer_get_name (layer));
+    guint n_objects = usage->n_objects;
+    GList *list;
+
+    for (list = dia_layer_get_object_list (layer);
+         list != NULL;
+         list = g_list_next (list)) {
+      item->size += sizeof (GList) + _add_object (usage, types, list->data);
+    }
+    item->n_objects = usage->n_objects - n_objects;
+    usage->total += item->size;
+    g_ptr_array_add (usage->layers, item);
+  });
+
+  g_ptr_array_sort (usage->types, _cmp_size);
+  g_hash_table_destroy (types);
+
+  return usage;
+}
+
+
+/**
+ * dia_memory_usage_free:
+ * @usage: (transfer full): the #DiaMemoryUsage
+ *
+ * Since: 0.98
+ */
+void
+dia_memory_usage_free (DiaMemoryUsage *usage)
+{
+  if (!usage) {
+    return;
+  }
+
+  g_clear_pointer (&usage->layers, g_ptr_array_unref);
+  g_clear_pointer (&usage->types, g_ptr_array_unref);
+  g_clear_pointer (&usage->shared, g_hash_table_destroy);
+  g_free (usage);
+}
+
+
+static void
+_append_items (GString *report, const char *title, GPtrArray *items)
+{
+  guint i;
+
+  g_string_append_printf (report, "\n%s:\n", title);
+  for (i = 0; i < items->len; i++) {
+    DiaMemoryUsageItem *item = g_ptr_array_index (items, i);
+    char *size = g_format_size (item->size);
+
+    g_string_append_printf (report, "  %-32s %8u objects %12s\n",
+                            item->name ? item->name : "",
+                            item->n_objects,
+                            size);
+    g_free (size);
+  }
+}
+
+
+/**
+ * dia_memory_usage_to_string:
+ * @usage: the #DiaMemoryUsage
+ *
+ * A readable report of @usage, followed by the caches shared by all
+ * diagrams.
+ *
+ * Returns: (transfer full): the report, free with g_free()
+ *
+ * Since: 0.98
+ */
+char *
+dia_memory_usage_to_string (DiaMemoryUsage *usage)
+{
+  GString *report;
+  char *size;
+
+  g_return_val_if_fail (usage != NULL, NULL);
+
+  report = g_string_new (NULL);
+
+  size = g_format_size (usage->total);
+  g_string_append_printf (report, "Objects: %u, %s\n", usage->n_objects, size);
+  g_free (size);
+  if (usage->undo > 0) {
+    size = g_format_size (usage->undo);
+    g_string_append_printf (report, "Undo: %s\n", size);
+    g_free (size);
+  }
+
+  _append_items (report, "Layers", usage->layers);
+  _append_items (report, "Object types", usage->types);
+
+  g_string_append (report, "\nShared by all diagrams:\n");
+  size = g_format_size (dia_font_sizes_cache_get_memory_size ());
+  g_string_append_printf (report, "  %-32s %16s %12s\n", "font measurements", "", size);
+  g_free (size);
+  size = g_format_size (dia_image_get_cache_size ());
+  g_string_append_printf (report, "  %-32s %16s %12s\n", "scaled images", "", size);
+  g_free (size);
+
+  return g_string_free (report, FALSE);
+}
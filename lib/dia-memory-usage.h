@@ -0,0 +1,72 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "diatypes.h"
+
+G_BEGIN_DECLS
+
+/**
+ * DiaMemoryUsageItem:
+ * @name: the layer or object type
+ * @n_objects: number of objects, including the ones in groups
+ * @size: memory used, in bytes
+ *
+ * Since: 0.98
+ */
+typedef struct _DiaMemoryUsageItem DiaMemoryUsageItem;
+struct _DiaMemoryUsageItem {
+  char  *name;
+  guint  n_objects;
+  gsize  size;
+};
+
+/**
+ * DiaMemoryUsage:
+ * @total: memory used by the objects of all layers, in bytes
+ * @n_objects: number of objects, including the ones in groups
+ * @layers: (element-type DiaMemoryUsageItem): by layer, bottom first
+ * @types: (element-type DiaMemoryUsageItem): by object type, the
+ *         biggest first
+ * @undo: memory used by the undo stack, filled in by the application
+ * @shared: the shared data counted so far, see dia_object_get_memory_size()
+ *
+ * Where the memory of a diagram goes, see dia_memory_usage_new()
+ *
+ * Since: 0.98
+ */
+typedef struct _DiaMemoryUsage DiaMemoryUsage;
+struct _DiaMemoryUsage {
+  gsize       total;
+  guint       n_objects;
+  GPtrArray  *layers;
+  GPtrArray  *types;
+  gsize       undo;
+  GHashTable *shared;
+};
+
+DiaMemoryUsage *dia_memory_usage_new       (DiagramData    *data);
+void            dia_memory_usage_free      (DiaMemoryUsage *usage);
+char           *dia_memory_usage_to_string (DiaMemoryUsage *usage);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DiaMemoryUsage, dia_memory_usage_free)
+
+G_END_DECLS
@@ -0,0 +1,271 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include "dia-object-profile.h"
+#include "object.h"
+#include "group.h"
+#include "diagramdata.h"
+#include "dia-layer.h"
+
+/*
+ * Calls and time of the object operations, by object type. Objects may be
+ * drawn from several threads, so the counters are locked; without
+ * counting the operations only pay for a check of the flag.
+ */
+
+typedef struct _ProfileCounters {
+  const DiaObjectType *type;
+  guint64              calls[DIA_OBJECT_PROFILE_N_OPS];
+  gint64               usec[DIA_OBJECT_PROFILE_N_OPS];
+  gint64               total;
+  int                  objects; /* in the reported diagram */
+} ProfileCounters;
+
+static const char *op_names[DIA_OBJECT_PROFILE_N_OPS] = {
+  "draw",
+  "distance",
+  "move",
+  "move handle",
+  "update",
+};
+
+static gboolean profile_enabled = FALSE;
+static GHashTable *profile_counters = NULL;
+G_LOCK_DEFINE_STATIC (profile);
+
+
+static gboolean
+_profile_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    const char *env = g_getenv ("DIA_OBJECT_PROFILE");
+
+    if (env && *env && g_strcmp0 (env, "0") != 0) {
+      profile_enabled = TRUE;
+    }
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return profile_enabled;
+}
+
+
+/**
+ * dia_object_profile_enabled:
+ *
+ * Counting is switched on by setting DIA_OBJECT_PROFILE or with
+ * dia_object_profile_set_enabled()
+ *
+ * Returns: %TRUE if object operations get counted
+ *
+ * Since: 0.98
+ */
+gboolean
+dia_object_profile_enabled (void)
+{
+  return _profile_init ();
+}
+
+
+/**
+ * dia_object_profile_set_enabled:
+ * @enabled: whether to count
+ *
+ * Start or stop counting, the counters are kept
+ *
+ * Since: 0.98
+ */
+void
+dia_object_profile_set_enabled (gboolean enabled)
+{
+  _profile_init ();
+  profile_enabled = enabled;
+}
+
+
+/**
+ * dia_object_profile_add:
+ * @type: the #DiaObjectType of the object
+ * @op: what it did
+ * @start: from DIA_OBJECT_PROFILE_BEGIN()
+ *
+ * Count an operation ending now. Does nothing for a @start of 0, i.e.
+ * when counting was off at the beginning.
+ *
+ * |[<!-- language="C" -->
+ * gint64 start = DIA_OBJECT_PROFILE_BEGIN ();
+ *
+ * self->ops->draw (self, renderer);
+ * dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_DRAW, start);
+ * ]|
+ *
+ * Since: 0.98
+ */
+void
+dia_object_profile_add (const DiaObjectType *type,
+                        DiaObjectProfileOp   op,
+                        gint64               start)
+{
+  gint64 usec;
+  ProfileCounters *counters;
+
+  if (start == 0 || !type) {
+    return;
+  }
+  g_return_if_fail (op < DIA_OBJECT_PROFILE_N_OPS);
+
+  usec = g_get_monotonic_time () - start;
+
+  G_LOCK (profile);
+  if (!profile_counters) {
+    profile_counters = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, g_free);
+  }
+  counters = g_hash_table_lookup (profile_counters, type);
+  if (!counters) {
+    counters = g_new0 (ProfileCounters, 1);
+    counters->type = type;
+    g_hash_table_insert (profile_counters, (gpointer) type, counters);
+  }
+  counters->calls[op]++;
+  counters->usec[op] += usec;
+  G_UNLOCK (profile);
+}
+
+
+/**
+ * dia_object_profile_reset:
+ *
+ * Forget everything counted so far
+ *
+ * Since: 0.98
+ */
+void
+dia_object_profile_reset (void)
+{
+  G_LOCK (profile);
+  if (profile_counters) {
+    g_hash_table_remove_all (profile_counters);
+  }
+  G_UNLOCK (profile);
+}
+
+
+static void
+_count_objects (GHashTable *objects, GList *list)
+{
+  for (; list != NULL; list = g_list_next (list)) {
+    DiaObject *obj = list->data;
+    int n = GPOINTER_TO_INT (g_hash_table_lookup (objects, obj->type));
+
+    g_hash_table_insert (objects, obj->type, GINT_TO_POINTER (n + 1));
+    if (IS_GROUP (obj)) {
+      _count_objects (objects, group_objects (obj));
+    }
+  }
+}
+
+
+static int
+_cmp_total (gconstpointer a, gconstpointer b)
+{
+  const ProfileCounters *ca = *(ProfileCounters **) a;
+  const ProfileCounters *cb = *(ProfileCounters **) b;
+
+  return ca->total < cb->total ? 1 : (ca->total > cb->total ? -1 : 0);
+}
+
+
+/**
+ * dia_object_profile_report:
+ * @data: (nullable): the diagram to count the objects of
+ *
+ * A readable report of the counters, the most expensive object type
+ * first. Times of objects containing others, e.g. groups, include the
+ * time of their children.
+ *
+ * Returns: (transfer full): the report, free with g_free()
+ *
+ * Since: 0.98
+ */
+char *
+dia_object_profile_report (DiagramData *data)
+{
+  GHashTable *objects = g_hash_table_new (g_direct_hash, g_direct_equal);
+  GPtrArray *sorted = g_ptr_array_new_with_free_func (g_free);
+  GString *report = g_string_new (NULL);
+  GHashTableIter iter;
+  ProfileCounters *counters;
+  guint i;
+  int op;
+
+  if (data) {
+    DIA_FOR_LAYER_IN_DIAGRAM (data, layer, l, {
+      _count_objects (objects, dia_layer_get_object_list (layer));
+    });
+  }
+
+  /* a snapshot, drawing may go on meanwhile */
+  G_LOCK (profile);
+  if (profile_counters) {
+    g_hash_table_iter_init (&iter, profile_counters);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &counters)) {
+      ProfileCounters *copy = g_memdup2 (counters, sizeof (ProfileCounters));
+
+      copy->total = 0;
+      for (op = 0; op < DIA_OBJECT_PROFILE_N_OPS; op++) {
+        copy->total += copy->usec[op];
+      }
+      copy->objects = GPOINTER_TO_INT (g_hash_table_lookup (objects, copy->type));
+      g_ptr_array_add (sorted, copy);
+    }
+  }
+  G_UNLOCK (profile);
+
+  g_ptr_array_sort (sorted, _cmp_total);
+
+  if (sorted->len == 0) {
+    g_string_append (report, "Nothing counted yet.\n");
+  }
+  for (i = 0; i < sorted->len; i++) {
+    counters = g_ptr_array_index (sorted, i);
+
+    g_string_append_printf (report, "%s: %d objects, %.1f ms\n",
+                            counters->type->name,
+                            counters->objects,
+                            counters->total / 1000.0);
+    for (op = 0; op < DIA_OBJECT_PROFILE_N_OPS; op++) {
+      if (counters->calls[op] == 0) {
+        continue;
+      }
+      g_string_append_printf (report, "  %-12s %10" G_GUINT64_FORMAT " calls %10.1f ms\n",
+                              op_names[op],
+                              counters->calls[op],
+                              counters->usec[op] / 1000.0);
+    }
+  }
+
+  g_ptr_array_unref (sorted);
+  g_hash_table_destroy (objects);
+
+  return g_string_free (report, FALSE);
+}
@@ -0,0 +1,60 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "diatypes.h"
+
+G_BEGIN_DECLS
+
+/**
+ * DiaObjectProfileOp:
+ * @DIA_OBJECT_PROFILE_DRAW: dia_object_draw()
+ * @DIA_OBJECT_PROFILE_DISTANCE: dia_object_distance_from()
+ * @DIA_OBJECT_PROFILE_MOVE: dia_object_move()
+ * @DIA_OBJECT_PROFILE_MOVE_HANDLE: dia_object_move_handle()
+ * @DIA_OBJECT_PROFILE_UPDATE: setting properties, editing text, transforming
+ *
+ * The object operations counted per #DiaObjectType
+ *
+ * Since: 0.98
+ */
+typedef enum {
+  DIA_OBJECT_PROFILE_DRAW,
+  DIA_OBJECT_PROFILE_DISTANCE,
+  DIA_OBJECT_PROFILE_MOVE,
+  DIA_OBJECT_PROFILE_MOVE_HANDLE,
+  DIA_OBJECT_PROFILE_UPDATE,
+  DIA_OBJECT_PROFILE_N_OPS
+} DiaObjectProfileOp;
+
+gboolean dia_object_profile_enabled     (void);
+void     dia_object_profile_set_enabled (gboolean             enabled);
+void     dia_object_profile_add         (const DiaObjectType *type,
+                                         DiaObjectProfileOp   op,
+                                         gint64               start);
+void     dia_object_profile_reset       (void);
+char    *dia_object_profile_report      (DiagramData         *data);
+
+/* the start for dia_object_profile_add(), 0 when not counting */
+#define DIA_OBJECT_PROFILE_BEGIN() \
+  (dia_object_profile_enabled () ? g_get_monotonic_time () : 0)
+
+G_END_DECLS
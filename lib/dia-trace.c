@@ -0,0 +1,236 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib/gstdio.h>
+
+#include "dia-trace.h"
+
+/*
+ * Spans are written as complete events ("ph":"X") of the Chrome trace
+ * event format, which chrome://tracing and https://ui.perfetto.dev load.
+ * The array is closed on exit, both viewers accept a file cut short by
+ * a crash as well.
+ */
+
+static FILE *trace_file = NULL;
+static gint64 trace_epoch = 0;
+static GMutex trace_lock;
+static GPrivate trace_tid;
+static int trace_next_tid = 0;
+
+
+static void
+_trace_close (void)
+{
+  g_mutex_lock (&trace_lock);
+  if (trace_file) {
+    fputs ("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+           "\"args\":{\"name\":\"Dia\"}}\n]\n", trace_file);
+    fclose (trace_file);
+    trace_file = NULL;
+  }
+  g_mutex_unlock (&trace_lock);
+}
+
+
+static gboolean
+_trace_init (void)
+{
+  static gsize initialized = 0;
+  static gboolean enabled = FALSE;
+
+  if (g_once_init_enter (&initialized)) {
+    const char *filename = g_getenv ("DIA_TRACE");
+
+    if (filename && *filename) {
+      trace_file = g_fopen (filename, "w");
+      if (trace_file) {
+        fputs ("[\n", trace_file);
+        trace_epoch = g_get_monotonic_time ();
+        atexit (_trace_close);
+        enabled = TRUE;
+      } else {
+        g_warning ("Can't open trace file '%s'", filename);
+      }
+    }
+
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return enabled;
+}
+
+
+static int
+_trace_thread_id (void)
+{
+  int tid = GPOINTER_TO_INT (g_private_get (&trace_tid));
+
+  if (tid == 0) {
+    tid = g_atomic_int_add (&trace_next_tid, 1) + 1;
+    g_private_set (&trace_tid, GINT_TO_POINTER (tid));
+  }
+
+  return tid;
+}
+
+
+static void
+_trace_write_string (GString *buf, const char *str)
+{
+  const char *p;
+
+  g_string_append_c (buf, '"');
+  for (p = str; *p; p++) {
+    if (*p == '"' || *p == '\\') {
+      g_string_append_c (buf, '\\');
+      g_string_append_c (buf, *p);
+    } else if ((guchar) *p < 0x20) {
+      g_string_append_printf (buf, "\\u%04x", (guchar) *p);
+    } else {
+      g_string_append_c (buf, *p);
+    }
+  }
+  g_string_append_c (buf, '"');
+}
+
+
+/**
+ * dia_trace_enabled:
+ *
+ * Tracing is switched on by setting DIA_TRACE to the name of the file
+ * receiving the trace
+ *
+ * Returns: %TRUE if spans get recorded
+ *
+ * Since: 0.98
+ */
+gboolean
+dia_trace_enabled (void)
+{
+  return _trace_init ();
+}
+
+
+/**
+ * dia_trace_begin:
+ *
+ * Start a span, to be finished with dia_trace_end(). Without tracing
+ * this is not much more than a function call.
+ *
+ * |[<!-- language="C" -->
+ * gint64 span = dia_trace_begin ();
+ *
+ * do_the_work ();
+ *
+ * dia_trace_end (span, DIA_TRACE_LOAD, "work", filename);
+ * ]|
+ *
+ * Returns: the span start, 0 if tracing is disabled
+ *
+ * Since: 0.98
+ */
+gint64
+dia_trace_begin (void)
+{
+  if (G_LIKELY (!_trace_init ())) {
+    return 0;
+  }
+
+  return g_get_monotonic_time ();
+}
+
+
+/**
+ * dia_trace_end:
+ * @start: the value returned by dia_trace_begin()
+ * @category: one of the DIA_TRACE_* categories
+ * @name: what was done, e.g. the object type
+ * @detail: (nullable): additional information, e.g. the file name
+ *
+ * Finish a span and write it to the trace
+ *
+ * Since: 0.98
+ */
+void
+dia_trace_end (gint64      start,
+               const char *category,
+               const char *name,
+               const char *detail)
+{
+  gint64 end;
+  GString *buf;
+
+  if (G_LIKELY (start == 0)) {
+    return;
+  }
+
+  end = g_get_monotonic_time ();
+
+  buf = g_string_sized_new (128);
+  g_string_append (buf, "{\"name\":");
+  _trace_write_string (buf, name ? name : "?");
+  g_string_append (buf, ",\"cat\":");
+  _trace_write_string (buf, category);
+  g_string_append_printf (buf,
+                          ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+                          ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":%d",
+                          start - trace_epoch,
+                          end - start,
+                          _trace_thread_id ());
+  if (detail) {
+    g_string_append (buf, ",\"args\":{\"detail\":");
+    _trace_write_string (buf, detail);
+    g_string_append_c (buf, '}');
+  }
+  g_string_append (buf, "},\n");
+
+  g_mutex_lock (&trace_lock);
+  if (trace_file) {
+    fwrite (buf->str, 1, buf->len, trace_file);
+  }
+  g_mutex_unlock (&trace_lock);
+
+  g_string_free (buf, TRUE);
+}
+
+
+/**
+ * dia_trace_flush:
+ *
+ * Make sure everything recorded so far is in the trace file
+ *
+ * Since: 0.98
+ */
+void
+dia_trace_flush (void)
+{
+  if (!_trace_init ()) {
+    return;
+  }
+
+  g_mutex_lock (&trace_lock);
+  if (trace_file) {
+    fflush (trace_file);
+  }
+  g_mutex_unlock (&trace_lock);
+}
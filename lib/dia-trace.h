@@ -0,0 +1,43 @@
+/* Dia -- an diagram creation/manipulation program
+ * Copyright (C) 1998 Alexander Larsson
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Span categories, so the trace viewers can filter on them
+ */
+#define DIA_TRACE_LOAD    "load"
+#define DIA_TRACE_SAVE    "save"
+#define DIA_TRACE_RENDER  "render"
+#define DIA_TRACE_TEXT    "text"
+#define DIA_TRACE_EDIT    "edit"
+#define DIA_TRACE_EXPORT  "export"
+
+gboolean dia_trace_enabled (void);
+gint64   dia_trace_begin   (void);
+void     dia_trace_end     (gint64      start,
+                            const char *category,
+                            const char *name,
+                            const char *detail);
+void     dia_trace_flush   (void);
+
+G_END_DECLS
@@ -21,6 +21,8 @@
 #include <glib/gi18n-lib.h>
 
 #include <string.h> /* memmove */
+#include <math.h>
+#include <glib/gstdio.h>
 
 #include "geometry.h"
 #include "dia_image.h"
@@ -41,6 +43,27 @@
  *
  * \ingroup ObjectParts
  */
+typedef struct _DiaImageLevel DiaImageLevel;
+typedef struct _DiaImageDecode DiaImageDecode;
+
+/*
+ * One level of the mipmap pyramid: the image downsampled by 2^level.
+ *
+ * The struct lives as long as its image, only the pixel data is
+ * dropped again when the global cache budget is exceeded.
+ */
+struct _DiaImageLevel {
+  DiaImage        *owner;
+  int              level;
+  int              width;
+  int              height;
+  GdkPixbuf       *pixbuf;
+  cairo_surface_t *surface;
+  gsize            bytes;   /* accounted in mipmap_cache_size */
+  GList            lru;     /* link in mipmap_lru, data is the level */
+  gboolean         pending; /* queued for a worker */
+};
+
 struct _DiaImage {
   GObject parent_instance;
   GdkPixbuf *image;
@@ -49,17 +72,151 @@ struct _DiaImage {
   GdkPixbuf *scaled; /* a cache of the last scaled version */
   int scaled_width, scaled_height;
   cairo_surface_t *surface;
+  char *store_key; /* set if this is the shared instance, see dia_image_intern() */
+  DiaImageLevel **levels; /* mipmap pyramid, [0] is unused (the image itself) */
+  int n_levels;
+  DiaImageDecode *decode; /* set while the pixbuf is not decoded yet */
+};
+
+
+typedef enum {
+  DECODE_QUEUED,
+  DECODE_RUNNING,
+  DECODE_DONE,
+} DiaImageDecodeState;
+
+/*
+ * A pending decode, see dia_image_new_deferred(). The job is reference
+ * counted (g_atomic_rc_box) because the pool, a waiter stealing it and
+ * the notification in the main context all need it.
+ */
+struct _DiaImageDecode {
+  DiaImage            *image; /* owned, keeps the image alive until decoded */
+  DiaImageDecodeFunc   func;
+  gpointer             data;
+  GDestroyNotify       destroy;
+  DiaImageDecodeState  state; /* protected by decode_lock */
+  GError              *error;
+};
+
+
+enum {
+  READY,
+  LEVEL_READY,
+  LAST_SIGNAL
 };
 
+static guint signals[LAST_SIGNAL] = { 0 };
+
+
+/*
+ * The image store: content key -> GWeakRef (DiaImage)
+ *
+ * Only the canonical instance for a given content is registered, so
+ * every object showing the same picture shares the pixbuf and the
+ * scaled/surface caches. Entries don't keep the image alive.
+ */
+G_LOCK_DEFINE_STATIC (image_store);
+static GHashTable *image_store = NULL;
+
+
+/*
+ * The mipmap cache: all generated levels of all images in LRU order
+ * (most recent at the head) sharing one memory budget.
+ */
+G_LOCK_DEFINE_STATIC (mipmap);
+static GQueue       mipmap_lru = G_QUEUE_INIT;
+static gsize        mipmap_cache_size = 0;
+static gsize        mipmap_cache_budget = 64 * 1024 * 1024;
+static gboolean     mipmap_async = FALSE;
+static GThreadPool *mipmap_pool = NULL;
+
+
+/*
+ * Deferred decoding: decode_cond is signalled whenever a job is done.
+ */
+static GMutex       decode_lock;
+static GCond        decode_cond;
+static gboolean     decode_async = FALSE;
+static GThreadPool *decode_pool = NULL;
+
+
+static void
+_weak_ref_free (GWeakRef *ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
+
 
 G_DEFINE_TYPE (DiaImage, dia_image, G_TYPE_OBJECT)
 
 
+static void
+_dia_image_unregister (DiaImage *image)
+{
+  GWeakRef *ref;
+
+  if (!image->store_key) {
+    return;
+  }
+
+  G_LOCK (image_store);
+  ref = g_hash_table_lookup (image_store, image->store_key);
+  if (ref) {
+    DiaImage *other = g_weak_ref_get (ref);
+
+    /* a new instance might have been registered since we died */
+    if (other == NULL || other == image) {
+      g_hash_table_remove (image_store, image->store_key);
+    }
+    g_clear_object (&other);
+  }
+  G_UNLOCK (image_store);
+
+  g_clear_pointer (&image->store_key, g_free);
+}
+
+
+/* with the mipmap lock held */
+static void
+_dia_image_level_clear (DiaImageLevel *level)
+{
+  g_clear_object (&level->pixbuf);
+  g_clear_pointer (&level->surface, cairo_surface_destroy);
+  mipmap_cache_size -= level->bytes;
+  level->bytes = 0;
+  if (level->lru.data) {
+    g_queue_unlink (&mipmap_lru, &level->lru);
+    level->lru.data = NULL;
+  }
+}
+
+
+static void
+_dia_image_free_levels (DiaImage *image)
+{
+  G_LOCK (mipmap);
+  for (int i = 1; i < image->n_levels; ++i) {
+    if (image->levels[i]) {
+      _dia_image_level_clear (image->levels[i]);
+      g_free (image->levels[i]);
+    }
+  }
+  g_clear_pointer (&image->levels, g_free);
+  image->n_levels = 0;
+  G_UNLOCK (mipmap);
+}
+
+
 static void
 dia_image_finalize (GObject *object)
 {
   DiaImage *image = DIA_IMAGE (object);
 
+  _dia_image_unregister (image);
+  _dia_image_free_levels (image);
+
   g_clear_object (&image->scaled);
   g_clear_object (&image->image);
 
@@ -68,6 +225,8 @@ dia_image_finalize (GObject *object)
 
   cairo_surface_destroy (image->surface);
   image->surface = NULL;
+
+  G_OBJECT_CLASS (dia_image_parent_class)->finalize (object);
 }
 
 
@@ -77,6 +236,37 @@ dia_image_class_init (DiaImageClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->finalize = dia_image_finalize;
+
+  /**
+   * DiaImage::ready:
+   * @image: the #DiaImage
+   *
+   * Emitted in the main context when a deferred image got its pixels,
+   * see dia_image_new_deferred()
+   */
+  signals[READY] = g_signal_new ("ready",
+                                 G_TYPE_FROM_CLASS (klass),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL,
+                                 g_cclosure_marshal_VOID__VOID,
+                                 G_TYPE_NONE, 0);
+
+  /**
+   * DiaImage::level-ready:
+   * @image: the #DiaImage
+   *
+   * Emitted in the main context when a mipmap level built in the
+   * background is done, see dia_image_set_mipmap_async(). Whoever drew
+   * the image with a finer level in the meantime should draw it again.
+   */
+  signals[LEVEL_READY] = g_signal_new ("level-ready",
+                                       G_TYPE_FROM_CLASS (klass),
+                                       G_SIGNAL_RUN_LAST,
+                                       0,
+                                       NULL, NULL,
+                                       g_cclosure_marshal_VOID__VOID,
+                                       G_TYPE_NONE, 0);
 }
 
 
@@ -92,6 +282,21 @@ dia_image_init (DiaImage *image)
   image->surface = NULL;
 }
 
+static GdkPixbuf *
+_dia_image_broken_pixbuf (void)
+{
+  static GdkPixbuf *broken = NULL;
+
+  /* also needed by the decode workers */
+  if (g_once_init_enter (&broken)) {
+    g_once_init_leave (&broken,
+                       pixbuf_from_resource ("/org/gnome/Dia/broken-image.png"));
+  }
+
+  return broken;
+}
+
+
 /*!
  * \brief Constructor of a 'broken' image
  * Get the image to put in place of a image that cannot be read.
@@ -101,14 +306,10 @@ dia_image_init (DiaImage *image)
 DiaImage *
 dia_image_get_broken (void)
 {
-  static GdkPixbuf *broken = NULL;
   DiaImage *image;
 
   image = DIA_IMAGE (g_object_new (DIA_TYPE_IMAGE, NULL));
-  if (broken == NULL) {
-    broken = pixbuf_from_resource ("/org/gnome/Dia/broken-image.png");
-  }
-  image->image = g_object_ref (broken);
+  image->image = g_object_ref (_dia_image_broken_pixbuf ());
   /* Kinda hard to export :) */
   image->filename = g_strdup("<broken>");
   image->scaled = NULL;
@@ -184,6 +385,259 @@ dia_image_new_from_pixbuf (GdkPixbuf *pixbuf)
   return dia_img;
 }
 
+
+static void
+_dia_image_decode_free (gpointer data)
+{
+  DiaImageDecode *job = data;
+
+  if (job->destroy) {
+    job->destroy (job->data);
+  }
+  g_clear_error (&job->error);
+  g_clear_object (&job->image);
+}
+
+
+static void
+_dia_image_decode_release (gpointer data)
+{
+  g_atomic_rc_box_release_full (data, _dia_image_decode_free);
+}
+
+
+/* in the main context */
+static gboolean
+_dia_image_decode_done (gpointer data)
+{
+  DiaImageDecode *job = data;
+
+  if (job->error) {
+    message_warning ("%s\n", job->error->message);
+  }
+  g_signal_emit (job->image, signals[READY], 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+/* decode in the calling thread, the caller moved the job to DECODE_RUNNING */
+static void
+_dia_image_decode_run (DiaImageDecode *job)
+{
+  DiaImage *image = job->image;
+  GdkPixbuf *pixbuf;
+
+  pixbuf = job->func (job->data, &job->error);
+  if (!pixbuf) {
+    pixbuf = g_object_ref (_dia_image_broken_pixbuf ());
+  }
+
+  g_mutex_lock (&decode_lock);
+  image->image = pixbuf;
+  if (!image->mime_type) {
+    image->mime_type = g_strdup (g_object_get_data (G_OBJECT (pixbuf),
+                                                    "mime-type"));
+  }
+  job->state = DECODE_DONE;
+  /* publishes image->image to the lock-free check in _dia_image_wait() */
+  g_atomic_pointer_set (&image->decode, NULL);
+  g_cond_broadcast (&decode_cond);
+  g_mutex_unlock (&decode_lock);
+
+  if (decode_async) {
+    /* never synchronous, a waiter might be in the middle of drawing */
+    g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                     _dia_image_decode_done,
+                     g_atomic_rc_box_acquire (job),
+                     _dia_image_decode_release);
+  } else if (job->error) {
+    message_warning ("%s\n", job->error->message);
+  }
+}
+
+
+static void
+_dia_image_decode_worker (gpointer data, gpointer user_data)
+{
+  DiaImageDecode *job = data;
+  gboolean run;
+
+  g_mutex_lock (&decode_lock);
+  /* maybe a waiter took it over already */
+  run = job->state == DECODE_QUEUED;
+  if (run) {
+    job->state = DECODE_RUNNING;
+  }
+  g_mutex_unlock (&decode_lock);
+
+  if (run) {
+    _dia_image_decode_run (job);
+  }
+
+  /* the reference of the pool */
+  _dia_image_decode_release (job);
+}
+
+
+/*
+ * Block until the pixels of a deferred image are there. A job still in
+ * the queue is decoded right here instead of waiting for a free worker.
+ */
+static void
+_dia_image_wait (const DiaImage *image)
+{
+  DiaImage *self = (DiaImage *) image;
+  DiaImageDecode *job;
+
+  if (G_LIKELY (g_atomic_pointer_get (&self->decode) == NULL)) {
+    return;
+  }
+
+  g_mutex_lock (&decode_lock);
+  job = self->decode;
+  if (job && job->state == DECODE_QUEUED) {
+    job->state = DECODE_RUNNING;
+    g_mutex_unlock (&decode_lock);
+    _dia_image_decode_run (job);
+    return;
+  }
+  while (self->decode) {
+    g_cond_wait (&decode_cond, &decode_lock);
+  }
+  g_mutex_unlock (&decode_lock);
+}
+
+
+/**
+ * dia_image_new_deferred:
+ * @func: decodes the pixels, called once from any thread
+ * @data: passed to @func
+ * @destroy: (nullable): frees @data when done
+ * @filename: (nullable): the filename of the image
+ * @mime_type: (nullable): the mime-type if already known
+ *
+ * Create an image whose pixels are decoded by a worker thread. Loading a
+ * diagram full of large pictures this way returns as soon as the XML is
+ * parsed, the pictures come in while the diagram is already shown.
+ *
+ * Until dia_image_is_ready() every access to the pixels blocks for them,
+ * so the image is usable anywhere. Code drawing on screen should check
+ * dia_image_is_ready() and show a placeholder until #DiaImage::ready.
+ * If @func fails the broken image is used and its #GError is reported.
+ *
+ * Without dia_image_set_decode_async() the image is decoded right away.
+ *
+ * Returns: (transfer full): a new #DiaImage
+ */
+DiaImage *
+dia_image_new_deferred (DiaImageDecodeFunc  func,
+                        gpointer            data,
+                        GDestroyNotify      destroy,
+                        const char         *filename,
+                        const char         *mime_type)
+{
+  DiaImage *image;
+  DiaImageDecode *job;
+
+  image = DIA_IMAGE (g_object_new (DIA_TYPE_IMAGE, NULL));
+  image->filename = g_strdup (filename);
+  image->mime_type = g_strdup (mime_type);
+
+  job = g_atomic_rc_box_new0 (DiaImageDecode);
+  job->image = g_object_ref (image);
+  job->func = func;
+  job->data = data;
+  job->destroy = destroy;
+
+  if (!decode_async) {
+    job->state = DECODE_RUNNING;
+    image->decode = job;
+    _dia_image_decode_run (job);
+    _dia_image_decode_release (job);
+
+    return image;
+  }
+
+  g_mutex_lock (&decode_lock);
+  if (!decode_pool) {
+    decode_pool = g_thread_pool_new (_dia_image_decode_worker, NULL,
+                                     g_get_num_processors (),
+                                     FALSE, NULL);
+  }
+  job->state = DECODE_QUEUED;
+  image->decode = job;
+  g_mutex_unlock (&decode_lock);
+
+  /* the job reference is handed to the pool */
+  g_thread_pool_push (decode_pool, job, NULL);
+
+  return image;
+}
+
+
+static GdkPixbuf *
+_dia_image_decode_file (gpointer data, GError **error)
+{
+  const char *filename = data;
+  GdkPixbuf *pixbuf;
+
+  pixbuf = gdk_pixbuf_new_from_file (filename, error);
+  /* like dia_image_load() don't complain about a missing file */
+  if (!pixbuf && !g_file_test (filename, G_FILE_TEST_EXISTS)) {
+    g_clear_error (error);
+  }
+
+  return pixbuf;
+}
+
+
+/**
+ * dia_image_set_decode_async:
+ * @async: whether dia_image_new_deferred() uses worker threads
+ *
+ * Needs a main loop running for #DiaImage::ready to be emitted, so it is
+ * only enabled for interactive use.
+ */
+void
+dia_image_set_decode_async (gboolean async)
+{
+  decode_async = async;
+}
+
+
+/**
+ * dia_image_is_ready:
+ * @image: the #DiaImage
+ *
+ * Returns: %FALSE while a deferred image is still decoded
+ */
+gboolean
+dia_image_is_ready (const DiaImage *image)
+{
+  g_return_val_if_fail (DIA_IS_IMAGE (image), TRUE);
+
+  return g_atomic_pointer_get (&((DiaImage *) image)->decode) == NULL;
+}
+
+/**
+ * dia_image_is_broken:
+ * @image: the #DiaImage
+ *
+ * Waits for a deferred image to be decoded.
+ *
+ * Returns: %TRUE if @image shows the placeholder for an unreadable image
+ */
+gboolean
+dia_image_is_broken (const DiaImage *image)
+{
+  g_return_val_if_fail (DIA_IS_IMAGE (image), TRUE);
+
+  _dia_image_wait (image);
+
+  return image->image == _dia_image_broken_pixbuf ();
+}
+
 /**
  * dia_image_add_ref:
  * @image: Image that we want a reference to.
@@ -212,8 +666,572 @@ dia_image_unref (DiaImage *image)
 }
 
 
+/**
+ * dia_image_pixbuf_checksum:
+ * @pixbuf: the #GdkPixbuf to identify
+ *
+ * Content address of the pixels in @pixbuf. Rows are hashed without their
+ * padding, so equal pictures give equal keys whatever their origin. The
+ * result is cached on the pixbuf, which Dia treats as immutable.
+ *
+ * Returns: a SHA-256 hex digest owned by @pixbuf
+ */
+const char *
+dia_image_pixbuf_checksum (const GdkPixbuf *pixbuf)
+{
+  GdkPixbuf *self = (GdkPixbuf *) pixbuf;
+  char *checksum;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+
+  checksum = g_object_get_data (G_OBJECT (self), "dia-checksum");
+  if (!checksum) {
+    GChecksum *sum = g_checksum_new (G_CHECKSUM_SHA256);
+    int width = gdk_pixbuf_get_width (self);
+    int height = gdk_pixbuf_get_height (self);
+    int rowstride = gdk_pixbuf_get_rowstride (self);
+    int n_channels = gdk_pixbuf_get_n_channels (self);
+    int bits = gdk_pixbuf_get_bits_per_sample (self);
+    gsize row_len = (width * n_channels * bits + 7) / 8;
+    const guint8 *pixels = gdk_pixbuf_read_pixels (self);
+    char header[64];
+
+    g_snprintf (header, sizeof (header), "%dx%dx%dx%d",
+                width, height, n_channels, bits);
+    g_checksum_update (sum, (const guchar *) header, -1);
+    for (int y = 0; y < height; ++y) {
+      g_checksum_update (sum, pixels + y * rowstride, row_len);
+    }
+
+    checksum = g_strdup (g_checksum_get_string (sum));
+    g_checksum_free (sum);
+    g_object_set_data_full (G_OBJECT (self), "dia-checksum",
+                            checksum, g_free);
+  }
+
+  return checksum;
+}
+
+
+/* a new reference to the instance registered for key, if any */
+static DiaImage *
+_dia_image_store_lookup (const char *key)
+{
+  DiaImage *shared = NULL;
+  GWeakRef *ref;
+
+  G_LOCK (image_store);
+  ref = image_store ? g_hash_table_lookup (image_store, key) : NULL;
+  if (ref) {
+    shared = g_weak_ref_get (ref);
+  }
+  G_UNLOCK (image_store);
+
+  return shared;
+}
+
+
+/*
+ * Register image under key (taking it) unless a live instance is there
+ * already, which is returned with a new reference instead.
+ */
+static DiaImage *
+_dia_image_store_insert (DiaImage *image, char *key)
+{
+  DiaImage *shared = NULL;
+  GWeakRef *ref;
+
+  G_LOCK (image_store);
+  if (!image_store) {
+    image_store = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         g_free,
+                                         (GDestroyNotify) _weak_ref_free);
+  }
+
+  ref = g_hash_table_lookup (image_store, key);
+  if (ref) {
+    shared = g_weak_ref_get (ref);
+  }
+
+  if (shared == NULL) {
+    ref = g_new0 (GWeakRef, 1);
+    g_weak_ref_init (ref, image);
+    g_hash_table_replace (image_store, g_strdup (key), ref);
+    image->store_key = key;
+    key = NULL;
+  }
+  G_UNLOCK (image_store);
+
+  g_clear_pointer (&key, g_free);
+
+  return shared;
+}
+
+
+/**
+ * dia_image_intern:
+ * @image: (transfer full): a freshly created #DiaImage
+ *
+ * Get the shared instance for the content of @image from the image store.
+ *
+ * Images are considered equal if their pixels, mime-type and filename are
+ * equal. The first image seen becomes the shared instance, later equal ones
+ * are dropped in favour of it. This way a picture used by hundreds of
+ * objects - loaded, pasted or restored by undo - is kept and scaled once.
+ *
+ * The shared instance is immutable like every _DiaImage, don't change its
+ * filename with dia_image_save() unless you own the only reference.
+ * Deferred images are returned as they are, their content is not known
+ * yet. dia_image_load_deferred() has its own sharing by file.
+ *
+ * Returns: (transfer full): the shared image, %NULL if @image was %NULL
+ */
+DiaImage *
+dia_image_intern (DiaImage *image)
+{
+  DiaImage *shared;
+  char *key;
+
+  if (image == NULL) {
+    return NULL;
+  }
+
+  g_return_val_if_fail (DIA_IS_IMAGE (image), image);
+
+  if (image->store_key || !dia_image_is_ready (image)) {
+    return image;
+  }
+
+  key = g_strdup_printf ("%s:%s:%s",
+                         dia_image_pixbuf_checksum (image->image),
+                         dia_image_get_mime_type (image),
+                         image->filename ? image->filename : "");
+
+  shared = _dia_image_store_insert (image, key);
+  if (shared) {
+    g_clear_object (&image);
+    return shared;
+  }
+
+  return image;
+}
+
+
+/**
+ * dia_image_load_deferred:
+ * @filename: Name of the file to load.
+ *
+ * Like dia_image_load() but decoding with dia_image_new_deferred(). The
+ * same unchanged file is only loaded once, however often it is referenced.
+ *
+ * Returns: (transfer full): the image, %NULL if there is no such file or
+ *          it is not an image
+ */
+DiaImage *
+dia_image_load_deferred (const char *filename)
+{
+  GdkPixbufFormat *format;
+  DiaImage *image, *shared;
+  char *mime_type = NULL;
+  char *key;
+  GStatBuf st;
+
+  if (!g_file_test (filename, G_FILE_TEST_IS_REGULAR) ||
+      g_stat (filename, &st) != 0) {
+    return NULL;
+  }
+
+  key = g_strdup_printf ("file:%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+                         filename,
+                         (gint64) st.st_mtime,
+                         (gint64) st.st_size);
+
+  image = _dia_image_store_lookup (key);
+  if (image) {
+    g_clear_pointer (&key, g_free);
+    return image;
+  }
+
+  /* only reads the header, the rest is up to the worker */
+  format = gdk_pixbuf_get_file_info (filename, NULL, NULL);
+  if (!format) {
+    /* let the caller fall back, e.g. to inline data */
+    g_clear_pointer (&key, g_free);
+    return NULL;
+  } else {
+    char **mime_types = gdk_pixbuf_format_get_mime_types (format);
+    mime_type = g_strdup (mime_types[0]);
+    g_strfreev (mime_types);
+  }
+
+  image = dia_image_new_deferred (_dia_image_decode_file,
+                                  g_strdup (filename),
+                                  g_free,
+                                  filename,
+                                  mime_type);
+  g_clear_pointer (&mime_type, g_free);
+
+  shared = _dia_image_store_insert (image, key);
+  if (shared) {
+    g_clear_object (&image);
+    return shared;
+  }
+
+  return image;
+}
+
+
+/**
+ * dia_image_store_size:
+ *
+ * Returns: the number of distinct images currently shared
+ */
+guint
+dia_image_store_size (void)
+{
+  guint size;
+
+  G_LOCK (image_store);
+  size = image_store ? g_hash_table_size (image_store) : 0;
+  G_UNLOCK (image_store);
+
+  return size;
+}
+
+
+/* with the mipmap lock held */
+static DiaImageLevel *
+_dia_image_get_level (DiaImage *image, int i)
+{
+  DiaImageLevel *level;
+
+  if (!image->levels) {
+    int size = MAX (gdk_pixbuf_get_width (image->image),
+                    gdk_pixbuf_get_height (image->image));
+
+    image->n_levels = 1;
+    while (size > 1) {
+      size /= 2;
+      image->n_levels++;
+    }
+    image->levels = g_new0 (DiaImageLevel *, image->n_levels);
+  }
+
+  g_return_val_if_fail (i > 0 && i < image->n_levels, NULL);
+
+  level = image->levels[i];
+  if (!level) {
+    level = g_new0 (DiaImageLevel, 1);
+    level->owner = image;
+    level->level = i;
+    level->width = MAX (1, gdk_pixbuf_get_width (image->image) >> i);
+    level->height = MAX (1, gdk_pixbuf_get_height (image->image) >> i);
+    image->levels[i] = level;
+  }
+
+  return level;
+}
+
+
+/* with the mipmap lock held: mark as most recently used and account
+ * its size, evicting the least recently used levels over budget */
+static void
+_dia_image_level_touch (DiaImageLevel *level)
+{
+  gsize bytes = 0;
+
+  if (level->pixbuf) {
+    bytes += gdk_pixbuf_get_byte_length (level->pixbuf);
+  }
+  if (level->surface) {
+    bytes += cairo_image_surface_get_stride (level->surface) * level->height;
+  }
+  mipmap_cache_size += bytes - level->bytes;
+  level->bytes = bytes;
+
+  if (level->lru.data) {
+    g_queue_unlink (&mipmap_lru, &level->lru);
+  }
+  level->lru.data = level;
+  g_queue_push_head_link (&mipmap_lru, &level->lru);
+
+  while (mipmap_cache_size > mipmap_cache_budget) {
+    GList *oldest = g_queue_peek_tail_link (&mipmap_lru);
+
+    if (!oldest || oldest->data == level) {
+      break;
+    }
+    _dia_image_level_clear (oldest->data);
+  }
+}
+
+
+/* the smallest level still covering width x height pixels */
+static int
+_dia_image_pick_level (DiaImage *image, int width, int height)
+{
+  int w = gdk_pixbuf_get_width (image->image);
+  int h = gdk_pixbuf_get_height (image->image);
+  int i = 0;
+
+  while ((w >> (i + 1)) >= MAX (width, 1) && (h >> (i + 1)) >= MAX (height, 1)) {
+    ++i;
+  }
+
+  return i;
+}
+
+
+/*
+ * Get the pixbuf of level i, creating it and the levels above by
+ * repeated halving. The scaling is done without holding the lock.
+ */
+static GdkPixbuf *
+_dia_image_level_pixbuf (DiaImage *image, int i)
+{
+  DiaImageLevel *level;
+  GdkPixbuf *src, *dst;
+
+  if (i == 0) {
+    return g_object_ref (image->image);
+  }
+
+  G_LOCK (mipmap);
+  level = _dia_image_get_level (image, i);
+  if (level->pixbuf) {
+    dst = g_object_ref (level->pixbuf);
+    _dia_image_level_touch (level);
+    G_UNLOCK (mipmap);
+    return dst;
+  }
+  G_UNLOCK (mipmap);
+
+  src = _dia_image_level_pixbuf (image, i - 1);
+  /* halving with bilinear interpolation averages 2x2 source pixels */
+  dst = gdk_pixbuf_scale_simple (src, level->width, level->height,
+                                 GDK_INTERP_BILINEAR);
+  g_clear_object (&src);
+
+  G_LOCK (mipmap);
+  if (level->pixbuf) {
+    /* someone else was faster */
+    g_set_object (&dst, level->pixbuf);
+  } else {
+    level->pixbuf = g_object_ref (dst);
+  }
+  _dia_image_level_touch (level);
+  G_UNLOCK (mipmap);
+
+  return dst;
+}
+
+
+/* in the main context */
+static gboolean
+_dia_image_level_done (gpointer data)
+{
+  g_signal_emit (data, signals[LEVEL_READY], 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+_dia_image_mipmap_worker (gpointer data, gpointer user_data)
+{
+  DiaImageLevel *level = data;
+  DiaImage *image = level->owner;
+  GdkPixbuf *pixbuf;
+
+  pixbuf = _dia_image_level_pixbuf (image, level->level);
+  g_clear_object (&pixbuf);
+
+  G_LOCK (mipmap);
+  level->pending = FALSE;
+  G_UNLOCK (mipmap);
+
+  /* takes over the reference taken when queuing */
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                   _dia_image_level_done,
+                   image,
+                   g_object_unref);
+}
+
+
+/* with the mipmap lock held: the best level we have pixels for right
+ * now, kicking off the generation of the one we want */
+static int
+_dia_image_level_ready (DiaImage *image, int i)
+{
+  DiaImageLevel *level = _dia_image_get_level (image, i);
+
+  if (level->pixbuf || level->surface) {
+    return i;
+  }
+
+  if (!level->pending) {
+    if (!mipmap_pool) {
+      mipmap_pool = g_thread_pool_new (_dia_image_mipmap_worker, NULL,
+                                       g_get_num_processors (),
+                                       FALSE, NULL);
+    }
+    level->pending = TRUE;
+    g_object_ref (image);
+    g_thread_pool_push (mipmap_pool, level, NULL);
+  }
+
+  /* fall back to the nearest finer level available */
+  while (--i > 0) {
+    level = image->levels[i];
+    if (level && (level->pixbuf || level->surface)) {
+      return i;
+    }
+  }
+
+  return 0;
+}
+
+
+/**
+ * dia_image_set_mipmap_async:
+ * @async: whether to generate missing mipmap levels in the background
+ *
+ * With @async a draw that needs a not yet available mipmap level uses the
+ * nearest finer one (at worst the image itself) and the requested level is
+ * generated by a worker thread for the next draw, announced by
+ * #DiaImage::level-ready. Meant for interactive use with a main loop
+ * running, exports should get the right level right away.
+ */
+void
+dia_image_set_mipmap_async (gboolean async)
+{
+  G_LOCK (mipmap);
+  mipmap_async = async;
+  G_UNLOCK (mipmap);
+}
+
+
+/**
+ * dia_image_set_cache_budget:
+ * @bytes: the maximum memory used by all mipmap levels
+ *
+ * The original images are not accounted, they are always kept.
+ */
+void
+dia_image_set_cache_budget (gsize bytes)
+{
+  G_LOCK (mipmap);
+  mipmap_cache_budget = bytes;
+  while (mipmap_cache_size > mipmap_cache_budget && mipmap_lru.tail) {
+    _dia_image_level_clear (mipmap_lru.tail->data);
+  }
+  G_UNLOCK (mipmap);
+}
+
+
+/**
+ * dia_image_get_cache_size:
+ *
+ * Returns: the memory currently used by mipmap levels of all images
+ */
+gsize
+dia_image_get_cache_size (void)
+{
+  gsize size;
+
+  G_LOCK (mipmap);
+  size = mipmap_cache_size;
+  G_UNLOCK (mipmap);
+
+  return size;
+}
+
+
+static gsize
+_pixbuf_memory_size (GdkPixbuf *pixbuf, GHashTable *shared)
+{
+  if (!pixbuf || g_hash_table_contains (shared, pixbuf)) {
+    return 0;
+  }
+  g_hash_table_add (shared, pixbuf);
+
+  return gdk_pixbuf_get_byte_length (pixbuf);
+}
+
+
+/**
+ * dia_image_get_memory_size:
+ * @image: the #DiaImage
+ * @shared: (nullable): the shared data already counted
+ *
+ * The memory used by @image: the pixels, the scaled and surface caches
+ * and the mipmap levels currently kept. Images are shared via
+ * dia_image_intern(), so @image is only counted if not in @shared yet.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+dia_image_get_memory_size (DiaImage *image, GHashTable *shared)
+{
+  GHashTable *pixbufs;
+  gsize size;
+  int i;
+
+  g_return_val_if_fail (DIA_IS_IMAGE (image), 0);
+
+  if (shared) {
+    if (g_hash_table_contains (shared, image)) {
+      return 0;
+    }
+    g_hash_table_add (shared, image);
+  }
+
+  /* the scaled version may be the image itself */
+  pixbufs = shared ? shared : g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  size = sizeof (DiaImage);
+  if (image->filename) {
+    size += strlen (image->filename) + 1;
+  }
+  if (image->mime_type) {
+    size += strlen (image->mime_type) + 1;
+  }
+  if (image->store_key) {
+    size += strlen (image->store_key) + 1;
+  }
+  if (dia_image_is_ready (image)) {
+    size += _pixbuf_memory_size (image->image, pixbufs);
+  }
+
+  G_LOCK (mipmap);
+  size += _pixbuf_memory_size (image->scaled, pixbufs);
+  if (image->surface) {
+    size += cairo_image_surface_get_stride (image->surface)
+              * cairo_image_surface_get_height (image->surface);
+  }
+  for (i = 1; i < image->n_levels; i++) {
+    if (image->levels[i]) {
+      size += sizeof (DiaImageLevel) + image->levels[i]->bytes;
+    }
+  }
+  G_UNLOCK (mipmap);
+
+  if (pixbufs != shared) {
+    g_hash_table_destroy (pixbufs);
+  }
+
+  return size;
+}
+
+
 /*!
  * \brief Create a scaled variant of the underlying pixbuf.
+ *
+ * The scaling starts from the nearest level of the mipmap pyramid, so
+ * zooming a large image only touches a fraction of its pixels.
  * @param image explicit this pointer
  * @param width Width in pixels of result.
  * @param height Height in pixels of result.
@@ -227,26 +1245,45 @@ dia_image_get_scaled_pixbuf (DiaImage *image, int width, int height)
   if (width < 1 || height < 1) {
     return NULL;
   }
+  _dia_image_wait (image);
   if (gdk_pixbuf_get_width (image->image) > width ||
       gdk_pixbuf_get_height (image->image) > height) {
-    /* Using TILES to make it look more like PostScript */
-    if (image->scaled == NULL ||
-        image->scaled_width != width || image->scaled_height != height) {
-      g_clear_object (&image->scaled);
-      image->scaled = gdk_pixbuf_scale_simple (image->image,
-                                               width,
-                                               height,
-                                               /* dont waste interpolation time if it wont be seen anyway */
-                                               (width * height > 256) ? GDK_INTERP_TILES : GDK_INTERP_NEAREST);
-      image->scaled_width = width;
-      image->scaled_height = height;
+    GdkPixbuf *src;
+
+    G_LOCK (mipmap);
+    if (image->scaled != NULL &&
+        image->scaled_width == width && image->scaled_height == height) {
+      scaled = g_object_ref (image->scaled);
+      G_UNLOCK (mipmap);
+      return scaled;
+    }
+    G_UNLOCK (mipmap);
+
+    src = _dia_image_level_pixbuf (image,
+                                   _dia_image_pick_level (image, width, height));
+    if (gdk_pixbuf_get_width (src) == width &&
+        gdk_pixbuf_get_height (src) == height) {
+      scaled = g_object_ref (src);
+    } else {
+      /* Using TILES to make it look more like PostScript */
+      scaled = gdk_pixbuf_scale_simple (src,
+                                        width,
+                                        height,
+                                        /* dont waste interpolation time if it wont be seen anyway */
+                                        (width * height > 256) ? GDK_INTERP_TILES : GDK_INTERP_NEAREST);
     }
-    scaled = image->scaled;
+    g_clear_object (&src);
+
+    G_LOCK (mipmap);
+    g_set_object (&image->scaled, scaled);
+    image->scaled_width = width;
+    image->scaled_height = height;
+    G_UNLOCK (mipmap);
   } else {
-    scaled = image->image;
+    scaled = g_object_ref (image->image);
   }
   /* always adding a reference */
-  return g_object_ref (scaled);
+  return scaled;
 }
 
 static gchar *
@@ -299,6 +1336,7 @@ dia_image_save (DiaImage *image, const gchar *filename)
 {
   gboolean saved = FALSE;
 
+  _dia_image_wait (image);
   if (image->image) {
     GError *error = NULL;
     gchar *type = _guess_format (filename);
@@ -308,6 +1346,8 @@ dia_image_save (DiaImage *image, const gchar *filename)
       saved = gdk_pixbuf_save (image->image, filename, type, &error, NULL);
     }
     if (saved) {
+      /* the filename is part of the store key */
+      _dia_image_unregister (image);
       g_clear_pointer (&image->filename, g_free);
       image->filename = g_strdup (filename);
     } else if (!type) {
@@ -337,6 +1377,7 @@ dia_image_width (const DiaImage *image)
 {
   g_return_val_if_fail (image != NULL, 0);
 
+  _dia_image_wait (image);
   return gdk_pixbuf_get_width (image->image);
 }
 
@@ -351,6 +1392,7 @@ dia_image_height (const DiaImage *image)
 {
   g_return_val_if_fail (image != NULL, 0);
 
+  _dia_image_wait (image);
   return gdk_pixbuf_get_height (image->image);
 }
 
@@ -365,6 +1407,7 @@ dia_image_rowstride (const DiaImage *image)
 {
   g_return_val_if_fail (image != NULL, 0);
 
+  _dia_image_wait (image);
   return gdk_pixbuf_get_rowstride (image->image);
 }
 /*!
@@ -380,6 +1423,7 @@ dia_image_pixbuf (const DiaImage *image)
     return NULL;
   }
 
+  _dia_image_wait (image);
   return image->image;
 }
 
@@ -392,6 +1436,8 @@ dia_image_pixbuf (const DiaImage *image)
 const gchar *
 dia_image_get_mime_type (const DiaImage *image)
 {
+  /* might be learned from the data */
+  _dia_image_wait (image);
   if (image->mime_type) {
     return image->mime_type;
   }
@@ -469,6 +1515,7 @@ dia_image_mask_data (const DiaImage *image)
   guint8 *mask;
   int i, size;
 
+  _dia_image_wait (image);
   if (!gdk_pixbuf_get_has_alpha (image->image)) {
     return NULL;
   }
@@ -502,6 +1549,8 @@ const guint8 *
 dia_image_rgba_data (const DiaImage *image)
 {
   g_return_val_if_fail (image != NULL, 0);
+
+  _dia_image_wait (image);
   if (gdk_pixbuf_get_has_alpha (image->image)) {
     const guint8 *pixels = gdk_pixbuf_get_pixels (image->image);
 
@@ -528,26 +1577,120 @@ dia_image_filename (const DiaImage *image)
   return image->filename;
 }
 
+static cairo_surface_t *
+_dia_image_surface_from_pixbuf (GdkPixbuf *pixbuf)
+{
+  cairo_surface_t *surface;
+  cairo_t *ctx;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        gdk_pixbuf_get_width (pixbuf),
+                                        gdk_pixbuf_get_height (pixbuf));
+  ctx = cairo_create (surface);
+  gdk_cairo_set_source_pixbuf (ctx, pixbuf, 0.0, 0.0);
+  cairo_paint (ctx);
+  cairo_destroy (ctx);
+
+  return surface;
+}
+
+
+/*!
+ * \brief The full resolution image as a cairo surface
+ *
+ * The surface is owned by the image.
+ * \memberof _DiaImage
+ */
 cairo_surface_t *
 dia_image_get_surface (DiaImage *self)
 {
-  cairo_t *ctx = NULL;
+  cairo_surface_t *surface;
 
   g_return_val_if_fail (self != NULL, NULL);
   g_return_val_if_fail (DIA_IS_IMAGE (self), NULL);
 
-  if (self->surface != NULL) {
-    return self->surface;
+  _dia_image_wait (self);
+
+  G_LOCK (mipmap);
+  surface = self->surface;
+  G_UNLOCK (mipmap);
+
+  if (surface != NULL) {
+    return surface;
+  }
+
+  surface = _dia_image_surface_from_pixbuf (self->image);
+
+  G_LOCK (mipmap);
+  if (self->surface) {
+    cairo_surface_destroy (surface);
+  } else {
+    self->surface = surface;
+  }
+  surface = self->surface;
+  G_UNLOCK (mipmap);
+
+  return surface;
+}
+
+
+/*!
+ * \brief A cairo surface suitable to paint the image at the given size
+ *
+ * Picks the smallest level of the mipmap pyramid which still covers
+ * @width x @height device pixels. Painting a large photo at a low zoom
+ * this way doesn't filter all of its pixels for every frame.
+ *
+ * @param self explicit this pointer
+ * @param width device pixels the image covers horizontally
+ * @param height device pixels the image covers vertically
+ * @return a new reference to a surface, maybe smaller than the image
+ * \memberof _DiaImage
+ */
+cairo_surface_t *
+dia_image_get_surface_for_size (DiaImage *self, int width, int height)
+{
+  DiaImageLevel *level;
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  int i;
+
+  g_return_val_if_fail (DIA_IS_IMAGE (self), NULL);
+
+  _dia_image_wait (self);
+  i = _dia_image_pick_level (self, width, height);
+
+  G_LOCK (mipmap);
+  if (i > 0 && mipmap_async) {
+    i = _dia_image_level_ready (self, i);
+  }
+  if (i == 0) {
+    G_UNLOCK (mipmap);
+    return cairo_surface_reference (dia_image_get_surface (self));
   }
 
-  self->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-                                              dia_image_width (self),
-                                              dia_image_height (self));
-  ctx = cairo_create (self->surface);
+  level = _dia_image_get_level (self, i);
+  if (level->surface) {
+    surface = cairo_surface_reference (level->surface);
+    _dia_image_level_touch (level);
+    G_UNLOCK (mipmap);
+    return surface;
+  }
+  G_UNLOCK (mipmap);
 
-  gdk_cairo_set_source_pixbuf (ctx, dia_image_pixbuf (self), 0.0, 0.0);
+  pixbuf = _dia_image_level_pixbuf (self, i);
+  surface = _dia_image_surface_from_pixbuf (pixbuf);
+  g_clear_object (&pixbuf);
 
-  cairo_paint (ctx);
+  G_LOCK (mipmap);
+  if (level->surface) {
+    cairo_surface_destroy (surface);
+  } else {
+    level->surface = surface;
+  }
+  surface = cairo_surface_reference (level->surface);
+  _dia_image_level_touch (level);
+  G_UNLOCK (mipmap);
 
-  return self->surface;
+  return surface;
 }
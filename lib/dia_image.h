@@ -30,12 +30,35 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (DiaImage, dia_image, DIA, IMAGE, GObject)
 
+/**
+ * DiaImageDecodeFunc:
+ * @data: the data given to dia_image_new_deferred()
+ * @error: return location for a #GError
+ *
+ * Called from a worker thread, must not touch anything but @data.
+ *
+ * Returns: (transfer full): the decoded pixels or %NULL on error
+ */
+typedef GdkPixbuf *(*DiaImageDecodeFunc) (gpointer data, GError **error);
+
 DiaImage        *dia_image_get_broken        (void);
 
 DiaImage        *dia_image_load              (const gchar    *filename);
+DiaImage        *dia_image_load_deferred     (const char     *filename);
 DiaImage        *dia_image_new_from_pixbuf   (GdkPixbuf      *pixbuf);
+DiaImage        *dia_image_new_deferred      (DiaImageDecodeFunc func,
+                                              gpointer        data,
+                                              GDestroyNotify  destroy,
+                                              const char     *filename,
+                                              const char     *mime_type);
+gboolean         dia_image_is_ready          (const DiaImage *image);
+gboolean         dia_image_is_broken         (const DiaImage *image);
+void             dia_image_set_decode_async  (gboolean        async);
 void             dia_image_add_ref           (DiaImage       *image);
 void             dia_image_unref             (DiaImage       *image);
+DiaImage        *dia_image_intern            (DiaImage       *image);
+guint            dia_image_store_size        (void);
+const char      *dia_image_pixbuf_checksum   (const GdkPixbuf *pixbuf);
 
 gboolean         dia_image_save              (DiaImage       *image,
                                               const gchar    *filename);
@@ -79,6 +102,15 @@ GdkPixbuf       *dia_image_get_scaled_pixbuf (DiaImage       *image,
                                               int             width,
                                               int             height);
 cairo_surface_t *dia_image_get_surface       (DiaImage       *self);
+cairo_surface_t *dia_image_get_surface_for_size
+                                             (DiaImage       *self,
+                                              int             width,
+                                              int             height);
+void             dia_image_set_mipmap_async  (gboolean        async);
+void             dia_image_set_cache_budget  (gsize           bytes);
+gsize            dia_image_get_cache_size    (void);
+gsize            dia_image_get_memory_size   (DiaImage       *image,
+                                              GHashTable     *shared);
 
 G_END_DECLS
 
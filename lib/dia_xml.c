@@ -246,6 +246,42 @@ xml_file_check_encoding (const char *filename,
 }
 
 
+/**
+ * dia_xml_file_fix_encoding:
+ * @filename: the XML file to read
+ * @ctx: for the message about the encoding assumed
+ *
+ * Outside of an UTF-8 locale a file without encoding declaration but with
+ * non-ASCII characters is taken to be in the locale's charset, see
+ * xml_file_check_encoding(). For readers not going through
+ * diaXmlParseFile(), e.g. streaming ones.
+ *
+ * Returns: (transfer full) (nullable): the name of a temporary copy
+ *          declaring the encoding, which the caller unlinks, or %NULL if
+ *          @filename is fine as it is
+ *
+ * Since: 0.98
+ */
+char *
+dia_xml_file_fix_encoding (const char *filename, DiaContext *ctx)
+{
+  const char *local_charset = NULL;
+  char *fname;
+
+  if (g_get_charset (&local_charset) || !local_charset) {
+    /* we're in an UTF-8 environment */
+    return NULL;
+  }
+
+  fname = xml_file_check_encoding (filename, local_charset, ctx);
+  if (fname && strcmp (fname, filename) == 0) {
+    g_clear_pointer (&fname, g_free);
+  }
+
+  return fname;
+}
+
+
 /*!
  * \brief Parse a given file into XML, handling old broken files correctly.
  * @param filename The name of the file to read.
@@ -257,26 +293,18 @@ xml_file_check_encoding (const char *filename,
 static xmlDocPtr
 xmlDiaParseFile (const char *filename, DiaContext *ctx)
 {
-  const char *local_charset = NULL;
   const xmlError *error_xml = NULL;
   xmlDocPtr ret = NULL;
+  char *fname = dia_xml_file_fix_encoding (filename, ctx);
 
-  if (   !g_get_charset (&local_charset)
-      && local_charset) {
-    /* we're not in an UTF-8 environment. */
-    char *fname = xml_file_check_encoding(filename, local_charset, ctx);
-    if (fname != filename) {
-      /* We've got a corrected file to parse. */
-      ret = xmlDoParseFile (fname, &error_xml);
-      unlink (fname);
-      /* printf("has read %s instead of %s\n",fname,filename); */
-    } else {
-      /* the XML file is good. libxml is "old enough" to handle it correctly.
-       */
-      ret = xmlDoParseFile (filename, &error_xml);
-    }
+  if (fname) {
+    /* We've got a corrected file to parse. */
+    ret = xmlDoParseFile (fname, &error_xml);
+    g_unlink (fname);
     g_clear_pointer (&fname, g_free);
   } else {
+    /* the XML file is good. libxml is "old enough" to handle it correctly.
+     */
     ret = xmlDoParseFile (filename, &error_xml);
   }
 
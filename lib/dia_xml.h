@@ -105,7 +105,10 @@ GHashTable *data_dict (DataNode data, DiaContext *ctx);
 void data_add_dict (AttributeNode attr, GHashTable *data, DiaContext *ctx);
 
 GdkPixbuf *data_pixbuf (DataNode data, DiaContext *ctx);
+DiaImage *data_image_deferred (DataNode data, DiaContext *ctx);
 void data_add_pixbuf (AttributeNode attr, GdkPixbuf *pixbuf, DiaContext *ctx);
+void data_begin_pixbuf_table (xmlNodePtr section, DiaContext *ctx);
+int data_end_pixbuf_table (DiaContext *ctx);
 
 DiaMatrix *data_matrix(DataNode data);
 void data_add_matrix(AttributeNode attr, DiaMatrix *matrix, DiaContext *ctx);
@@ -114,6 +117,7 @@ DiaPattern *data_pattern(DataNode data, DiaContext *ctx);
 void data_add_pattern(AttributeNode attr, DiaPattern *pat, DiaContext *ctx);
 
 xmlDocPtr diaXmlParseFile(const char *filename, DiaContext *ctx, gboolean try_harder);
+char *dia_xml_file_fix_encoding (const char *filename, DiaContext *ctx);
 
 #define dia_clear_xml_string(pointer) g_clear_pointer(pointer, xmlFree)
 
@@ -35,6 +35,7 @@
 #include "paper.h"
 #include "persistence.h"
 #include "dia-layer.h"
+#include "dia-trace.h"
 
 #include "dynamic_obj.h"
 #include "diamarshal.h"
@@ -50,6 +51,13 @@ typedef struct {
   DiaHighlightType type;
 } ObjectHighlight;
 
+/* the objects added to a layer during a bulk add, in order */
+typedef struct _BulkAdded {
+  DiaLayer   *layer;
+  GList      *objects;
+  GHashTable *links;   /* object -> its link in objects */
+} BulkAdded;
+
 
 enum {
   PROP_0,
@@ -62,8 +70,10 @@ static GParamSpec *pspecs[LAST_PROP] = { NULL, };
 enum {
   OBJECT_ADD,
   OBJECT_REMOVE,
+  OBJECT_CHANGED,
   SELECTION_CHANGED,
   LAYERS_CHANGED,
+  OBJECTS_ADDED,
   LAST_SIGNAL
 };
 static guint signals[LAST_SIGNAL] = { 0, };
@@ -168,6 +178,18 @@ active_layer_died (gpointer  data,
 }
 
 
+static void
+_bulk_added_free (gpointer data)
+{
+  BulkAdded *added = data;
+
+  g_list_free (added->objects);
+  g_clear_pointer (&added->links, g_hash_table_destroy);
+  g_clear_object (&added->layer);
+  g_free (added);
+}
+
+
 static void
 diagram_data_finalize (GObject *object)
 {
@@ -186,6 +208,9 @@ diagram_data_finalize (GObject *object)
   data->selected = NULL; /* for safety */
   data->selected_count_private = 0;
 
+  g_list_free_full (data->bulk_added, _bulk_added_free);
+  data->bulk_added = NULL;
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -359,6 +384,28 @@ dia_diagram_data_class_init (DiagramDataClass *klass)
               G_TYPE_POINTER,
               G_TYPE_POINTER);
 
+  /**
+   * DiagramData::object-changed:
+   * @self: the #DiagramData
+   * @layer: the #DiaLayer of @object
+   * @object: the #DiaObject
+   *
+   * Emitted for changes of an object not caused by the user, e.g. when
+   * a deferred image finished decoding. Not undoable, just to update
+   * the displays.
+   *
+   * Since: 0.98
+   */
+  signals[OBJECT_CHANGED] =
+    g_signal_new ("object-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  0, NULL, NULL,
+                  dia_marshal_VOID__POINTER_POINTER,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_POINTER,
+                  G_TYPE_POINTER);
+
   signals[SELECTION_CHANGED] =
     g_signal_new ("selection_changed",
                   G_TYPE_FROM_CLASS (klass),
@@ -386,6 +433,27 @@ dia_diagram_data_class_init (DiagramDataClass *klass)
                   dia_marshal_VOID__UINT_UINT_UINT,
                   G_TYPE_NONE, 3,
                   G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+
+  /**
+   * DiagramData::objects-added:
+   * @self: the #DiagramData
+   * @layer: the #DiaLayer the objects were added to
+   * @objects: (element-type DiaObject): the objects in order of addition
+   *
+   * Emitted by dia_diagram_data_end_bulk_add() once per layer, instead of
+   * #DiagramData::object_add for every object added meanwhile.
+   *
+   * Since: 0.98
+   */
+  signals[OBJECTS_ADDED] =
+    g_signal_new ("objects-added",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  0, NULL, NULL,
+                  dia_marshal_VOID__POINTER_POINTER,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_POINTER,
+                  G_TYPE_POINTER);
 }
 
 
@@ -926,27 +994,12 @@ data_update_extents(DiagramData *data)
 GList *
 data_get_sorted_selected (DiagramData *data)
 {
-  GList *list;
-  GList *sorted_list;
-  GList *found;
-  DiaObject *obj;
-
   g_assert (g_list_length (data->selected) == data->selected_count_private);
   if (data->selected_count_private == 0)
     return NULL;
 
-  sorted_list = NULL;
-  list = g_list_last (dia_layer_get_object_list (dia_diagram_data_get_active_layer (data)));
-  while (list != NULL) {
-    found = g_list_find (data->selected, list->data);
-    if (found) {
-      obj = (DiaObject *) found->data;
-      sorted_list = g_list_prepend (sorted_list, obj);
-    }
-    list = g_list_previous (list);
-  }
-
-  return sorted_list;
+  return dia_layer_sort_objects (dia_diagram_data_get_active_layer (data),
+                                 data->selected);
 }
 
 /*!
@@ -962,32 +1015,144 @@ data_get_sorted_selected (DiagramData *data)
 GList *
 data_get_sorted_selected_remove (DiagramData *data)
 {
-  GList *list;
   GList *sorted_list;
-  GList *found;
-  DiaObject *obj;
 
-  g_assert (g_list_length (data->selected) == data->selected_count_private);
-  if (data->selected_count_private == 0)
-    return NULL;
+  sorted_list = data_get_sorted_selected (data);
+  dia_layer_remove_objects (dia_diagram_data_get_active_layer (data),
+                            sorted_list);
 
-  sorted_list = NULL;
-  list = g_list_last (dia_layer_get_object_list (dia_diagram_data_get_active_layer (data)));
-  while (list != NULL) {
-    found = g_list_find (data->selected, list->data);
-    if (found) {
-      obj = (DiaObject *) found->data;
-      sorted_list = g_list_prepend (sorted_list, obj);
+  return sorted_list;
+}
 
-      list = g_list_previous (list);
 
-      dia_layer_remove_object (dia_diagram_data_get_active_layer (data), obj);
-    } else {
-      list = g_list_previous (list);
+static BulkAdded *
+_bulk_added_find (DiagramData *data, DiaLayer *layer)
+{
+  GList *list;
+
+  for (list = data->bulk_added; list != NULL; list = g_list_next (list)) {
+    BulkAdded *added = list->data;
+
+    if (added->layer == layer) {
+      return added;
     }
   }
 
-  return sorted_list;
+  return NULL;
+}
+
+
+/* Returns TRUE if the signal is replaced by the one emitted at the end of
+ * the bulk add */
+static gboolean
+_bulk_add_intercept (DiagramData *data,
+                     DiaLayer    *layer,
+                     DiaObject   *obj,
+                     const char  *signal_name)
+{
+  gboolean is_add = strcmp ("object_add", signal_name) == 0;
+  BulkAdded *added;
+  GList *link;
+
+  if (!is_add && strcmp ("object_remove", signal_name) != 0) {
+    return FALSE;
+  }
+
+  added = _bulk_added_find (data, layer);
+
+  if (!obj) {
+    /* the whole layer is added or removed, which covers its objects */
+    if (added) {
+      data->bulk_added = g_list_remove (data->bulk_added, added);
+      _bulk_added_free (added);
+    }
+    return FALSE;
+  }
+
+  if (is_add) {
+    if (!added) {
+      added = g_new0 (BulkAdded, 1);
+      added->layer = g_object_ref (layer);
+      added->links = g_hash_table_new (g_direct_hash, g_direct_equal);
+      data->bulk_added = g_list_append (data->bulk_added, added);
+    }
+    added->objects = g_list_prepend (added->objects, obj);
+    g_hash_table_insert (added->links, obj, added->objects);
+    return TRUE;
+  }
+
+  /* nobody knows about it yet, so there is nothing to tell */
+  link = added ? g_hash_table_lookup (added->links, obj) : NULL;
+  if (link) {
+    g_hash_table_remove (added->links, obj);
+    added->objects = g_list_delete_link (added->objects, link);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+/**
+ * dia_diagram_data_begin_bulk_add:
+ * @self: the #DiagramData
+ *
+ * Start adding many objects, e.g. from an importer. Until the matching
+ * dia_diagram_data_end_bulk_add() objects added to the layers of @self
+ * don't emit #DiagramData::object_add. Calls can be nested.
+ *
+ * Since: 0.98
+ */
+void
+dia_diagram_data_begin_bulk_add (DiagramData *self)
+{
+  g_return_if_fail (DIA_IS_DIAGRAM_DATA (self));
+
+  self->bulk_add++;
+}
+
+
+/**
+ * dia_diagram_data_end_bulk_add:
+ * @self: the #DiagramData
+ *
+ * Finish what dia_diagram_data_begin_bulk_add() started: emits
+ * #DiagramData::objects-added once for every layer objects were added to
+ * and updates the extents.
+ *
+ * Since: 0.98
+ */
+void
+dia_diagram_data_end_bulk_add (DiagramData *self)
+{
+  GList *bulk_added;
+  GList *list;
+
+  g_return_if_fail (DIA_IS_DIAGRAM_DATA (self));
+  g_return_if_fail (self->bulk_add > 0);
+
+  if (--self->bulk_add > 0) {
+    return;
+  }
+
+  bulk_added = g_steal_pointer (&self->bulk_added);
+
+  for (list = bulk_added; list != NULL; list = g_list_next (list)) {
+    BulkAdded *added = list->data;
+
+    added->objects = g_list_reverse (added->objects);
+    dia_layer_update_extents (added->layer);
+    /* not (yet) part of the diagram, it'll be announced with the layer */
+    if (added->objects && data_layer_get_index (self, added->layer) >= 0) {
+      g_signal_emit (self, signals[OBJECTS_ADDED], 0, added->layer, added->objects);
+    }
+  }
+
+  if (bulk_added) {
+    data_update_extents (self);
+  }
+
+  g_list_free_full (bulk_added, _bulk_added_free);
 }
 
 
@@ -1005,6 +1170,15 @@ data_emit (DiagramData *data,
            DiaObject   *obj,
 	  const char *signal_name)
 {
+  /* a layer not (yet) part of a diagram */
+  if (!data) {
+    return;
+  }
+
+  if (data->bulk_add > 0 && _bulk_add_intercept (data, layer, obj, signal_name)) {
+    return;
+  }
+
   /* check what signal it is */
   if (strcmp("object_add",signal_name) == 0)
     g_signal_emit(data, signals[OBJECT_ADD], 0, layer, obj);
@@ -1012,6 +1186,9 @@ data_emit (DiagramData *data,
   if (strcmp("object_remove",signal_name) == 0)
     g_signal_emit(data, signals[OBJECT_REMOVE], 0, layer, obj);
 
+  if (strcmp("object-changed",signal_name) == 0)
+    g_signal_emit(data, signals[OBJECT_CHANGED], 0, layer, obj);
+
 }
 
 
@@ -1043,11 +1220,15 @@ data_render (DiagramData    *data,
   DIA_FOR_LAYER_IN_DIAGRAM (data, layer, i, {
     active_layer = (layer == active);
     if (dia_layer_is_visible (layer)) {
+      gint64 span = dia_trace_begin ();
+
       if (obj_renderer) {
         dia_layer_render (layer, renderer, update, obj_renderer, gdata, active_layer);
       } else {
         dia_renderer_draw_layer (renderer, layer, active_layer, update);
       }
+      dia_trace_end (span, DIA_TRACE_RENDER, "layer",
+                     dia_layer_get_name (layer));
     }
   });
 
@@ -1056,20 +1237,26 @@ data_render (DiagramData    *data,
   }
 }
 
-/*!
- * \brief Calls data_render() for paginated formats
+/**
+ * dia_diagram_data_get_pages:
+ * @data: the #DiagramData
+ * @n_pages: (out): the number of pages
  *
- * Call data_render() for every used page in the diagram
+ * The used pages of the diagram, in the order data_render_paginated()
+ * renders them: row by row, top to bottom.
  *
- * \memberof _DiagramData
+ * Returns: (array length=n_pages): the bounds of the pages, free with
+ * g_free()
+ *
+ * Since: 0.98
  */
-void
-data_render_paginated (DiagramData *data, DiaRenderer *renderer, gpointer user_data)
+DiaRectangle *
+dia_diagram_data_get_pages (DiagramData *data, int *n_pages)
 {
+  GArray *pages = g_array_new (FALSE, FALSE, sizeof (DiaRectangle));
   DiaRectangle *extents;
   gdouble width, height;
   gdouble x, y, initx, inity;
-  gint xpos, ypos;
 
   /* the usable area of the page */
   width = data->paper.width;
@@ -1086,12 +1273,12 @@ data_render_paginated (DiagramData *data, DiaRenderer *renderer, gpointer user_d
   }
 
   /* iterate through all the pages in the diagram */
-  for (y = inity, ypos = 0; y < extents->bottom; y += height, ypos++) {
+  for (y = inity; y < extents->bottom; y += height) {
     /* ensure we are not producing pages for epsilon */
     if ((extents->bottom - y) < 1e-6)
       break;
 
-    for (x = initx, xpos = 0; x < extents->right; x += width, xpos++) {
+    for (x = initx; x < extents->right; x += width) {
       DiaRectangle page_bounds;
 
       if ((extents->right - x) < 1e-6)
@@ -1102,9 +1289,36 @@ data_render_paginated (DiagramData *data, DiaRenderer *renderer, gpointer user_d
       page_bounds.top = y;
       page_bounds.bottom = y + height;
 
-      data_render (data, renderer, &page_bounds, NULL, user_data);
+      g_array_append_val (pages, page_bounds);
     }
   }
+
+  *n_pages = pages->len;
+
+  return (DiaRectangle *) g_array_free (pages, FALSE);
+}
+
+/*!
+ * \brief Calls data_render() for paginated formats
+ *
+ * Call data_render() for every used page in the diagram
+ *
+ * \memberof _DiagramData
+ */
+void
+data_render_paginated (DiagramData *data, DiaRenderer *renderer, gpointer user_data)
+{
+  DiaRectangle *pages;
+  int n_pages;
+  int i;
+
+  pages = dia_diagram_data_get_pages (data, &n_pages);
+
+  for (i = 0; i < n_pages; i++) {
+    data_render (data, renderer, &pages[i], NULL, user_data);
+  }
+
+  g_free (pages);
 }
 
 
@@ -100,6 +100,8 @@ struct _DiagramData {
 
   GList *highlighted;        /*!< List of objects that are highlighted */
 
+  int bulk_add;              /*!< Nesting of dia_diagram_data_begin_bulk_add() */
+  GList *bulk_added;         /*!< Per layer the objects added meanwhile, don't use ! */
 };
 
 /* DiagramData vtable */
@@ -143,6 +145,8 @@ gboolean data_update_extents(DiagramData *data); /* returns true if changed. */
 GList *data_get_sorted_selected(DiagramData *data);
 GList *data_get_sorted_selected_remove(DiagramData *data);
 void data_emit(DiagramData *data,DiaLayer *layer,DiaObject* obj,const char *signal_name);
+void dia_diagram_data_begin_bulk_add (DiagramData *self);
+void dia_diagram_data_end_bulk_add   (DiagramData *self);
 
 void data_foreach_object (DiagramData *data, GFunc func, gpointer user_data);
 
@@ -154,6 +158,7 @@ void data_render(DiagramData *data, DiaRenderer *renderer, DiaRectangle *update,
 		 ObjectRenderer obj_renderer /* Can be NULL */,
 		 gpointer gdata);
 void data_render_paginated(DiagramData *data, DiaRenderer *renderer, gpointer user_data);
+DiaRectangle *dia_diagram_data_get_pages (DiagramData *data, int *n_pages);
 
 DiagramData *diagram_data_clone (DiagramData *data);
 DiagramData *diagram_data_clone_selected (DiagramData *data);
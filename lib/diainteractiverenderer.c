@@ -352,3 +352,62 @@ dia_interactive_renderer_set_selection (DiaInteractiveRenderer *self,
 
   irenderer->set_selection (self, has_selection, x, y, width, height);
 }
+
+
+/**
+ * dia_interactive_renderer_set_preview:
+ * @self: the #DiaInteractiveRenderer
+ * @objects: (element-type DiaObject) (nullable): objects to snapshot
+ *
+ * Render @objects once into an overlay which paint() draws on top of the
+ * rendered diagram, so moving them can be previewed without re-rendering.
+ * Passing %NULL removes the overlay.
+ *
+ * Returns: %FALSE if the renderer can't do previews
+ *
+ * Since: 0.98
+ */
+gboolean
+dia_interactive_renderer_set_preview (DiaInteractiveRenderer *self,
+                                      GList                  *objects)
+{
+  DiaInteractiveRendererInterface *irenderer =
+    DIA_INTERACTIVE_RENDERER_GET_IFACE (self);
+
+  g_return_val_if_fail (irenderer != NULL, FALSE);
+
+  if (irenderer->set_preview == NULL || irenderer->move_preview == NULL) {
+    return FALSE;
+  }
+
+  irenderer->set_preview (self, objects);
+
+  return TRUE;
+}
+
+
+/**
+ * dia_interactive_renderer_move_preview:
+ * @self: the #DiaInteractiveRenderer
+ * @dx: horizontal offset in pixels
+ * @dy: vertical offset in pixels
+ *
+ * Move the overlay from dia_interactive_renderer_set_preview() relative
+ * to where the objects were rendered.
+ *
+ * Since: 0.98
+ */
+void
+dia_interactive_renderer_move_preview (DiaInteractiveRenderer *self,
+                                       double                  dx,
+                                       double                  dy)
+{
+  DiaInteractiveRendererInterface *irenderer =
+    DIA_INTERACTIVE_RENDERER_GET_IFACE (self);
+
+  g_return_if_fail (irenderer != NULL);
+
+  if (irenderer->move_preview) {
+    irenderer->move_preview (self, dx, dy);
+  }
+}
@@ -49,6 +49,8 @@ G_DECLARE_INTERFACE (DiaInteractiveRenderer, dia_interactive_renderer, DIA, INTE
  * @paint: Copy already rendered content to the given context
  * @draw_object_highlighted: Support for drawing selected objects highlighted
  * @set_selection: Set the current selection box
+ * @set_preview: Snapshot objects into an overlay, or drop it for %NULL
+ * @move_preview: Offset the overlay in pixels
  */
 struct _DiaInteractiveRendererInterface
 {
@@ -96,6 +98,11 @@ struct _DiaInteractiveRendererInterface
                                    double                  y,
                                    double                  width,
                                    double                  height);
+  void (*set_preview)             (DiaInteractiveRenderer *self,
+                                   GList                  *objects);
+  void (*move_preview)            (DiaInteractiveRenderer *self,
+                                   double                  dx,
+                                   double                  dy);
 };
 
 
@@ -139,6 +146,11 @@ void dia_interactive_renderer_set_selection           (DiaInteractiveRenderer *s
                                                        double                  y,
                                                        double                  width,
                                                        double                  height);
+gboolean dia_interactive_renderer_set_preview         (DiaInteractiveRenderer *self,
+                                                       GList                  *objects);
+void dia_interactive_renderer_move_preview            (DiaInteractiveRenderer *self,
+                                                       double                  dx,
+                                                       double                  dy);
 
 
 G_END_DECLS
@@ -35,6 +35,7 @@
 #include "dia_dirs.h"
 #include "properties.h" /* stdprops_init() */
 #include "standard-path.h"
+#include "dia_image.h"
 
 
 G_GNUC_PRINTF(3, 0)
@@ -100,6 +101,10 @@ libdia_init (guint flags)
   stdprops_init();
 
   if (flags & DIA_INTERACTIVE) {
+    /* don't stall zooming while image mipmaps get built */
+    dia_image_set_mipmap_async (TRUE);
+    /* nor loading while images get decoded */
+    dia_image_set_decode_async (TRUE);
 #if !GTK_CHECK_VERSION (3, 0, 0)
     char *diagtkrc;
 
@@ -24,6 +24,7 @@
 
 #include <glib/gi18n-lib.h>
 #include <math.h>
+#include <string.h>
 
 #include "diarenderer.h"
 #include "object.h"
@@ -34,6 +35,22 @@
 #include "boundingbox.h" /* PolyBBextra */
 #include "dia-layer.h"
 
+/* the scratch memory is handed out in multiples of this */
+#define SCRATCH_ALIGN 16
+#define SCRATCH_MIN_SIZE 4096
+
+typedef struct _ScratchArena ScratchArena;
+struct _ScratchArena
+{
+  guint8  *block;
+  gsize    size;
+  gsize    used;
+  gpointer overflow;      /* heap blocks taken when the block was full */
+  gsize    overflow_size;
+  gsize    peak;          /* most needed at once since the last reset */
+  guint    allocations;   /* heap allocations since begin_render() */
+};
+
 typedef struct _DiaRendererPrivate DiaRendererPrivate;
 struct _DiaRendererPrivate
 {
@@ -42,7 +59,9 @@ struct _DiaRendererPrivate
                          * this info, but currently _not_ : multi-line text is
                          * growing on every line when zoomed: BUG in font.c  --hb
                          */
+  double   tolerance;   /* maximum deviation of flattened curves */
   BezierApprox *bezier;
+  ScratchArena scratch;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (DiaRenderer, dia_renderer, G_TYPE_OBJECT)
@@ -51,6 +70,7 @@ enum {
   PROP_0,
   PROP_FONT,
   PROP_FONT_HEIGHT,
+  PROP_TOLERANCE,
   LAST_PROP
 };
 
@@ -63,6 +83,9 @@ struct _BezierApprox {
   int currpoint;
 };
 
+/* the default flatness, in cm, was fine enough for the display */
+#define BEZIER_DEFAULT_TOLERANCE 0.001
+
 static void begin_render (DiaRenderer *, const DiaRectangle *update);
 static void end_render (DiaRenderer *);
 
@@ -187,6 +210,9 @@ static gboolean is_capable_to (DiaRenderer *renderer, RenderCapability cap);
 
 static void set_pattern (DiaRenderer *renderer, DiaPattern *pat);
 
+static gboolean begin_symbol (DiaRenderer *renderer, const char *key, DiaMatrix *matrix);
+static void end_symbol (DiaRenderer *renderer);
+
 static void
 dia_renderer_set_property (GObject      *object,
                            guint         property_id,
@@ -204,6 +230,9 @@ dia_renderer_set_property (GObject      *object,
     case PROP_FONT_HEIGHT:
       priv->font_height = g_value_get_double (value);
       break;
+    case PROP_TOLERANCE:
+      priv->tolerance = g_value_get_double (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -226,6 +255,9 @@ dia_renderer_get_property (GObject    *object,
     case PROP_FONT_HEIGHT:
       g_value_set_double (value, priv->font_height);
       break;
+    case PROP_TOLERANCE:
+      g_value_set_double (value, priv->tolerance);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -255,17 +287,15 @@ draw_layer (DiaRenderer  *renderer,
             DiaRectangle *update)
 {
   GList *list = dia_layer_get_object_list (layer);
-  void (*func) (DiaRenderer*, DiaObject *, DiaMatrix *);
 
   g_return_if_fail (layer != NULL);
 
-  func = DIA_RENDERER_GET_CLASS(renderer)->draw_object;
   /* Draw all objects  */
   while (list!=NULL) {
     DiaObject *obj = (DiaObject *) list->data;
 
     if (update==NULL || rectangle_intersects(update, dia_object_get_enclosing_box(obj))) {
-      (*func)(renderer, obj, NULL);
+      dia_renderer_draw_object (renderer, obj, NULL);
     }
     list = g_list_next(list);
   }
@@ -319,6 +349,77 @@ draw_object (DiaRenderer *renderer,
   dia_object_draw (object, renderer);
 }
 
+static void
+_scratch_free_overflow (ScratchArena *arena)
+{
+  while (arena->overflow) {
+    gpointer next = *(gpointer *) arena->overflow;
+
+    g_free (arena->overflow);
+    arena->overflow = next;
+  }
+  arena->overflow_size = 0;
+}
+
+/* what has been handed out since the mark, for all but a reset */
+typedef struct _ScratchMark ScratchMark;
+struct _ScratchMark
+{
+  gsize    used;
+  gpointer overflow;
+  gsize    overflow_size;
+};
+
+static void
+_scratch_mark (ScratchArena *arena, ScratchMark *mark)
+{
+  mark->used = arena->used;
+  mark->overflow = arena->overflow;
+  mark->overflow_size = arena->overflow_size;
+}
+
+/*
+ * Gives back everything handed out since the mark, e.g. after an object
+ * is drawn, so a frame needs only as much as its biggest object.
+ */
+static void
+_scratch_release (ScratchArena *arena, const ScratchMark *mark)
+{
+  arena->peak = MAX (arena->peak, arena->used + arena->overflow_size);
+
+  while (arena->overflow != mark->overflow) {
+    gpointer next = *(gpointer *) arena->overflow;
+
+    g_free (arena->overflow);
+    arena->overflow = next;
+  }
+  arena->overflow_size = mark->overflow_size;
+  arena->used = mark->used;
+}
+
+/*
+ * Everything handed out is released at once. If the block was too small
+ * in the last frame it gets replaced by one big enough for the most that
+ * was needed at once, so redrawing the same thing doesn't allocate anymore.
+ */
+static void
+_scratch_reset (ScratchArena *arena)
+{
+  gsize peak = MAX (arena->peak, arena->used + arena->overflow_size);
+
+  _scratch_free_overflow (arena);
+  if (peak > arena->size) {
+    gsize size = MAX (peak, SCRATCH_MIN_SIZE);
+
+    g_free (arena->block);
+    arena->size = (gsize) 1 << g_bit_storage (size - 1);
+    arena->block = g_malloc (arena->size);
+    arena->allocations++;
+  }
+  arena->used = 0;
+  arena->peak = 0;
+}
+
 static void
 dia_renderer_finalize (GObject *object)
 {
@@ -332,6 +433,9 @@ dia_renderer_finalize (GObject *object)
     g_clear_pointer (&priv->bezier, g_free);
   }
 
+  _scratch_free_overflow (&priv->scratch);
+  g_clear_pointer (&priv->scratch.block, g_free);
+
   G_OBJECT_CLASS (dia_renderer_parent_class)->finalize (object);
 }
 
@@ -388,6 +492,8 @@ dia_renderer_class_init (DiaRendererClass *klass)
   /* other */
   renderer_class->is_capable_to = is_capable_to;
   renderer_class->set_pattern = set_pattern;
+  renderer_class->begin_symbol = begin_symbol;
+  renderer_class->end_symbol = end_symbol;
 
   /**
    * DiaRenderer:font:
@@ -414,6 +520,25 @@ dia_renderer_class_init (DiaRendererClass *klass)
                          0.0,
                          G_PARAM_READWRITE);
 
+  /**
+   * DiaRenderer:tolerance:
+   *
+   * Maximum distance in diagram units between a curve and the polyline
+   * approximating it, used by the fallback draw_bezier() and
+   * draw_beziergon(). Export renderers with a coarser device grid should
+   * set it to about half of their device unit.
+   *
+   * Since: 0.98
+   */
+  pspecs[PROP_TOLERANCE] =
+    g_param_spec_double ("tolerance",
+                         "Tolerance",
+                         "Maximum deviation of flattened curves",
+                         1e-6,
+                         G_MAXDOUBLE,
+                         BEZIER_DEFAULT_TOLERANCE,
+                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
   g_object_class_install_properties (object_class, LAST_PROP, pspecs);
 }
 
@@ -842,123 +967,104 @@ draw_text_line (DiaRenderer  *renderer,
  * [ 1  0  0  0]
  * (At least that's what Hearn and Baker says for beziers.)
  */
-#define BEZIER_SUBDIVIDE_LIMIT 0.001
-#define BEZIER_SUBDIVIDE_LIMIT_SQ (BEZIER_SUBDIVIDE_LIMIT*BEZIER_SUBDIVIDE_LIMIT)
+#define BEZIER_MAX_SEGMENTS 1024
 
 static void
-bezier_add_point(BezierApprox *bezier,
-                 Point *point)
+bezier_reserve (BezierApprox *bezier, int extra)
 {
-  /* Grow if needed: */
-  if (bezier->currpoint == bezier->numpoints) {
-    bezier->numpoints += 40;
-    bezier->points = g_renew (Point, bezier->points, bezier->numpoints);
-  }
+  int needed = bezier->currpoint + extra;
 
-  bezier->points[bezier->currpoint] = *point;
+  if (needed > bezier->numpoints) {
+    int n = MAX (bezier->numpoints, 32);
 
-  bezier->currpoint++;
-}
+    while (n < needed)
+      n *= 2;
 
-static void
-bezier_add_lines(BezierApprox *bezier,
-                 Point points[4])
-{
-  Point u, v, x, y;
-  Point r[4];
-  Point s[4];
-  Point middle;
-  double delta;
-  real v_len_sq;
-
-  /* Check if almost flat: */
-  u = points[1];
-  point_sub(&u, &points[0]);
-  v = points[3];
-  point_sub(&v, &points[0]);
-  y = v;
-  v_len_sq = point_dot(&v,&v);
-  if (isnan(v_len_sq)) {
-    g_warning("v_len_sq is NaN while calculating bezier curve!");
-    return;
-  }
-  if (v_len_sq < 0.000001)
-    v_len_sq = 0.000001;
-  point_scale(&y, point_dot(&u,&v)/v_len_sq);
-  x = u;
-  point_sub(&x,&y);
-  delta = point_dot(&x,&x);
-  if (delta < BEZIER_SUBDIVIDE_LIMIT_SQ) {
-    u = points[2];
-    point_sub(&u, &points[3]);
-    v = points[0];
-    point_sub(&v, &points[3]);
-    y = v;
-    v_len_sq = point_dot(&v,&v);
-    if (v_len_sq < 0.000001)
-      v_len_sq = 0.000001;
-    point_scale(&y, point_dot(&u,&v)/v_len_sq);
-    x = u;
-    point_sub(&x,&y);
-    delta = point_dot(&x,&x);
-    if (delta < BEZIER_SUBDIVIDE_LIMIT_SQ) { /* Almost flat, draw a line */
-      bezier_add_point(bezier, &points[3]);
-      return;
-    }
+    bezier->numpoints = n;
+    bezier->points = g_renew (Point, bezier->points, n);
   }
-  /* Subdivide into two bezier curves: */
+}
 
-  middle = points[1];
-  point_add(&middle, &points[2]);
-  point_scale(&middle, 0.5);
+static void
+bezier_add_point (BezierApprox *bezier,
+                  const Point  *point)
+{
+  bezier_reserve (bezier, 1);
+  bezier->points[bezier->currpoint++] = *point;
+}
 
-  r[0] = points[0];
+/*
+ * The number of uniform steps in t needed to keep the chords within
+ * tolerance of the curve. The second differences of the control polygon
+ * bound the curvature, giving n = sqrt(3/4 * max|P[i] - 2P[i+1] + P[i+2]| / tol)
+ * (Wang's formula). Returns -1 if the control points are not finite.
+ */
+static int
+bezier_segments (const Point points[4], double tolerance)
+{
+  double ax = points[0].x - 2 * points[1].x + points[2].x;
+  double ay = points[0].y - 2 * points[1].y + points[2].y;
+  double bx = points[1].x - 2 * points[2].x + points[3].x;
+  double by = points[1].y - 2 * points[2].y + points[3].y;
+  double dd = MAX (ax * ax + ay * ay, bx * bx + by * by);
+  double n;
 
-  r[1] = points[0];
-  point_add(&r[1], &points[1]);
-  point_scale(&r[1], 0.5);
+  if (!isfinite (dd))
+    return -1;
 
-  r[2] = r[1];
-  point_add(&r[2], &middle);
-  point_scale(&r[2], 0.5);
+  n = ceil (sqrt (0.75 * sqrt (dd) / tolerance));
 
-  s[3] = points[3];
+  return (int) CLAMP (n, 1, BEZIER_MAX_SEGMENTS);
+}
 
-  s[2] = points[2];
-  point_add(&s[2], &points[3]);
-  point_scale(&s[2], 0.5);
+/*
+ * Flatten one cubic without recursion: the segment count is known up
+ * front, so the buffer is grown once and the points are evaluated from
+ * the power basis form. Every iteration is independent, which lets the
+ * compiler vectorize the loop.
+ */
+static void
+bezier_add_curve (BezierApprox *bezier,
+                  const Point   points[4],
+                  double        tolerance)
+{
+  double ax, ay, bx, by, cx, cy, dt;
+  Point *out;
+  int n = bezier_segments (points, tolerance);
+  int i;
 
-  s[1] = s[2];
-  point_add(&s[1], &middle);
-  point_scale(&s[1], 0.5);
+  if (n < 0) {
+    g_warning ("NaN while calculating bezier curve!");
+    return;
+  }
 
-  r[3] = r[2];
-  point_add(&r[3], &s[1]);
-  point_scale(&r[3], 0.5);
+  bezier_reserve (bezier, n);
 
-  s[0] = r[3];
+  cx = 3 * (points[1].x - points[0].x);
+  cy = 3 * (points[1].y - points[0].y);
+  bx = 3 * (points[2].x - points[1].x) - cx;
+  by = 3 * (points[2].y - points[1].y) - cy;
+  ax = points[3].x - points[0].x - cx - bx;
+  ay = points[3].y - points[0].y - cy - by;
 
-  bezier_add_lines(bezier, r);
-  bezier_add_lines(bezier, s);
-}
+  out = bezier->points + bezier->currpoint;
+  dt = 1.0 / n;
+  for (i = 1; i < n; i++) {
+    double t = i * dt;
 
-static void
-bezier_add_curve(BezierApprox *bezier,
-                 Point points[4])
-{
-  /* Is the bezier curve malformed? */
-  if ( (distance_point_point(&points[0], &points[1]) < 0.00001) &&
-       (distance_point_point(&points[2], &points[3]) < 0.00001) &&
-       (distance_point_point(&points[0], &points[3]) < 0.00001)) {
-    bezier_add_point(bezier, &points[3]);
+    out[i - 1].x = ((ax * t + bx) * t + cx) * t + points[0].x;
+    out[i - 1].y = ((ay * t + by) * t + cy) * t + points[0].y;
   }
+  /* hit the end point exactly, the next segment starts there */
+  out[n - 1] = points[3];
 
-  bezier_add_lines(bezier, points);
+  bezier->currpoint += n;
 }
 
 static void
 approximate_bezier (BezierApprox *bezier,
-                    BezPoint *points, int numpoints)
+                    BezPoint *points, int numpoints,
+                    double tolerance)
 {
   Point curve[4];
   int i;
@@ -982,7 +1088,7 @@ approximate_bezier (BezierApprox *bezier,
         curve[1] = points[i].p1;
         curve[2] = points[i].p2;
         curve[3] = points[i].p3;
-        bezier_add_curve(bezier, curve);
+        bezier_add_curve (bezier, curve, tolerance);
         break;
       default:
         g_return_if_reached ();
@@ -1021,18 +1127,14 @@ draw_bezier (DiaRenderer *renderer,
   DiaRendererPrivate *priv = dia_renderer_get_instance_private (renderer);
   BezierApprox *bezier;
 
+  /* the buffer is kept with the renderer and reused for every curve */
   if (priv->bezier)
     bezier = priv->bezier;
   else
     priv->bezier = bezier = g_new0 (BezierApprox, 1);
 
-  if (bezier->points == NULL) {
-    bezier->numpoints = 30;
-    bezier->points = g_new0 (Point, bezier->numpoints);
-  }
-
   bezier->currpoint = 0;
-  approximate_bezier (bezier, points, numpoints);
+  approximate_bezier (bezier, points, numpoints, priv->tolerance);
 
   dia_renderer_draw_polyline (renderer,
                               bezier->points,
@@ -1061,18 +1163,14 @@ draw_beziergon (DiaRenderer *renderer,
 
   g_return_if_fail (fill != NULL || stroke != NULL);
 
+  /* the buffer is kept with the renderer and reused for every curve */
   if (priv->bezier)
     bezier = priv->bezier;
   else
     priv->bezier = bezier = g_new0 (BezierApprox, 1);
 
-  if (bezier->points == NULL) {
-    bezier->numpoints = 30;
-    bezier->points = g_new0 (Point, bezier->numpoints);
-  }
-
   bezier->currpoint = 0;
-  approximate_bezier (bezier, points, numpoints);
+  approximate_bezier (bezier, points, numpoints, priv->tolerance);
 
   if (fill || stroke)
     dia_renderer_draw_polygon (renderer,
@@ -1945,11 +2043,12 @@ get_text_width (DiaRenderer *renderer,
   font = dia_renderer_get_font (renderer, &font_height);
 
   if (font) {
-    char *str = g_strndup (text, length);
+    char *str = dia_renderer_scratch_new (renderer, char, length + 1);
 
-    ret = dia_font_string_width (str, font, font_height);
+    memcpy (str, text, length);
+    str[length] = '\0';
 
-    g_clear_pointer (&str, g_free);
+    ret = dia_font_string_width (str, font, font_height);
   } else {
     g_warning ("%s::get_text_width not implemented (and font == NULL)!",
                G_OBJECT_CLASS_NAME (G_OBJECT_GET_CLASS (renderer)));
@@ -1974,6 +2073,8 @@ get_text_width (DiaRenderer *renderer,
  *  - RENDER_AFFINE : at least draw_object() to be overwritten to support affine transformations.
  *    At some point in time also draw_text() and draw_image() need to handle at least rotation.
  *  - RENDER_PATTERN : set_pattern() overwrite and filling with pattern instead of fill color
+ *  - RENDER_SYMBOLS : begin_symbol() and end_symbol() overwrite to define drawing once
+ *    and instantiate it with a transformation
  *
  * \memberof _DiaRenderer
  */
@@ -1995,6 +2096,29 @@ set_pattern (DiaRenderer *renderer, DiaPattern *pat)
              G_OBJECT_CLASS_NAME (G_OBJECT_GET_CLASS (renderer)));
 }
 
+/*!
+ * \brief Start the definition of a reusable symbol
+ * The base class has no symbol support, the caller has to check for
+ * RENDER_SYMBOLS before relying on the transformation being applied
+ * \memberof _DiaRenderer \pure
+ */
+static gboolean
+begin_symbol (DiaRenderer *renderer, const char *key, DiaMatrix *matrix)
+{
+  g_warning ("%s::begin_symbol not implemented!",
+             G_OBJECT_CLASS_NAME (G_OBJECT_GET_CLASS (renderer)));
+  return TRUE;
+}
+
+/*!
+ * \brief Finish the definition of a reusable symbol
+ * \memberof _DiaRenderer \pure
+ */
+static void
+end_symbol (DiaRenderer *renderer)
+{
+}
+
 static void
 dia_renderer_init (DiaRenderer *self)
 {
@@ -2034,54 +2158,46 @@ dia_renderer_bezier_fill (DiaRenderer *self,
   if (!needs_split) {
     dia_renderer_draw_beziergon (self, pts, total, color, NULL);
   } else {
-    GArray *points = g_array_new (FALSE, FALSE, sizeof(BezPoint));
+    /* every point gets copied once, plus at most one closing line per outline */
+    BezPoint *points = dia_renderer_scratch_new (self, BezPoint, 2 * total);
+    int len = 0;
     Point close_to;
     gboolean needs_close = FALSE;
     /* start with move-to */
-    g_array_append_val (points, pts[0]);
+    points[len++] = pts[0];
     for (i = 1; i < total; ++i) {
       if (BEZ_MOVE_TO == pts[i].type) {
         /* check whether the start point of the second outline is within the first outline. */
-        real dist = distance_bez_shape_point (&g_array_index (points, BezPoint, 0), points->len, 0, &pts[i].p1);
+        real dist = distance_bez_shape_point (points, len, 0, &pts[i].p1);
         if (dist > 0) { /* outside, just create a new one? */
           /* flush what we have */
           if (needs_close) {
-            BezPoint bp;
-            bp.type = BEZ_LINE_TO;
-            bp.p1 = close_to;
-            g_array_append_val(points, bp);
+            points[len].type = BEZ_LINE_TO;
+            points[len].p1 = close_to;
+            len++;
           }
-          dia_renderer_draw_beziergon (self,
-                                       &g_array_index (points, BezPoint, 0),
-                                       points->len,
-                                       color,
-                                       NULL);
-          g_array_set_size (points, 0);
-          g_array_append_val (points, pts[i]); /* new needs move-to */
+          dia_renderer_draw_beziergon (self, points, len, color, NULL);
+          len = 0;
+          points[len++] = pts[i]; /* new needs move-to */
           needs_close = FALSE;
         } else {
-          BezPoint bp = pts[i];
-          bp.type = BEZ_LINE_TO;
           /* just turn the move- to a line-to */
-          g_array_append_val (points, bp);
+          points[len] = pts[i];
+          points[len].type = BEZ_LINE_TO;
+          len++;
           /* and remember the point we lined from */
           close_to = (pts[i-1].type == BEZ_CURVE_TO ? pts[i-1].p3 : pts[i-1].p1);
           needs_close = TRUE;
         }
       } else {
-        g_array_append_val (points, pts[i]);
+        points[len++] = pts[i];
       }
     }
-    if (points->len > 1) {
+    if (len > 1) {
       /* actually most renderers need at least three points, but having only one
        * point is an artifact coming from the algorithm above: "new needs move-to" */
-      dia_renderer_draw_beziergon (self,
-                                   &g_array_index (points, BezPoint, 0),
-                                   points->len,
-                                   color,
-                                   NULL);
+      dia_renderer_draw_beziergon (self, points, len, color, NULL);
     }
-    g_array_free (points, TRUE);
   }
 }
 
@@ -2177,9 +2293,17 @@ dia_renderer_draw_object (DiaRenderer      *self,
                           DiaObject        *object,
                           DiaMatrix        *matrix)
 {
+  DiaRendererPrivate *priv;
+  ScratchMark mark;
+
   g_return_if_fail (DIA_IS_RENDERER (self));
 
+  priv = dia_renderer_get_instance_private (self);
+  _scratch_mark (&priv->scratch, &mark);
+
   DIA_RENDERER_GET_CLASS (self)->draw_object (self, object, matrix);
+
+  _scratch_release (&priv->scratch, &mark);
 }
 
 
@@ -2198,8 +2322,14 @@ void
 dia_renderer_begin_render (DiaRenderer        *self,
                            const DiaRectangle *update)
 {
+  DiaRendererPrivate *priv;
+
   g_return_if_fail (DIA_IS_RENDERER (self));
 
+  priv = dia_renderer_get_instance_private (self);
+  priv->scratch.allocations = 0;
+  _scratch_reset (&priv->scratch);
+
   DIA_RENDERER_GET_CLASS (self)->begin_render (self, update);
 }
 
@@ -2207,9 +2337,89 @@ dia_renderer_begin_render (DiaRenderer        *self,
 void
 dia_renderer_end_render (DiaRenderer      *self)
 {
+  DiaRendererPrivate *priv;
+
   g_return_if_fail (DIA_IS_RENDERER (self));
 
   DIA_RENDERER_GET_CLASS (self)->end_render (self);
+
+  priv = dia_renderer_get_instance_private (self);
+  _scratch_reset (&priv->scratch);
+}
+
+
+/**
+ * dia_renderer_scratch_alloc:
+ * @self: the #DiaRenderer
+ * @size: number of bytes needed
+ *
+ * Temporary memory for drawing, e.g. the points of a transformed polyline.
+ * It must not be freed and stays valid until the object being drawn
+ * with dia_renderer_draw_object() is done, or otherwise until the
+ * renderer's next dia_renderer_begin_render() or dia_renderer_end_render(),
+ * so it is fine for the duration of a draw call but not to be kept.
+ *
+ * Once the scratch memory has grown to what a frame needs, redrawing
+ * does not touch the heap anymore. Use dia_renderer_scratch_new() for
+ * typed arrays.
+ *
+ * Returns: (transfer none): uninitialized memory, aligned for any type
+ *
+ * Since: 0.98
+ */
+gpointer
+dia_renderer_scratch_alloc (DiaRenderer *self,
+                            gsize        size)
+{
+  DiaRendererPrivate *priv;
+  ScratchArena *arena;
+  gsize offset;
+  guint8 *mem;
+
+  g_return_val_if_fail (DIA_IS_RENDERER (self), NULL);
+
+  priv = dia_renderer_get_instance_private (self);
+  arena = &priv->scratch;
+
+  offset = (arena->used + SCRATCH_ALIGN - 1) & ~((gsize) SCRATCH_ALIGN - 1);
+  if (arena->block && offset + size <= arena->size) {
+    arena->used = offset + size;
+    return arena->block + offset;
+  }
+
+  /* full, take it from the heap until the next reset makes room */
+  mem = g_malloc (size + SCRATCH_ALIGN);
+  *(gpointer *) mem = arena->overflow;
+  arena->overflow = mem;
+  arena->overflow_size += size + SCRATCH_ALIGN;
+  arena->allocations++;
+
+  return mem + SCRATCH_ALIGN;
+}
+
+
+/**
+ * dia_renderer_get_scratch_allocations:
+ * @self: the #DiaRenderer
+ *
+ * How often the scratch memory had to go to the heap since the last
+ * dia_renderer_begin_render(). Drawing the same diagram a second time
+ * should not need any.
+ *
+ * Returns: the number of heap allocations of the current frame
+ *
+ * Since: 0.98
+ */
+guint
+dia_renderer_get_scratch_allocations (DiaRenderer *self)
+{
+  DiaRendererPrivate *priv;
+
+  g_return_val_if_fail (DIA_IS_RENDERER (self), 0);
+
+  priv = dia_renderer_get_instance_private (self);
+
+  return priv->scratch.allocations;
 }
 
 
@@ -2694,3 +2904,50 @@ dia_renderer_draw_rotated_image (DiaRenderer      *self,
                                                      angle,
                                                      image);
 }
+
+
+/**
+ * dia_renderer_begin_symbol:
+ * @self: the #DiaRenderer
+ * @key: identifies the drawing, equal keys must produce equal drawings
+ * @matrix: placement of this instance
+ *
+ * Only to be used with renderers capable of %RENDER_SYMBOLS
+ *
+ * If a symbol with @key was already defined the renderer places another
+ * instance of it transformed by @matrix and %FALSE is returned. Otherwise
+ * the caller has to draw the symbol in its own coordinates followed by
+ * dia_renderer_end_symbol(), which places the first instance.
+ *
+ * Returns: %TRUE if the symbol has to be drawn
+ *
+ * Since: 0.98
+ */
+gboolean
+dia_renderer_begin_symbol (DiaRenderer      *self,
+                           const char       *key,
+                           DiaMatrix        *matrix)
+{
+  g_return_val_if_fail (DIA_IS_RENDERER (self), TRUE);
+  g_return_val_if_fail (key != NULL, TRUE);
+  g_return_val_if_fail (matrix != NULL, TRUE);
+
+  return DIA_RENDERER_GET_CLASS (self)->begin_symbol (self, key, matrix);
+}
+
+
+/**
+ * dia_renderer_end_symbol:
+ * @self: the #DiaRenderer
+ *
+ * Finish the symbol started by dia_renderer_begin_symbol()
+ *
+ * Since: 0.98
+ */
+void
+dia_renderer_end_symbol (DiaRenderer      *self)
+{
+  g_return_if_fail (DIA_IS_RENDERER (self));
+
+  DIA_RENDERER_GET_CLASS (self)->end_symbol (self);
+}
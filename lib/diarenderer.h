@@ -36,7 +36,8 @@ typedef enum {
   RENDER_HOLES   = (1<<0),
   RENDER_ALPHA   = (1<<1),
   RENDER_AFFINE  = (1<<2),
-  RENDER_PATTERN = (1<<3)
+  RENDER_PATTERN = (1<<3),
+  RENDER_SYMBOLS = (1<<4)
 } RenderCapability;
 
 #define DIA_TYPE_RENDERER dia_renderer_get_type ()
@@ -102,6 +103,9 @@ G_DECLARE_DERIVABLE_TYPE (DiaRenderer, dia_renderer, DIA, RENDERER, GObject)
  *    angle in degrees
  * @draw_rotated_image: draw image rotated around center with given angle
  *    in degrees
+ * @begin_symbol: start or reuse a shared definition, see
+ *    dia_renderer_begin_symbol()
+ * @end_symbol: finish the definition started with @begin_symbol
  *
  * Base class for all of Dia's render facilities
  *
@@ -278,6 +282,10 @@ struct _DiaRendererClass
                                                  real              height,
                                                  real              angle,
                                                  DiaImage         *image);
+  gboolean (*begin_symbol)                      (DiaRenderer      *renderer,
+                                                 const char       *key,
+                                                 DiaMatrix        *matrix);
+  void     (*end_symbol)                        (DiaRenderer      *renderer);
 };
 
 void     dia_renderer_draw_layer                        (DiaRenderer      *self,
@@ -435,6 +443,10 @@ void     dia_renderer_draw_rotated_image                (DiaRenderer      *self,
                                                          real              height,
                                                          real              angle,
                                                          DiaImage         *image);
+gboolean dia_renderer_begin_symbol                      (DiaRenderer      *self,
+                                                         const char       *key,
+                                                         DiaMatrix        *matrix);
+void     dia_renderer_end_symbol                        (DiaRenderer      *self);
 
 void     dia_renderer_bezier_fill                       (DiaRenderer      *self,
                                                          BezPoint         *pts,
@@ -445,6 +457,23 @@ void     dia_renderer_bezier_stroke                     (DiaRenderer      *self,
                                                          int               total,
                                                          Color            *color);
 
+gpointer dia_renderer_scratch_alloc                     (DiaRenderer      *self,
+                                                         gsize             size);
+guint    dia_renderer_get_scratch_allocations           (DiaRenderer      *self);
+
+/**
+ * dia_renderer_scratch_new:
+ * @renderer: the #DiaRenderer
+ * @struct_type: the type of the elements
+ * @n_structs: the number of elements
+ *
+ * Typed dia_renderer_scratch_alloc()
+ *
+ * Since: 0.98
+ */
+#define dia_renderer_scratch_new(renderer, struct_type, n_structs) \
+  ((struct_type *) dia_renderer_scratch_alloc ((renderer), sizeof (struct_type) * (gsize) (n_structs)))
+
 /*! \brief query DIA_RENDER_BOUNDING_BOXES */
 int render_bounding_boxes (void);
 
@@ -41,6 +41,7 @@
 #include <libxml/entities.h>
 #include <libxml/tree.h>
 #include <libxml/xmlmemory.h>
+#include <libxml/xmlIO.h>
 
 #include "geometry.h"
 #include "dia_xml_libxml.h"
@@ -184,6 +185,46 @@ _gradient_do (gpointer key,
   }
 }
 
+/*
+ * The shared styles as a CSS style sheet, NULL if there are none
+ */
+static xmlNodePtr
+_make_style_node (DiaSvgRenderer *renderer)
+{
+  xmlNodePtr node;
+  GString *css;
+  guint i;
+
+  if (!renderer->class_styles || renderer->class_styles->len == 0)
+    return NULL;
+
+  css = g_string_new ("\n");
+  for (i = 0; i < renderer->class_styles->len; i++) {
+    g_string_append_printf (css, ".s%u { %s }\n",
+                            i, (char *) g_ptr_array_index (renderer->class_styles, i));
+  }
+
+  node = xmlNewNode (renderer->svg_name_space, (const xmlChar *)"style");
+  xmlSetProp (node, (const xmlChar *)"type", (const xmlChar *)"text/css");
+  xmlAddChild (node, xmlNewCDataBlock (renderer->doc, (const xmlChar *) css->str, css->len));
+  g_string_free (css, TRUE);
+
+  /* the next rendering starts over */
+  g_hash_table_remove_all (renderer->classes);
+  g_ptr_array_set_size (renderer->class_styles, 0);
+
+  return node;
+}
+
+static void
+_prepend_child (xmlNodePtr parent, xmlNodePtr node)
+{
+  if (parent->children)
+    xmlAddPrevSibling (parent->children, node);
+  else
+    xmlAddChild (parent, node);
+}
+
 /*!
  * \brief Flush all pending information to file
  * \memberof _DiaSvgRenderer
@@ -192,20 +233,53 @@ static void
 end_render(DiaRenderer *self)
 {
   DiaSvgRenderer *renderer = DIA_SVG_RENDERER (self);
+  xmlNodePtr root = xmlDocGetRootElement (renderer->doc);
+  xmlNodePtr defs = NULL;
+  xmlNodePtr style;
+
   g_clear_pointer (&renderer->linestyle, g_free);
 
+  /* symbols referenced by <use> go first */
+  defs = g_steal_pointer (&renderer->symbol_defs);
+  g_clear_pointer (&renderer->symbols, g_hash_table_destroy);
+
   /* handle potential patterns */
   if (renderer->patterns) {
-    xmlNodePtr root = xmlDocGetRootElement (renderer->doc);
-    xmlNodePtr defs = xmlNewNode (renderer->svg_name_space, (const xmlChar *)"defs");
-    GradientData gd = { renderer, defs };
+    GradientData gd;
+
+    if (!defs)
+      defs = xmlNewNode (renderer->svg_name_space, (const xmlChar *)"defs");
+    gd.renderer = renderer;
+    gd.node = defs;
     g_hash_table_foreach (renderer->patterns, _gradient_do, &gd);
-    xmlAddPrevSibling (root->children, defs);
     g_hash_table_destroy (renderer->patterns);
     renderer->patterns = NULL;
   }
-  xmlSetDocCompressMode(renderer->doc, 0);
-  xmlDiaSaveFile(renderer->filename, renderer->doc);
+  style = _make_style_node (renderer);
+
+  if (renderer->output) {
+    /* everything else is already written, references may point forward */
+    if (defs) {
+      xmlNodeDumpOutput (renderer->output, renderer->doc, defs, 1, 1, "UTF-8");
+      xmlOutputBufferWriteString (renderer->output, "\n");
+      xmlFreeNode (defs);
+    }
+    if (style) {
+      xmlNodeDumpOutput (renderer->output, renderer->doc, style, 1, 1, "UTF-8");
+      xmlOutputBufferWriteString (renderer->output, "\n");
+      xmlFreeNode (style);
+    }
+    dia_svg_renderer_stream_end_tag (renderer, root);
+    xmlOutputBufferClose (renderer->output);
+    renderer->output = NULL;
+  } else {
+    if (defs)
+      _prepend_child (root, defs);
+    if (style)
+      _prepend_child (root, style);
+    xmlSetDocCompressMode(renderer->doc, 0);
+    xmlDiaSaveFile(renderer->filename, renderer->doc);
+  }
   g_clear_pointer (&renderer->filename, g_free);
   xmlFreeDoc(renderer->doc);
 }
@@ -228,6 +302,108 @@ is_capable_to (DiaRenderer *renderer, RenderCapability cap)
   return FALSE;
 }
 
+/*!
+ * \brief Place an instance of a symbol with <use>
+ */
+static void
+_use_symbol (DiaSvgRenderer *renderer, const char *id, const DiaMatrix *m)
+{
+  xmlNodePtr node;
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+  GString *str = g_string_new ("#");
+
+  node = xmlNewChild (renderer->root, renderer->svg_name_space,
+                      (const xmlChar *) "use", NULL);
+  g_string_append (str, id);
+  xmlSetProp (node, (const xmlChar *) "xlink:href", (xmlChar *) str->str);
+
+  if (m->xx == 1.0 && m->yx == 0.0 && m->xy == 0.0 && m->yy == 1.0) {
+    g_string_assign (str, "translate(");
+  } else {
+    g_string_assign (str, "matrix(");
+    g_string_append (str, g_ascii_formatd (buf, sizeof (buf), "%g", m->xx));
+    g_string_append_c (str, ',');
+    g_string_append (str, g_ascii_formatd (buf, sizeof (buf), "%g", m->yx));
+    g_string_append_c (str, ',');
+    g_string_append (str, g_ascii_formatd (buf, sizeof (buf), "%g", m->xy));
+    g_string_append_c (str, ',');
+    g_string_append (str, g_ascii_formatd (buf, sizeof (buf), "%g", m->yy));
+    g_string_append_c (str, ',');
+  }
+  g_string_append (str, g_ascii_formatd (buf, sizeof (buf), "%g", m->x0 * renderer->scale));
+  g_string_append_c (str, ',');
+  g_string_append (str, g_ascii_formatd (buf, sizeof (buf), "%g", m->y0 * renderer->scale));
+  g_string_append_c (str, ')');
+  xmlSetProp (node, (const xmlChar *) "transform", (xmlChar *) str->str);
+
+  g_string_free (str, TRUE);
+}
+
+/*!
+ * \brief Reuse or start a symbol definition
+ *
+ * The drawing of a new symbol is collected below a <g> in the <defs>,
+ * every instance - including the first - is a <use> element referencing it.
+ * Only derived classes advertising RENDER_SYMBOLS get this called.
+ *
+ * \memberof _DiaSvgRenderer
+ */
+static gboolean
+begin_symbol (DiaRenderer *self, const char *key, DiaMatrix *matrix)
+{
+  DiaSvgRenderer *renderer = DIA_SVG_RENDERER (self);
+  const char *id;
+  char *new_id;
+
+  g_return_val_if_fail (renderer->symbol_parent == NULL, TRUE);
+
+  if (!renderer->symbols)
+    renderer->symbols = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_free);
+
+  id = g_hash_table_lookup (renderer->symbols, key);
+  if (id) {
+    _use_symbol (renderer, id, matrix);
+    return FALSE;
+  }
+
+  new_id = g_strdup_printf ("symbol%u", g_hash_table_size (renderer->symbols));
+  g_hash_table_insert (renderer->symbols, g_strdup (key), new_id);
+
+  if (!renderer->symbol_defs)
+    renderer->symbol_defs = xmlNewNode (renderer->svg_name_space,
+                                        (const xmlChar *) "defs");
+
+  renderer->symbol_parent = renderer->root;
+  renderer->symbol_matrix = *matrix;
+  renderer->root = xmlNewChild (renderer->symbol_defs,
+                                renderer->svg_name_space,
+                                (const xmlChar *) "g", NULL);
+  xmlSetProp (renderer->root, (const xmlChar *) "id", (xmlChar *) new_id);
+
+  return TRUE;
+}
+
+/*!
+ * \brief Finish the symbol definition and place the first instance
+ * \memberof _DiaSvgRenderer
+ */
+static void
+end_symbol (DiaRenderer *self)
+{
+  DiaSvgRenderer *renderer = DIA_SVG_RENDERER (self);
+  xmlChar *id;
+
+  g_return_if_fail (renderer->symbol_parent != NULL);
+
+  id = xmlGetProp (renderer->root, (const xmlChar *) "id");
+  renderer->root = renderer->symbol_parent;
+  renderer->symbol_parent = NULL;
+
+  _use_symbol (renderer, (const char *) id, &renderer->symbol_matrix);
+  xmlFree (id);
+}
+
 /*!
  * \brief Set line width
  * \memberof _DiaSvgRenderer
@@ -472,7 +648,7 @@ draw_line(DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, renderer->svg_name_space, (const xmlChar *)"line", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) get_draw_style(renderer, NULL, line_colour));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, NULL, line_colour));
 
   dia_svg_dtostr(d_buf, start->x);
   xmlSetProp(node, (const xmlChar *)"x1", (xmlChar *) d_buf);
@@ -502,7 +678,7 @@ draw_polyline(DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, renderer->svg_name_space, (const xmlChar *)"polyline", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) get_draw_style(renderer, NULL, line_colour));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, NULL, line_colour));
 
   str = g_string_new(NULL);
   for (i = 0; i < num_points; i++)
@@ -531,7 +707,7 @@ draw_polygon (DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, renderer->svg_name_space, (const xmlChar *)"polygon", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) get_draw_style (renderer, fill, stroke));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, fill, stroke));
 
   if (fill)
     xmlSetProp(node, (const xmlChar *)"fill-rule", (const xmlChar *) "evenodd");
@@ -560,7 +736,7 @@ draw_rect(DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, NULL, (const xmlChar *)"rect", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) get_draw_style (renderer, fill, stroke));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, fill, stroke));
 
   dia_svg_dtostr(d_buf, ul_corner->x);
   xmlSetProp(node, (const xmlChar *)"x", (xmlChar *) d_buf);
@@ -604,7 +780,7 @@ draw_arc(DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, renderer->svg_name_space, (const xmlChar *)"path", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) get_draw_style(renderer, NULL, colour));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, NULL, colour));
 
   g_snprintf(buf, sizeof(buf), "M %s,%s A %s,%s 0 %d %d %s,%s",
 	     dia_svg_dtostr(sx_buf, sx), dia_svg_dtostr(sy_buf, sy),
@@ -647,7 +823,7 @@ fill_arc(DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, NULL, (const xmlChar *)"path", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *)get_draw_style(renderer, colour, NULL));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, colour, NULL));
 
   g_snprintf(buf, sizeof(buf), "M %s,%s A %s,%s 0 %d %d %s,%s L %s,%s z",
 	     dia_svg_dtostr(sx_buf, sx), dia_svg_dtostr(sy_buf, sy),
@@ -676,7 +852,7 @@ draw_ellipse(DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, renderer->svg_name_space, (const xmlChar *)"ellipse", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) get_draw_style (renderer, fill, stroke));
+  dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, fill, stroke));
 
   dia_svg_dtostr(d_buf, center->x);
   xmlSetProp(node, (const xmlChar *)"cx", (xmlChar *) d_buf);
@@ -710,7 +886,7 @@ _bezier(DiaRenderer *self,
   node = xmlNewChild(renderer->root, renderer->svg_name_space, (const xmlChar *)"path", NULL);
 
   if (fill || stroke)
-    xmlSetProp(node, (const xmlChar *)"style", (xmlChar *)get_draw_style(renderer, fill, stroke));
+    dia_svg_renderer_set_style (renderer, node, get_draw_style (renderer, fill, stroke));
 
   str = g_string_new(NULL);
 
@@ -870,7 +1046,7 @@ draw_text_line (DiaRenderer  *self,
 			  dia_font_get_slant_string(font),
 			  dia_font_get_weight_string(font));
 
-  xmlSetProp(node, (const xmlChar *)"style", (xmlChar *) style->str);
+  dia_svg_renderer_set_style (renderer, node, style->str);
   g_string_free (style, TRUE);
 
   dia_svg_dtostr(d_buf, pos->x);
@@ -946,8 +1122,8 @@ draw_rounded_rect (DiaRenderer *self,
 
   node = xmlNewChild(renderer->root, NULL, (const xmlChar *)"rect", NULL);
 
-  xmlSetProp(node, (const xmlChar *)"style",
-	     (const xmlChar *)DIA_SVG_RENDERER_GET_CLASS(self)->get_draw_style (renderer, fill, stroke));
+  dia_svg_renderer_set_style (renderer, node,
+                              DIA_SVG_RENDERER_GET_CLASS (self)->get_draw_style (renderer, fill, stroke));
 
   g_ascii_formatd(buf, sizeof(buf), "%g", ul_corner->x * renderer->scale);
   xmlSetProp(node, (const xmlChar *)"x", (xmlChar *) buf);
@@ -962,6 +1138,191 @@ draw_rounded_rect (DiaRenderer *self,
   xmlSetProp(node, (const xmlChar *)"ry", (xmlChar *) buf);
 }
 
+/**
+ * dia_svg_renderer_set_share_styles:
+ * @self: the #DiaSvgRenderer
+ * @share: %TRUE to refer to styles by class
+ *
+ * With many elements drawn alike, most of an SVG file is repeated style
+ * attributes. Instead every distinct style can be written once into a
+ * &lt;style&gt; sheet, with the elements only naming their class.
+ *
+ * Since: 0.98
+ */
+void
+dia_svg_renderer_set_share_styles (DiaSvgRenderer *self,
+                                   gboolean        share)
+{
+  g_return_if_fail (DIA_IS_SVG_RENDERER (self));
+
+  if (share && !self->classes) {
+    self->classes = g_hash_table_new (g_str_hash, g_str_equal);
+    self->class_styles = g_ptr_array_new_with_free_func (g_free);
+  } else if (!share) {
+    g_clear_pointer (&self->classes, g_hash_table_destroy);
+    g_clear_pointer (&self->class_styles, g_ptr_array_unref);
+  }
+}
+
+/**
+ * dia_svg_renderer_set_style:
+ * @self: the #DiaSvgRenderer
+ * @node: the element to style
+ * @style: CSS declarations, e.g. from #DiaSvgRendererClass.get_draw_style
+ *
+ * Set the style attribute of @node, or its class when styles are shared.
+ *
+ * Since: 0.98
+ */
+void
+dia_svg_renderer_set_style (DiaSvgRenderer *self,
+                            xmlNodePtr      node,
+                            const char     *style)
+{
+  gpointer index;
+  char klass[16];
+
+  if (!self->classes) {
+    xmlSetProp (node, (const xmlChar *)"style", (const xmlChar *) style);
+    return;
+  }
+
+  /* indices are stored off by one to tell them from a miss */
+  index = g_hash_table_lookup (self->classes, style);
+  if (!index) {
+    char *key = g_strdup (style);
+
+    g_ptr_array_add (self->class_styles, key);
+    index = GUINT_TO_POINTER (self->class_styles->len);
+    g_hash_table_insert (self->classes, key, index);
+  }
+
+  g_snprintf (klass, sizeof (klass), "s%u", GPOINTER_TO_UINT (index) - 1);
+  xmlSetProp (node, (const xmlChar *)"class", (const xmlChar *) klass);
+}
+
+/**
+ * dia_svg_renderer_open_stream:
+ * @self: the #DiaSvgRenderer
+ *
+ * Instead of building the whole document and saving it in end_render(),
+ * write it to #DiaSvgRenderer:filename while rendering. The root element
+ * has to be complete, the derived class then hands over finished elements
+ * with dia_svg_renderer_stream_children().
+ *
+ * Returns: %FALSE if the file can't be written
+ *
+ * Since: 0.98
+ */
+gboolean
+dia_svg_renderer_open_stream (DiaSvgRenderer *self)
+{
+  xmlNodePtr root;
+
+  g_return_val_if_fail (DIA_IS_SVG_RENDERER (self), FALSE);
+  g_return_val_if_fail (self->output == NULL, FALSE);
+
+  root = xmlDocGetRootElement (self->doc);
+  g_return_val_if_fail (root != NULL, FALSE);
+
+  self->output = xmlOutputBufferCreateFilename (self->filename, NULL, 0);
+  if (!self->output)
+    return FALSE;
+
+  xmlOutputBufferWriteString (self->output,
+                              "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n");
+  if (self->doc->intSubset) {
+    xmlNodeDumpOutput (self->output, self->doc, (xmlNodePtr) self->doc->intSubset, 0, 0, "UTF-8");
+    xmlOutputBufferWriteString (self->output, "\n");
+  }
+  dia_svg_renderer_stream_start_tag (self, root);
+
+  return TRUE;
+}
+
+/**
+ * dia_svg_renderer_stream_start_tag:
+ * @self: the #DiaSvgRenderer
+ * @node: the element
+ *
+ * Write the start tag of @node with its attributes, but not its children.
+ *
+ * Since: 0.98
+ */
+void
+dia_svg_renderer_stream_start_tag (DiaSvgRenderer *self,
+                                   xmlNodePtr      node)
+{
+  xmlAttrPtr attr;
+
+  g_return_if_fail (self->output != NULL);
+
+  xmlOutputBufferWriteString (self->output, "<");
+  xmlOutputBufferWriteString (self->output, (const char *) node->name);
+  for (attr = node->properties; attr != NULL; attr = attr->next) {
+    xmlChar *value = xmlNodeListGetString (node->doc, attr->children, 1);
+    xmlChar *escaped = xmlEncodeSpecialChars (self->doc, value);
+
+    xmlOutputBufferWriteString (self->output, " ");
+    if (attr->ns && attr->ns->prefix) {
+      xmlOutputBufferWriteString (self->output, (const char *) attr->ns->prefix);
+      xmlOutputBufferWriteString (self->output, ":");
+    }
+    xmlOutputBufferWriteString (self->output, (const char *) attr->name);
+    xmlOutputBufferWriteString (self->output, "=\"");
+    xmlOutputBufferWriteString (self->output, escaped ? (const char *) escaped : "");
+    xmlOutputBufferWriteString (self->output, "\"");
+
+    xmlFree (escaped);
+    xmlFree (value);
+  }
+  xmlOutputBufferWriteString (self->output, ">\n");
+}
+
+/**
+ * dia_svg_renderer_stream_end_tag:
+ * @self: the #DiaSvgRenderer
+ * @node: the element
+ *
+ * Since: 0.98
+ */
+void
+dia_svg_renderer_stream_end_tag (DiaSvgRenderer *self,
+                                 xmlNodePtr      node)
+{
+  g_return_if_fail (self->output != NULL);
+
+  xmlOutputBufferWriteString (self->output, "</");
+  xmlOutputBufferWriteString (self->output, (const char *) node->name);
+  xmlOutputBufferWriteString (self->output, ">\n");
+}
+
+/**
+ * dia_svg_renderer_stream_children:
+ * @self: the #DiaSvgRenderer
+ * @node: the parent element
+ *
+ * Write all the children of @node and free them, so the memory used
+ * doesn't grow with the size of the diagram.
+ *
+ * Since: 0.98
+ */
+void
+dia_svg_renderer_stream_children (DiaSvgRenderer *self,
+                                  xmlNodePtr      node)
+{
+  xmlNodePtr child;
+
+  g_return_if_fail (self->output != NULL);
+
+  while ((child = node->children) != NULL) {
+    xmlUnlinkNode (child);
+    xmlNodeDumpOutput (self->output, self->doc, child, 1, 1, "UTF-8");
+    xmlOutputBufferWriteString (self->output, "\n");
+    xmlFreeNode (child);
+  }
+}
+
 /* constructor */
 static void
 dia_svg_renderer_init (DiaSvgRenderer *self)
@@ -975,6 +1336,13 @@ static gpointer parent_class = NULL;
 static void
 dia_svg_renderer_finalize (GObject *object)
 {
+  DiaSvgRenderer *renderer = DIA_SVG_RENDERER (object);
+
+  dia_svg_renderer_set_share_styles (renderer, FALSE);
+  g_clear_pointer (&renderer->output, xmlOutputBufferClose);
+  g_clear_pointer (&renderer->symbols, g_hash_table_destroy);
+  g_clear_pointer (&renderer->symbol_defs, xmlFreeNode);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1003,6 +1371,9 @@ dia_svg_renderer_class_init (DiaSvgRendererClass *klass)
   renderer_class->set_fillstyle  = set_fillstyle;
   renderer_class->set_pattern    = set_pattern;
 
+  renderer_class->begin_symbol   = begin_symbol;
+  renderer_class->end_symbol     = end_symbol;
+
   renderer_class->draw_line    = draw_line;
   renderer_class->draw_polygon = draw_polygon;
   renderer_class->draw_arc     = draw_arc;
@@ -35,6 +35,22 @@ struct _DiaSvgRenderer
   DiaPattern *active_pattern;
   /*! \private all patterns seen between begin_render and end_render */
   GHashTable *patterns;
+
+  /*! \private style string to class index, see dia_svg_renderer_set_style() */
+  GHashTable *classes;
+  /*! \private the style strings in class index order */
+  GPtrArray *class_styles;
+  /*! \private write elements as they are done, see dia_svg_renderer_open_stream() */
+  xmlOutputBufferPtr output;
+
+  /*! \private symbol key to id, see dia_renderer_begin_symbol() */
+  GHashTable *symbols;
+  /*! \private the symbol definitions, written with the other defs */
+  xmlNodePtr symbol_defs;
+  /*! \private the root to restore while a symbol is defined */
+  xmlNodePtr symbol_parent;
+  /*! \private placement of the symbol being defined */
+  DiaMatrix symbol_matrix;
 };
 
 struct _DiaSvgRendererClass
@@ -44,6 +60,19 @@ struct _DiaSvgRendererClass
   const gchar* (*get_draw_style) (DiaSvgRenderer*, Color* fill, Color *stroke);
 };
 
+void     dia_svg_renderer_set_share_styles  (DiaSvgRenderer *self,
+                                            gboolean        share);
+void     dia_svg_renderer_set_style         (DiaSvgRenderer *self,
+                                            xmlNodePtr      node,
+                                            const char     *style);
+gboolean dia_svg_renderer_open_stream       (DiaSvgRenderer *self);
+void     dia_svg_renderer_stream_start_tag  (DiaSvgRenderer *self,
+                                            xmlNodePtr      node);
+void     dia_svg_renderer_stream_end_tag    (DiaSvgRenderer *self,
+                                            xmlNodePtr      node);
+void     dia_svg_renderer_stream_children   (DiaSvgRenderer *self,
+                                            xmlNodePtr      node);
+
 G_END_DECLS
 
 #endif /* DIA_SVG_RENDERER_H */
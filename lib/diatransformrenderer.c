@@ -44,6 +44,8 @@ struct _DiaTransformRenderer
   DiaRenderer *worker; /*!< the renderer with real output */
 
   GQueue *matrices;
+
+  GArray *path; /*!< reused to build arcs and ellipses */
 };
 
 struct _DiaTransformRendererClass
@@ -78,6 +80,7 @@ static void
 dia_transform_renderer_init (DiaTransformRenderer *self)
 {
   self->matrices = g_queue_new ();
+  self->path = g_array_new (FALSE, FALSE, sizeof (BezPoint));
 }
 
 
@@ -92,8 +95,11 @@ dia_path_renderer_finalize (GObject *object)
   DiaTransformRenderer *self = DIA_TRANSFORM_RENDERER (object);
 
   g_queue_free (self->matrices);
+  g_array_free (self->path, TRUE);
   /* drop our reference */
   g_clear_object (&self->worker);
+
+  G_OBJECT_CLASS (dia_transform_renderer_parent_class)->finalize (object);
 }
 
 
@@ -244,10 +250,12 @@ _polyline (DiaRenderer *self,
            Color       *stroke,
            gboolean     closed)
 {
-  Point *a_pts = g_newa (Point, num_points);
   DiaTransformRenderer *renderer = DIA_TRANSFORM_RENDERER (self);
   DiaMatrix *m = g_queue_peek_tail (renderer->matrices);
+  Point *a_pts;
   g_return_if_fail (renderer->worker != NULL);
+  /* the worker is the one getting begin_render() */
+  a_pts = dia_renderer_scratch_new (renderer->worker, Point, num_points);
   memcpy (a_pts, points, sizeof(Point)*num_points);
   if (m) {
     int i;
@@ -298,12 +306,13 @@ _bezier (DiaRenderer *self,
          Color       *stroke,
          gboolean     closed)
 {
-  BezPoint *a_pts = g_newa (BezPoint, num_points);
   DiaTransformRenderer *renderer = DIA_TRANSFORM_RENDERER (self);
   DiaMatrix *m = g_queue_peek_tail (renderer->matrices);
+  BezPoint *a_pts;
 
   g_return_if_fail (renderer->worker != NULL);
 
+  a_pts = dia_renderer_scratch_new (renderer->worker, BezPoint, num_points);
   memcpy (a_pts, points, sizeof(BezPoint)*num_points);
   if (m) {
     int i;
@@ -328,10 +337,11 @@ _arc (DiaRenderer *self,
       real angle1, real angle2,
       Color *stroke, Color *fill)
 {
-  GArray *path = g_array_new (FALSE, FALSE, sizeof(BezPoint));
+  GArray *path = DIA_TRANSFORM_RENDERER (self)->path;
+
+  g_array_set_size (path, 0);
   path_build_arc (path, center, width, height, angle1, angle2, stroke == NULL);
   _bezier (self, &g_array_index (path, BezPoint, 0), path->len, fill, stroke, fill!=NULL);
-  g_array_free (path, TRUE);
 }
 
 /*!
@@ -370,10 +380,11 @@ draw_ellipse (DiaRenderer *self,
 	      real width, real height,
 	      Color *fill, Color *stroke)
 {
-  GArray *path = g_array_new (FALSE, FALSE, sizeof(BezPoint));
+  GArray *path = DIA_TRANSFORM_RENDERER (self)->path;
+
+  g_array_set_size (path, 0);
   path_build_ellipse (path, center, width, height);
   _bezier (self, &g_array_index (path, BezPoint, 0), path->len, fill, stroke, fill!=NULL);
-  g_array_free (path, TRUE);
 }
 /*!
  * \brief Transform bezier and delegate draw
@@ -517,6 +517,25 @@ element_destroy (Element *elem)
 }
 
 
+/**
+ * element_get_memory_size:
+ * @elem: the #Element
+ * @struct_size: sizeof the object's structure
+ *
+ * The memory used by @elem as an #Element, see object_get_memory_size().
+ * The handles are part of the structure.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+element_get_memory_size (Element *elem, gsize struct_size)
+{
+  return object_get_memory_size (&elem->object, struct_size);
+}
+
+
 /**
  * element_save:
  * @elem: the #Element to save
@@ -70,6 +70,7 @@ void element_update_boundingbox(Element *elem);
 void element_init(Element *elem, int num_handles, int num_connections);
 void element_destroy(Element *elem);
 void element_copy(Element *from, Element *to);
+gsize element_get_memory_size (Element *elem, gsize struct_size);
 DiaObjectChange *element_move_handle           (Element          *elem,
                                                 HandleId          id,
                                                 Point            *to,
@@ -28,6 +28,7 @@
 #include <time.h>
 
 #include <pango/pango.h>
+#include <pango/pangocairo.h>
 #undef PANGO_DISABLE_DEPRECATED /* pango_ft_get_context */
 #include <gdk/gdk.h>
 #include <gtk/gtk.h> /* just for gtk_get_default_language() */
@@ -38,9 +39,12 @@
 #endif
 #include "font.h"
 #include "message.h"
-#include "textline.h"
+#include "dia-trace.h"
 
 static PangoContext *pango_context = NULL;
+static GThread      *pango_context_thread = NULL;
+/* Pango is not thread safe, other threads measure with their own context */
+static GPrivate      thread_context = G_PRIVATE_INIT (g_object_unref);
 
 /**
  * DiaFont:
@@ -75,15 +79,45 @@ dia_font_push_context (PangoContext *pcontext)
 }
 
 
+/* the calling thread's own context, measuring with the given settings */
+static PangoContext *
+_dia_font_get_thread_context (const cairo_font_options_t *options,
+                              double                      resolution,
+                              PangoLanguage              *language)
+{
+  PangoContext *context = g_private_get (&thread_context);
+
+  if (!context) {
+    /* the default font map is per thread */
+    context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+    g_private_set (&thread_context, context);
+  }
+  pango_cairo_context_set_font_options (context, options);
+  pango_cairo_context_set_resolution (context, resolution);
+  pango_context_set_language (context, language);
+
+  return context;
+}
+
+
 /**
  * dia_font_get_context:
  *
- * Retrieve the current context (used for the font widget)
+ * Retrieve the current context (used for the font widget). Threads other
+ * than the one asking first get their own.
  */
 PangoContext *
 dia_font_get_context (void)
 {
+  if (pango_context != NULL && pango_context_thread != g_thread_self ()) {
+    /* measure like the main one */
+    return _dia_font_get_thread_context (pango_cairo_context_get_font_options (pango_context),
+                                         pango_cairo_context_get_resolution (pango_context),
+                                         pango_context_get_language (pango_context));
+  }
+
   if (pango_context == NULL) {
+    pango_context_thread = g_thread_self ();
 /* Maybe this one with pangocairo
      dia_font_push_context (pango_cairo_font_map_create_context (pango_cairo_font_map_get_default()));
  * but it gives:
@@ -690,9 +724,9 @@ dia_font_string_width (const char *string, DiaFont *font, double height)
   double result = 0;
 
   if (string && *string) {
-    TextLine *text_line = text_line_new (string, font, height);
-    result = text_line_get_width (text_line);
-    text_line_destroy (text_line);
+    DiaFontSizes *sizes = dia_font_sizes_lookup (string, font, height);
+    result = sizes->width;
+    dia_font_sizes_unref (sizes);
   }
 
   return result;
@@ -713,9 +747,9 @@ dia_font_ascent (const char *string, DiaFont *font, double height)
     return ascent * factor;
   } else {
     /* previous, _expensive_ but string specific way */
-    TextLine *text_line = text_line_new (string, font, height);
-    double result = text_line_get_ascent (text_line);
-    text_line_destroy (text_line);
+    DiaFontSizes *sizes = dia_font_sizes_lookup (string, font, height);
+    double result = sizes->ascent;
+    dia_font_sizes_unref (sizes);
     return result;
   }
 }
@@ -735,21 +769,19 @@ dia_font_descent (const char *string, DiaFont *font, double height)
     return descent * factor;
   } else {
     /* previous, _expensive_ but string specific way */
-    TextLine *text_line = text_line_new (string, font, height);
-    double result = text_line_get_descent (text_line);
-    text_line_destroy (text_line);
+    DiaFontSizes *sizes = dia_font_sizes_lookup (string, font, height);
+    double result = sizes->descent;
+    dia_font_sizes_unref (sizes);
     return result;
   }
 }
 
 
-/**
- * dia_font_build_layout:
- *
- * prepares a layout of the text, in font 'font'.
- */
-PangoLayout *
-dia_font_build_layout (const char *string, DiaFont *font, double height)
+static PangoLayout *
+_dia_font_build_layout (PangoContext *context,
+                        const char   *string,
+                        DiaFont      *font,
+                        double        height)
 {
   PangoLayout *layout;
   PangoAttrList *list;
@@ -758,7 +790,7 @@ dia_font_build_layout (const char *string, DiaFont *font, double height)
   PangoFontDescription *pfd;
   double factor;
 
-  layout = pango_layout_new (dia_font_get_context ());
+  layout = pango_layout_new (context);
 
   length = string ? strlen (string) : 0;
   pango_layout_set_text (layout, string, length);
@@ -787,6 +819,18 @@ dia_font_build_layout (const char *string, DiaFont *font, double height)
 }
 
 
+/**
+ * dia_font_build_layout:
+ *
+ * prepares a layout of the text, in font 'font'.
+ */
+PangoLayout *
+dia_font_build_layout (const char *string, DiaFont *font, double height)
+{
+  return _dia_font_build_layout (dia_font_get_context (), string, font, height);
+}
+
+
 /**
  * get_string_offsets:
  * @iter: The #PangoLayoutIter to count characters in.
@@ -869,32 +913,16 @@ get_layout_offsets(PangoLayoutLine *line, PangoLayoutLine **layout_line)
 }
 
 
-/**
- * dia_font_get_sizes:
- * @string: text to measure
- * @font: the font to use
- * @height: the font height to use
- * @width: (out): width of @string
- * @ascent: (out): width of @ascent
- * @descent: (out): width of @descent
- * @n_offsets: (out): number of @layout_offsets
- * @layout_offsets: (out): offsets of @string
- *
- * Get size information for the given string, font and height.
- *
- * Returns: an array of offsets of the individual glyphs in the layout.
- *
- * Since: dawn-of-time
- */
-double *
-dia_font_get_sizes (const char       *string,
-                    DiaFont          *font,
-                    double            height,
-                    double           *width,
-                    double           *ascent,
-                    double           *descent,
-                    int              *n_offsets,
-                    PangoLayoutLine **layout_offsets)
+static double *
+_dia_font_get_sizes (PangoContext     *context,
+                     const char       *string,
+                     DiaFont          *font,
+                     double            height,
+                     double           *width,
+                     double           *ascent,
+                     double           *descent,
+                     int              *n_offsets,
+                     PangoLayoutLine **layout_offsets)
 {
   PangoLayout* layout;
   PangoLayoutIter* iter;
@@ -902,6 +930,7 @@ dia_font_get_sizes (const char       *string,
   const char *non_empty_string;
   PangoRectangle ink_rect,logical_rect;
   double *offsets = NULL; /* avoid: 'offsets' may be used uninitialized in this function */
+  gint64 span = dia_trace_begin ();
 
   /* We need some reasonable ascent/descent values even for empty strings. */
   if (string == NULL || string[0] == '\0') {
@@ -909,7 +938,7 @@ dia_font_get_sizes (const char       *string,
   } else {
     non_empty_string = string;
   }
-  layout = dia_font_build_layout(non_empty_string, font, height * global_zoom_factor);
+  layout = _dia_font_build_layout (context, non_empty_string, font, height * global_zoom_factor);
 
   /* Only one line here ? */
   iter = pango_layout_get_iter(layout);
@@ -949,10 +978,614 @@ dia_font_get_sizes (const char       *string,
     int full_width = ink_rect.width + ink_rect.x;
     *width = pdu_to_dcm(logical_rect.width > full_width ? logical_rect.width : full_width) / global_zoom_factor;
   }
+  dia_trace_end (span, DIA_TRACE_TEXT, "shape", dia_font_get_family (font));
+
   return offsets;
 }
 
 
+/**
+ * dia_font_get_sizes:
+ * @string: text to measure
+ * @font: the font to use
+ * @height: the font height to use
+ * @width: (out): width of @string
+ * @ascent: (out): width of @ascent
+ * @descent: (out): width of @descent
+ * @n_offsets: (out): number of @layout_offsets
+ * @layout_offsets: (out): offsets of @string
+ *
+ * Get size information for the given string, font and height.
+ *
+ * Returns: an array of offsets of the individual glyphs in the layout.
+ *
+ * Since: dawn-of-time
+ */
+double *
+dia_font_get_sizes (const char       *string,
+                    DiaFont          *font,
+                    double            height,
+                    double           *width,
+                    double           *ascent,
+                    double           *descent,
+                    int              *n_offsets,
+                    PangoLayoutLine **layout_offsets)
+{
+  return _dia_font_get_sizes (dia_font_get_context (),
+                              string, font, height,
+                              width, ascent, descent,
+                              n_offsets, layout_offsets);
+}
+
+
+/*
+ * The sizes cache: (string, font description, height) -> DiaFontSizes
+ *
+ * Measuring means building and shaping a PangoLayout, by far the most
+ * expensive part of loading or zooming a diagram with many labels. The
+ * same strings come again and again though, from copies, undo and every
+ * object using the same font. All entries are in LRU order (most recent
+ * at the head), the tail is dropped beyond sizes_cache_limit.
+ */
+typedef struct _SizesEntry {
+  char                 *string;
+  PangoFontDescription *pfd;
+  double                height;
+  DiaFontSizes         *sizes;
+  GList                 lru; /* link in sizes_lru, data is the entry */
+} SizesEntry;
+
+G_LOCK_DEFINE_STATIC (sizes_cache);
+static GHashTable *sizes_cache = NULL;
+static GQueue      sizes_lru = G_QUEUE_INIT;
+static guint       sizes_cache_limit = 4096;
+static guint       sizes_cache_hits = 0;
+static guint       sizes_cache_misses = 0;
+
+
+static guint
+_sizes_entry_hash (gconstpointer p)
+{
+  const SizesEntry *entry = p;
+
+  return g_str_hash (entry->string)
+         ^ pango_font_description_hash (entry->pfd)
+         ^ g_double_hash (&entry->height);
+}
+
+
+static gboolean
+_sizes_entry_equal (gconstpointer a, gconstpointer b)
+{
+  const SizesEntry *ea = a;
+  const SizesEntry *eb = b;
+
+  return ea->height == eb->height
+         && strcmp (ea->string, eb->string) == 0
+         && pango_font_description_equal (ea->pfd, eb->pfd);
+}
+
+
+static void
+_layout_offsets_free (PangoLayoutLine *line)
+{
+  for (GSList *runs = line->runs; runs != NULL; runs = g_slist_next (runs)) {
+    PangoGlyphItem *run = runs->data;
+
+    g_clear_pointer (&run->glyphs->glyphs, g_free);
+    g_clear_pointer (&run->glyphs, g_free);
+    g_free (run);
+  }
+  g_slist_free (line->runs);
+  g_free (line);
+}
+
+
+static void
+_dia_font_sizes_clear (gpointer data)
+{
+  DiaFontSizes *sizes = data;
+
+  g_clear_pointer (&sizes->offsets, g_free);
+  g_clear_pointer (&sizes->layout_offsets, _layout_offsets_free);
+}
+
+
+/* with the sizes_cache lock held if it is in sizes_lru */
+static void
+_sizes_entry_free (gpointer data)
+{
+  SizesEntry *entry = data;
+
+  if (entry->lru.data) {
+    g_queue_unlink (&sizes_lru, &entry->lru);
+  }
+  g_clear_pointer (&entry->string, g_free);
+  g_clear_pointer (&entry->pfd, pango_font_description_free);
+  g_clear_pointer (&entry->sizes, dia_font_sizes_unref);
+  g_free (entry);
+}
+
+
+static DiaFontSizes *
+_dia_font_sizes_new (PangoContext *context,
+                     const char   *string,
+                     DiaFont      *font,
+                     double        height)
+{
+  DiaFontSizes *sizes = g_atomic_rc_box_new0 (DiaFontSizes);
+
+  sizes->offsets = _dia_font_get_sizes (context, string, font, height,
+                                        &sizes->width,
+                                        &sizes->ascent,
+                                        &sizes->descent,
+                                        &sizes->n_offsets,
+                                        &sizes->layout_offsets);
+  if (string[0] == '\0') {
+    /* only the ascent/descent of the stand-in string are meaningful */
+    _dia_font_sizes_clear (sizes);
+    sizes->n_offsets = 0;
+  }
+
+  return sizes;
+}
+
+
+/* a new reference to the cached sizes, if any */
+static DiaFontSizes *
+_sizes_cache_lookup (const SizesEntry *probe, gboolean count)
+{
+  SizesEntry *entry;
+  DiaFontSizes *sizes = NULL;
+
+  G_LOCK (sizes_cache);
+  if (!sizes_cache) {
+    sizes_cache = g_hash_table_new_full (_sizes_entry_hash,
+                                         _sizes_entry_equal,
+                                         _sizes_entry_free,
+                                         NULL);
+  }
+  entry = g_hash_table_lookup (sizes_cache, probe);
+  if (entry) {
+    g_queue_unlink (&sizes_lru, &entry->lru);
+    g_queue_push_head_link (&sizes_lru, &entry->lru);
+    sizes = dia_font_sizes_ref (entry->sizes);
+  }
+  if (count) {
+    if (entry) {
+      sizes_cache_hits++;
+    } else {
+      sizes_cache_misses++;
+    }
+  }
+  G_UNLOCK (sizes_cache);
+
+  return sizes;
+}
+
+
+/* cache sizes (taking them) for probe, returns a new reference to the
+ * cached ones which might be from someone else being faster */
+static DiaFontSizes *
+_sizes_cache_insert (const SizesEntry *probe, DiaFontSizes *sizes)
+{
+  SizesEntry *entry;
+
+  G_LOCK (sizes_cache);
+  entry = g_hash_table_lookup (sizes_cache, probe);
+  if (entry) {
+    dia_font_sizes_unref (sizes);
+    g_queue_unlink (&sizes_lru, &entry->lru);
+  } else {
+    entry = g_new0 (SizesEntry, 1);
+    entry->string = g_strdup (probe->string);
+    entry->pfd = pango_font_description_copy (probe->pfd);
+    entry->height = probe->height;
+    entry->sizes = sizes;
+    entry->lru.data = entry;
+    g_hash_table_add (sizes_cache, entry);
+  }
+  g_queue_push_head_link (&sizes_lru, &entry->lru);
+  sizes = dia_font_sizes_ref (entry->sizes);
+
+  while (g_hash_table_size (sizes_cache) > sizes_cache_limit) {
+    g_hash_table_remove (sizes_cache, sizes_lru.tail->data);
+  }
+  G_UNLOCK (sizes_cache);
+
+  return sizes;
+}
+
+
+/**
+ * dia_font_sizes_lookup:
+ * @string: (nullable): text to measure
+ * @font: the font to use
+ * @height: the font height to use
+ *
+ * Like dia_font_get_sizes() but shared through a global cache. The result
+ * is immutable, it is the same for every caller asking for the same.
+ *
+ * Returns: (transfer full): the sizes, release with dia_font_sizes_unref()
+ *
+ * Since: 0.98
+ */
+DiaFontSizes *
+dia_font_sizes_lookup (const char *string, DiaFont *font, double height)
+{
+  SizesEntry probe = { (char *) (string ? string : ""), font->pfd, height, };
+  DiaFontSizes *sizes;
+
+  sizes = _sizes_cache_lookup (&probe, TRUE);
+  if (sizes) {
+    return sizes;
+  }
+
+  /* Pango without holding the lock */
+  sizes = _dia_font_sizes_new (dia_font_get_context (), probe.string, font, height);
+
+  return _sizes_cache_insert (&probe, sizes);
+}
+
+
+/*
+ * Measuring ahead on worker threads, see dia_font_prefetch_new()
+ */
+struct _DiaFontPrefetch {
+  GHashTable           *queued;     /* SizesEntry without sizes */
+  cairo_font_options_t *options;    /* of the main context */
+  double                resolution;
+  PangoLanguage        *language;
+  GMutex                lock;
+  GCond                 cond;
+  int                   pending;    /* jobs not done yet */
+};
+
+typedef struct _PrefetchJob {
+  DiaFontPrefetch  *prefetch;
+  const SizesEntry *probe;          /* owned by prefetch->queued */
+  DiaFont          *font;
+} PrefetchJob;
+
+static GThreadPool *prefetch_pool = NULL;
+
+
+static void
+_dia_font_prefetch_worker (gpointer data, gpointer user_data)
+{
+  PrefetchJob *job = data;
+  DiaFontPrefetch *prefetch = job->prefetch;
+  PangoContext *context;
+  DiaFontSizes *sizes;
+
+  /* measure exactly like dia_font_get_context() would */
+  context = _dia_font_get_thread_context (prefetch->options,
+                                          prefetch->resolution,
+                                          prefetch->language);
+
+  sizes = _sizes_cache_lookup (job->probe, FALSE);
+  if (!sizes) {
+    sizes = _sizes_cache_insert (job->probe,
+                                 _dia_font_sizes_new (context,
+                                                      job->probe->string,
+                                                      job->font,
+                                                      job->probe->height));
+  }
+  dia_font_sizes_unref (sizes);
+
+  g_clear_object (&job->font);
+  g_free (job);
+
+  g_mutex_lock (&prefetch->lock);
+  if (--prefetch->pending == 0) {
+    g_cond_signal (&prefetch->cond);
+  }
+  g_mutex_unlock (&prefetch->lock);
+}
+
+
+/**
+ * dia_font_prefetch_new:
+ *
+ * Start measuring text on worker threads ahead of its use.
+ *
+ * Loading a diagram creates its objects one after the other, each one
+ * shaping its text with Pango. Instead the loader can hand all strings to
+ * dia_font_prefetch_add() first: they are measured in parallel into the
+ * cache of dia_font_sizes_lookup() while the objects get created, which
+ * then mostly find their sizes ready.
+ *
+ * Returns: (transfer full): the prefetch, end it with dia_font_prefetch_finish()
+ *
+ * Since: 0.98
+ */
+DiaFontPrefetch *
+dia_font_prefetch_new (void)
+{
+  PangoContext *context = dia_font_get_context ();
+  const cairo_font_options_t *options;
+  DiaFontPrefetch *prefetch = g_new0 (DiaFontPrefetch, 1);
+
+  prefetch->queued = g_hash_table_new_full (_sizes_entry_hash,
+                                            _sizes_entry_equal,
+                                            _sizes_entry_free,
+                                            NULL);
+  options = pango_cairo_context_get_font_options (context);
+  prefetch->options = options ? cairo_font_options_copy (options) : NULL;
+  prefetch->resolution = pango_cairo_context_get_resolution (context);
+  prefetch->language = pango_context_get_language (context);
+  g_mutex_init (&prefetch->lock);
+  g_cond_init (&prefetch->cond);
+
+  if (!prefetch_pool) {
+    prefetch_pool = g_thread_pool_new (_dia_font_prefetch_worker, NULL,
+                                       g_get_num_processors (),
+                                       FALSE, NULL);
+  }
+
+  return prefetch;
+}
+
+
+/**
+ * dia_font_prefetch_add:
+ * @prefetch: the #DiaFontPrefetch
+ * @string: a single line of text
+ * @font: the font, must not be changed until the prefetch is finished
+ * @height: the font height
+ *
+ * Queue measuring @string, repetitions are ignored.
+ *
+ * Since: 0.98
+ */
+void
+dia_font_prefetch_add (DiaFontPrefetch *prefetch,
+                       const char      *string,
+                       DiaFont         *font,
+                       double           height)
+{
+  SizesEntry probe = { (char *) (string ? string : ""), font->pfd, height, };
+  SizesEntry *entry;
+  PrefetchJob *job;
+  guint limit;
+
+  g_return_if_fail (prefetch != NULL);
+
+  G_LOCK (sizes_cache);
+  limit = sizes_cache_limit;
+  G_UNLOCK (sizes_cache);
+
+  /* more would only push each other out of the cache */
+  if (g_hash_table_size (prefetch->queued) >= limit ||
+      g_hash_table_contains (prefetch->queued, &probe)) {
+    return;
+  }
+
+  entry = g_new0 (SizesEntry, 1);
+  entry->string = g_strdup (probe.string);
+  entry->pfd = pango_font_description_copy (font->pfd);
+  entry->height = height;
+  g_hash_table_add (prefetch->queued, entry);
+
+  job = g_new0 (PrefetchJob, 1);
+  job->prefetch = prefetch;
+  job->probe = entry;
+  job->font = g_object_ref (font);
+
+  g_mutex_lock (&prefetch->lock);
+  prefetch->pending++;
+  g_mutex_unlock (&prefetch->lock);
+
+  g_thread_pool_push (prefetch_pool, job, NULL);
+}
+
+
+/**
+ * dia_font_prefetch_finish:
+ * @prefetch: (transfer full): the #DiaFontPrefetch
+ *
+ * Wait for the measurements still running and free @prefetch.
+ *
+ * Since: 0.98
+ */
+void
+dia_font_prefetch_finish (DiaFontPrefetch *prefetch)
+{
+  g_return_if_fail (prefetch != NULL);
+
+  g_mutex_lock (&prefetch->lock);
+  while (prefetch->pending > 0) {
+    g_cond_wait (&prefetch->cond, &prefetch->lock);
+  }
+  g_mutex_unlock (&prefetch->lock);
+
+  dia_log_message ("font prefetch: %u strings",
+                   g_hash_table_size (prefetch->queued));
+
+  g_clear_pointer (&prefetch->queued, g_hash_table_destroy);
+  g_clear_pointer (&prefetch->options, cairo_font_options_destroy);
+  g_mutex_clear (&prefetch->lock);
+  g_cond_clear (&prefetch->cond);
+  g_free (prefetch);
+}
+
+
+/**
+ * dia_font_sizes_ref:
+ * @sizes: the #DiaFontSizes
+ *
+ * Returns: (transfer full): @sizes
+ *
+ * Since: 0.98
+ */
+DiaFontSizes *
+dia_font_sizes_ref (DiaFontSizes *sizes)
+{
+  return g_atomic_rc_box_acquire (sizes);
+}
+
+
+/**
+ * dia_font_sizes_unref:
+ * @sizes: (transfer full): the #DiaFontSizes
+ *
+ * Since: 0.98
+ */
+void
+dia_font_sizes_unref (DiaFontSizes *sizes)
+{
+  g_atomic_rc_box_release_full (sizes, _dia_font_sizes_clear);
+}
+
+
+/**
+ * dia_font_sizes_cache_set_limit:
+ * @n_entries: the maximum number of measurements kept
+ *
+ * Since: 0.98
+ */
+void
+dia_font_sizes_cache_set_limit (guint n_entries)
+{
+  G_LOCK (sizes_cache);
+  sizes_cache_limit = n_entries;
+  while (sizes_cache && g_hash_table_size (sizes_cache) > sizes_cache_limit) {
+    g_hash_table_remove (sizes_cache, sizes_lru.tail->data);
+  }
+  G_UNLOCK (sizes_cache);
+}
+
+
+/**
+ * dia_font_sizes_cache_clear:
+ *
+ * Drop all cached measurements, e.g. after the fonts available changed.
+ * The statistics are reset, too.
+ *
+ * Since: 0.98
+ */
+void
+dia_font_sizes_cache_clear (void)
+{
+  G_LOCK (sizes_cache);
+  if (sizes_cache) {
+    dia_log_message ("font sizes cache: %u hits, %u misses, %u entries",
+                     sizes_cache_hits,
+                     sizes_cache_misses,
+                     g_hash_table_size (sizes_cache));
+    g_hash_table_remove_all (sizes_cache);
+  }
+  sizes_cache_hits = 0;
+  sizes_cache_misses = 0;
+  G_UNLOCK (sizes_cache);
+}
+
+
+/**
+ * dia_font_sizes_cache_stats:
+ * @hits: (out) (optional): lookups answered from the cache
+ * @misses: (out) (optional): lookups which needed Pango
+ * @n_entries: (out) (optional): number of cached measurements
+ *
+ * Since: 0.98
+ */
+void
+dia_font_sizes_cache_stats (guint *hits, guint *misses, guint *n_entries)
+{
+  G_LOCK (sizes_cache);
+  if (hits) {
+    *hits = sizes_cache_hits;
+  }
+  if (misses) {
+    *misses = sizes_cache_misses;
+  }
+  if (n_entries) {
+    *n_entries = sizes_cache ? g_hash_table_size (sizes_cache) : 0;
+  }
+  G_UNLOCK (sizes_cache);
+}
+
+
+static gsize
+_layout_offsets_memory_size (PangoLayoutLine *line)
+{
+  gsize size = sizeof (PangoLayoutLine);
+
+  for (GSList *runs = line->runs; runs != NULL; runs = g_slist_next (runs)) {
+    PangoGlyphItem *run = runs->data;
+
+    size += sizeof (GSList) + sizeof (PangoGlyphItem) + sizeof (PangoGlyphString);
+    size += run->glyphs->num_glyphs * sizeof (PangoGlyphInfo);
+  }
+
+  return size;
+}
+
+
+/**
+ * dia_font_sizes_get_memory_size:
+ * @sizes: the #DiaFontSizes
+ * @shared: (nullable): the shared data already counted
+ *
+ * The memory of a measurement, which is shared by all users of the same
+ * string and font. It is only counted if not in @shared yet.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+dia_font_sizes_get_memory_size (DiaFontSizes *sizes, GHashTable *shared)
+{
+  gsize size;
+
+  if (!sizes) {
+    return 0;
+  }
+  if (shared) {
+    if (g_hash_table_contains (shared, sizes)) {
+      return 0;
+    }
+    g_hash_table_add (shared, sizes);
+  }
+
+  size = sizeof (DiaFontSizes) + sizes->n_offsets * sizeof (double);
+  if (sizes->layout_offsets) {
+    size += _layout_offsets_memory_size (sizes->layout_offsets);
+  }
+
+  return size;
+}
+
+
+/**
+ * dia_font_sizes_cache_get_memory_size:
+ *
+ * Returns: the memory used by the sizes cache, in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+dia_font_sizes_cache_get_memory_size (void)
+{
+  GHashTableIter iter;
+  SizesEntry *entry;
+  gsize size = 0;
+
+  G_LOCK (sizes_cache);
+  if (sizes_cache) {
+    g_hash_table_iter_init (&iter, sizes_cache);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL)) {
+      size += sizeof (SizesEntry) + strlen (entry->string) + 1;
+      size += dia_font_sizes_get_memory_size (entry->sizes, NULL);
+    }
+  }
+  G_UNLOCK (sizes_cache);
+
+  return size;
+}
+
+
 /*
  * Compatibility with older files out of pre Pango Time.
  * Make old files look as similar as possible
@@ -1074,6 +1707,47 @@ dia_font_new_from_legacy_name (const char* name)
 }
 
 
+/**
+ * dia_font_get_memory_size:
+ * @font: the #DiaFont
+ * @shared: (nullable): the shared data already counted
+ *
+ * Fonts are shared between the objects using them, so @font is only
+ * counted if not in @shared yet.
+ *
+ * Returns: the memory used by @font, in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+dia_font_get_memory_size (DiaFont *font, GHashTable *shared)
+{
+  const char *family;
+  gsize size;
+
+  if (!font) {
+    return 0;
+  }
+  if (shared) {
+    if (g_hash_table_contains (shared, font)) {
+      return 0;
+    }
+    g_hash_table_add (shared, font);
+  }
+
+  size = sizeof (DiaFont);
+  family = pango_font_description_get_family (font->pfd);
+  if (family) {
+    size += strlen (family) + 1;
+  }
+  if (font->legacy_name) {
+    size += strlen (font->legacy_name) + 1;
+  }
+
+  return size;
+}
+
+
 /**
  * dia_font_get_legacy_name:
  *
@@ -122,6 +122,8 @@ void                        dia_font_set_weight_from_string (DiaFont          *f
                                                              const char       *weight);
 void                        dia_font_set_slant_from_string  (DiaFont          *font,
                                                              const char       *slant);
+gsize                       dia_font_get_memory_size        (DiaFont          *font,
+                                                             GHashTable       *shared);
 
 /* -------- Font and string functions - unscaled versions.
    Use these version in Objects, primarily. */
@@ -147,6 +149,50 @@ double                     *dia_font_get_sizes              (const char       *s
                                                              int              *n_offsets,
                                                              PangoLayoutLine **layout_offsets);
 
+/**
+ * DiaFontSizes:
+ * @width: width of the string
+ * @ascent: ascent of the line
+ * @descent: descent of the line
+ * @n_offsets: number of @offsets
+ * @offsets: widths of the individual glyphs
+ * @layout_offsets: the glyph geometry of the layout line
+ *
+ * The measurements of dia_font_get_sizes(), shared and immutable.
+ */
+typedef struct _DiaFontSizes DiaFontSizes;
+struct _DiaFontSizes {
+  double           width;
+  double           ascent;
+  double           descent;
+  int              n_offsets;
+  double          *offsets;
+  PangoLayoutLine *layout_offsets;
+};
+
+DiaFontSizes               *dia_font_sizes_lookup           (const char       *string,
+                                                             DiaFont          *font,
+                                                             double            height);
+DiaFontSizes               *dia_font_sizes_ref              (DiaFontSizes     *sizes);
+void                        dia_font_sizes_unref            (DiaFontSizes     *sizes);
+void                        dia_font_sizes_cache_set_limit  (guint             n_entries);
+void                        dia_font_sizes_cache_clear      (void);
+void                        dia_font_sizes_cache_stats      (guint            *hits,
+                                                             guint            *misses,
+                                                             guint            *n_entries);
+gsize                       dia_font_sizes_get_memory_size  (DiaFontSizes     *sizes,
+                                                             GHashTable       *shared);
+gsize                       dia_font_sizes_cache_get_memory_size (void);
+
+typedef struct _DiaFontPrefetch DiaFontPrefetch;
+
+DiaFontPrefetch            *dia_font_prefetch_new           (void);
+void                        dia_font_prefetch_add           (DiaFontPrefetch  *prefetch,
+                                                             const char       *string,
+                                                             DiaFont          *font,
+                                                             double            height);
+void                        dia_font_prefetch_finish        (DiaFontPrefetch  *prefetch);
+
 /* -------- Font and string functions - scaled versions.
    Use these version in Renderers, exclusively. */
 
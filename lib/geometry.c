@@ -29,6 +29,7 @@
 /* include normal versions of the inlined functions here ... */
 #include "geometry.h"
 
+#include "dia-geometry-kernels.h"
 #include "object.h"
 #include "units.h"
 
@@ -190,37 +191,24 @@ distance_line_point(const Point *line_start, const Point *line_end,
   return perp_dist;
 }
 
-/* returns 1 if the line crosses the ray from (-Inf, rayend.y) to rayend */
-static int
-line_crosses_ray(const Point *line_start,
-                 const Point *line_end, const Point *rayend)
-{
-  if ((line_start->y <= rayend->y && line_end->y > rayend->y) || /* upward crossing */
-      (line_start->y > rayend->y && line_end->y <= rayend->y)) { /* downward crossing */
-    real vt = (rayend->y - line_start->y) / (line_end->y - line_start->y);
-    if (rayend->x < line_start->x + vt * (line_end->x - line_start->x)) /* intersect */
-      return 1;
-  }
-  return 0;
-}
-
 real
 distance_polygon_point(const Point *poly, guint npoints, real line_width,
 		       const Point *point)
 {
-  guint i, last = npoints - 1;
-  real line_dist = G_MAXFLOAT;
+  real line_dist, dist;
   guint crossings = 0;
 
-  /* calculate ray crossings and line distances */
-  for (i = 0; i < npoints; i++) {
-    real dist;
-
-    crossings += line_crosses_ray(&poly[last], &poly[i], point);
-    dist = distance_line_point(&poly[last], &poly[i], line_width, point);
-    line_dist = MIN(line_dist, dist);
-    last = i;
-  }
+  if (npoints == 0)
+    return G_MAXFLOAT;
+
+  /* calculate ray crossings and line distances, the closing segment last */
+  line_dist = dia_geometry_kernels_get ()->segments_distance (poly, npoints,
+                                                              line_width,
+                                                              point,
+                                                              &crossings);
+  crossings += line_crosses_ray(&poly[npoints - 1], &poly[0], point);
+  dist = distance_line_point(&poly[npoints - 1], &poly[0], line_width, point);
+  line_dist = MIN(line_dist, dist);
   /* If there is an odd number of ray crossings, we are inside the polygon.
    * Otherwise, return the minium distance from a line segment */
   if (crossings % 2 == 1)
@@ -229,22 +217,108 @@ distance_polygon_point(const Point *poly, guint npoints, real line_width,
     return line_dist;
 }
 
+/**
+ * distance_polyline_point:
+ * @poly: the points of the polyline
+ * @npoints: the number of points
+ * @line_width: the line width
+ * @point: the point to measure the distance to
+ *
+ * The minimum of distance_line_point() over all segments of an open
+ * polyline.
+ *
+ * Returns: the distance, %G_MAXFLOAT for less than two points
+ *
+ * Since: 0.98
+ */
+real
+distance_polyline_point (const Point *poly,
+                         guint        npoints,
+                         real         line_width,
+                         const Point *point)
+{
+  return dia_geometry_kernels_get ()->segments_distance (poly, npoints,
+                                                         line_width,
+                                                         point, NULL);
+}
+
 /* number of segments to use in bezier curve approximation */
 #define NBEZ_SEGS 10
 
-/* if cross is not NULL, it will be incremented for each ray crossing */
-static real
-bez_point_distance_and_ray_crosses(const Point *b1,
-                                   const Point *b2, const Point *b3,
-                                   const Point *b4,
-				   real line_width, const Point *point,
-                                   guint *cross)
+/* number of points handed to the kernels at once */
+#define SEGMENT_BATCH_SIZE 128
+
+/*
+ * Flattened bezier paths are collected into a point buffer and measured
+ * in batches, so the vectorized kernels get runs of segments to work on.
+ */
+typedef struct _SegmentBatch SegmentBatch;
+struct _SegmentBatch {
+  const DiaGeometryKernels *kernels;
+  double       line_width;
+  const Point *point;
+  guint       *crossings;
+  double       dist;
+  guint        n;
+  Point        pts[SEGMENT_BATCH_SIZE];
+};
+
+static void
+segment_batch_init (SegmentBatch *batch,
+                    double        line_width,
+                    const Point  *point,
+                    guint        *crossings)
+{
+  batch->kernels = dia_geometry_kernels_get ();
+  batch->line_width = line_width;
+  batch->point = point;
+  batch->crossings = crossings;
+  batch->dist = G_MAXFLOAT;
+  batch->n = 0;
+}
+
+/* measure the collected segments, keeping the last point to continue */
+static void
+segment_batch_flush (SegmentBatch *batch)
+{
+  if (batch->n > 1) {
+    double dist = batch->kernels->segments_distance (batch->pts, batch->n,
+                                                     batch->line_width,
+                                                     batch->point,
+                                                     batch->crossings);
+    batch->dist = MIN (batch->dist, dist);
+    batch->pts[0] = batch->pts[batch->n - 1];
+    batch->n = 1;
+  }
+}
+
+static void
+segment_batch_move_to (SegmentBatch *batch, const Point *p)
+{
+  segment_batch_flush (batch);
+  batch->pts[0] = *p;
+  batch->n = 1;
+}
+
+static void
+segment_batch_line_to (SegmentBatch *batch, const Point *p)
+{
+  if (batch->n == SEGMENT_BATCH_SIZE) {
+    segment_batch_flush (batch);
+  }
+  batch->pts[batch->n++] = *p;
+}
+
+static void
+segment_batch_curve_to (SegmentBatch *batch,
+                        const Point  *b2,
+                        const Point  *b3,
+                        const Point  *b4)
 {
   static gboolean calculated_coeff = FALSE;
   static real coeff[NBEZ_SEGS+1][4];
+  Point b1 = batch->pts[batch->n - 1];
   int i;
-  real line_dist = G_MAXFLOAT;
-  Point prev, pt;
 
   if (!calculated_coeff) {
     for (i = 0; i <= NBEZ_SEGS; i++) {
@@ -259,36 +333,31 @@ bez_point_distance_and_ray_crosses(const Point *b1,
   }
   calculated_coeff = TRUE;
 
-  prev.x = coeff[0][0] * b1->x + coeff[0][1] * b2->x +
-           coeff[0][2] * b3->x + coeff[0][3] * b4->x;
-  prev.y = coeff[0][0] * b1->y + coeff[0][1] * b2->y +
-           coeff[0][2] * b3->y + coeff[0][3] * b4->y;
   for (i = 1; i <= NBEZ_SEGS; i++) {
-    real dist;
+    Point pt;
 
-    pt.x = coeff[i][0] * b1->x + coeff[i][1] * b2->x +
+    pt.x = coeff[i][0] * b1.x + coeff[i][1] * b2->x +
            coeff[i][2] * b3->x + coeff[i][3] * b4->x;
-    pt.y = coeff[i][0] * b1->y + coeff[i][1] * b2->y +
+    pt.y = coeff[i][0] * b1.y + coeff[i][1] * b2->y +
            coeff[i][2] * b3->y + coeff[i][3] * b4->y;
-
-    dist = distance_line_point(&prev, &pt, line_width, point);
-    line_dist = MIN(line_dist, dist);
-    if (cross)
-      *cross += line_crosses_ray(&prev, &pt, point);
-
-    prev = pt;
+    segment_batch_line_to (batch, &pt);
   }
-  return line_dist;
 }
 
 real
 distance_bez_seg_point(const Point *b1, const BezPoint *b2,
 		       real line_width, const Point *point)
 {
-  if (b2->type == BEZ_CURVE_TO)
-    return bez_point_distance_and_ray_crosses(b1, &b2->p1, &b2->p2, &b2->p3,
-					      line_width, point, NULL);
-  else
+  if (b2->type == BEZ_CURVE_TO) {
+    SegmentBatch batch;
+
+    segment_batch_init (&batch, line_width, point, NULL);
+    segment_batch_move_to (&batch, b1);
+    segment_batch_curve_to (&batch, &b2->p1, &b2->p2, &b2->p3);
+    segment_batch_flush (&batch);
+
+    return batch.dist;
+  } else
     return distance_line_point(b1, &b2->p1, line_width, point);
 }
 
@@ -299,40 +368,32 @@ distance_bez_line_point (const BezPoint *b,
                          double          line_width,
                          const Point    *point)
 {
-  Point last;
+  SegmentBatch batch;
   guint i;
-  double line_dist = G_MAXFLOAT;
 
   g_return_val_if_fail (b[0].type == BEZ_MOVE_TO, -1);
 
-  last = b[0].p1;
+  segment_batch_init (&batch, line_width, point, NULL);
+  segment_batch_move_to (&batch, &b[0].p1);
 
   for (i = 1; i < npoints; i++) {
-    double dist;
-
     switch (b[i].type) {
       case BEZ_MOVE_TO:
-        last = b[i].p1;
+        segment_batch_move_to (&batch, &b[i].p1);
         break;
       case BEZ_LINE_TO:
-        dist = distance_line_point (&last, &b[i].p1, line_width, point);
-        line_dist = MIN (line_dist, dist);
-        last = b[i].p1;
+        segment_batch_line_to (&batch, &b[i].p1);
         break;
       case BEZ_CURVE_TO:
-        dist = bez_point_distance_and_ray_crosses (&last,
-                                                   &b[i].p1, &b[i].p2,
-                                                   &b[i].p3, line_width,
-                                                   point,
-                                                   NULL);
-        line_dist = MIN(line_dist, dist);
-        last = b[i].p3;
+        segment_batch_curve_to (&batch, &b[i].p1, &b[i].p2, &b[i].p3);
         break;
       default:
         g_return_val_if_reached (G_MAXDOUBLE);
     }
   }
-  return line_dist;
+  segment_batch_flush (&batch);
+
+  return batch.dist;
 }
 
 
@@ -342,40 +403,37 @@ distance_bez_shape_point (const BezPoint *b,
                           double          line_width,
                           const Point    *point)
 {
+  SegmentBatch batch;
   Point last;
   const Point *close_to; /* path must be closed to calculate distance */
   guint i;
-  double line_dist = G_MAXFLOAT;
+  double line_dist;
   guint crossings = 0;
 
   g_return_val_if_fail (b[0].type == BEZ_MOVE_TO, -1);
 
+  segment_batch_init (&batch, line_width, point, &crossings);
+  segment_batch_move_to (&batch, &b[0].p1);
   last = b[0].p1;
   close_to = &b[0].p1;
 
   for (i = 1; i < npoints; i++) {
-    double dist;
-
     switch (b[i].type) {
       case BEZ_MOVE_TO:
         /* no complains, there are renderers capable to handle this */
+        segment_batch_move_to (&batch, &b[i].p1);
         last = b[i].p1;
         close_to = &b[i].p1;
         break;
       case BEZ_LINE_TO:
-        dist = distance_line_point (&last, &b[i].p1, line_width, point);
-        crossings += line_crosses_ray (&last, &b[i].p1, point);
-        line_dist = MIN (line_dist, dist);
+        segment_batch_line_to (&batch, &b[i].p1);
         last = b[i].p1;
         if (close_to && close_to->x == last.x && close_to->y == last.y) {
           close_to = NULL;
         }
         break;
       case BEZ_CURVE_TO:
-        dist = bez_point_distance_and_ray_crosses (&last, &b[i].p1, &b[i].p2,
-                                                   &b[i].p3, line_width,
-                                                   point, &crossings);
-        line_dist = MIN(line_dist, dist);
+        segment_batch_curve_to (&batch, &b[i].p1, &b[i].p2, &b[i].p3);
         last = b[i].p3;
         if (close_to && close_to->x == last.x && close_to->y == last.y) {
           close_to = NULL;
@@ -385,6 +443,9 @@ distance_bez_shape_point (const BezPoint *b,
         g_return_val_if_reached (0.0);
     }
   }
+  segment_batch_flush (&batch);
+  line_dist = batch.dist;
+
   if (close_to) {
     /* final, implicit line-to */
     real dist = distance_line_point (&last, close_to, line_width, point);
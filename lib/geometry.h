@@ -285,12 +285,29 @@ distance_point_point_manhattan(const Point *p1, const Point *p2)
   return ABS(dx) + ABS(dy);
 }
 
+/* returns 1 if the line crosses the ray from (-Inf, rayend.y) to rayend */
+static inline int
+line_crosses_ray (const Point *line_start,
+                  const Point *line_end,
+                  const Point *rayend)
+{
+  if ((line_start->y <= rayend->y && line_end->y > rayend->y) || /* upward crossing */
+      (line_start->y > rayend->y && line_end->y <= rayend->y)) { /* downward crossing */
+    real vt = (rayend->y - line_start->y) / (line_end->y - line_start->y);
+    if (rayend->x < line_start->x + vt * (line_end->x - line_start->x)) /* intersect */
+      return 1;
+  }
+  return 0;
+}
+
 real distance_rectangle_point(const DiaRectangle *rect, const Point *point);
 real distance_line_point(const Point *line_start, const Point *line_end,
 			 real line_width, const Point *point);
 
 real distance_polygon_point(const Point *poly, guint npoints,
 			    real line_width, const Point *point);
+real distance_polyline_point(const Point *poly, guint npoints,
+			     real line_width, const Point *point);
 
 /* bezier distance calculations */
 real distance_bez_seg_point(const Point *b1, const BezPoint *b2,
@@ -73,6 +73,8 @@ static void                   group_set_props                (Group            *
                                                               GPtrArray        *props);
 static void                   group_transform                (Group            *group,
                                                               const DiaMatrix  *m);
+static gsize                  group_get_memory_size          (Group            *group,
+                                                              GHashTable       *shared);
 
 
 static ObjectOps group_ops = {
@@ -91,7 +93,8 @@ static ObjectOps group_ops = {
   (SetPropsFunc)        group_set_props,
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) group_apply_properties_list,
-  (TransformFunc)       group_transform
+  (TransformFunc)       group_transform,
+  (GetMemorySizeFunc)   group_get_memory_size
 };
 
 DiaObjectType group_type = {
@@ -930,6 +933,24 @@ group_transform (Group *group, const DiaMatrix *m)
 }
 
 
+/* the group including its children */
+static gsize
+group_get_memory_size (Group *group, GHashTable *shared)
+{
+  gsize size = object_get_memory_size (&group->object, sizeof (Group));
+  GList *list;
+
+  if (group->matrix) {
+    size += sizeof (DiaMatrix);
+  }
+  for (list = group->objects; list != NULL; list = g_list_next (list)) {
+    size += sizeof (GList) + dia_object_get_memory_size (list->data, shared);
+  }
+
+  return size;
+}
+
+
 const DiaMatrix *
 group_get_transform (Group *group)
 {
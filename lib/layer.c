@@ -37,6 +37,9 @@ struct _DiaLayerPrivate {
                                   sorted by decreasing z-value,
                                   objects can ONLY be connected to objects
                                   in the same layer! */
+  GSequence *order;            /* The links of objects in the same order,
+                                  for positions in O(log n) */
+  GHashTable *index;           /* DiaObject -> its GSequenceIter in order */
 
   gboolean visible;            /* The visibility of the layer */
   gboolean connectable;        /* Whether the layer can currently be connected
@@ -76,6 +79,107 @@ static GParamSpec *pspecs[LAST_PROP] = { NULL, };
 
 static int count = 0;
 
+
+/*
+ * The object list is what callers iterate, so it stays a GList. Every
+ * link of it is also kept in a GSequence, a balanced tree which knows
+ * the position of an element, and each object maps to its iter there.
+ * Finding, inserting and removing an object doesn't walk the list.
+ */
+
+/* put the chain starting at @links before @before, which may be the end */
+static void
+_objects_splice (DiaLayerPrivate *priv,
+                 GSequenceIter   *before,
+                 GList           *links)
+{
+  GList *last;
+  GList *l;
+
+  if (links == NULL) {
+    return;
+  }
+
+  last = g_list_last (links);
+
+  if (g_sequence_iter_is_end (before)) {
+    if (!g_sequence_iter_is_begin (before)) {
+      GList *tail = g_sequence_get (g_sequence_iter_prev (before));
+
+      tail->next = links;
+      links->prev = tail;
+    } else {
+      priv->objects = links;
+    }
+  } else {
+    GList *sibling = g_sequence_get (before);
+
+    links->prev = sibling->prev;
+    last->next = sibling;
+    if (sibling->prev) {
+      sibling->prev->next = links;
+    } else {
+      priv->objects = links;
+    }
+    sibling->prev = last;
+  }
+
+  for (l = links; l != NULL; l = l->next) {
+    g_hash_table_insert (priv->index,
+                         l->data,
+                         g_sequence_insert_before (before, l));
+    if (l == last) {
+      break;
+    }
+  }
+}
+
+
+static GSequenceIter *
+_objects_iter_at (DiaLayerPrivate *priv, int pos)
+{
+  if (pos < 0 || pos >= g_sequence_get_length (priv->order)) {
+    return g_sequence_get_end_iter (priv->order);
+  }
+
+  return g_sequence_get_iter_at_pos (priv->order, pos);
+}
+
+
+static gboolean
+_objects_remove (DiaLayerPrivate *priv, DiaObject *obj)
+{
+  GSequenceIter *iter = g_hash_table_lookup (priv->index, obj);
+  GList *link;
+
+  if (iter == NULL) {
+    return FALSE;
+  }
+
+  link = g_sequence_get (iter);
+  g_sequence_remove (iter);
+  g_hash_table_remove (priv->index, obj);
+  priv->objects = g_list_delete_link (priv->objects, link);
+
+  return TRUE;
+}
+
+
+/* forget the index and build it for the list now in priv->objects */
+static void
+_objects_reindex (DiaLayerPrivate *priv)
+{
+  GList *list = priv->objects;
+
+  g_sequence_remove_range (g_sequence_get_begin_iter (priv->order),
+                           g_sequence_get_end_iter (priv->order));
+  g_hash_table_remove_all (priv->index);
+
+  priv->objects = NULL;
+  _objects_splice (priv, g_sequence_get_end_iter (priv->order), list);
+}
+
+
 static void
 dia_layer_finalize (GObject *object)
 {
@@ -86,6 +190,8 @@ dia_layer_finalize (GObject *object)
   g_message ("RIP Layer %p %p (%i)", self, priv->parent_diagram, count);
 
   g_clear_pointer (&priv->name, g_free);
+  g_clear_pointer (&priv->index, g_hash_table_destroy);
+  g_clear_pointer (&priv->order, g_sequence_free);
   destroy_object_list (priv->objects);
 
   g_clear_weak_pointer (&priv->parent_diagram);
@@ -222,6 +328,8 @@ dia_layer_init (DiaLayer *self)
   priv->connectable = FALSE;
 
   priv->objects = NULL;
+  priv->order = g_sequence_new (NULL);
+  priv->index = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   priv->extents.left = 0.0;
   priv->extents.right = 10.0;
@@ -382,6 +490,7 @@ dia_layer_new_from_layer (DiaLayer *old)
 
   priv->extents = old_priv->extents;
   priv->objects = object_copy_list (priv->objects);
+  _objects_reindex (priv);
 
   return layer;
 }
@@ -411,7 +520,7 @@ set_parent_layer (gpointer element, gpointer user_data)
  * Get the index of an object in a layer.
  *
  * Returns: The index of the object in the layers list of objects. This is also
- *  the vertical position of the object.
+ *  the vertical position of the object. -1 if it isn't in the layer.
  *
  * Since: 0.98
  */
@@ -419,8 +528,13 @@ int
 dia_layer_object_get_index (DiaLayer *layer, DiaObject *obj)
 {
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
+  GSequenceIter *iter = g_hash_table_lookup (priv->index, obj);
 
-  return (int) g_list_index (priv->objects, (gpointer) obj);
+  if (iter == NULL) {
+    return -1;
+  }
+
+  return g_sequence_iter_get_position (iter);
 }
 
 /**
@@ -436,12 +550,43 @@ DiaObject *
 dia_layer_object_get_nth (DiaLayer *layer, guint index)
 {
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
+  GList *link;
+
+  if (index >= (guint) g_sequence_get_length (priv->order)) {
+    return NULL;
+  }
+
+  link = g_sequence_get (g_sequence_get_iter_at_pos (priv->order, index));
+
+  return (DiaObject *) link->data;
+}
+
+/**
+ * dia_layer_object_get_next:
+ * @layer: The layer containing @obj
+ * @obj: An object in @layer
+ *
+ * Walking the layer from an object, without knowing its index
+ *
+ * Returns: (nullable): The object above @obj, %NULL for the top one or if
+ *  @obj isn't in @layer.
+ *
+ * Since: 0.98
+ */
+DiaObject *
+dia_layer_object_get_next (DiaLayer *layer, DiaObject *obj)
+{
+  DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
+  GSequenceIter *iter = g_hash_table_lookup (priv->index, obj);
+  GList *link;
 
-  if (g_list_length (priv->objects) > index) {
-    g_assert (g_list_nth (priv->objects, index));
-    return (DiaObject *) g_list_nth (priv->objects, index)->data;
+  if (iter == NULL) {
+    return NULL;
   }
-  return NULL;
+
+  link = g_sequence_get (iter);
+
+  return link->next ? link->next->data : NULL;
 }
 
 /**
@@ -455,7 +600,7 @@ dia_layer_object_count (DiaLayer *layer)
 {
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
-  return g_list_length (priv->objects);
+  return g_sequence_get_length (priv->order);
 }
 
 /**
@@ -486,7 +631,9 @@ dia_layer_add_object (DiaLayer *layer, DiaObject *obj)
 {
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
-  priv->objects = g_list_append (priv->objects, (gpointer) obj);
+  _objects_splice (priv,
+                   g_sequence_get_end_iter (priv->order),
+                   g_list_prepend (NULL, obj));
   set_parent_layer (obj, layer);
 
   /* send a signal that we have added a object to the diagram */
@@ -508,7 +655,7 @@ dia_layer_add_object_at (DiaLayer *layer, DiaObject *obj, int pos)
 {
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
-  priv->objects = g_list_insert (priv->objects, (gpointer) obj, pos);
+  _objects_splice (priv, _objects_iter_at (priv, pos), g_list_prepend (NULL, obj));
   set_parent_layer (obj, layer);
 
   /* send a signal that we have added a object to the diagram */
@@ -531,7 +678,7 @@ dia_layer_add_objects (DiaLayer *layer, GList *obj_list)
   GList *list = obj_list;
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
-  priv->objects = g_list_concat (priv->objects, obj_list);
+  _objects_splice (priv, g_sequence_get_end_iter (priv->order), obj_list);
   g_list_foreach (obj_list, set_parent_layer, layer);
 
   while (list != NULL) {
@@ -558,7 +705,7 @@ dia_layer_add_objects_first (DiaLayer *layer, GList *obj_list) {
   GList *list = obj_list;
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
-  priv->objects = g_list_concat (obj_list, priv->objects);
+  _objects_splice (priv, g_sequence_get_begin_iter (priv->order), obj_list);
   g_list_foreach (obj_list, set_parent_layer, layer);
 
   /* Send one signal per object added */
@@ -588,7 +735,7 @@ dia_layer_remove_object (DiaLayer *layer, DiaObject *obj)
   /* send a signal that we'll remove a object from the diagram */
   data_emit (dia_layer_get_parent_diagram (layer), layer, obj, "object_remove");
 
-  priv->objects = g_list_remove (priv->objects, obj);
+  _objects_remove (priv, obj);
   dynobj_list_remove_object (obj);
   set_parent_layer (obj, NULL);
 }
@@ -598,7 +745,8 @@ dia_layer_remove_object (DiaLayer *layer, DiaObject *obj)
  * @layer: The layer to remove the objects from.
  * @obj_list: The objects to remove.
  *
- * Remove a list of objects from a layer.
+ * Remove a list of objects from a layer. The remaining objects keep
+ * their order, each removal costs O(log n).
  *
  * Since: 0.98
  */
@@ -615,6 +763,79 @@ dia_layer_remove_objects (DiaLayer *layer, GList *obj_list)
   }
 }
 
+typedef struct _ObjectPosition ObjectPosition;
+struct _ObjectPosition {
+  int        pos;
+  DiaObject *obj;
+};
+
+
+static int
+_compare_positions (gconstpointer a, gconstpointer b)
+{
+  const ObjectPosition *pa = a;
+  const ObjectPosition *pb = b;
+
+  return (pa->pos > pb->pos) - (pa->pos < pb->pos);
+}
+
+
+/**
+ * dia_layer_sort_objects:
+ * @layer: The layer giving the order.
+ * @obj_list: Objects, usually a selection.
+ *
+ * Sort objects by their position in the layer, without walking the
+ * whole layer. Objects not in @layer are left out.
+ *
+ * Returns: (transfer container): A new list of the objects of @obj_list
+ *  in @layer, from bottom to top.
+ *
+ * Since: 0.98
+ */
+GList *
+dia_layer_sort_objects (DiaLayer *layer, GList *obj_list)
+{
+  DiaLayerPrivate *priv;
+  GArray *positions;
+  GList *sorted = NULL;
+  int i;
+
+  g_return_val_if_fail (DIA_IS_LAYER (layer), NULL);
+
+  priv = dia_layer_get_instance_private (layer);
+
+  positions = g_array_new (FALSE, FALSE, sizeof (ObjectPosition));
+  for (; obj_list != NULL; obj_list = g_list_next (obj_list)) {
+    GSequenceIter *iter = g_hash_table_lookup (priv->index, obj_list->data);
+    ObjectPosition op;
+
+    if (iter == NULL) {
+      continue;
+    }
+    op.pos = g_sequence_iter_get_position (iter);
+    op.obj = obj_list->data;
+    g_array_append_val (positions, op);
+  }
+
+  g_array_sort (positions, _compare_positions);
+
+  for (i = positions->len - 1; i >= 0; i--) {
+    ObjectPosition *op = &g_array_index (positions, ObjectPosition, i);
+
+    /* the same object twice in obj_list */
+    if (sorted && sorted->data == op->obj) {
+      continue;
+    }
+    sorted = g_list_prepend (sorted, op->obj);
+  }
+
+  g_array_free (positions, TRUE);
+
+  return sorted;
+}
+
+
 /**
  * dia_layer_find_objects_intersecting_rectangle:
  * @layer: The layer to search in.
@@ -916,35 +1137,27 @@ dia_layer_replace_object_with_list (DiaLayer  *layer,
                                     DiaObject *remove_obj,
                                     GList     *insert_list)
 {
-  GList *list, *il;
+  GSequenceIter *iter;
+  GList *il;
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
-  list = g_list_find (priv->objects, remove_obj);
+  iter = g_hash_table_lookup (priv->index, remove_obj);
 
-  g_assert (list!=NULL);
+  g_assert (iter != NULL);
   dynobj_list_remove_object (remove_obj);
   data_emit (dia_layer_get_parent_diagram (layer), layer, remove_obj, "object_remove");
   set_parent_layer (remove_obj, NULL);
   g_list_foreach (insert_list, set_parent_layer, layer);
 
-  if (list->prev == NULL) {
-    priv->objects = insert_list;
-  } else {
-    list->prev->next = insert_list;
-    insert_list->prev = list->prev;
-  }
-  if (list->next != NULL) {
-    GList *last;
-    last = g_list_last (insert_list);
-    last->next = list->next;
-    list->next->prev = last;
-  }
+  iter = g_sequence_iter_next (iter);
+  _objects_remove (priv, remove_obj);
+  _objects_splice (priv, iter, insert_list);
+
   il = insert_list;
   while (il) {
     data_emit (dia_layer_get_parent_diagram (layer), layer, il->data, "object_add");
     il = g_list_next (il);
   }
-  g_list_free_1 (list);
 
   /* with transformed groups the list and the single object are not necessarily
    * of the same size */
@@ -968,29 +1181,45 @@ void
 dia_layer_set_object_list (DiaLayer *layer, GList *list)
 {
   GList *ol;
+  GHashTable *old_index;
+  GHashTable *new_objects = g_hash_table_new (g_direct_hash, g_direct_equal);
   DiaLayerPrivate *priv = dia_layer_get_instance_private (layer);
 
+  for (ol = list; ol != NULL; ol = g_list_next (ol)) {
+    g_hash_table_add (new_objects, ol->data);
+  }
+
   /* signal removal on all objects */
   ol = priv->objects;
   while (ol) {
-    if (!g_list_find (list, ol->data)) /* only if it really vanishes */
+    if (!g_hash_table_contains (new_objects, ol->data)) /* only if it really vanishes */
       data_emit (dia_layer_get_parent_diagram (layer), layer, ol->data, "object_remove");
     ol = g_list_next (ol);
   }
+  g_hash_table_destroy (new_objects);
+
   /* restore old list */
   ol = priv->objects;
   g_list_foreach (priv->objects, set_parent_layer, NULL);
   g_list_foreach (priv->objects, layer_remove_dynobj, NULL);
 
-  priv->objects = list;
+  /* the old index tells what is new */
+  old_index = priv->index;
+  priv->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_sequence_remove_range (g_sequence_get_begin_iter (priv->order),
+                           g_sequence_get_end_iter (priv->order));
+  priv->objects = NULL;
+  _objects_splice (priv, g_sequence_get_end_iter (priv->order), list);
+
   g_list_foreach (priv->objects, set_parent_layer, layer);
   /* signal addition on all objects */
   list = priv->objects;
   while (list) {
-    if (!g_list_find (ol, list->data)) /* only if it is new */
+    if (!g_hash_table_contains (old_index, list->data)) /* only if it is new */
       data_emit (dia_layer_get_parent_diagram (layer), layer, list->data, "object_add");
     list = g_list_next (list);
   }
+  g_hash_table_destroy (old_index);
   g_list_free (ol);
 }
 
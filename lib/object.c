@@ -31,6 +31,12 @@
 #include "message.h"
 #include "parent.h"
 #include "dia-layer.h"
+#include "dia-object-profile.h"
+#include "properties.h"
+#include "prop_text.h"
+#include "prop_geomtypes.h"
+#include "prop_pixbuf.h"
+#include "prop_sdarray.h"
 
 #include "debug.h"
 
@@ -1210,6 +1216,172 @@ object_copy_using_properties (DiaObject *obj)
   return newobj;
 }
 
+
+/**
+ * object_get_memory_size:
+ * @obj: the object
+ * @struct_size: sizeof the object's structure
+ *
+ * The memory used by @obj as a #DiaObject: its structure, the arrays of
+ * handles and connection points, the lists of connected objects and the
+ * meta info. For implementing #GetMemorySizeFunc, which adds what the
+ * object owns on top.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+object_get_memory_size (DiaObject *obj, gsize struct_size)
+{
+  gsize size = struct_size;
+  int i;
+
+  size += obj->num_handles * sizeof (Handle *);
+  size += obj->num_connections * sizeof (ConnectionPoint *);
+  for (i = 0; i < obj->num_connections; i++) {
+    if (obj->connections[i]) {
+      size += g_list_length (obj->connections[i]->connected) * sizeof (GList);
+    }
+  }
+  if (obj->meta) {
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init (&iter, obj->meta);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+      size += strlen (key) + 1 + strlen (value) + 1;
+    }
+  }
+
+  return size;
+}
+
+
+static gsize
+_pixbuf_memory_size (GdkPixbuf *pixbuf, GHashTable *shared)
+{
+  if (!pixbuf) {
+    return 0;
+  }
+  if (shared) {
+    if (g_hash_table_contains (shared, pixbuf)) {
+      return 0;
+    }
+    g_hash_table_add (shared, pixbuf);
+  }
+
+  return gdk_pixbuf_get_byte_length (pixbuf);
+}
+
+
+/* the data the property values hold, not their own structures */
+static gsize
+_props_memory_size (GPtrArray *props, GHashTable *shared)
+{
+  gsize size = 0;
+  guint i;
+
+  for (i = 0; i < props->len; i++) {
+    Property *prop = g_ptr_array_index (props, i);
+    GQuark type = prop->type_quark;
+
+    if (prop->name_quark == g_quark_from_static_string ("meta")) {
+      /* already by object_get_memory_size() */
+      continue;
+    }
+
+    if (type == g_quark_from_static_string (PROP_TYPE_STRING) ||
+        type == g_quark_from_static_string (PROP_TYPE_MULTISTRING) ||
+        type == g_quark_from_static_string (PROP_TYPE_FILE)) {
+      StringProperty *p = (StringProperty *) prop;
+
+      size += p->string_data ? strlen (p->string_data) + 1 : 0;
+    } else if (type == g_quark_from_static_string (PROP_TYPE_TEXT)) {
+      TextProperty *p = (TextProperty *) prop;
+
+      size += p->text_data ? strlen (p->text_data) + 1 : 0;
+    } else if (type == g_quark_from_static_string (PROP_TYPE_STRINGLIST)) {
+      StringListProperty *p = (StringListProperty *) prop;
+      GList *l;
+
+      for (l = p->string_list; l != NULL; l = g_list_next (l)) {
+        size += sizeof (GList) + strlen (l->data) + 1;
+      }
+    } else if (type == g_quark_from_static_string (PROP_TYPE_POINTARRAY)) {
+      PointarrayProperty *p = (PointarrayProperty *) prop;
+
+      size += p->pointarray_data->len * sizeof (Point);
+    } else if (type == g_quark_from_static_string (PROP_TYPE_BEZPOINTARRAY)) {
+      BezPointarrayProperty *p = (BezPointarrayProperty *) prop;
+
+      size += p->bezpointarray_data->len * sizeof (BezPoint);
+    } else if (type == g_quark_from_static_string (PROP_TYPE_SARRAY) ||
+               type == g_quark_from_static_string (PROP_TYPE_DARRAY)) {
+      ArrayProperty *p = (ArrayProperty *) prop;
+      guint r;
+
+      for (r = 0; r < p->records->len; r++) {
+        size += _props_memory_size (g_ptr_array_index (p->records, r), shared);
+      }
+    } else if (type == g_quark_from_static_string (PROP_TYPE_PIXBUF)) {
+      size += _pixbuf_memory_size (((PixbufProperty *) prop)->pixbuf, shared);
+    }
+  }
+
+  return size;
+}
+
+
+/**
+ * dia_object_get_memory_size:
+ * @self: the object
+ * @shared: (nullable): the shared data already counted
+ *
+ * The memory used by @self, including everything it owns: geometry, text,
+ * images and strings. Objects implementing #GetMemorySizeFunc report it
+ * exactly, for the others it is estimated from their properties.
+ *
+ * Data shared between objects, e.g. the pixels of an image used several
+ * times, is counted only if not in @shared yet and is added to it then.
+ * Pass the same set for all objects of a diagram to count it once.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+dia_object_get_memory_size (DiaObject  *self,
+                            GHashTable *shared)
+{
+  const PropDescription *descs;
+  gsize size;
+
+  g_return_val_if_fail (self != NULL, 0);
+
+  if (self->ops->get_memory_size) {
+    return self->ops->get_memory_size (self, shared);
+  }
+
+  /* the structure is unknown, at least it holds or points to the
+   * handles and connection points */
+  size = object_get_memory_size (self,
+                                 sizeof (DiaObject) +
+                                 self->num_handles * sizeof (Handle) +
+                                 self->num_connections * sizeof (ConnectionPoint));
+  descs = self->ops->describe_props ? dia_object_describe_properties (self) : NULL;
+  if (descs && self->ops->get_props) {
+    /* what gets saved is what the object holds */
+    GPtrArray *props = prop_list_from_descs (descs, pdtpp_do_save);
+
+    dia_object_get_properties (self, props);
+    size += _props_memory_size (props, shared);
+    prop_list_free (props);
+  }
+
+  return size;
+}
+
 /**
  * dia_object_get_bounding_box:
  * @obj: The object to get the bounding box for.
@@ -1457,10 +1629,14 @@ void
 dia_object_draw (DiaObject   *self,
                  DiaRenderer *renderer)
 {
+  gint64 start;
+
   g_return_if_fail (self != NULL);
   g_return_if_fail (self->ops->draw != NULL);
 
+  start = DIA_OBJECT_PROFILE_BEGIN ();
   self->ops->draw (self, renderer);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_DRAW, start);
 }
 
 /**
@@ -1483,10 +1659,17 @@ double
 dia_object_distance_from (DiaObject *self,
                           Point     *point)
 {
+  gint64 start;
+  double distance;
+
   g_return_val_if_fail (self != NULL, 0.0);
   g_return_val_if_fail (self->ops->distance_from != NULL, 0.0);
 
-  return self->ops->distance_from (self, point);
+  start = DIA_OBJECT_PROFILE_BEGIN ();
+  distance = self->ops->distance_from (self, point);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_DISTANCE, start);
+
+  return distance;
 }
 
 
@@ -1570,10 +1753,17 @@ DiaObjectChange *
 dia_object_move (DiaObject *self,
                  Point     *to)
 {
+  gint64 start;
+  DiaObjectChange *change;
+
   g_return_val_if_fail (self != NULL, NULL);
   g_return_val_if_fail (self->ops->move != NULL, NULL);
 
-  return self->ops->move (self, to);
+  start = DIA_OBJECT_PROFILE_BEGIN ();
+  change = self->ops->move (self, to);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_MOVE, start);
+
+  return change;
 }
 
 
@@ -1617,10 +1807,17 @@ dia_object_move_handle (DiaObject              *self,
                         HandleMoveReason        reason,
                         ModifierKeys            modifiers)
 {
+  gint64 start;
+  DiaObjectChange *change;
+
   g_return_val_if_fail (self != NULL, NULL);
   g_return_val_if_fail (self->ops->move_handle != NULL, NULL);
 
-  return self->ops->move_handle (self, handle, to, cp, reason, modifiers);
+  start = DIA_OBJECT_PROFILE_BEGIN ();
+  change = self->ops->move_handle (self, handle, to, cp, reason, modifiers);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_MOVE_HANDLE, start);
+
+  return change;
 }
 
 
@@ -1786,10 +1983,14 @@ void
 dia_object_set_properties (DiaObject *self,
                            GPtrArray *list)
 {
+  gint64 start;
+
   g_return_if_fail (self != NULL);
   g_return_if_fail (self->ops->set_props != NULL);
 
+  start = DIA_OBJECT_PROFILE_BEGIN ();
   self->ops->set_props (self, list);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_UPDATE, start);
 }
 
 
@@ -1814,10 +2015,17 @@ DiaObjectChange *
 dia_object_apply_properties (DiaObject *self,
                              GPtrArray *list)
 {
+  gint64 start;
+  DiaObjectChange *change;
+
   g_return_val_if_fail (self != NULL, NULL);
   g_return_val_if_fail (self->ops->apply_properties_list != NULL, NULL);
 
-  return self->ops->apply_properties_list (self, list);
+  start = DIA_OBJECT_PROFILE_BEGIN ();
+  change = self->ops->apply_properties_list (self, list);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_UPDATE, start);
+
+  return change;
 }
 
 /**
@@ -1848,10 +2056,17 @@ dia_object_edit_text (DiaObject     *self,
                       TextEditState  state,
                       gchar         *textchange)
 {
+  gint64 start;
+  gboolean allowed;
+
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (self->ops->edit_text != NULL, FALSE);
 
-  return self->ops->edit_text (self, text, state, textchange);
+  start = DIA_OBJECT_PROFILE_BEGIN ();
+  allowed = self->ops->edit_text (self, text, state, textchange);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_UPDATE, start);
+
+  return allowed;
 }
 
 /**
@@ -1875,10 +2090,17 @@ gboolean
 dia_object_transform (DiaObject       *self,
                       const DiaMatrix *m)
 {
+  gint64 start;
+  gboolean applied;
+
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (self->ops->transform != NULL, FALSE);
 
-  return self->ops->transform (self, m);
+  start = DIA_OBJECT_PROFILE_BEGIN ();
+  applied = self->ops->transform (self, m);
+  dia_object_profile_add (self->type, DIA_OBJECT_PROFILE_UPDATE, start);
+
+  return applied;
 }
 
 
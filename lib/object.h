@@ -224,6 +224,18 @@ typedef void (* SetPropsFunc) (DiaObject *obj, GPtrArray *props);
 typedef DiaMenu *(*ObjectMenuFunc) (DiaObject* obj, Point *position);
 typedef gboolean (*TextEditFunc) (DiaObject *obj, Text *text, TextEditState state, gchar *textchange);
 typedef gboolean (*TransformFunc) (DiaObject *obj, const DiaMatrix *m);
+/**
+ * GetMemorySizeFunc:
+ * @obj: Explicit this pointer
+ * @shared: (nullable): the shared data already counted, e.g. images
+ *
+ * The memory used by the object, including everything it owns. Data shared
+ * with other objects is only counted if not in @shared yet, see
+ * dia_object_get_memory_size()
+ *
+ * Returns: the size in bytes
+ */
+typedef gsize (*GetMemorySizeFunc) (DiaObject *obj, GHashTable *shared);
 
 
 
@@ -280,6 +292,7 @@ DiaObject *object_load_using_properties(const DiaObjectType *type,
 void object_save_using_properties(DiaObject *obj, ObjectNode obj_node,
                                   DiaContext *ctx);
 DiaObject *object_copy_using_properties(DiaObject *obj);
+gsize object_get_memory_size (DiaObject *obj, gsize struct_size);
 
 /*****************************************
  **  The structures used to define an object
@@ -327,6 +340,7 @@ struct _ObjectOps {
                                                           GPtrArray        *props);
   gboolean               (*transform)                    (DiaObject        *obj,
                                                           const DiaMatrix  *m);
+  GetMemorySizeFunc      get_memory_size;
 
   /*!
     Unused places (for extension).
@@ -334,7 +348,7 @@ struct _ObjectOps {
     Then an older object will be binary compatible, because all new code
     checks if new ops are supported (!= NULL)
   */
-  void      (*unused[3])(DiaObject *obj,...);
+  void      (*unused[2])(DiaObject *obj,...);
 };
 
 // #ifdef _DIA_OBJECT_BUILD
@@ -529,6 +543,8 @@ gboolean               dia_object_edit_text           (DiaObject              *s
                                                        gchar                  *textchange);
 gboolean               dia_object_transform           (DiaObject              *self,
                                                        const DiaMatrix        *m);
+gsize                  dia_object_get_memory_size     (DiaObject              *self,
+                                                       GHashTable             *shared);
 void                   dia_object_add_handle           (DiaObject               *self,
                                                         Handle                  *handle,
                                                         int                      index,
@@ -656,6 +656,38 @@ orthconn_destroy(OrthConn *orth)
   g_clear_pointer (&orth->handles, g_free);
 }
 
+
+/**
+ * orthconn_get_memory_size:
+ * @orth: the #OrthConn
+ * @struct_size: sizeof the object's structure
+ *
+ * The memory used by @orth as an #OrthConn: on top of
+ * object_get_memory_size() the points, orientations, handles and the
+ * connection points on the segments.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+orthconn_get_memory_size (OrthConn *orth, gsize struct_size)
+{
+  gsize size = object_get_memory_size (&orth->object, struct_size);
+
+  size += orth->numpoints * sizeof (Point);
+  size += orth->numorient * sizeof (Orientation);
+  size += orth->numhandles * (sizeof (Handle *) + sizeof (Handle));
+  if (orth->midpoints) {
+    size += sizeof (ConnPointLine);
+    size += orth->midpoints->num_connections *
+              (sizeof (GSList) + sizeof (ConnectionPoint));
+  }
+
+  return size;
+}
+
+
 static void
 place_handle_by_swapping(OrthConn *orth, int index, Handle *handle)
 {
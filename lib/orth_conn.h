@@ -92,6 +92,8 @@ void             orthconn_update_boundingbox          (OrthConn         *orth);
 void             orthconn_init                        (OrthConn         *orth,
                                                        Point            *startpoint);
 void             orthconn_destroy                     (OrthConn         *orth);
+gsize            orthconn_get_memory_size             (OrthConn         *orth,
+                                                       gsize             struct_size);
 void             orthconn_set_points                  (OrthConn         *orth,
                                                        int               num_points,
                                                        Point            *points);
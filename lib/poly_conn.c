@@ -198,17 +198,8 @@ polyconn_closest_handle(PolyConn *poly, Point *point)
 real
 polyconn_distance_from(PolyConn *poly, Point *point, real line_width)
 {
-  int i;
-  real dist;
-
-  dist = distance_line_point( &poly->points[0], &poly->points[1],
-			      line_width, point);
-  for (i=1;i<poly->numpoints-1;i++) {
-    dist = MIN(dist,
-	       distance_line_point( &poly->points[i], &poly->points[i+1],
-				    line_width, point));
-  }
-  return dist;
+  return distance_polyline_point (poly->points, poly->numpoints,
+                                  line_width, point);
 }
 
 static void
@@ -454,6 +445,30 @@ polyconn_destroy (PolyConn *poly)
 }
 
 
+/**
+ * polyconn_get_memory_size:
+ * @poly: the #PolyConn
+ * @struct_size: sizeof the object's structure
+ *
+ * The memory used by @poly as a #PolyConn: on top of
+ * object_get_memory_size() the points and the handles.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+polyconn_get_memory_size (PolyConn *poly, gsize struct_size)
+{
+  gsize size = object_get_memory_size (&poly->object, struct_size);
+
+  size += poly->numpoints * sizeof (Point);
+  size += poly->object.num_handles * sizeof (Handle);
+
+  return size;
+}
+
+
 void
 polyconn_save(PolyConn *poly, ObjectNode obj_node, DiaContext *ctx)
 {
@@ -57,6 +57,7 @@ void polyconn_update_boundingbox(PolyConn *poly);
 void polyconn_init(PolyConn *poly, int num_points);
 void polyconn_set_points(PolyConn *poly, int num_points, Point *points);
 void polyconn_destroy(PolyConn *poly);
+gsize polyconn_get_memory_size (PolyConn *poly, gsize struct_size);
 void polyconn_copy(PolyConn *from, PolyConn *to);
 void polyconn_save(PolyConn *poly, ObjectNode obj_node, DiaContext *ctx);
 void polyconn_load(PolyConn *poly, ObjectNode obj_node, DiaContext *ctx);  /* NOTE: Does object_init() */
@@ -32,6 +32,7 @@
 #include "properties.h"
 #include "propinternals.h"
 #include "message.h"
+#include "dia_image.h"
 
 static PixbufProperty *
 pixbufprop_new(const PropDescription *pdesc, PropDescToPropPredicate reason)
@@ -67,6 +68,57 @@ pixbufprop_copy(PixbufProperty *src)
 }
 
 
+/*
+ * Decode the base64 text in (may be NULL) to a pixbuf with its "mime-type"
+ * attached. Thread safe, used by the workers of data_image_deferred().
+ */
+static GdkPixbuf *
+_pixbuf_decode_base64 (const char *in, GError **error)
+{
+  GdkPixbuf *pixbuf = NULL;
+  GdkPixbufLoader *loader;
+  GError *err = NULL;
+  int state = 0;
+  guint save = 0;
+# define BUF_SIZE 4096
+  guchar buf[BUF_SIZE];
+  gssize len = in ? strlen (in) : 0;
+
+  loader = gdk_pixbuf_loader_new ();
+
+  do {
+    gsize step = g_base64_decode_step (in,
+                                       len > BUF_SIZE ? BUF_SIZE : len,
+                                       buf, &state, &save);
+    if (!gdk_pixbuf_loader_write (loader, buf, step, &err)) {
+      break;
+    }
+
+    in += BUF_SIZE;
+    len -= BUF_SIZE;
+  } while (len > 0);
+
+  if (gdk_pixbuf_loader_close (loader, err ? NULL : &err)) {
+    GdkPixbufFormat *format = gdk_pixbuf_loader_get_format (loader);
+    char **mime_types = gdk_pixbuf_format_get_mime_types (format);
+
+    pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+    /* attach the mime-type to the pixbuf */
+    g_object_set_data_full (G_OBJECT (pixbuf), "mime-type",
+                            g_strdup (mime_types[0]),
+                            (GDestroyNotify) g_free);
+    g_strfreev (mime_types);
+  } else {
+    g_propagate_error (error, err);
+  }
+
+  g_clear_object (&loader);
+
+  return pixbuf;
+# undef BUF_SIZE
+}
+
+
 /**
  * pixbuf_decode_base64:
  * @b64: Base64 encoded data
@@ -76,104 +128,295 @@ pixbufprop_copy(PixbufProperty *src)
 GdkPixbuf *
 pixbuf_decode_base64 (const char *b64)
 {
-  /* see lib/prop_pixbuf.c(data_pixbuf) for a very similar implementation */
-  GdkPixbuf *pixbuf = NULL;
-  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf;
   GError *error = NULL;
 
-  loader = gdk_pixbuf_loader_new ();
-  if (loader) {
-    int state = 0;
-    guint save = 0;
-#   define BUF_SIZE 4096
-    guchar buf[BUF_SIZE];
-    char *in = (gchar *)b64; /* direct access, not involving another xmlStrDup/xmlFree */
-    gssize len = strlen (b64);
-
-    do {
-      gsize step = g_base64_decode_step (in,
-					 len > BUF_SIZE ? BUF_SIZE : len,
-					 buf, &state, &save);
-      if (!gdk_pixbuf_loader_write (loader, buf, step, &error))
-	break;
-
-      in += BUF_SIZE;
-      len -= BUF_SIZE;
-    } while (len > 0);
-
-    if (gdk_pixbuf_loader_close (loader, error ? NULL : &error)) {
-      GdkPixbufFormat *format = gdk_pixbuf_loader_get_format (loader);
-      char  *format_name = gdk_pixbuf_format_get_name (format);
-      char **mime_types = gdk_pixbuf_format_get_mime_types (format);
-
-      dia_log_message ("Loaded pixbuf from '%s' with '%s'", format_name, mime_types[0]);
-      pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
-      /* attach the mime-type to the pixbuf */
-      g_object_set_data_full (G_OBJECT (pixbuf), "mime-type",
-                              g_strdup (mime_types[0]),
-                              (GDestroyNotify) g_free);
-      g_strfreev (mime_types);
-      g_clear_pointer (&format_name, g_free);
-    } else {
-      message_warning (_("Failed to load image form diagram:\n%s"), error->message);
-      g_clear_error (&error);
+  pixbuf = _pixbuf_decode_base64 (b64, &error);
+  if (pixbuf) {
+    dia_log_message ("Loaded pixbuf with '%s'",
+                     (char *) g_object_get_data (G_OBJECT (pixbuf), "mime-type"));
+  } else {
+    message_warning (_("Failed to load image form diagram:\n%s"), error->message);
+    g_clear_error (&error);
+  }
+
+  return pixbuf;
+}
+
+
+/*
+ * Images written once per document
+ *
+ * While a diagram is saved or loaded the context carries a PixbufTable.
+ * Every distinct pixbuf goes once into the <dia:images> section as
+ * <dia:composite type="pixbuf" id="checksum"> and objects only store a
+ * "ref" to it. Loading decodes each entry at most once, and even inline
+ * data of older files is shared if it's the very same text.
+ */
+typedef struct _PixbufTable {
+  xmlNodePtr  section;   /* <dia:images>, may be NULL when loading */
+  GHashTable *entries;   /* id -> DataNode in section */
+  GHashTable *pixbufs;   /* id or inline checksum -> GdkPixbuf */
+  GHashTable *images;    /* the same for data_image_deferred() */
+  int         n_refs;    /* number of references resolved or written */
+} PixbufTable;
+
+#define PIXBUF_TABLE_KEY "dia-pixbuf-table"
+
+
+static void
+_pixbuf_table_free (PixbufTable *table)
+{
+  g_clear_pointer (&table->entries, g_hash_table_destroy);
+  g_clear_pointer (&table->pixbufs, g_hash_table_destroy);
+  g_clear_pointer (&table->images, g_hash_table_destroy);
+  g_free (table);
+}
+
+
+/**
+ * data_begin_pixbuf_table:
+ * @section: the node holding the shared images
+ * @ctx: the #DiaContext of the load or save
+ *
+ * Make data_pixbuf() and data_add_pixbuf() share images via @section
+ * until data_end_pixbuf_table() is called. When loading @section may be
+ * %NULL, which still avoids decoding repeated inline data twice.
+ */
+void
+data_begin_pixbuf_table (xmlNodePtr section, DiaContext *ctx)
+{
+  PixbufTable *table;
+
+  g_return_if_fail (ctx != NULL);
+
+  table = g_new0 (PixbufTable, 1);
+  table->section = section;
+  table->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          (GDestroyNotify) xmlFree, NULL);
+  table->pixbufs = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, g_object_unref);
+  table->images = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, g_object_unref);
+
+  for (xmlNodePtr node = section ? section->xmlChildrenNode : NULL;
+       node != NULL;
+       node = node->next) {
+    xmlChar *id;
+
+    if (xmlIsBlankNode (node) || node->type != XML_ELEMENT_NODE) {
+      continue;
     }
 
-    g_clear_object (&loader);
+    id = xmlGetProp (node, (const xmlChar *) "id");
+    if (id) {
+      g_hash_table_insert (table->entries, id, node);
+    }
   }
+
+  g_object_set_data_full (G_OBJECT (ctx), PIXBUF_TABLE_KEY, table,
+                          (GDestroyNotify) _pixbuf_table_free);
+}
+
+
+/**
+ * data_end_pixbuf_table:
+ * @ctx: the #DiaContext given to data_begin_pixbuf_table()
+ *
+ * Returns: the number of distinct images in the section
+ */
+int
+data_end_pixbuf_table (DiaContext *ctx)
+{
+  PixbufTable *table;
+  int n_images;
+
+  g_return_val_if_fail (ctx != NULL, 0);
+
+  table = g_object_get_data (G_OBJECT (ctx), PIXBUF_TABLE_KEY);
+  if (!table) {
+    return 0;
+  }
+
+  n_images = g_hash_table_size (table->entries);
+  dia_log_message ("Pixbuf table: %d images for %d references",
+                   n_images, table->n_refs);
+  g_object_set_data (G_OBJECT (ctx), PIXBUF_TABLE_KEY, NULL);
+
+  return n_images;
+}
+
+
+/* the base64 text of a pixbuf composite, owned by the document */
+static const char *
+_data_pixbuf_text (DataNode data)
+{
+  xmlNode *node = attribute_first_data (composite_find_attribute (data, "data"));
+
+  if (node && node->children && xmlStrcmp (node->children->name, (const xmlChar*)"text") == 0) {
+    return (const char *) node->children->content;
+  }
+
+  return NULL;
+}
+
+
+static GdkPixbuf *
+_data_pixbuf_inline (DataNode data, DiaContext *ctx)
+{
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+
+  pixbuf = _pixbuf_decode_base64 (_data_pixbuf_text (data), &error);
+  if (!pixbuf) {
+    message_warning (_("Failed to load image form diagram:\n%s"), error->message);
+    g_clear_error (&error);
+  }
+
   return pixbuf;
-# undef BUF_SIZE
+}
+
+
+static char *
+_data_pixbuf_text_checksum (DataNode data)
+{
+  const char *text = _data_pixbuf_text (data);
+
+  if (text) {
+    return g_compute_checksum_for_string (G_CHECKSUM_SHA256, text, -1);
+  }
+
+  return NULL;
+}
+
+
+/*
+ * Follow a "ref" into the image section and get the key to share the
+ * result by. Returns FALSE if the reference is dangling.
+ */
+static gboolean
+_data_pixbuf_resolve (DataNode *data, PixbufTable *table, char **key, DiaContext *ctx)
+{
+  AttributeNode attr = composite_find_attribute (*data, "ref");
+
+  *key = NULL;
+  if (attr) {
+    /* reference into the document's image section */
+    DataNode entry;
+
+    *key = data_string (attribute_first_data (attr), ctx);
+    entry = (table && *key) ? g_hash_table_lookup (table->entries, *key) : NULL;
+    if (!entry) {
+      dia_context_add_message (ctx, _("Missing image data '%s'"),
+                               *key ? *key : "");
+      g_clear_pointer (key, g_free);
+      return FALSE;
+    }
+    *data = entry;
+  } else if (table) {
+    *key = _data_pixbuf_text_checksum (*data);
+  }
+
+  if (*key) {
+    table->n_refs++;
+  }
+
+  return TRUE;
 }
 
 
 GdkPixbuf *
 data_pixbuf (DataNode data, DiaContext *ctx)
 {
+  PixbufTable *table = ctx ? g_object_get_data (G_OBJECT (ctx), PIXBUF_TABLE_KEY) : NULL;
   GdkPixbuf *pixbuf = NULL;
-  GdkPixbufLoader *loader;
-  GError *error = NULL;
-  AttributeNode attr = composite_find_attribute(data, "data");
+  char *key = NULL;
 
-  loader = gdk_pixbuf_loader_new ();
-  if (loader) {
-    xmlNode *node = attribute_first_data (attr);
-    gint state = 0;
-    guint save = 0;
-#  define BUF_SIZE 4096
-    guchar buf[BUF_SIZE];
-    gchar *in = NULL; /* direct access, not involving another xmlStrDup/xmlFree */
-    gssize len = 0;
-
-    if (node->children && xmlStrcmp (node->children->name, (const xmlChar*)"text") == 0) {
-      in = (gchar *)node->children->content;
-      len = strlen ((char *)in);
-    }
+  if (!_data_pixbuf_resolve (&data, table, &key, ctx)) {
+    return NULL;
+  }
+
+  if (!key) {
+    return _data_pixbuf_inline (data, ctx);
+  }
+
+  pixbuf = g_hash_table_lookup (table->pixbufs, key);
+  if (pixbuf) {
+    g_clear_pointer (&key, g_free);
+    return g_object_ref (pixbuf);
+  }
+
+  pixbuf = _data_pixbuf_inline (data, ctx);
+  if (pixbuf) {
+    g_hash_table_insert (table->pixbufs, key, g_object_ref (pixbuf));
+  } else {
+    g_clear_pointer (&key, g_free);
+  }
+
+  return pixbuf;
+}
 
-    do {
-      gsize step = g_base64_decode_step (in,
-					 len > BUF_SIZE ? BUF_SIZE : len,
-					 buf, &state, &save);
 
-      if (!gdk_pixbuf_loader_write (loader, buf, step, &error))
-	break;
+static GdkPixbuf *
+_data_image_decode (gpointer data, GError **error)
+{
+  return _pixbuf_decode_base64 (data, error);
+}
 
-      in += BUF_SIZE;
-      len -= BUF_SIZE;
-    } while (len > 0);
 
-    if (gdk_pixbuf_loader_close (loader, error ? NULL : &error)) {
-      pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
-    } else {
-      message_warning (_("Failed to load image form diagram:\n%s"), error->message);
-      g_clear_error (&error);
+/**
+ * data_image_deferred:
+ * @data: a pixbuf composite as understood by data_pixbuf()
+ * @ctx: the #DiaContext of the load
+ *
+ * Like data_pixbuf() but leave the decoding to a worker thread, see
+ * dia_image_new_deferred(). With a pixbuf table every image is decoded
+ * once for the whole document.
+ *
+ * Returns: (transfer full): a #DiaImage, %NULL if there is no data
+ */
+DiaImage *
+data_image_deferred (DataNode data, DiaContext *ctx)
+{
+  PixbufTable *table = ctx ? g_object_get_data (G_OBJECT (ctx), PIXBUF_TABLE_KEY) : NULL;
+  DiaImage *image;
+  const char *text;
+  char *key = NULL;
+
+  if (!_data_pixbuf_resolve (&data, table, &key, ctx)) {
+    return NULL;
+  }
+
+  if (key) {
+    image = g_hash_table_lookup (table->images, key);
+    if (image) {
+      g_clear_pointer (&key, g_free);
+      return g_object_ref (image);
     }
+  }
 
-    g_clear_object (&loader);
+  text = _data_pixbuf_text (data);
+  if (!text) {
+    dia_context_add_message (ctx, _("Missing image data '%s'"),
+                             key ? key : "");
+    g_clear_pointer (&key, g_free);
+    return NULL;
   }
-#  undef BUF_SIZE
-  return pixbuf;
+
+  /* the document is gone before the worker is done */
+  image = dia_image_new_deferred (_data_image_decode,
+                                  g_strdup (text),
+                                  g_free,
+                                  NULL,
+                                  NULL);
+  if (key) {
+    g_hash_table_insert (table->images, key, g_object_ref (image));
+  }
+
+  return image;
 }
 
+
 static void
 pixbufprop_load(PixbufProperty *prop, AttributeNode attr, DataNode data, DiaContext *ctx)
 {
@@ -255,10 +498,9 @@ pixbuf_encode_base64 (const GdkPixbuf *pixbuf, const char *prefix)
 
   return (gchar *)g_byte_array_free (ed.array, FALSE);
 }
-void
-data_add_pixbuf (AttributeNode attr, GdkPixbuf *pixbuf, DiaContext *ctx)
+static void
+_data_add_pixbuf_inline (DataNode composite, GdkPixbuf *pixbuf, DiaContext *ctx)
 {
-  ObjectNode composite = data_add_composite(attr, "pixbuf", ctx);
   AttributeNode comp_attr = composite_add_attribute (composite, "data");
   gchar *b64;
 
@@ -270,6 +512,32 @@ data_add_pixbuf (AttributeNode attr, GdkPixbuf *pixbuf, DiaContext *ctx)
   g_clear_pointer (&b64, g_free);
 }
 
+
+void
+data_add_pixbuf (AttributeNode attr, GdkPixbuf *pixbuf, DiaContext *ctx)
+{
+  PixbufTable *table = ctx ? g_object_get_data (G_OBJECT (ctx), PIXBUF_TABLE_KEY) : NULL;
+  ObjectNode composite = data_add_composite(attr, "pixbuf", ctx);
+  const char *key;
+
+  if (!table || !table->section) {
+    _data_add_pixbuf_inline (composite, pixbuf, ctx);
+    return;
+  }
+
+  key = dia_image_pixbuf_checksum (pixbuf);
+  if (!g_hash_table_contains (table->entries, key)) {
+    DataNode entry = data_add_composite (table->section, "pixbuf", ctx);
+
+    xmlSetProp (entry, (const xmlChar *) "id", (const xmlChar *) key);
+    _data_add_pixbuf_inline (entry, pixbuf, ctx);
+    g_hash_table_insert (table->entries, xmlStrdup ((const xmlChar *) key), entry);
+  }
+  table->n_refs++;
+
+  data_add_string (composite_add_attribute (composite, "ref"), key, ctx);
+}
+
 static void
 pixbufprop_save(PixbufProperty *prop, AttributeNode attr, DiaContext *ctx)
 {
@@ -53,6 +53,11 @@ struct _DiaCairoInteractiveRenderer {
   double selection_width;
   double selection_height;
 
+  /* Drag preview overlay, in pixels */
+  cairo_surface_t *preview;
+  double preview_x;
+  double preview_y;
+
   /** If non-NULL, this rendering is a highlighting with the given color. */
   Color *highlight_color;
 };
@@ -86,6 +91,7 @@ dia_cairo_interactive_renderer_finalize (GObject *object)
 
   g_clear_pointer (&base_renderer->cr, cairo_destroy);
   g_clear_pointer (&renderer->surface, cairo_surface_destroy);
+  g_clear_pointer (&renderer->preview, cairo_surface_destroy);
 
   G_OBJECT_CLASS (dia_cairo_interactive_renderer_parent_class)->finalize (object);
 }
@@ -480,6 +486,14 @@ dia_cairo_interactive_renderer_paint (DiaInteractiveRenderer *object,
   cairo_clip (ctx);
   cairo_paint (ctx);
 
+  if (renderer->preview) {
+    cairo_set_source_surface (ctx,
+                              renderer->preview,
+                              renderer->preview_x,
+                              renderer->preview_y);
+    cairo_paint (ctx);
+  }
+
   /* If there should be a selection rectange */
   if (renderer->has_selection) {
     /* Use a dark gray */
@@ -572,6 +586,53 @@ dia_cairo_interactive_renderer_set_selection (DiaInteractiveRenderer *renderer,
   self->selection_height = height;
 }
 
+static void
+dia_cairo_interactive_renderer_set_preview (DiaInteractiveRenderer *self,
+                                            GList                  *objects)
+{
+  DiaCairoInteractiveRenderer *renderer = DIA_CAIRO_INTERACTIVE_RENDERER (self);
+  DiaCairoRenderer *base_renderer = DIA_CAIRO_RENDERER (self);
+  GList *list;
+
+  g_clear_pointer (&renderer->preview, cairo_surface_destroy);
+  renderer->preview_x = 0;
+  renderer->preview_y = 0;
+
+  if (!objects) {
+    return;
+  }
+
+  g_return_if_fail (base_renderer->cr == NULL);
+
+  /* same transformation as begin_render(), but on a transparent surface */
+  renderer->preview = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                  renderer->width,
+                                                  renderer->height);
+  base_renderer->cr = cairo_create (renderer->preview);
+  cairo_scale (base_renderer->cr, *renderer->zoom_factor, *renderer->zoom_factor);
+  cairo_translate (base_renderer->cr, -renderer->visible->left, -renderer->visible->top);
+  g_clear_object (&base_renderer->layout);
+  base_renderer->layout = pango_cairo_create_layout (base_renderer->cr);
+  cairo_set_fill_rule (base_renderer->cr, CAIRO_FILL_RULE_EVEN_ODD);
+
+  for (list = objects; list != NULL; list = g_list_next (list)) {
+    dia_renderer_draw_object (DIA_RENDERER (self), list->data, NULL);
+  }
+
+  g_clear_pointer (&base_renderer->cr, cairo_destroy);
+}
+
+static void
+dia_cairo_interactive_renderer_move_preview (DiaInteractiveRenderer *self,
+                                             double                  dx,
+                                             double                  dy)
+{
+  DiaCairoInteractiveRenderer *renderer = DIA_CAIRO_INTERACTIVE_RENDERER (self);
+
+  renderer->preview_x = dx;
+  renderer->preview_y = dy;
+}
+
 static void
 dia_cairo_interactive_renderer_iface_init (DiaInteractiveRendererInterface* iface)
 {
@@ -586,6 +647,8 @@ dia_cairo_interactive_renderer_iface_init (DiaInteractiveRendererInterface* ifac
   iface->set_size                = dia_cairo_interactive_renderer_set_size;
   iface->draw_object_highlighted = dia_cairo_interactive_renderer_draw_object_highlighted;
   iface->set_selection           = dia_cairo_interactive_renderer_set_selection;
+  iface->set_preview             = dia_cairo_interactive_renderer_set_preview;
+  iface->move_preview            = dia_cairo_interactive_renderer_move_preview;
 }
 
 
@@ -79,8 +79,10 @@ dia_cairo_renderer_begin_render (DiaRenderer *self, const DiaRectangle *update)
   DiaCairoRenderer *renderer = DIA_CAIRO_RENDERER (self);
   real onedu = 0.0;
   real lmargin = 0.0, tmargin = 0.0;
-  gboolean paginated = renderer->surface && /* only with our own pagination, not GtkPrint */
-    cairo_surface_get_type (renderer->surface) == CAIRO_SURFACE_TYPE_PDF && !renderer->skip_show_page;
+  gboolean is_pdf = renderer->surface &&
+    cairo_surface_get_type (renderer->surface) == CAIRO_SURFACE_TYPE_PDF;
+  /* only with our own pagination, not GtkPrint */
+  gboolean paginated = (is_pdf && !renderer->skip_show_page) || renderer->page_setup;
   Color background = color_white;
 
   if (renderer->surface && !renderer->cr) {
@@ -103,7 +105,9 @@ dia_cairo_renderer_begin_render (DiaRenderer *self, const DiaRectangle *update)
            * (72.0 / 2.54) + 0.5;
     /* "Changes the size of a PDF surface for the current (and
      * subsequent) pages." Pagination setup? */
-    cairo_pdf_surface_set_size (renderer->surface, width, height);
+    if (is_pdf) {
+      cairo_pdf_surface_set_size (renderer->surface, width, height);
+    }
     lmargin = data->paper.lmargin / data->paper.scaling;
     tmargin = data->paper.tmargin / data->paper.scaling;
   }
@@ -196,6 +200,25 @@ dia_cairo_renderer_end_render (DiaRenderer *self)
   DIAG_STATE (renderer->cr)
 }
 
+/* Whether the output ends up in pixels, i.e. downsampled images won't be
+ * noticed. Everything else must get the full resolution. */
+static gboolean
+_is_raster_target (cairo_t *cr)
+{
+  switch (cairo_surface_get_type (cairo_get_target (cr))) {
+    case CAIRO_SURFACE_TYPE_PDF:
+    case CAIRO_SURFACE_TYPE_PS:
+    case CAIRO_SURFACE_TYPE_SVG:
+    case CAIRO_SURFACE_TYPE_WIN32_PRINTING:
+    case CAIRO_SURFACE_TYPE_RECORDING:
+    case CAIRO_SURFACE_TYPE_SCRIPT:
+      return FALSE;
+    default:
+      return TRUE;
+  }
+}
+
+
 /*!
  * \brief Advertize renderers capabilities
  *
@@ -204,9 +227,10 @@ dia_cairo_renderer_end_render (DiaRenderer *self)
  * \memberof _DiaCairoRenderer
  */
 static gboolean
-dia_cairo_renderer_is_capable_to (DiaRenderer      *renderer,
+dia_cairo_renderer_is_capable_to (DiaRenderer      *self,
                                   RenderCapability  cap)
 {
+  DiaCairoRenderer *renderer = DIA_CAIRO_RENDERER (self);
   static RenderCapability warned = RENDER_HOLES;
 
   if (RENDER_HOLES == cap) {
@@ -217,6 +241,12 @@ dia_cairo_renderer_is_capable_to (DiaRenderer      *renderer,
     return TRUE;
   } else if (RENDER_PATTERN == cap) {
     return TRUE;
+  } else if (RENDER_SYMBOLS == cap) {
+    /* only vector output keeps a single copy of the recording. Objects
+     * may change themselves to draw a symbol, not while others read them */
+    return renderer->cr &&
+           !_is_raster_target (renderer->cr) &&
+           !renderer->on_worker;
   }
 
   if (cap != warned) {
@@ -229,6 +259,98 @@ dia_cairo_renderer_is_capable_to (DiaRenderer      *renderer,
 }
 
 
+static void
+_place_symbol (DiaCairoRenderer *renderer,
+               cairo_pattern_t  *symbol,
+               const DiaMatrix  *matrix)
+{
+  cairo_save (renderer->cr);
+  cairo_transform (renderer->cr, (const cairo_matrix_t *) matrix);
+  cairo_set_source (renderer->cr, symbol);
+  cairo_paint (renderer->cr);
+  cairo_restore (renderer->cr);
+}
+
+/*!
+ * \brief Reuse or start recording a symbol
+ *
+ * New symbols are drawn to a recording surface with the current
+ * transformation, every instance paints that surface as source. The
+ * vector backends keep a single copy of it in the output.
+ *
+ * \memberof _DiaCairoRenderer
+ */
+static gboolean
+dia_cairo_renderer_begin_symbol (DiaRenderer *self,
+                                 const char  *key,
+                                 DiaMatrix   *matrix)
+{
+  DiaCairoRenderer *renderer = DIA_CAIRO_RENDERER (self);
+  cairo_pattern_t *symbol;
+  cairo_surface_t *surface;
+  cairo_matrix_t m;
+
+  g_return_val_if_fail (renderer->symbol_parent == NULL, TRUE);
+
+  if (!renderer->symbols) {
+    renderer->symbols = g_hash_table_new_full (g_str_hash,
+                                               g_str_equal,
+                                               g_free,
+                                               (GDestroyNotify) cairo_pattern_destroy);
+  }
+
+  symbol = g_hash_table_lookup (renderer->symbols, key);
+  if (symbol) {
+    _place_symbol (renderer, symbol, matrix);
+    return FALSE;
+  }
+
+  g_assert (sizeof (cairo_matrix_t) == sizeof (DiaMatrix));
+  cairo_get_matrix (renderer->cr, &m);
+
+  surface = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+  renderer->symbol = cairo_pattern_create_for_surface (surface);
+  /* user space of the instance to the recording's device space */
+  cairo_pattern_set_matrix (renderer->symbol, &m);
+
+  renderer->symbol_parent = renderer->cr;
+  renderer->cr = cairo_create (surface);
+  cairo_surface_destroy (surface);
+
+  cairo_set_matrix (renderer->cr, &m);
+  cairo_set_antialias (renderer->cr, cairo_get_antialias (renderer->symbol_parent));
+  cairo_set_fill_rule (renderer->cr, cairo_get_fill_rule (renderer->symbol_parent));
+
+  renderer->symbol_key = g_strdup (key);
+  renderer->symbol_matrix = *matrix;
+
+  return TRUE;
+}
+
+/*!
+ * \brief Finish recording and place the first instance
+ * \memberof _DiaCairoRenderer
+ */
+static void
+dia_cairo_renderer_end_symbol (DiaRenderer *self)
+{
+  DiaCairoRenderer *renderer = DIA_CAIRO_RENDERER (self);
+  cairo_pattern_t *symbol;
+
+  g_return_if_fail (renderer->symbol_parent != NULL);
+
+  g_clear_pointer (&renderer->cr, cairo_destroy);
+  renderer->cr = g_steal_pointer (&renderer->symbol_parent);
+
+  symbol = g_steal_pointer (&renderer->symbol);
+  g_hash_table_insert (renderer->symbols,
+                       g_steal_pointer (&renderer->symbol_key),
+                       symbol);
+
+  _place_symbol (renderer, symbol, &renderer->symbol_matrix);
+}
+
+
 /*!
  * \brief Remember the given pattern to use for consecutive fill
  * @param self explicit this pointer
@@ -1077,17 +1199,34 @@ dia_cairo_renderer_draw_rotated_image (DiaRenderer *self,
                                        DiaImage    *image)
 {
   DiaCairoRenderer *renderer = DIA_CAIRO_RENDERER (self);
-  int w = dia_image_width (image);
-  int h = dia_image_height (image);
+  cairo_surface_t *surface;
+  int w, h;
+
+  if (_is_raster_target (renderer->cr)) {
+    /* the device pixels covered decide about the mipmap level to use */
+    double wx = width, wy = 0.0, hx = 0.0, hy = height;
+
+    cairo_user_to_device_distance (renderer->cr, &wx, &wy);
+    cairo_user_to_device_distance (renderer->cr, &hx, &hy);
+    surface = dia_image_get_surface_for_size (image,
+                                              (int) ceil (hypot (wx, wy)),
+                                              (int) ceil (hypot (hx, hy)));
+  } else {
+    /* vector output always gets the full resolution */
+    surface = cairo_surface_reference (dia_image_get_surface (image));
+  }
+  w = cairo_image_surface_get_width (surface);
+  h = cairo_image_surface_get_height (surface);
 
-  DIAG_NOTE (g_message ("draw_image %fx%f [%d(%d),%d] @%f,%f",
-                        width, height, w, rs, h, point->x, point->y));
+  DIAG_NOTE (g_message ("draw_image %fx%f [%d,%d] @%f,%f",
+                        width, height, w, h, point->x, point->y));
 
   cairo_save (renderer->cr);
   cairo_translate (renderer->cr, point->x, point->y);
   cairo_scale (renderer->cr, width / w, height / h);
   cairo_move_to (renderer->cr, 0.0, 0.0);
-  cairo_set_source_surface (renderer->cr, dia_image_get_surface (image), 0.0, 0.0);
+  cairo_set_source_surface (renderer->cr, surface, 0.0, 0.0);
+  cairo_surface_destroy (surface);
 
   if (angle != 0.0) {
     DiaMatrix rotate;
@@ -1262,6 +1401,11 @@ dia_cairo_renderer_finalize (GObject *object)
   g_clear_object (&renderer->layout);
   g_clear_object (&renderer->font);
 
+  g_clear_pointer (&renderer->symbols, g_hash_table_destroy);
+  g_clear_pointer (&renderer->symbol, cairo_pattern_destroy);
+  g_clear_pointer (&renderer->symbol_parent, cairo_destroy);
+  g_clear_pointer (&renderer->symbol_key, g_free);
+
   G_OBJECT_CLASS (dia_cairo_renderer_parent_class)->finalize (object);
 }
 
@@ -1310,6 +1454,8 @@ dia_cairo_renderer_class_init (DiaCairoRendererClass *klass)
 
   /* other */
   renderer_class->is_capable_to = dia_cairo_renderer_is_capable_to;
+  renderer_class->begin_symbol = dia_cairo_renderer_begin_symbol;
+  renderer_class->end_symbol = dia_cairo_renderer_end_symbol;
   renderer_class->set_pattern   = dia_cairo_renderer_set_pattern;
 
   g_object_class_override_property (object_class, PROP_FONT, "font");
@@ -53,6 +53,8 @@
 
 #include <pango/pangocairo.h>
 
+#include <zlib.h>
+
 #include "geometry.h"
 #include "dia_image.h"
 #include "diarenderer.h"
@@ -68,6 +70,453 @@
 #endif
 
 
+#ifdef CAIRO_HAS_PDF_SURFACE
+/*
+ * Rendering the pages of a PDF in parallel: every page is recorded by its
+ * own renderer on a worker thread, the PDF gets them in page order. The
+ * diagram is only read meanwhile, objects changing state of their own
+ * while drawing must serialise that. The renderers are marked on_worker
+ * to not ask for symbols, which custom shapes draw by changing themselves.
+ */
+typedef struct _PageJob {
+  DiaRectangle     bounds;
+  cairo_surface_t *recording; /* set when done */
+} PageJob;
+
+typedef struct _PageQueue {
+  DiagramData *data;
+  double       scale;
+  double       width;         /* of a page in points */
+  double       height;
+  PageJob     *jobs;
+  GMutex       lock;
+  GCond        done;
+} PageQueue;
+
+
+static void
+_record_page (gpointer data, gpointer user_data)
+{
+  PageJob *job = data;
+  PageQueue *queue = user_data;
+  cairo_rectangle_t extents = { 0.0, 0.0, queue->width, queue->height };
+  cairo_surface_t *recording;
+  DiaCairoRenderer *renderer;
+
+  recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, &extents);
+  renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+  renderer->dia = queue->data;
+  renderer->scale = queue->scale;
+  renderer->page_setup = TRUE;
+  renderer->skip_show_page = TRUE;
+  renderer->on_worker = TRUE;
+  renderer->surface = cairo_surface_reference (recording);
+
+  data_render (queue->data, DIA_RENDERER (renderer), &job->bounds, NULL, NULL);
+  g_clear_object (&renderer);
+
+  g_mutex_lock (&queue->lock);
+  job->recording = recording;
+  g_cond_broadcast (&queue->done);
+  g_mutex_unlock (&queue->lock);
+}
+
+
+/* Returns FALSE if it's not worth it, the caller renders sequentially */
+static gboolean
+_render_pages_parallel (DiagramData *data, DiaCairoRenderer *renderer,
+                        double width, double height)
+{
+  int n_threads = MIN (g_get_num_processors (), 8);
+  GThreadPool *pool;
+  PageQueue queue;
+  DiaRectangle *pages;
+  cairo_t *cr;
+  int n_pages;
+  int next;
+  int i;
+
+  if (n_threads < 2) {
+    return FALSE;
+  }
+
+  pages = dia_diagram_data_get_pages (data, &n_pages);
+  if (n_pages < 2) {
+    g_free (pages);
+    return FALSE;
+  }
+
+  queue.jobs = g_new0 (PageJob, n_pages);
+  for (i = 0; i < n_pages; i++) {
+    queue.jobs[i].bounds = pages[i];
+  }
+  g_free (pages);
+
+  queue.data = data;
+  queue.scale = renderer->scale;
+  queue.width = width;
+  queue.height = height;
+  g_mutex_init (&queue.lock);
+  g_cond_init (&queue.done);
+
+  /* racy on first use otherwise, and the workers get their own fonts */
+  render_bounding_boxes ();
+  dia_font_get_context ();
+
+  /* only a few pages in flight, recordings can be big */
+  pool = g_thread_pool_new (_record_page, &queue, n_threads, FALSE, NULL);
+  for (next = 0; next < MIN (n_pages, 2 * n_threads); next++) {
+    g_thread_pool_push (pool, &queue.jobs[next], NULL);
+  }
+
+  /* assemble in page order while the later ones are still recorded */
+  cr = cairo_create (renderer->surface);
+  cairo_pdf_surface_set_size (renderer->surface, width, height);
+  for (i = 0; i < n_pages; i++) {
+    cairo_surface_t *recording;
+
+    g_mutex_lock (&queue.lock);
+    while (!queue.jobs[i].recording) {
+      g_cond_wait (&queue.done, &queue.lock);
+    }
+    recording = queue.jobs[i].recording;
+    g_mutex_unlock (&queue.lock);
+
+    if (next < n_pages) {
+      g_thread_pool_push (pool, &queue.jobs[next++], NULL);
+    }
+
+    cairo_set_source_surface (cr, recording, 0.0, 0.0);
+    cairo_paint (cr);
+    cairo_show_page (cr);
+    cairo_surface_destroy (recording);
+  }
+  cairo_destroy (cr);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_cond_clear (&queue.done);
+  g_mutex_clear (&queue.lock);
+  g_free (queue.jobs);
+
+  return TRUE;
+}
+#endif
+
+
+/*
+ * PNG bigger than this are not rendered to a single image surface but in
+ * bands of about this size, rendered in parallel and written row by row
+ * as they are done. Peak memory stays at a few bands.
+ */
+#define BAND_BYTES (8 * 1024 * 1024)
+
+/* just enough of PNG to stream rows: 8 bit RGB(A), no interlacing */
+typedef struct _PngWriter {
+  FILE     *file;
+  z_stream  stream;
+  guint8    buffer[64 * 1024]; /* deflated, for the next IDAT */
+  guint8   *row;               /* filter type and pixels */
+  int       width;
+  gboolean  alpha;
+  gboolean  failed;
+} PngWriter;
+
+
+static void
+_png_put_uint32 (guint8 *p, guint32 value)
+{
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+
+static void
+_png_write_chunk (PngWriter    *writer,
+                  const char   *type,
+                  const guint8 *data,
+                  guint32       length)
+{
+  guint8 head[8];
+  guint8 tail[4];
+  uLong crc;
+
+  _png_put_uint32 (head, length);
+  memcpy (head + 4, type, 4);
+  crc = crc32 (0, head + 4, 4);
+  if (length > 0) {
+    crc = crc32 (crc, data, length);
+  }
+  _png_put_uint32 (tail, crc);
+
+  if (fwrite (head, 1, 8, writer->file) != 8 ||
+      (length > 0 && fwrite (data, 1, length, writer->file) != length) ||
+      fwrite (tail, 1, 4, writer->file) != 4) {
+    writer->failed = TRUE;
+  }
+}
+
+
+static PngWriter *
+_png_writer_new (const char *filename, int width, int height, gboolean alpha)
+{
+  static const guint8 signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+  PngWriter *writer;
+  guint8 header[13];
+  FILE *file = g_fopen (filename, "wb");
+
+  if (!file) {
+    return NULL;
+  }
+
+  writer = g_new0 (PngWriter, 1);
+  writer->file = file;
+  writer->width = width;
+  writer->alpha = alpha;
+  writer->row = g_new (guint8, 1 + width * (alpha ? 4 : 3));
+
+  if (deflateInit (&writer->stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    writer->failed = TRUE;
+  }
+  writer->stream.next_out = writer->buffer;
+  writer->stream.avail_out = sizeof (writer->buffer);
+
+  _png_put_uint32 (header, width);
+  _png_put_uint32 (header + 4, height);
+  header[8] = 8;                 /* bit depth */
+  header[9] = alpha ? 6 : 2;     /* RGBA or RGB */
+  header[10] = 0;                /* deflate */
+  header[11] = 0;                /* adaptive filtering */
+  header[12] = 0;                /* not interlaced */
+
+  if (fwrite (signature, 1, 8, file) != 8) {
+    writer->failed = TRUE;
+  }
+  _png_write_chunk (writer, "IHDR", header, sizeof (header));
+
+  return writer;
+}
+
+
+static void
+_png_writer_deflate (PngWriter *writer, int flush)
+{
+  int ret;
+
+  do {
+    ret = deflate (&writer->stream, flush);
+    if (writer->stream.avail_out == 0 || (flush == Z_FINISH && ret == Z_STREAM_END)) {
+      _png_write_chunk (writer, "IDAT", writer->buffer,
+                        sizeof (writer->buffer) - writer->stream.avail_out);
+      writer->stream.next_out = writer->buffer;
+      writer->stream.avail_out = sizeof (writer->buffer);
+    }
+  } while (ret == Z_OK && (writer->stream.avail_in > 0 || flush == Z_FINISH));
+
+  if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+    writer->failed = TRUE;
+  }
+}
+
+
+/* the rows of an ARGB32 surface, cairo's are premultiplied */
+static void
+_png_writer_add_rows (PngWriter *writer, cairo_surface_t *surface)
+{
+  const guint8 *data;
+  int stride = cairo_image_surface_get_stride (surface);
+  int height = cairo_image_surface_get_height (surface);
+  int x, y;
+
+  cairo_surface_flush (surface);
+  data = cairo_image_surface_get_data (surface);
+
+  for (y = 0; y < height && !writer->failed; y++) {
+    const guint32 *pixel = (const guint32 *) (data + y * stride);
+    guint8 *out = writer->row;
+
+    *out++ = 0; /* no filter */
+    for (x = 0; x < writer->width; x++) {
+      guint32 p = pixel[x];
+      guint a = p >> 24;
+      guint r = (p >> 16) & 0xff;
+      guint g = (p >> 8) & 0xff;
+      guint b = p & 0xff;
+
+      if (a != 0 && a != 0xff) {
+        r = (r * 0xff + a / 2) / a;
+        g = (g * 0xff + a / 2) / a;
+        b = (b * 0xff + a / 2) / a;
+      }
+      *out++ = r;
+      *out++ = g;
+      *out++ = b;
+      if (writer->alpha) {
+        *out++ = a;
+      }
+    }
+
+    writer->stream.next_in = writer->row;
+    writer->stream.avail_in = out - writer->row;
+    _png_writer_deflate (writer, Z_NO_FLUSH);
+  }
+}
+
+
+/* Returns FALSE if anything went wrong on the way */
+static gboolean
+_png_writer_finish (PngWriter *writer)
+{
+  gboolean ok;
+
+  _png_writer_deflate (writer, Z_FINISH);
+  _png_write_chunk (writer, "IEND", NULL, 0);
+  deflateEnd (&writer->stream);
+
+  ok = !writer->failed;
+  if (fclose (writer->file) != 0) {
+    ok = FALSE;
+  }
+  g_clear_pointer (&writer->row, g_free);
+  g_free (writer);
+
+  return ok;
+}
+
+
+typedef struct _BandJob {
+  int              top;     /* first row in the image */
+  int              height;
+  cairo_surface_t *surface; /* set when done */
+} BandJob;
+
+typedef struct _BandQueue {
+  DiagramData *data;
+  double       scale;
+  gboolean     with_alpha;
+  int          width;
+  BandJob     *jobs;
+  GMutex       lock;
+  GCond        done;
+} BandQueue;
+
+
+static void
+_render_band (gpointer data, gpointer user_data)
+{
+  BandJob *job = data;
+  BandQueue *queue = user_data;
+  DiaRectangle *extents = &queue->data->extents;
+  DiaRectangle update;
+  cairo_surface_t *surface;
+  DiaCairoRenderer *renderer;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, queue->width, job->height);
+  renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+  renderer->dia = queue->data;
+  renderer->scale = queue->scale;
+  renderer->with_alpha = queue->with_alpha;
+  renderer->on_worker = TRUE;
+  renderer->surface = cairo_surface_reference (surface);
+  /* begin_render() places the diagram relative to this */
+  renderer->cr = cairo_create (surface);
+  cairo_translate (renderer->cr, 0.0, -job->top);
+
+  /* only what touches the band, with a pixel to spare */
+  update.left = extents->left;
+  update.right = extents->right;
+  update.top = extents->top + (job->top - 2) / queue->scale;
+  update.bottom = extents->top + (job->top + job->height + 2) / queue->scale;
+
+  data_render (queue->data, DIA_RENDERER (renderer), &update, NULL, NULL);
+  g_clear_object (&renderer);
+
+  g_mutex_lock (&queue->lock);
+  job->surface = surface;
+  g_cond_broadcast (&queue->done);
+  g_mutex_unlock (&queue->lock);
+}
+
+
+static gboolean
+_export_png_bands (DiagramData      *data,
+                   DiaContext       *ctx,
+                   DiaCairoRenderer *renderer,
+                   int               width,
+                   int               height,
+                   const char       *filename)
+{
+  int n_threads = CLAMP (g_get_num_processors (), 1, 8);
+  int band_height = MAX (BAND_BYTES / (width * 4), 16);
+  int n_bands = (height + band_height - 1) / band_height;
+  GThreadPool *pool;
+  BandQueue queue;
+  PngWriter *writer;
+  int next, i;
+
+  writer = _png_writer_new (filename, width, height, renderer->with_alpha);
+  if (!writer) {
+    dia_context_add_message_with_errno (ctx, errno, _("Can't open output file %s."),
+                                        dia_context_get_filename (ctx));
+    return FALSE;
+  }
+
+  queue.data = data;
+  queue.scale = renderer->scale;
+  queue.with_alpha = renderer->with_alpha;
+  queue.width = width;
+  queue.jobs = g_new0 (BandJob, n_bands);
+  for (i = 0; i < n_bands; i++) {
+    queue.jobs[i].top = i * band_height;
+    queue.jobs[i].height = MIN (band_height, height - i * band_height);
+  }
+  g_mutex_init (&queue.lock);
+  g_cond_init (&queue.done);
+
+  /* racy on first use otherwise, and the workers get their own fonts */
+  render_bounding_boxes ();
+  dia_font_get_context ();
+
+  /* never more than two bands per thread around */
+  pool = g_thread_pool_new (_render_band, &queue, n_threads, FALSE, NULL);
+  for (next = 0; next < MIN (n_bands, 2 * n_threads); next++) {
+    g_thread_pool_push (pool, &queue.jobs[next], NULL);
+  }
+
+  for (i = 0; i < n_bands; i++) {
+    cairo_surface_t *surface;
+
+    g_mutex_lock (&queue.lock);
+    while (!queue.jobs[i].surface) {
+      g_cond_wait (&queue.done, &queue.lock);
+    }
+    surface = queue.jobs[i].surface;
+    g_mutex_unlock (&queue.lock);
+
+    _png_writer_add_rows (writer, surface);
+    cairo_surface_destroy (surface);
+
+    if (next < n_bands) {
+      g_thread_pool_push (pool, &queue.jobs[next++], NULL);
+    }
+  }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_cond_clear (&queue.done);
+  g_mutex_clear (&queue.lock);
+  g_free (queue.jobs);
+
+  if (!_png_writer_finish (writer)) {
+    dia_context_add_message_with_errno (ctx, errno, _("Can't write output file %s."),
+                                        dia_context_get_filename (ctx));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+
 /* dia export funtion */
 gboolean
 cairo_export_data (DiagramData *data,
@@ -85,6 +534,8 @@ cairo_export_data (DiagramData *data,
    * filename encdong is always utf-8, so another conversion is needed.
    */
   gchar *filename_crt = (gchar *) filename;
+  gboolean banded = FALSE;
+  gboolean ret = TRUE;
 #if DIA_CAIRO_CAN_EMF
   HDC hFileDC = NULL;
 #endif
@@ -142,6 +593,10 @@ cairo_export_data (DiagramData *data,
     width  = ceil((data->extents.right - data->extents.left) * renderer->scale) + 1;
     height = ceil((data->extents.bottom - data->extents.top) * renderer->scale) + 1;
     DIAG_NOTE(g_message ("PNG Surface %dx%d\n", (int)width, (int)height));
+    if (width * height * 4 > BAND_BYTES) {
+      banded = TRUE;
+      break;
+    }
     /* use case screwed by API shakeup. We need to special case */
     renderer->surface = cairo_image_surface_create(
 						CAIRO_FORMAT_ARGB32,
@@ -261,13 +716,20 @@ cairo_export_data (DiagramData *data,
   DIAG_NOTE(g_message("export_data extents %f,%f -> %f,%f",
             data->extents.left, data->extents.top, data->extents.right, data->extents.bottom));
 
-  if (OUTPUT_PDF == kind)
-    data_render_paginated(data, DIA_RENDERER(renderer), NULL);
-  else
+  if (OUTPUT_PDF == kind) {
+#ifdef CAIRO_HAS_PDF_SURFACE
+    if (!_render_pages_parallel (data, renderer, width, height))
+#endif
+      data_render_paginated(data, DIA_RENDERER(renderer), NULL);
+  } else if (banded) {
+    /* our own writer, takes the GLib filename */
+    ret = _export_png_bands (data, ctx, renderer, (int)width, (int)height, filename);
+  } else {
     data_render(data, DIA_RENDERER(renderer), NULL, NULL, NULL);
+  }
 
 #if defined CAIRO_HAS_PNG_FUNCTIONS
-  if (OUTPUT_PNGA == kind || OUTPUT_PNG == kind)
+  if ((OUTPUT_PNGA == kind || OUTPUT_PNG == kind) && !banded)
     {
       cairo_surface_write_to_png(renderer->surface, filename_crt);
       cairo_surface_destroy(renderer->surface);
@@ -321,7 +783,7 @@ cairo_export_data (DiagramData *data,
   g_clear_object (&renderer);
   if (filename != filename_crt)
     g_clear_pointer (&filename_crt, g_free);
-  return TRUE;
+  return ret;
 }
 
 G_GNUC_UNUSED /* keep implmentation for reference, see bug 599401 */
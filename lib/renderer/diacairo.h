@@ -70,6 +70,8 @@ struct _DiaCairoRenderer
   real scale;
   gboolean with_alpha; /*!< define to TRUE for transparent background */
   gboolean skip_show_page; /*!< when using for print avoid the internal show_page */
+  gboolean page_setup; /*!< position and clip like a PDF page, e.g. to record one */
+  gboolean on_worker; /*!< one of several threads drawing the same objects */
   gboolean stroke_pending; /*!< to delay call to cairo_stroke */
 
   /** caching the font description from set_font */
@@ -80,6 +82,15 @@ struct _DiaCairoRenderer
 
   /*! If set use for fill */
   DiaPattern *pattern;
+
+  /*! symbol key to recorded drawing, see dia_renderer_begin_symbol() */
+  GHashTable *symbols;
+  /*! the real target while a symbol is recorded */
+  cairo_t *symbol_parent;
+  /*! the symbol being recorded */
+  cairo_pattern_t *symbol;
+  char *symbol_key;
+  DiaMatrix symbol_matrix;
 };
 
 typedef enum OutputKind
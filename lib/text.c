@@ -474,6 +474,32 @@ text_destroy (Text *text)
 }
 
 
+/**
+ * text_get_memory_size:
+ * @text: the #Text
+ * @shared: (nullable): the shared data already counted
+ *
+ * The memory used by @text and its lines, fonts are only counted if not
+ * in @shared yet.
+ *
+ * Returns: the size in bytes
+ *
+ * Since: 0.98
+ */
+gsize
+text_get_memory_size (const Text *text, GHashTable *shared)
+{
+  gsize size = sizeof (Text) + text->numlines * sizeof (TextLine *);
+
+  size += dia_font_get_memory_size (text->font, shared);
+  for (int i = 0; i < text->numlines; i++) {
+    size += text_line_get_memory_size (text->lines[i], shared);
+  }
+
+  return size;
+}
+
+
 void
 text_set_height (Text *text, double height)
 {
@@ -1300,6 +1326,106 @@ data_text (AttributeNode text_attr, DiaContext *ctx)
 }
 
 
+
+/* queue the lines of a text composite, parsed like data_text() does */
+static void
+_data_text_prefetch_one (AttributeNode    text_attr,
+                         DiaFontPrefetch *prefetch,
+                         DiaContext      *ctx)
+{
+  char *string = NULL;
+  DiaFont *font;
+  double height = 1.0;
+  AttributeNode attr;
+
+  attr = composite_find_attribute (text_attr, "string");
+  if (attr != NULL) {
+    string = data_string (attribute_first_data (attr), ctx);
+  }
+  /* set_string() would convert it, don't bother */
+  if (!string || !g_utf8_validate (string, -1, NULL)) {
+    g_clear_pointer (&string, g_free);
+    return;
+  }
+
+  attr = composite_find_attribute (text_attr, "height");
+  if (attr != NULL) {
+    height = data_real (attribute_first_data (attr), ctx);
+  }
+
+  attr = composite_find_attribute (text_attr, "font");
+  if (attr != NULL) {
+    font = data_font (attribute_first_data (attr), ctx);
+  } else {
+    font = dia_font_new_from_style (DIA_FONT_SANS,1.0);
+  }
+
+  if (font) {
+    /* split like set_string() */
+    char **lines = g_strsplit (string, "\n", -1);
+
+    if (!lines[0]) {
+      dia_font_prefetch_add (prefetch, "", font, height);
+    }
+    for (int i = 0; lines[i] != NULL; ++i) {
+      dia_font_prefetch_add (prefetch, lines[i], font, height);
+    }
+    g_strfreev (lines);
+  }
+
+  g_clear_object (&font);
+  g_clear_pointer (&string, g_free);
+}
+
+
+static void
+_data_text_prefetch (xmlNodePtr node, DiaFontPrefetch *prefetch, DiaContext *ctx)
+{
+  for (xmlNodePtr child = node->xmlChildrenNode; child != NULL; child = child->next) {
+    xmlChar *type;
+
+    if (child->type != XML_ELEMENT_NODE) {
+      continue;
+    }
+
+    if (xmlStrcmp (child->name, (const xmlChar *) "composite") == 0 &&
+        (type = xmlGetProp (child, (const xmlChar *) "type")) != NULL) {
+      gboolean is_text = xmlStrcmp (type, (const xmlChar *) "text") == 0;
+
+      dia_clear_xml_string (&type);
+      if (is_text) {
+        _data_text_prefetch_one (child, prefetch, ctx);
+        continue;
+      }
+    }
+
+    _data_text_prefetch (child, prefetch, ctx);
+  }
+}
+
+
+/**
+ * data_text_prefetch:
+ * @node: the XML subtree to scan, e.g. a layer
+ * @prefetch: where to queue the text lines
+ *
+ * Find all text composites below @node and queue their lines for
+ * measuring, see dia_font_prefetch_new(). Problems are left to be
+ * reported by data_text().
+ *
+ * Since: 0.98
+ */
+void
+data_text_prefetch (xmlNodePtr node, DiaFontPrefetch *prefetch)
+{
+  DiaContext *ctx = dia_context_new (_("Text"));
+
+  _data_text_prefetch (node, prefetch, ctx);
+
+  /* just dropped, not shown */
+  g_clear_object (&ctx);
+}
+
 void
 text_get_attributes (Text *text, TextAttributes *attr)
 {
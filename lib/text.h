@@ -90,6 +90,8 @@ Text   *new_text_default      (Point         *pos,
                                DiaAlignment   align);
 void    text_destroy          (Text       *text);
 Text   *text_copy             (Text       *text);
+gsize   text_get_memory_size  (const Text *text,
+                               GHashTable *shared);
 char   *text_get_line         (const Text *text,
                                int         line);
 char   *text_get_string_copy  (const Text *text);
@@ -130,6 +132,7 @@ double text_get_descent(Text *text);
 gboolean text_delete_key_handler(Focus *focus, DiaObjectChange **change);
 void data_add_text(AttributeNode attr, Text *text, DiaContext *ctx);
 Text *data_text(AttributeNode attr, DiaContext *ctx);
+void data_text_prefetch (xmlNodePtr node, DiaFontPrefetch *prefetch);
 
 gboolean apply_textattr_properties(GPtrArray *props,
                                    Text *text, const gchar *textname,
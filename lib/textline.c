@@ -33,7 +33,6 @@
 
 static void text_line_dirty_cache(TextLine *text_line);
 static void text_line_cache_values(TextLine *text_line);
-static void clear_layout_offset (TextLine *text_line);
 
 /*!
  * \brief Sets this object to display a particular string.
@@ -128,11 +127,30 @@ text_line_destroy (TextLine *text_line)
 {
   g_clear_pointer (&text_line->chars, g_free);
   g_clear_object (&text_line->font);
-  clear_layout_offset (text_line);
-  g_clear_pointer (&text_line->offsets, g_free);
+  g_clear_pointer (&text_line->sizes, dia_font_sizes_unref);
   g_free (text_line);
 }
 
+/*!
+ * \brief The memory used by the line
+ * The font and the measurements are shared, they are only counted if not
+ * in @shared yet, see dia_object_get_memory_size()
+ * \memberof TextLine
+ */
+gsize
+text_line_get_memory_size (const TextLine *text_line, GHashTable *shared)
+{
+  gsize size = sizeof (TextLine);
+
+  if (text_line->chars) {
+    size += strlen (text_line->chars) + 1;
+  }
+  size += dia_font_get_memory_size (text_line->font, shared);
+  size += dia_font_sizes_get_memory_size (text_line->sizes, shared);
+
+  return size;
+}
+
 /*!
  * \brief TextLine bounding box caclulation
  *
@@ -240,23 +258,6 @@ text_line_dirty_cache(TextLine *text_line)
 }
 
 
-static void
-clear_layout_offset (TextLine *text_line)
-{
-  if (text_line->layout_offsets != NULL) {
-    GSList *runs = text_line->layout_offsets->runs;
-
-    for (; runs != NULL; runs = g_slist_next(runs)) {
-      PangoGlyphItem *run = (PangoGlyphItem *) runs->data;
-
-      g_clear_pointer (&run->glyphs->glyphs, g_free);
-      g_clear_pointer (&run->glyphs, g_free);
-    }
-    g_slist_free(runs);
-    g_clear_pointer (&text_line->layout_offsets, g_free);
-  }
-}
-
 static void
 text_line_cache_values(TextLine *text_line)
 {
@@ -264,30 +265,21 @@ text_line_cache_values(TextLine *text_line)
       text_line->chars != text_line->chars_cache ||
       text_line->font != text_line->font_cache ||
       text_line->height != text_line->height_cache) {
-    int n_offsets;
-
-    g_clear_pointer (&text_line->offsets, g_free);
-    clear_layout_offset (text_line);
-
-    if (text_line->chars == NULL ||
-	text_line->chars[0] == '\0') {
-      /* caclculate reasonable ascent/decent even for empty string */
-      text_line->offsets =
-        dia_font_get_sizes("XjgM149", text_line->font, text_line->height,
-			   &text_line->width, &text_line->ascent,
-			   &text_line->descent, &n_offsets,
-			   &text_line->layout_offsets);
-      clear_layout_offset (text_line);
-      g_clear_pointer (&text_line->offsets, g_free);
-      text_line->offsets = g_new (real,0); /* another way to assign NULL;) */
-      text_line->width = 0;
-    } else {
-      text_line->offsets =
-	dia_font_get_sizes(text_line->chars, text_line->font, text_line->height,
-			   &text_line->width, &text_line->ascent,
-			   &text_line->descent, &n_offsets,
-			   &text_line->layout_offsets);
-    }
+    DiaFontSizes *sizes;
+
+    /* reasonable ascent/decent even for the empty string, see there */
+    sizes = dia_font_sizes_lookup (text_line->chars,
+                                   text_line->font,
+                                   text_line->height);
+    g_clear_pointer (&text_line->sizes, dia_font_sizes_unref);
+    text_line->sizes = sizes;
+
+    text_line->width = sizes->width;
+    text_line->ascent = sizes->ascent;
+    text_line->descent = sizes->descent;
+    text_line->offsets = sizes->offsets;
+    text_line->layout_offsets = sizes->layout_offsets;
+
     text_line->clean = TRUE;
     text_line->chars_cache = text_line->chars;
     text_line->font_cache = text_line->font;
@@ -57,14 +57,17 @@ struct _TextLine {
   DiaFont *font_cache;
   double height_cache;
 
-  /** Offsets of the individual glyphs in the string.  */
+  /** Offsets of the individual glyphs in the string, owned by sizes */
   double *offsets;
   PangoLayoutLine *layout_offsets;
+  /* the shared measurements, see dia_font_sizes_lookup() */
+  DiaFontSizes *sizes;
 };
 
 TextLine *text_line_new(const gchar *string, DiaFont *font, real height);
 void text_line_destroy(TextLine *text);
 TextLine *text_line_copy(const TextLine *text);
+gsize text_line_get_memory_size(const TextLine *text, GHashTable *shared);
 void text_line_set_string(TextLine *text, const char *string);
 void text_line_set_height(TextLine *text, real height);
 void text_line_set_font(TextLine *text, DiaFont *font);
@@ -225,8 +225,8 @@ participation_draw (Participation *participation, DiaRenderer *renderer)
   dia_renderer_set_linecaps (renderer, DIA_LINE_CAPS_BUTT);
 
   if (participation->total) {
-    left_points = g_new0 (Point, n);
-    right_points = g_new0 (Point, n);
+    left_points = dia_renderer_scratch_new (renderer, Point, n);
+    right_points = dia_renderer_scratch_new (renderer, Point, n);
     for(i = 0; i < n - 1; i++) {
       if(orth->orientation[i] == HORIZONTAL) { /* HORIZONTAL */
         if (points[i].x < points[i+1].x) { /* RIGHT */
@@ -276,8 +276,6 @@ participation_draw (Participation *participation, DiaRenderer *renderer)
 
     dia_renderer_draw_polyline (renderer, left_points, n, &color_black);
     dia_renderer_draw_polyline (renderer, right_points, n, &color_black);
-    g_clear_pointer (&left_points, g_free);
-    g_clear_pointer (&right_points, g_free);
   } else {
     dia_renderer_draw_polyline (renderer, points, n, &color_black);
   }
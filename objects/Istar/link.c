@@ -460,7 +460,7 @@ link_draw (Link *link, DiaRenderer *renderer)
 {
   Point *endpoints, p1, p2, pa;
   Arrow arrow;
-  char *annot;
+  const char *annot;
   double w;
   BezPoint bpl[4];
 
@@ -484,25 +484,25 @@ link_draw (Link *link, DiaRenderer *renderer)
   switch (link->type) {
     case POS_CONTRIB:
       w=1.5*LINK_WIDTH;
-      annot = g_strdup("+");
+      annot = "+";
       break;
     case NEG_CONTRIB:
       w=1.5*LINK_WIDTH;
-      annot = g_strdup("-");
+      annot = "-";
       break;
     case DEPENDENCY:
-      annot = g_strdup("");
+      annot = "";
       break;
     case DECOMPOSITION:
       arrow.type = ARROW_CROSS;
-      annot = g_strdup("");
+      annot = "";
       break;
     case MEANS_ENDS:
       arrow.type = ARROW_LINES;
-      annot = g_strdup("");
+      annot = "";
       break;
     case UNSPECIFIED: /* use above defaults */
-      annot = g_strdup("");
+      annot = "";
       break;
     default:
       g_return_if_reached ();
@@ -529,7 +529,6 @@ link_draw (Link *link, DiaRenderer *renderer)
                               DIA_ALIGN_CENTRE,
                               &color_black);
   }
-  g_clear_pointer (&annot, g_free);
 
   /** special stuff for dependency **/
   if (link->type == DEPENDENCY) {
@@ -25,12 +25,6 @@
 
 #include <time.h>
 #include <glib.h>
-#ifdef HAVE_UNISTD_H
-#include <unistd.h> /* close */
-#endif
-#ifdef G_OS_WIN32
-#include <io.h> /* close */
-#endif
 #include <glib/gstdio.h>
 
 #include "object.h"
@@ -40,11 +34,9 @@
 #include "boundingbox.h"
 #include "element.h"
 #include "diagramdata.h"
+#include "dia-layer.h"
 #include "filter.h"
 
-#include "filter.h"
-#include "dia_image.h"
-
 #include "pixmaps/diagram_as_element.xpm"
 
 #define DEFAULT_WIDTH 2.0
@@ -63,10 +55,7 @@ typedef struct _DiagramAsElement {
 
   char *filename;
   time_t mtime;
-  DiagramData *data;
-
-  /* for indirect rendering*/
-  DiaImage *image;
+  DiagramData *data; /* shared with every other embed of the file */
 
   real scale;
 } DiagramAsElement;
@@ -181,8 +170,12 @@ static void
 _dae_draw (DiagramAsElement *dae, DiaRenderer *renderer)
 {
   Element *elem = &dae->element;
+  /* per thread, pages may be drawn in parallel */
+  static GPrivate drawing_key;
+  int drawing = GPOINTER_TO_INT (g_private_get (&drawing_key));
 
-  if (!dae->data) {
+  /* a diagram may contain itself */
+  if (!dae->data || drawing > 2) {
     /* just draw the box */
     Point lower_right = {
       elem->corner.x + elem->width,
@@ -196,52 +189,99 @@ _dae_draw (DiagramAsElement *dae, DiaRenderer *renderer)
                             &dae->border_color);
 
   } else {
-    if (FALSE) {
-      /* if the renderer supports transformations ... */
-      /* temporary messing with it (not enough) */
-      dae->data->paper.scaling *= dae->scale;
-      data_render (dae->data, DIA_RENDERER (renderer), NULL, NULL, NULL);
-      dae->data->paper.scaling /= dae->scale;
-    } else {
-      /* we have to render to an image and draw that */
-      if (!dae->image) { /* lazy creation */
-        char *imgfname = NULL;
-        int fd = g_file_open_tmp ("diagram-as-elementXXXXXX.png", &imgfname, NULL);
-        if (fd != -1) {
-          DiaExportFilter *ef = filter_export_get_by_name ("cairo-alpha-png");
-          if (!ef) { /* prefer cairo with alpha, but don't require it */
-            ef = filter_guess_export_filter (imgfname);
-          }
-          close(fd);
-          if (ef) {
-            DiaContext *ctx = dia_context_new ("Diagram as Object");
-
-            dia_context_set_filename (ctx, imgfname);
-            if (ef->export_func (dae->data, ctx, imgfname, dae->filename, ef->user_data)) {
-              DiaImage *tmp_image = dia_image_load (imgfname);
-
-              /* some extra gymnastics to create an image w/o filename */
-              if (tmp_image) {
-                dae->image = dia_image_new_from_pixbuf ((GdkPixbuf *) dia_image_pixbuf (tmp_image));
-                g_clear_object (&tmp_image);
-              }
-              /* FIXME: where to put the message in case of an error? */
-              dia_context_release (ctx);
-            }
-          } /* found a filter */
-          g_unlink (imgfname);
-          g_clear_pointer (&imgfname, g_free);
-        } /* temporary file created*/
-      } /* only if we have no image yet */
-      if (dae->image) {
-        dia_renderer_draw_image (renderer,
-                                 &elem->corner,
-                                 elem->width,
-                                 elem->height,
-                                 dae->image);
+    /* the embedded objects scaled into the element, renderers capable of
+     * transformations do it themselves, others get a DiaTransformRenderer */
+    DiaMatrix m = {
+      dae->scale, 0.0, 0.0, dae->scale,
+      elem->corner.x - dae->data->extents.left * dae->scale,
+      elem->corner.y - dae->data->extents.top * dae->scale
+    };
+
+    g_private_set (&drawing_key, GINT_TO_POINTER (drawing + 1));
+    DIA_FOR_LAYER_IN_DIAGRAM (dae->data, layer, i, {
+      GList *list;
+
+      if (!dia_layer_is_visible (layer)) {
+        continue;
       }
-    }
+
+      for (list = dia_layer_get_object_list (layer); list != NULL; list = g_list_next (list)) {
+        dia_renderer_draw_object (renderer, list->data, &m);
+      }
+    });
+    g_private_set (&drawing_key, GINT_TO_POINTER (drawing));
+  }
+}
+
+
+/*
+ * Embedded diagrams are only read, so every embed of the same file shares
+ * the DiagramData as long as the file doesn't change. The cache doesn't
+ * keep them alive, they go with the last embed referencing them.
+ */
+typedef struct _DaeCacheEntry {
+  DiagramData *data;
+  time_t       mtime;
+} DaeCacheEntry;
+
+static GHashTable *_dae_cache = NULL;
+
+static void
+_dae_cache_forget (gpointer user_data, GObject *where_the_object_was)
+{
+  char *filename = user_data;
+  DaeCacheEntry *entry = g_hash_table_lookup (_dae_cache, filename);
+
+  /* it may already be replaced by a newer version of the file */
+  if (entry && entry->data == (DiagramData *) where_the_object_was) {
+    g_hash_table_remove (_dae_cache, filename);
+  }
+  g_clear_pointer (&filename, g_free);
+}
+
+/* Returns: (transfer full): the diagram in filename, %NULL if it can't be read */
+static DiagramData *
+_dae_cache_get (const char *filename, time_t mtime)
+{
+  DaeCacheEntry *entry;
+  DiaImportFilter *inf;
+  DiagramData *data;
+  DiaContext *ctx;
+
+  if (!_dae_cache) {
+    _dae_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  }
+
+  entry = g_hash_table_lookup (_dae_cache, filename);
+  if (entry && entry->mtime == mtime) {
+    return g_object_ref (entry->data);
+  }
+
+  inf = filter_guess_import_filter (filename);
+  if (!inf) {
+    return NULL;
+  }
+
+  data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  ctx = dia_context_new (diagram_as_element_type.name);
+  dia_context_set_filename (ctx, filename);
+  if (!inf->import_func (filename, data, ctx, inf->user_data)) {
+    /* FIXME: where to put the message in case of an error? */
+    g_clear_object (&data);
+  }
+  dia_context_release (ctx);
+
+  if (data) {
+    data_update_extents (data); /* should already be called by importer? */
+
+    entry = g_new0 (DaeCacheEntry, 1);
+    entry->data = data;
+    entry->mtime = mtime;
+    g_hash_table_insert (_dae_cache, g_strdup (filename), entry);
+    g_object_weak_ref (G_OBJECT (data), _dae_cache_forget, g_strdup (filename));
   }
+
+  return data;
 }
 
 
@@ -260,30 +300,16 @@ _dae_update_data (DiagramAsElement *dae)
   if (   strlen (dae->filename)
       && g_stat (dae->filename, &statbuf) == 0
       && dae->mtime != statbuf.st_mtime) {
-    DiaImportFilter *inf;
-
     g_clear_object (&dae->data);
-    dae->data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
-
-    inf = filter_guess_import_filter(dae->filename);
-    if (inf) {
-      DiaContext *ctx = dia_context_new (diagram_as_element_type.name);
-
-      dia_context_set_filename (ctx, dae->filename);
-      if (inf->import_func(dae->filename, dae->data, ctx, inf->user_data)) {
-        data_update_extents (dae->data); /* should already be called by importer? */
-        dae->scale = dae->element.width / (dae->data->extents.right - dae->data->extents.left);
-        dae->element.height = (dae->data->extents.bottom - dae->data->extents.top) * dae->scale;
-        dae->mtime = statbuf.st_mtime;
-      }
-      /* FIXME: where to put the message in case of an error? */
-      dia_context_release (ctx);
+    dae->data = _dae_cache_get (dae->filename, statbuf.st_mtime);
+    if (dae->data) {
+      dae->scale = dae->element.width / (dae->data->extents.right - dae->data->extents.left);
+      dae->element.height = (dae->data->extents.bottom - dae->data->extents.top) * dae->scale;
+      dae->mtime = statbuf.st_mtime;
     }
-    /* invalidate possibly cached image */
-    g_clear_object (&dae->image);
   }
   /* fixme - fit the scale to draw the diagram in elements size ?*/
-  if (dae->scale)
+  if (dae->scale && dae->data)
     dae->scale = dae->element.width / (dae->data->extents.right - dae->data->extents.left);
 
   elem->extra_spacing.border_trans = dae->border_line_width/2.0;
@@ -305,8 +331,6 @@ _dae_destroy(DiagramAsElement *dae)
 
   g_clear_pointer (&dae->filename, g_free);
 
-  g_clear_object (&dae->image);
-
   element_destroy(&dae->element);
 }
 
@@ -500,13 +500,16 @@ association_draw (Association *assoc, DiaRenderer *renderer)
     pos = end->text_pos;
 
     if (end->role != NULL && *end->role) {
-      char *role_name = g_strdup_printf ("%c%s", visible_char[(int) end->visibility], end->role);
+      gsize len = strlen (end->role);
+      char *role_name = dia_renderer_scratch_new (renderer, char, len + 2);
+
+      role_name[0] = visible_char[(int) end->visibility];
+      memcpy (role_name + 1, end->role, len + 1);
       dia_renderer_draw_string (renderer,
                                 role_name,
                                 &pos,
                                 end->text_align,
                                 &assoc->text_color);
-      g_clear_pointer (&role_name, g_free);
       pos.y += assoc->font_height;
     }
     if (end->multiplicity != NULL) {
@@ -63,6 +63,7 @@ static DiaObject *umlclass_create(Point *startpoint,
 			       Handle **handle1,
 			       Handle **handle2);
 static void umlclass_destroy(UMLClass *umlclass);
+static gsize umlclass_get_memory_size(UMLClass *umlclass, GHashTable *shared);
 static DiaObject *umlclass_copy(UMLClass *umlclass);
 
 static void umlclass_save(UMLClass *umlclass, ObjectNode obj_node,
@@ -138,6 +139,8 @@ static ObjectOps umlclass_ops = {
   (SetPropsFunc)        umlclass_set_props,
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
+  (TransformFunc)       NULL,
+  (GetMemorySizeFunc)   umlclass_get_memory_size,
 };
 
 extern PropDescDArrayExtra umlattribute_extra;
@@ -589,6 +592,99 @@ umlclass_move (UMLClass *umlclass, Point *to)
 }
 
 
+/*
+ * Measuring text is what makes recalculating big classes slow, so the
+ * metrics are kept by font and string. When anything in the class changes
+ * only the strings of changed members are measured again, the others are
+ * found here. Pages may be drawn in parallel, hence the lock.
+ */
+G_LOCK_DEFINE_STATIC (text_metrics);
+
+typedef struct _UMLTextMetrics {
+  real  width;
+  real  ascent; /* < 0.0 until asked for */
+  guint generation;
+} UMLTextMetrics;
+
+/* called with text_metrics held */
+static UMLTextMetrics *
+umlclass_get_text_metrics (UMLClass   *umlclass,
+                           const char *string,
+                           DiaFont    *font,
+                           real        font_height)
+{
+  UMLTextMetrics *metrics;
+  char *key;
+
+  if (!umlclass->text_metrics) {
+    umlclass->text_metrics = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, g_free);
+  }
+
+  /* not the font pointer, it may be reused for another font */
+  key = g_strdup_printf ("%s\n%d\n%g\n%s",
+                         dia_font_get_family (font),
+                         dia_font_get_style (font),
+                         font_height,
+                         string);
+  metrics = g_hash_table_lookup (umlclass->text_metrics, key);
+  if (!metrics) {
+    metrics = g_new (UMLTextMetrics, 1);
+    metrics->width = dia_font_string_width (string, font, font_height);
+    metrics->ascent = -1.0;
+    g_hash_table_insert (umlclass->text_metrics, key, metrics);
+  } else {
+    g_clear_pointer (&key, g_free);
+  }
+  metrics->generation = umlclass->text_metrics_generation;
+
+  return metrics;
+}
+
+static real
+umlclass_text_width (UMLClass   *umlclass,
+                     const char *string,
+                     DiaFont    *font,
+                     real        font_height)
+{
+  real width;
+
+  G_LOCK (text_metrics);
+  width = umlclass_get_text_metrics (umlclass, string, font, font_height)->width;
+  G_UNLOCK (text_metrics);
+
+  return width;
+}
+
+static real
+umlclass_text_ascent (UMLClass   *umlclass,
+                      const char *string,
+                      DiaFont    *font,
+                      real        font_height)
+{
+  UMLTextMetrics *metrics;
+  real ascent;
+
+  G_LOCK (text_metrics);
+  metrics = umlclass_get_text_metrics (umlclass, string, font, font_height);
+  if (metrics->ascent < 0.0) {
+    metrics->ascent = dia_font_ascent (string, font, font_height);
+  }
+  ascent = metrics->ascent;
+  G_UNLOCK (text_metrics);
+
+  return ascent;
+}
+
+static gboolean
+umlclass_text_metrics_unused (gpointer key, gpointer value, gpointer user_data)
+{
+  UMLTextMetrics *metrics = value;
+
+  return metrics->generation != GPOINTER_TO_UINT (user_data);
+}
+
+
 /**
  * underlines the text at the start point using the text to determine
  * the length of the underline. Draw a line under the text represented by
@@ -857,9 +953,9 @@ umlclass_draw_namebox (UMLClass    *umlclass,
   /* stereotype: */
   if (umlclass->stereotype != NULL && umlclass->stereotype[0] != '\0') {
     char *string = umlclass->stereotype_string;
-    ascent = dia_font_ascent (string,
-                              umlclass->normal_font,
-                              umlclass->font_height);
+    ascent = umlclass_text_ascent (umlclass, string,
+                                   umlclass->normal_font,
+                                   umlclass->font_height);
     StartPoint.y += ascent;
     dia_renderer_set_font (renderer,
                            umlclass->normal_font,
@@ -881,7 +977,7 @@ umlclass_draw_namebox (UMLClass    *umlclass,
       font = umlclass->classname_font;
       font_height = umlclass->classname_font_height;
     }
-    ascent = dia_font_ascent (umlclass->name, font, font_height);
+    ascent = umlclass_text_ascent (umlclass, umlclass->name, font, font_height);
     StartPoint.y += ascent;
 
     dia_renderer_set_font (renderer, font, font_height);
@@ -970,7 +1066,7 @@ umlclass_draw_attributebox (UMLClass    *umlclass,
         font = umlclass->normal_font;
         font_height = umlclass->font_height;
       }
-      ascent = dia_font_ascent (attstr, font, font_height);
+      ascent = umlclass_text_ascent (umlclass, attstr, font, font_height);
       StartPoint.y += ascent;
       dia_renderer_set_font (renderer, font, font_height);
       dia_renderer_draw_string (renderer,
@@ -1061,7 +1157,6 @@ umlclass_draw_operationbox (UMLClass    *umlclass,
     GList *wrapsublist = NULL;
     gchar *part_opstr = NULL;
     int wrap_pos, last_wrap_pos, ident;
-    int part_opstr_len = 0, part_opstr_need = 0;
 
     StartPoint.x += (umlclass->line_width/2.0 + 0.1);
     StartPoint.y += 0.1;
@@ -1087,7 +1182,7 @@ umlclass_draw_operationbox (UMLClass    *umlclass,
           font_height = umlclass->font_height;
       }
 
-      ascent = dia_font_ascent (opstr, font, font_height);
+      ascent = umlclass_text_ascent (umlclass, opstr, font, font_height);
       op->ascent = ascent;
       dia_renderer_set_font (renderer, font, font_height);
 
@@ -1095,32 +1190,19 @@ umlclass_draw_operationbox (UMLClass    *umlclass,
         ident = op->wrap_indent;
         wrapsublist = op->wrappos;
         last_wrap_pos = 0;
+        /* every wrapped line fits, indent included */
+        part_opstr = dia_renderer_scratch_new (renderer, char, ident + strlen (opstr) + 1);
 
         while( wrapsublist != NULL) {
           wrap_pos = GPOINTER_TO_INT (wrapsublist->data);
 
           if (last_wrap_pos == 0) {
-            part_opstr_need = wrap_pos + 1;
-            if (part_opstr_len < part_opstr_need) {
-              part_opstr_len = part_opstr_need;
-              part_opstr = g_renew (char, part_opstr, part_opstr_need);
-            } else {
-              /* ensure to never strncpy to NULL and not shrink */
-              part_opstr = g_renew (char,
-                                    part_opstr,
-                                    MAX (part_opstr_need, part_opstr_len));
-            }
             strncpy (part_opstr, opstr, wrap_pos);
-            memset (part_opstr+wrap_pos, '\0', 1);
-          } else   {
-            part_opstr_need = ident + wrap_pos - last_wrap_pos + 1;
-            if (part_opstr_len < part_opstr_need) {
-              part_opstr_len = part_opstr_need;
-              part_opstr = g_renew (char, part_opstr, part_opstr_need);
-            }
+            part_opstr[wrap_pos] = '\0';
+          } else {
             memset (part_opstr, ' ', ident);
-            memset (part_opstr+ident, '\0', 1);
-            strncat (part_opstr, opstr+last_wrap_pos, wrap_pos-last_wrap_pos);
+            part_opstr[ident] = '\0';
+            strncat (part_opstr, opstr + last_wrap_pos, wrap_pos - last_wrap_pos);
           }
 
           if( last_wrap_pos == 0 ) {
@@ -1185,7 +1267,6 @@ umlclass_draw_operationbox (UMLClass    *umlclass,
       i++;
       g_clear_pointer (&opstr, g_free);
     }
-    g_clear_pointer (&part_opstr, g_free);
   }
   return Yoffset;
 }
@@ -1242,7 +1323,7 @@ umlclass_draw_template_parameters_box (UMLClass    *umlclass,
   while (list != NULL) {
     char *paramstr = uml_formal_parameter_get_string ((UMLFormalParameter *) list->data);
 
-    ascent = dia_font_ascent (paramstr, font, font_height);
+    ascent = umlclass_text_ascent (umlclass, paramstr, font, font_height);
     TextInsert.y += ascent;
     dia_renderer_draw_string (renderer,
                               paramstr,
@@ -1471,13 +1552,13 @@ umlclass_calculate_name_data(UMLClass *umlclass)
 
   if (umlclass->name != NULL && umlclass->name[0] != '\0') {
     if (umlclass->abstract) {
-      maxwidth = dia_font_string_width(umlclass->name,
-                                       umlclass->abstract_classname_font,
-                                       umlclass->abstract_classname_font_height);
+      maxwidth = umlclass_text_width (umlclass, umlclass->name,
+                                      umlclass->abstract_classname_font,
+                                      umlclass->abstract_classname_font_height);
     } else {
-      maxwidth = dia_font_string_width(umlclass->name,
-                                       umlclass->classname_font,
-                                       umlclass->classname_font_height);
+      maxwidth = umlclass_text_width (umlclass, umlclass->name,
+                                      umlclass->classname_font,
+                                      umlclass->classname_font_height);
     }
   }
 
@@ -1491,9 +1572,9 @@ umlclass_calculate_name_data(UMLClass *umlclass)
 			                                    UML_STEREOTYPE_END,
 			                                    NULL);
 
-    width = dia_font_string_width (umlclass->stereotype_string,
-                                   umlclass->normal_font,
-                                   umlclass->font_height);
+    width = umlclass_text_width (umlclass, umlclass->stereotype_string,
+                                 umlclass->normal_font,
+                                 umlclass->font_height);
     maxwidth = MAX(width, maxwidth);
   } else {
     umlclass->stereotype_string = NULL;
@@ -1506,9 +1587,9 @@ umlclass_calculate_name_data(UMLClass *umlclass)
                                                          umlclass->comment_tagging,
                                                          umlclass->comment_line_length,
                                                          &NumberOfLines);
-    width = dia_font_string_width (CommentString,
-                                   umlclass->comment_font,
-                                   umlclass->comment_font_height);
+    width = umlclass_text_width (umlclass, CommentString,
+                                 umlclass->comment_font,
+                                 umlclass->comment_font_height);
 
     g_clear_pointer (&CommentString, g_free);
     umlclass->namebox_height += umlclass->comment_font_height * NumberOfLines;
@@ -1545,16 +1626,16 @@ umlclass_calculate_attribute_data(UMLClass *umlclass)
 
       if (attr->abstract)
       {
-        width = dia_font_string_width(attstr,
-                                      umlclass->abstract_font,
-                                      umlclass->abstract_font_height);
+        width = umlclass_text_width (umlclass, attstr,
+                                     umlclass->abstract_font,
+                                     umlclass->abstract_font_height);
         umlclass->attributesbox_height += umlclass->abstract_font_height;
       }
       else
       {
-        width = dia_font_string_width(attstr,
-                                      umlclass->normal_font,
-                                      umlclass->font_height);
+        width = umlclass_text_width (umlclass, attstr,
+                                     umlclass->normal_font,
+                                     umlclass->font_height);
         umlclass->attributesbox_height += umlclass->font_height;
       }
       maxwidth = MAX(width, maxwidth);
@@ -1566,9 +1647,9 @@ umlclass_calculate_attribute_data(UMLClass *umlclass)
                                                             umlclass->comment_tagging,
                                                             umlclass->comment_line_length,
                                                             &NumberOfLines);
-        width = dia_font_string_width(CommentString,
-                                       umlclass->comment_font,
-                                       umlclass->comment_font_height);
+        width = umlclass_text_width (umlclass, CommentString,
+                                     umlclass->comment_font,
+                                     umlclass->comment_font_height);
         g_clear_pointer (&CommentString, g_free);
         umlclass->attributesbox_height += umlclass->comment_font_height * NumberOfLines + umlclass->comment_font_height/2;
         maxwidth = MAX(width, maxwidth);
@@ -1647,7 +1728,7 @@ umlclass_calculate_operation_data(UMLClass *umlclass)
 	    Font       = umlclass->normal_font;
 	    FontHeight = umlclass->font_height;
       }
-      op->ascent = dia_font_ascent(opstr, Font, FontHeight);
+      op->ascent = umlclass_text_ascent (umlclass, opstr, Font, FontHeight);
 
       if( umlclass->wrap_operations )
       {
@@ -1703,7 +1784,7 @@ umlclass_calculate_operation_data(UMLClass *umlclass)
               strncat( part_opstr, opstr+last_wrap_pos, wrap_pos-last_wrap_pos);
             }
 
-            width = dia_font_string_width(part_opstr,Font,FontHeight);
+            width = umlclass_text_width (umlclass, part_opstr,Font,FontHeight);
             umlclass->operationsbox_height += FontHeight;
 
             maxwidth = MAX(width, maxwidth);
@@ -1733,7 +1814,7 @@ umlclass_calculate_operation_data(UMLClass *umlclass)
           Font       = umlclass->normal_font;
           FontHeight = umlclass->font_height;
         }
-        width = dia_font_string_width(opstr,Font,FontHeight);
+        width = umlclass_text_width (umlclass, opstr,Font,FontHeight);
         umlclass->operationsbox_height += FontHeight;
 
         maxwidth = MAX(width, maxwidth);
@@ -1745,9 +1826,9 @@ umlclass_calculate_operation_data(UMLClass *umlclass)
                                                             umlclass->comment_tagging,
                                                             umlclass->comment_line_length,
                                                             &NumberOfLines);
-        width = dia_font_string_width(CommentString,
-                                       umlclass->comment_font,
-                                       umlclass->comment_font_height);
+        width = umlclass_text_width (umlclass, CommentString,
+                                     umlclass->comment_font,
+                                     umlclass->comment_font_height);
         g_clear_pointer (&CommentString, g_free);
         umlclass->operationsbox_height += umlclass->comment_font_height * NumberOfLines + umlclass->comment_font_height/2;
         maxwidth = MAX(width, maxwidth);
@@ -1798,6 +1879,9 @@ umlclass_calculate_data(UMLClass *umlclass)
 
   if (!umlclass->destroyed)
   {
+    /* what isn't asked for in this round belongs to changed members */
+    umlclass->text_metrics_generation++;
+
     maxwidth = MAX(umlclass_calculate_name_data(umlclass),      maxwidth);
 
     umlclass->element.height = umlclass->namebox_height;
@@ -1834,9 +1918,9 @@ umlclass_calculate_data(UMLClass *umlclass)
         UMLFormalParameter *param = (UMLFormalParameter *) list->data;
         gchar *paramstr = uml_formal_parameter_get_string (param);
 
-        width = dia_font_string_width(paramstr,
-                                      umlclass->normal_font,
-                                      umlclass->font_height);
+        width = umlclass_text_width (umlclass, paramstr,
+                                     umlclass->normal_font,
+                                     umlclass->font_height);
         maxwidth = MAX(width, maxwidth);
 
         i++;
@@ -1845,6 +1929,14 @@ umlclass_calculate_data(UMLClass *umlclass)
       }
     }
     umlclass->templates_width = maxwidth + 2*0.2;
+
+    G_LOCK (text_metrics);
+    if (umlclass->text_metrics) {
+      g_hash_table_foreach_remove (umlclass->text_metrics,
+                                   umlclass_text_metrics_unused,
+                                   GUINT_TO_POINTER (umlclass->text_metrics_generation));
+    }
+    G_UNLOCK (text_metrics);
   }
 }
 
@@ -2049,12 +2141,83 @@ umlclass_destroy(UMLClass *umlclass)
   umlclass->formal_params = NULL;
 
   g_clear_pointer (&umlclass->stereotype_string, g_free);
+  g_clear_pointer (&umlclass->text_metrics, g_hash_table_destroy);
 
   if (umlclass->properties_dialog != NULL) {
     umlclass_dialog_free (umlclass->properties_dialog);
   }
 }
 
+
+static gsize
+_string_size (const char *string)
+{
+  return string ? strlen (string) + 1 : 0;
+}
+
+static gsize
+umlclass_get_memory_size (UMLClass *umlclass, GHashTable *shared)
+{
+  gsize size = object_get_memory_size (&umlclass->element.object, sizeof (UMLClass));
+  GList *list;
+
+  size += dia_font_get_memory_size (umlclass->normal_font, shared);
+  size += dia_font_get_memory_size (umlclass->abstract_font, shared);
+  size += dia_font_get_memory_size (umlclass->polymorphic_font, shared);
+  size += dia_font_get_memory_size (umlclass->classname_font, shared);
+  size += dia_font_get_memory_size (umlclass->abstract_classname_font, shared);
+  size += dia_font_get_memory_size (umlclass->comment_font, shared);
+
+  size += _string_size (umlclass->name);
+  size += _string_size (umlclass->stereotype);
+  size += _string_size (umlclass->comment);
+  size += _string_size (umlclass->stereotype_string);
+
+  for (list = umlclass->attributes; list != NULL; list = g_list_next (list)) {
+    UMLAttribute *attr = list->data;
+
+    size += sizeof (GList) + sizeof (UMLAttribute) + 2 * sizeof (ConnectionPoint);
+    size += _string_size (attr->name) + _string_size (attr->type)
+            + _string_size (attr->value) + _string_size (attr->comment);
+  }
+  for (list = umlclass->operations; list != NULL; list = g_list_next (list)) {
+    UMLOperation *op = list->data;
+    GList *params;
+
+    size += sizeof (GList) + sizeof (UMLOperation) + 2 * sizeof (ConnectionPoint);
+    size += _string_size (op->name) + _string_size (op->type)
+            + _string_size (op->comment) + _string_size (op->stereotype);
+    size += g_list_length (op->wrappos) * sizeof (GList);
+    for (params = op->parameters; params != NULL; params = g_list_next (params)) {
+      UMLParameter *param = params->data;
+
+      size += sizeof (GList) + sizeof (UMLParameter);
+      size += _string_size (param->name) + _string_size (param->type)
+              + _string_size (param->value) + _string_size (param->comment);
+    }
+  }
+  for (list = umlclass->formal_params; list != NULL; list = g_list_next (list)) {
+    UMLFormalParameter *param = list->data;
+
+    size += sizeof (GList) + sizeof (UMLFormalParameter);
+    size += _string_size (param->name) + _string_size (param->type);
+  }
+
+  G_LOCK (text_metrics);
+  if (umlclass->text_metrics) {
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init (&iter, umlclass->text_metrics);
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+      size += strlen (key) + 1 + sizeof (UMLTextMetrics);
+    }
+  }
+  G_UNLOCK (text_metrics);
+
+  return size;
+}
+
 static DiaObject *
 umlclass_copy(UMLClass *umlclass)
 {
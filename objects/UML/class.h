@@ -135,6 +135,10 @@ struct _UMLClass {
   real templates_height;
   real templates_width;
 
+  /*! widths and ascents of the member strings, by font and string */
+  GHashTable *text_metrics;
+  guint text_metrics_generation;
+
   /* Dialog: */
   UMLClassDialog *properties_dialog;
 
@@ -335,7 +335,6 @@ compfeat_draw (Compfeat *compfeat, DiaRenderer *renderer)
   Point *points;
   OrthConn *orth = &compfeat->orth;
   int n;
-  char directions;
   Arrow startarrow, endarrow;
 
   g_return_if_fail (compfeat != NULL);
@@ -348,16 +347,6 @@ compfeat_draw (Compfeat *compfeat, DiaRenderer *renderer)
   dia_renderer_set_linestyle (renderer, DIA_LINE_STYLE_SOLID, 0.0);
   dia_renderer_set_linecaps (renderer, DIA_LINE_CAPS_BUTT);
 
-  if (compfeat->orth.orientation[orth->numorient - 1] == HORIZONTAL) {
-    directions = (points[n - 1].x > points[n - 2].x)? DIR_EAST: DIR_WEST;
-  } else {
-    directions = (points[n - 1].y > points[n - 2].y)? DIR_SOUTH: DIR_NORTH;
-  }
-
-  if (compfeat->role == COMPPROP_FACET
-      || compfeat->role == COMPPROP_EVENTSOURCE)
-    compfeat->cp.directions = directions;
-
   startarrow.type = ARROW_NONE;
   startarrow.length = COMPPROP_DIAMETER;
   startarrow.width = COMPPROP_DIAMETER;
@@ -463,8 +452,15 @@ compfeat_update_data(Compfeat *compfeat)
   obj->position = points[0];
 
   if (compfeat->role == COMPPROP_FACET
-      || compfeat->role == COMPPROP_EVENTSOURCE)
+      || compfeat->role == COMPPROP_EVENTSOURCE) {
     compfeat->cp.pos = points[n - 1];
+    /* not while drawing, pages may be drawn in parallel */
+    if (orth->orientation[orth->numorient - 1] == HORIZONTAL) {
+      compfeat->cp.directions = (points[n - 1].x > points[n - 2].x) ? DIR_EAST : DIR_WEST;
+    } else {
+      compfeat->cp.directions = (points[n - 1].y > points[n - 2].y) ? DIR_SOUTH : DIR_NORTH;
+    }
+  }
 
   compfeat->text_pos = compfeat->text_handle.pos = compfeat->text->position;
 
@@ -58,6 +58,24 @@ typedef enum {
 
 typedef struct _Custom Custom;
 
+/*!
+ * \brief The display list transformed for one placement
+ *
+ * Indexed with the offsets assigned by compiling the ShapeInfo. Only
+ * recalculated when the placement used for it changes.
+ */
+typedef struct _CustomGeometry {
+  gboolean valid;
+  double xscale, yscale;
+  double xoffs, yoffs;
+  double subscale;
+  gboolean flip_h, flip_v;
+  /*! transformed ShapeInfo::points */
+  Point *points;
+  /*! transformed ShapeInfo::bezpoints */
+  BezPoint *bezpoints;
+} CustomGeometry;
+
 /*!
  * \brief Custom shape representation as DiaObject
  *
@@ -109,6 +127,9 @@ struct _Custom {
   double padding;
 
   DiaTextFitting text_fitting;
+
+  /*! cached geometry for drawing and hit-testing */
+  CustomGeometry geometry;
 };
 
 
@@ -130,8 +151,6 @@ static void             custom_draw                (Custom           *custom,
 static void             custom_draw_displaylist    (GList            *display_list,
                                                     Custom           *custom,
                                                     DiaRenderer      *renderer,
-                                                    GArray           *arr,
-                                                    GArray           *barr,
                                                     double           *cur_line,
                                                     double           *cur_dash,
                                                     DiaLineCaps      *cur_caps,
@@ -140,8 +159,6 @@ static void             custom_draw_displaylist    (GList            *display_li
 static void             custom_draw_element        (GraphicElement   *el,
                                                     Custom           *custom,
                                                     DiaRenderer      *renderer,
-                                                    GArray           *arr,
-                                                    GArray           *barr,
                                                     double           *cur_line,
                                                     double           *cur_dash,
                                                     DiaLineCaps      *cur_caps,
@@ -157,6 +174,7 @@ static DiaObject *custom_create(Point *startpoint,
 				Handle **handle2);
 static void custom_destroy(Custom *custom);
 static DiaObject *custom_copy(Custom *custom);
+static gsize custom_get_memory_size(Custom *custom, GHashTable *shared);
 static DiaMenu *custom_get_object_menu(Custom *custom, Point *clickedpoint);
 
 static PropDescription *custom_describe_props(Custom *custom);
@@ -202,6 +220,8 @@ static ObjectOps custom_ops = {
   (SetPropsFunc)        custom_set_props,
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
+  (TransformFunc)       NULL,
+  (GetMemorySizeFunc)   custom_get_memory_size,
 };
 
 static PropDescription custom_props[] = {
@@ -570,22 +590,148 @@ transform_rect(Custom *custom, const DiaRectangle *r1, DiaRectangle *out)
 }
 
 
+/*
+ * The area covered by an image, @origin being its transformed top left
+ * corner. When flipped that corner becomes the right resp. bottom edge.
+ */
+static void
+custom_image_rect (Custom                    *custom,
+                   const GraphicElementImage *image,
+                   const Point               *origin,
+                   DiaRectangle              *out)
+{
+  real width, height;
+
+  transform_size (custom, image->width, image->height, &width, &height);
+
+  out->left = custom->flip_h ? origin->x - width : origin->x;
+  out->top = custom->flip_v ? origin->y - height : origin->y;
+  out->right = out->left + width;
+  out->bottom = out->top + height;
+}
+
+
+static void
+custom_transform_displaylist (Custom *custom, GList *display_list)
+{
+  const ShapeInfo *info = custom->info;
+  CustomGeometry *geometry = &custom->geometry;
+  GList *tmp;
+  int i, n;
+
+  for (tmp = display_list; tmp != NULL; tmp = tmp->next) {
+    GraphicElement *el = tmp->data;
+
+    switch (el->type) {
+      case GE_LINE:
+      case GE_RECT:
+        n = 2;
+        break;
+      case GE_POLYLINE:
+      case GE_POLYGON:
+        n = el->polyline.npoints;
+        break;
+      case GE_ELLIPSE:
+      case GE_IMAGE:
+        n = 1;
+        break;
+      case GE_PATH:
+      case GE_SHAPE: {
+        const BezPoint *in = info->bezpoints + el->any.offset;
+        BezPoint *out = geometry->bezpoints + el->any.offset;
+
+        for (i = 0; i < el->path.npoints; i++) {
+          out[i].type = in[i].type;
+          transform_coord (custom, &in[i].p1, &out[i].p1);
+          if (in[i].type == BEZ_CURVE_TO) {
+            transform_coord (custom, &in[i].p2, &out[i].p2);
+            transform_coord (custom, &in[i].p3, &out[i].p3);
+          }
+        }
+        n = 0;
+        break;
+      }
+      case GE_SUBSHAPE:
+        custom->current_subshape = &el->subshape;
+        custom_transform_displaylist (custom, el->subshape.display_list);
+        custom->current_subshape = NULL;
+        n = 0;
+        break;
+      case GE_TEXT:
+      default:
+        n = 0;
+        break;
+    }
+
+    for (i = 0; i < n; i++) {
+      transform_coord (custom,
+                       &info->points[el->any.offset + i],
+                       &geometry->points[el->any.offset + i]);
+    }
+  }
+}
+
+
+/*
+ * Bring the cached geometry up to date, only transforming the display list
+ * if the placement changed since the last call.
+ */
+static void
+custom_update_geometry (Custom *custom)
+{
+  CustomGeometry *geometry = &custom->geometry;
+
+  if (geometry->valid &&
+      geometry->xscale == custom->xscale &&
+      geometry->yscale == custom->yscale &&
+      geometry->xoffs == custom->xoffs &&
+      geometry->yoffs == custom->yoffs &&
+      geometry->subscale == custom->subscale &&
+      geometry->flip_h == custom->flip_h &&
+      geometry->flip_v == custom->flip_v) {
+    return;
+  }
+
+  if (!geometry->points && custom->info->n_points > 0) {
+    geometry->points = g_new0 (Point, custom->info->n_points);
+  }
+  if (!geometry->bezpoints && custom->info->n_bezpoints > 0) {
+    geometry->bezpoints = g_new0 (BezPoint, custom->info->n_bezpoints);
+  }
+
+  custom_transform_displaylist (custom, custom->info->display_list);
+
+  geometry->xscale = custom->xscale;
+  geometry->yscale = custom->yscale;
+  geometry->xoffs = custom->xoffs;
+  geometry->yoffs = custom->yoffs;
+  geometry->subscale = custom->subscale;
+  geometry->flip_h = custom->flip_h;
+  geometry->flip_v = custom->flip_v;
+  geometry->valid = TRUE;
+}
+
+
+static void
+custom_geometry_clear (CustomGeometry *geometry)
+{
+  g_clear_pointer (&geometry->points, g_free);
+  g_clear_pointer (&geometry->bezpoints, g_free);
+  geometry->valid = FALSE;
+}
+
+
 static double
 custom_distance_from (Custom *custom, Point *point)
 {
-  static GArray *arr = NULL, *barr = NULL;
+  const Point *pts;
+  const BezPoint *bpts;
   Point p1, p2;
   DiaRectangle rect;
-  gint i;
   GList *tmp;
   real min_dist = G_MAXFLOAT, dist = G_MAXFLOAT;
 
-  if (!arr) {
-    arr = g_array_new (FALSE, FALSE, sizeof(Point));
-  }
-  if (!barr) {
-    barr = g_array_new (FALSE, FALSE, sizeof(BezPoint));
-  }
+  custom_update_geometry (custom);
 
   for (tmp = custom->info->display_list; tmp != NULL; tmp = tmp->next) {
     GraphicElement *el = tmp->data;
@@ -593,37 +739,23 @@ custom_distance_from (Custom *custom, Point *point)
 
     switch (el->type) {
       case GE_LINE:
-        transform_coord (custom, &el->line.p1, &p1);
-        transform_coord (custom, &el->line.p2, &p2);
-        dist = distance_line_point (&p1, &p2, line_width, point);
+        pts = &custom->geometry.points[el->any.offset];
+        dist = distance_line_point (&pts[0], &pts[1], line_width, point);
         break;
       case GE_POLYLINE:
-        transform_coord (custom, &el->polyline.points[0], &p1);
-        dist = G_MAXFLOAT;
-        for (i = 1; i < el->polyline.npoints; i++) {
-          real seg_dist;
-
-          transform_coord (custom, &el->polyline.points[i], &p2);
-          seg_dist = distance_line_point (&p1, &p2, line_width, point);
-          p1 = p2;
-          dist = MIN (dist, seg_dist);
-          if (dist == 0.0) {
-            break;
-          }
-        }
+        pts = &custom->geometry.points[el->any.offset];
+        dist = distance_polyline_point (pts, el->polyline.npoints,
+                                        line_width, point);
         break;
       case GE_POLYGON:
-        g_array_set_size (arr, el->polygon.npoints);
-        for (i = 0; i < el->polygon.npoints; i++) {
-          transform_coord (custom, &el->polygon.points[i],
-                           &g_array_index (arr, Point, i));
-        }
-        dist = distance_polygon_point ((Point *)arr->data, el->polygon.npoints,
-              line_width, point);
+        pts = &custom->geometry.points[el->any.offset];
+        dist = distance_polygon_point (pts, el->polygon.npoints,
+                                       line_width, point);
         break;
       case GE_RECT:
-        transform_coord (custom, &el->rect.corner1, &p1);
-        transform_coord (custom, &el->rect.corner2, &p2);
+        pts = &custom->geometry.points[el->any.offset];
+        p1 = pts[0];
+        p2 = pts[1];
         if (p1.x < p2.x) {
           rect.left = p1.x - line_width/2;  rect.right = p2.x + line_width/2;
         } else {
@@ -637,15 +769,10 @@ custom_distance_from (Custom *custom, Point *point)
         dist = distance_rectangle_point (&rect, point);
         break;
       case GE_IMAGE:
-        p2.x = el->image.topleft.x + el->image.width;
-        p2.y = el->image.topleft.y + el->image.height;
-        transform_coord (custom, &el->image.topleft, &p1);
-        transform_coord (custom, &p2, &p2);
-
-        rect.left   = p1.x;
-        rect.top    = p1.y;
-        rect.right  = p2.x;
-        rect.bottom = p2.y;
+        custom_image_rect (custom,
+                           &el->image,
+                           &custom->geometry.points[el->any.offset],
+                           &rect);
         dist = distance_rectangle_point (&rect, point);
         break;
       case GE_TEXT:
@@ -656,60 +783,22 @@ custom_distance_from (Custom *custom, Point *point)
         text_set_position (el->text.object, &el->text.anchor);
         break;
       case GE_ELLIPSE:
-        transform_coord (custom, &el->ellipse.center, &p1);
-        dist = distance_ellipse_point (&p1,
+        pts = &custom->geometry.points[el->any.offset];
+        dist = distance_ellipse_point (&pts[0],
                                        el->ellipse.width * fabs (custom->xscale),
                                        el->ellipse.height * fabs (custom->yscale),
                                        line_width, point);
         break;
       case GE_PATH:
-        g_array_set_size (barr, el->path.npoints);
-        for (i = 0; i < el->path.npoints; i++) {
-          switch (g_array_index (barr,BezPoint,i).type = el->path.points[i].type) {
-            case BEZ_CURVE_TO:
-              transform_coord (custom,
-                               &el->path.points[i].p3,
-                               &g_array_index (barr, BezPoint, i).p3);
-              transform_coord (custom,
-                               &el->path.points[i].p2,
-                               &g_array_index (barr, BezPoint, i).p2);
-            case BEZ_MOVE_TO:
-            case BEZ_LINE_TO:
-              transform_coord (custom,
-                               &el->path.points[i].p1,
-                               &g_array_index (barr, BezPoint, i).p1);
-              break;
-            default:
-              g_return_val_if_reached (G_MAXFLOAT);
-          }
-        }
-        dist = distance_bez_line_point ((BezPoint *) barr->data,
+        bpts = &custom->geometry.bezpoints[el->any.offset];
+        dist = distance_bez_line_point (bpts,
                                         el->path.npoints,
                                         line_width,
                                         point);
         break;
       case GE_SHAPE:
-        g_array_set_size (barr, el->path.npoints);
-        for (i = 0; i < el->path.npoints; i++) {
-          switch (g_array_index (barr, BezPoint , i).type = el->path.points[i].type) {
-            case BEZ_CURVE_TO:
-              transform_coord (custom,
-                               &el->path.points[i].p3,
-                               &g_array_index (barr, BezPoint, i).p3);
-              transform_coord (custom,
-                               &el->path.points[i].p2,
-                               &g_array_index (barr, BezPoint, i).p2);
-            case BEZ_MOVE_TO:
-            case BEZ_LINE_TO:
-              transform_coord (custom,
-                               &el->path.points[i].p1,
-                               &g_array_index (barr, BezPoint, i).p1);
-              break;
-            default:
-              g_return_val_if_reached (G_MAXFLOAT);
-          }
-        }
-        dist = distance_bez_shape_point ((BezPoint *) barr->data,
+        bpts = &custom->geometry.bezpoints[el->any.offset];
+        dist = distance_bez_shape_point (bpts,
                                          el->path.npoints,
                                          line_width,
                                          point);
@@ -913,24 +1002,23 @@ get_colour (Custom *custom, Color *colour, gint32 c, double opacity)
 }
 
 
+/*
+ * Drawing sub-shapes sets the current one on the object and text elements
+ * are positioned in the ShapeInfo, shared by all objects of the shape.
+ * Renderers may draw on several threads.
+ */
+G_LOCK_DEFINE_STATIC (draw_state);
+
+
 static void
-custom_draw (Custom *custom, DiaRenderer *renderer)
+custom_draw_shape (Custom *custom, DiaRenderer *renderer)
 {
-  static GArray *arr = NULL, *barr = NULL;
   double cur_line = 1.0, cur_dash = 1.0;
   DiaLineCaps cur_caps = DIA_LINE_CAPS_BUTT;
   DiaLineJoin cur_join = DIA_LINE_JOIN_MITER;
   DiaLineStyle cur_style = custom->line_style;
 
-  g_return_if_fail (custom != NULL);
-  g_return_if_fail (renderer != NULL);
-
-  if (!arr) {
-    arr = g_array_new (FALSE, FALSE, sizeof(Point));
-  }
-  if (!barr) {
-    barr = g_array_new (FALSE, FALSE, sizeof(BezPoint));
-  }
+  custom_update_geometry (custom);
 
   dia_renderer_set_fillstyle (renderer, DIA_FILL_STYLE_SOLID);
   dia_renderer_set_linewidth (renderer, custom->border_width);
@@ -944,14 +1032,86 @@ custom_draw (Custom *custom, DiaRenderer *renderer)
    * them all by reference.
    * If anyone does know this, please correct/simplify.
    */
+  if (custom->info->draw_changes_state) {
+    G_LOCK (draw_state);
+  }
   custom_draw_displaylist (custom->info->display_list,
                            custom,
-                           renderer, arr, barr,
+                           renderer,
                            &cur_line,
                            &cur_dash,
                            &cur_caps,
                            &cur_join,
                            &cur_style);
+  if (custom->info->draw_changes_state) {
+    G_UNLOCK (draw_state);
+  }
+}
+
+
+/*
+ * Everything changing the drawing of the display list besides the
+ * position. Scale and flip stay part of the symbol so line widths and
+ * text are not distorted by the placement.
+ */
+static char *
+custom_symbol_key (Custom *custom)
+{
+  return g_strdup_printf ("custom:%s:%.9g:%.9g:%.9g:%d:%.9g:%d:"
+                          "%g,%g,%g,%g:%g,%g,%g,%g:%g,%g,%g,%g",
+                          custom->info->name,
+                          custom->xscale,
+                          custom->yscale,
+                          custom->border_width,
+                          custom->line_style,
+                          custom->dashlength,
+                          custom->show_background,
+                          custom->border_color.red,
+                          custom->border_color.green,
+                          custom->border_color.blue,
+                          custom->border_color.alpha,
+                          custom->inner_color.red,
+                          custom->inner_color.green,
+                          custom->inner_color.blue,
+                          custom->inner_color.alpha,
+                          custom->text->color.red,
+                          custom->text->color.green,
+                          custom->text->color.blue,
+                          custom->text->color.alpha);
+}
+
+
+static void
+custom_draw (Custom *custom, DiaRenderer *renderer)
+{
+  g_return_if_fail (custom != NULL);
+  g_return_if_fail (renderer != NULL);
+
+  /* sub-shapes don't scale linearly, so these can't be shared */
+  if (custom->info->subshapes == NULL &&
+      dia_renderer_is_capable_of (renderer, RENDER_SYMBOLS)) {
+    DiaMatrix m = { 1.0, 0.0, 0.0, 1.0, custom->xoffs, custom->yoffs };
+    char *key = custom_symbol_key (custom);
+
+    if (dia_renderer_begin_symbol (renderer, key, &m)) {
+      double xoffs = custom->xoffs, yoffs = custom->yoffs;
+      CustomGeometry geometry = custom->geometry;
+
+      /* draw at the origin, the renderer places it with the matrix */
+      custom->xoffs = custom->yoffs = 0.0;
+      custom->geometry = (CustomGeometry) { FALSE, };
+      custom_draw_shape (custom, renderer);
+      custom_geometry_clear (&custom->geometry);
+      custom->geometry = geometry;
+      custom->xoffs = xoffs;
+      custom->yoffs = yoffs;
+
+      dia_renderer_end_symbol (renderer);
+    }
+    g_clear_pointer (&key, g_free);
+  } else {
+    custom_draw_shape (custom, renderer);
+  }
 
   if (custom->info->has_text) {
     text_draw (custom->text, renderer);
@@ -963,8 +1123,6 @@ static void
 custom_draw_displaylist (GList        *display_list,
                          Custom       *custom,
                          DiaRenderer  *renderer,
-                         GArray       *arr,
-                         GArray       *barr,
                          double       *cur_line,
                          double       *cur_dash,
                          DiaLineCaps  *cur_caps,
@@ -982,8 +1140,8 @@ custom_draw_displaylist (GList        *display_list,
      * we pass them all by reference.
      * If anyone does know this, please correct/simplify.
      */
-    custom_draw_element( el, custom, renderer, arr, barr, cur_line, cur_dash,
-                         cur_caps, cur_join, cur_style, &fg, &bg );
+    custom_draw_element (el, custom, renderer, cur_line, cur_dash,
+                         cur_caps, cur_join, cur_style, &fg, &bg);
   }
 }
 
@@ -992,8 +1150,6 @@ static void
 custom_draw_element (GraphicElement *el,
                      Custom         *custom,
                      DiaRenderer    *renderer,
-                     GArray         *arr,
-                     GArray         *barr,
                      double         *cur_line,
                      double         *cur_dash,
                      DiaLineCaps    *cur_caps,
@@ -1002,10 +1158,12 @@ custom_draw_element (GraphicElement *el,
                      Color          *fg,
                      Color          *bg)
 {
+  Point *pts = NULL;
+  BezPoint *bpts = NULL;
   Point p1, p2;
+  DiaRectangle rect;
   double width, height;
   double coord;
-  int i;
   double radius;
 
   /* Somehow - maybe due to scaling - the exact match does not always work. Instead of:
@@ -1048,43 +1206,37 @@ custom_draw_element (GraphicElement *el,
   (*cur_line) = el->any.s.line_width;
   get_colour (custom, fg, el->any.s.stroke, el->any.s.stroke_opacity);
   get_colour (custom, bg, el->any.s.fill, el->any.s.fill_opacity);
+
+  /* the transformed geometry, see custom_update_geometry() */
+  if (el->type == GE_PATH || el->type == GE_SHAPE) {
+    bpts = &custom->geometry.bezpoints[el->any.offset];
+  } else if (el->any.offset >= 0 && el->type != GE_SUBSHAPE) {
+    pts = &custom->geometry.points[el->any.offset];
+  }
+
   switch (el->type) {
     case GE_LINE:
-      transform_coord (custom, &el->line.p1, &p1);
-      transform_coord (custom, &el->line.p2, &p2);
       if (el->any.s.stroke != DIA_SVG_COLOUR_NONE)
-        dia_renderer_draw_line (renderer, &p1, &p2, fg);
+        dia_renderer_draw_line (renderer, &pts[0], &pts[1], fg);
       break;
     case GE_POLYLINE:
-      g_array_set_size (arr, el->polyline.npoints);
-      for (i = 0; i < el->polyline.npoints; i++) {
-        transform_coord (custom,
-                         &el->polyline.points[i],
-                         &g_array_index (arr, Point, i));
-      }
       if (el->any.s.stroke != DIA_SVG_COLOUR_NONE) {
         dia_renderer_draw_polyline (renderer,
-                                    (Point *) arr->data,
+                                    pts,
                                     el->polyline.npoints,
                                     fg);
       }
       break;
     case GE_POLYGON:
-      g_array_set_size (arr, el->polygon.npoints);
-      for (i = 0; i < el->polygon.npoints; i++) {
-        transform_coord (custom,
-                         &el->polygon.points[i],
-                         &g_array_index (arr, Point, i));
-      }
       dia_renderer_draw_polygon (renderer,
-                                 (Point *)arr->data,
+                                 pts,
                                  el->polygon.npoints,
                                  (custom->show_background && el->any.s.fill != DIA_SVG_COLOUR_NONE) ? bg : NULL,
                                  (el->any.s.stroke != DIA_SVG_COLOUR_NONE) ? fg : NULL);
       break;
     case GE_RECT:
-      transform_coord (custom, &el->rect.corner1, &p1);
-      transform_coord (custom, &el->rect.corner2, &p2);
+      p1 = pts[0];
+      p2 = pts[1];
       radius = custom_transform_length (custom, el->rect.corner_radius);
       if (p1.x > p2.x) {
         coord = p1.x;
@@ -1116,81 +1268,45 @@ custom_draw_element (GraphicElement *el,
       text_set_position (el->text.object, &el->text.anchor);
       break;
     case GE_ELLIPSE:
-      transform_coord (custom, &el->ellipse.center, &p1);
       transform_size (custom,
                       el->ellipse.width,
                       el->ellipse.height,
                       &width,
                       &height);
       dia_renderer_draw_ellipse (renderer,
-                                 &p1,
+                                 &pts[0],
                                  width,
                                  height,
                                  (custom->show_background && el->any.s.fill != DIA_SVG_COLOUR_NONE) ? bg : NULL,
                                  (el->any.s.stroke != DIA_SVG_COLOUR_NONE) ? fg : NULL);
       break;
     case GE_IMAGE:
-      transform_coord (custom, &el->image.topleft, &p1);
       /* to scale correctly also for sub-shape some extra hoops */
-      transform_size (custom, el->image.width, el->image.height, &width, &height);
+      custom_image_rect (custom, &el->image, &pts[0], &rect);
+      p1.x = rect.left;
+      p1.y = rect.top;
       dia_renderer_draw_image (renderer,
                                &p1,
-                               width,
-                               height,
+                               rect.right - rect.left,
+                               rect.bottom - rect.top,
                                el->image.image);
       break;
     case GE_PATH:
-      g_array_set_size (barr, el->path.npoints);
-      for (i = 0; i < el->path.npoints; i++)
-        switch (g_array_index (barr,BezPoint,i).type=el->path.points[i].type) {
-          case BEZ_CURVE_TO:
-            transform_coord (custom,
-                             &el->path.points[i].p3,
-                             &g_array_index (barr, BezPoint, i).p3);
-            transform_coord (custom, &el->path.points[i].p2,
-                             &g_array_index (barr, BezPoint, i).p2);
-          case BEZ_MOVE_TO:
-          case BEZ_LINE_TO:
-            transform_coord (custom, &el->path.points[i].p1,
-                             &g_array_index (barr, BezPoint, i).p1);
-            break;
-          default:
-            g_return_if_reached ();
-      }
       if (el->any.s.stroke != DIA_SVG_COLOUR_NONE) {
         dia_renderer_draw_bezier (renderer,
-                                  (BezPoint *) barr->data,
+                                  bpts,
                                   el->path.npoints,
                                   fg);
       }
       break;
     case GE_SHAPE:
-      g_array_set_size (barr, el->path.npoints);
-      for (i = 0; i < el->path.npoints; i++)
-        switch (g_array_index (barr,BezPoint,i).type=el->path.points[i].type) {
-          case BEZ_CURVE_TO:
-            transform_coord (custom,
-                             &el->path.points[i].p3,
-                             &g_array_index (barr, BezPoint, i).p3);
-            transform_coord (custom,
-                             &el->path.points[i].p2,
-                             &g_array_index (barr, BezPoint, i).p2);
-          case BEZ_MOVE_TO:
-          case BEZ_LINE_TO:
-            transform_coord (custom,
-                             &el->path.points[i].p1,
-                             &g_array_index (barr, BezPoint, i).p1);
-            break;
-          default:
-            g_return_if_reached ();
-      }
       if (custom->show_background && el->any.s.fill != DIA_SVG_COLOUR_NONE) {
         dia_renderer_draw_beziergon(renderer,
-            (BezPoint *)barr->data, el->path.npoints,
+            bpts, el->path.npoints,
             bg, (el->any.s.stroke != DIA_SVG_COLOUR_NONE) ? fg : NULL);
       } else if (el->any.s.stroke != DIA_SVG_COLOUR_NONE) {
         dia_renderer_draw_bezier (renderer,
-                                  (BezPoint *) barr->data,
+                                  bpts,
                                   el->path.npoints,
                                   fg);
       }
@@ -1203,8 +1319,6 @@ custom_draw_element (GraphicElement *el,
         custom_draw_displaylist (subshape->display_list,
                                  custom,
                                  renderer,
-                                 arr,
-                                 barr,
                                  cur_line,
                                  cur_dash,
                                  cur_caps,
@@ -1312,8 +1426,6 @@ custom_update_data(Custom *custom, AnchorShape horiz, AnchorShape vert)
   DiaObject *obj = &elem->object;
   Point center, bottom_right;
   Point p;
-  static GArray *arr = NULL, *barr = NULL;
-
   int i;
   GList *tmp;
   char *txs;
@@ -1482,12 +1594,10 @@ custom_update_data(Custom *custom, AnchorShape horiz, AnchorShape vert)
   elem->extra_spacing.border_trans = 0; /*custom->border_width/2; */
   element_update_boundingbox(elem);
 
-  /* Merge in the bounding box of every individual element */
-  if (!arr)
-    arr = g_array_new(FALSE, FALSE, sizeof(Point));
-  if (!barr)
-    barr = g_array_new(FALSE, FALSE, sizeof(BezPoint));
+  /* the only place the display list gets transformed */
+  custom_update_geometry (custom);
 
+  /* Merge in the bounding box of every individual element */
   for (tmp = custom->info->display_list; tmp != NULL; tmp = tmp->next) {
     GraphicElement *el = tmp->data;
     DiaRectangle rect;
@@ -1509,14 +1619,11 @@ custom_update_data(Custom *custom, AnchorShape horiz, AnchorShape vert)
       break;
     case GE_LINE: {
       LineBBExtras extra;
-      Point p1,p2;
+      const Point *pts = &custom->geometry.points[el->any.offset];
       extra.start_trans = extra.end_trans = el->line.s.line_width * lwfactor;
       extra.start_long = extra.end_long = 0;
 
-      transform_coord(custom, &el->line.p1, &p1);
-      transform_coord(custom, &el->line.p2, &p2);
-
-      line_bbox(&p1,&p2,&extra,&rect);
+      line_bbox(&pts[0],&pts[1],&extra,&rect);
       break;
     }
     case GE_POLYGON:
@@ -1527,12 +1634,7 @@ custom_update_data(Custom *custom, AnchorShape horiz, AnchorShape vert)
         el->polyline.s.line_width * lwfactor;
       extra.start_long = extra.end_long = 0;
 
-      g_array_set_size(arr, el->polyline.npoints);
-      for (i = 0; i < el->polyline.npoints; i++)
-        transform_coord(custom, &el->polyline.points[i],
-                        &g_array_index(arr, Point, i));
-
-      polyline_bbox(&g_array_index(arr,Point,0),el->polyline.npoints,
+      polyline_bbox(&custom->geometry.points[el->any.offset],el->polyline.npoints,
                     &extra,el->type==GE_POLYGON,&rect);
       break;
     }
@@ -1543,35 +1645,15 @@ custom_update_data(Custom *custom, AnchorShape horiz, AnchorShape vert)
         el->path.s.line_width * lwfactor;
       extra.start_long = extra.end_long = 0;
 
-      g_array_set_size (barr, el->path.npoints);
-      for (i = 0; i < el->path.npoints; i++) {
-        switch (g_array_index (barr, BezPoint, i).type = el->path.points[i].type) {
-          case BEZ_CURVE_TO:
-            transform_coord (custom, &el->path.points[i].p3,
-                             &g_array_index (barr, BezPoint, i).p3);
-            transform_coord (custom, &el->path.points[i].p2,
-                             &g_array_index (barr, BezPoint, i).p2);
-          case BEZ_MOVE_TO:
-          case BEZ_LINE_TO:
-            transform_coord (custom, &el->path.points[i].p1,
-                             &g_array_index (barr, BezPoint, i).p1);
-            break;
-          default:
-            g_return_if_reached ();
-        }
-      }
-
-      polybezier_bbox(&g_array_index(barr,BezPoint,0),el->path.npoints,
+      polybezier_bbox(&custom->geometry.bezpoints[el->any.offset],el->path.npoints,
                       &extra,el->type==GE_SHAPE,&rect);
       break;
     }
     case GE_ELLIPSE: {
       ElementBBExtras extra;
-      Point centre;
       extra.border_trans = el->ellipse.s.line_width * lwfactor;
-      transform_coord(custom, &el->ellipse.center, &centre);
 
-      ellipse_bbox(&centre,
+      ellipse_bbox(&custom->geometry.points[el->any.offset],
                    el->ellipse.width * fabs(custom->xscale),
                    el->ellipse.height * fabs(custom->yscale),
                    &extra,&rect);
@@ -1789,6 +1871,29 @@ custom_destroy(Custom *custom)
   element_destroy(&custom->element);
 
   g_clear_pointer (&custom->connections, g_free);
+  custom_geometry_clear (&custom->geometry);
+}
+
+
+static gsize
+custom_get_memory_size (Custom *custom, GHashTable *shared)
+{
+  gsize size = element_get_memory_size (&custom->element, sizeof (Custom));
+
+  /* the extended attributes are allocated behind the structure */
+  size += custom->info->ext_attr_size;
+  size += custom->info->nconnections * sizeof (ConnectionPoint);
+  if (custom->geometry.points) {
+    size += custom->info->n_points * sizeof (Point);
+  }
+  if (custom->geometry.bezpoints) {
+    size += custom->info->n_bezpoints * sizeof (BezPoint);
+  }
+  if (custom->info->has_text) {
+    size += text_get_memory_size (custom->text, shared);
+  }
+
+  return size;
 }
 
 static DiaObject *
@@ -137,6 +137,87 @@ shape_info_realise(ShapeInfo* info)
   }
 }
 
+static void
+compile_display_list (GList    *display_list,
+                      GArray   *points,
+                      GArray   *bezpoints,
+                      gboolean *changes_state)
+{
+  GList *tmp;
+
+  for (tmp = display_list; tmp != NULL; tmp = tmp->next) {
+    GraphicElement *el = tmp->data;
+
+    switch (el->type) {
+      case GE_LINE:
+        el->any.offset = points->len;
+        g_array_append_val (points, el->line.p1);
+        g_array_append_val (points, el->line.p2);
+        break;
+      case GE_POLYLINE:
+      case GE_POLYGON:
+        el->any.offset = points->len;
+        g_array_append_vals (points, el->polyline.points, el->polyline.npoints);
+        break;
+      case GE_RECT:
+        el->any.offset = points->len;
+        g_array_append_val (points, el->rect.corner1);
+        g_array_append_val (points, el->rect.corner2);
+        break;
+      case GE_ELLIPSE:
+        el->any.offset = points->len;
+        g_array_append_val (points, el->ellipse.center);
+        break;
+      case GE_IMAGE:
+        el->any.offset = points->len;
+        g_array_append_val (points, el->image.topleft);
+        break;
+      case GE_PATH:
+      case GE_SHAPE:
+        el->any.offset = bezpoints->len;
+        g_array_append_vals (bezpoints, el->path.points, el->path.npoints);
+        break;
+      case GE_SUBSHAPE:
+        compile_display_list (el->subshape.display_list, points, bezpoints,
+                              changes_state);
+        *changes_state = TRUE;
+        break;
+      case GE_TEXT:
+        /* positioned by the text object */
+        el->any.offset = -1;
+        *changes_state = TRUE;
+        break;
+      default:
+        el->any.offset = -1;
+        break;
+    }
+  }
+}
+
+/*!
+ * \brief Collect the display list geometry into flat arrays
+ *
+ * Every element gets the offset of it's points, so objects can transform
+ * all of them in one go and keep the result until their placement changes.
+ *
+ * \extends _ShapeInfo
+ */
+static void
+shape_info_compile (ShapeInfo *info)
+{
+  GArray *points = g_array_new (FALSE, FALSE, sizeof (Point));
+  GArray *bezpoints = g_array_new (FALSE, FALSE, sizeof (BezPoint));
+
+  info->draw_changes_state = FALSE;
+  compile_display_list (info->display_list, points, bezpoints,
+                        &info->draw_changes_state);
+
+  info->n_points = points->len;
+  info->points = (Point *) g_array_free (points, FALSE);
+  info->n_bezpoints = bezpoints->len;
+  info->bezpoints = (BezPoint *) g_array_free (bezpoints, FALSE);
+}
+
 real
 shape_info_get_default_width(ShapeInfo *info)
 {
@@ -958,6 +1039,7 @@ load_shape_info (const gchar *filename, ShapeInfo *preload)
   }
   /*MC 11/03 parse ext attributes if any & prepare prop tables */
   custom_setup_properties (info, ext_node);
+  shape_info_compile (info);
   xmlFreeDoc(doc);
   return info;
 }
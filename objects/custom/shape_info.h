@@ -59,9 +59,12 @@ typedef struct _GraphicElementText GraphicElementText;
 typedef struct _GraphicElementImage GraphicElementImage;
 typedef struct _GraphicElementSubShape GraphicElementSubShape;
 
+/* offset is the index of the first point in ShapeInfo::points
+ * or ShapeInfo::bezpoints, see shape_info_compile() */
 #define SHAPE_INFO_COMMON  \
   GraphicElementType type; \
-  DiaSvgStyle s
+  DiaSvgStyle s; \
+  int offset
 
 struct _GraphicElementAny {
   SHAPE_INFO_COMMON;
@@ -203,6 +206,15 @@ struct _ShapeInfo {
 
   GList *subshapes;
 
+  /*! all points of the display list including sub-shapes in drawing order */
+  Point *points;
+  int n_points;
+  /*! all path points of the display list in drawing order */
+  BezPoint *bezpoints;
+  int n_bezpoints;
+  /*! drawing sub-shapes or text elements changes state shared by the objects */
+  gboolean draw_changes_state;
+
   DiaObjectType *object_type; /* back link so we can find the correct type */
 
   /*MC 11/03 added */
@@ -87,6 +87,7 @@ static void bezierline_save(Bezierline *bezierline, ObjectNode obj_node,
 static DiaObject *bezierline_load(ObjectNode obj_node, int version, DiaContext *ctx);
 static DiaMenu *bezierline_get_object_menu(Bezierline *bezierline, Point *clickedpoint);
 static gboolean bezierline_transform(Bezierline *bezierline, const DiaMatrix *m);
+static gsize bezierline_get_memory_size(Bezierline *bezierline, GHashTable *shared);
 
 static void compute_gap_points(Bezierline *bezierline, Point *gap_points);
 static real approx_bez_length(BezierConn *bez);
@@ -131,6 +132,7 @@ static ObjectOps bezierline_ops = {
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
   (TransformFunc)       bezierline_transform,
+  (GetMemorySizeFunc)   bezierline_get_memory_size,
 };
 
 static PropNumData gap_range = { -G_MAXFLOAT, G_MAXFLOAT, 0.1};
@@ -499,6 +501,18 @@ bezierline_destroy(Bezierline *bezierline)
   bezierconn_destroy(&bezierline->bez);
 }
 
+static gsize
+bezierline_get_memory_size (Bezierline *bezierline, GHashTable *shared)
+{
+  gsize size = bezierconn_get_memory_size (&bezierline->bez, sizeof (Bezierline));
+
+  if (bezierline->bez.object.enclosing_box) {
+    size += sizeof (DiaRectangle);
+  }
+
+  return size;
+}
+
 static DiaObject *
 bezierline_copy(Bezierline *bezierline)
 {
@@ -30,6 +30,9 @@
 #include "element.h"
 #include "connectionpoint.h"
 #include "diarenderer.h"
+#include "diainteractiverenderer.h"
+#include "diagramdata.h"
+#include "dia-layer.h"
 #include "attributes.h"
 #include "dia_image.h"
 #include "message.h"
@@ -71,6 +74,9 @@ struct _Image {
   double angle;
 
   time_t mtime;
+
+  gulong ready_id; /* waiting for image to be decoded */
+  gulong level_id; /* for redrawing with a better mipmap level */
 };
 
 static struct _ImageProperties {
@@ -88,6 +94,7 @@ static DiaObjectChange* image_move_handle(Image *image, Handle *handle,
 static DiaObjectChange* image_move(Image *image, Point *to);
 static void image_draw(Image *image, DiaRenderer *renderer);
 static gboolean image_transform(Image *image, const DiaMatrix *m);
+static gsize image_get_memory_size(Image *image, GHashTable *shared);
 static void image_update_data(Image *image);
 static DiaObject *image_create(Point *startpoint,
 			  void *user_data,
@@ -163,6 +170,7 @@ static ObjectOps image_ops = {
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
   (TransformFunc)       image_transform,
+  (GetMemorySizeFunc)   image_get_memory_size,
 };
 
 static PropOffset image_offsets[] = {
@@ -180,6 +188,66 @@ static PropOffset image_offsets[] = {
   { NULL, 0, 0 }
 };
 
+/* the size of the picture is known now, keep_aspect might change ours */
+static void
+_image_ready (DiaImage *dia_image, Image *image)
+{
+  DiaObject *obj = &image->element.object;
+  DiaLayer *layer = dia_object_get_parent_layer (obj);
+  DiagramData *dia = layer ? dia_layer_get_parent_diagram (layer) : NULL;
+
+  g_clear_signal_handler (&image->ready_id, dia_image);
+
+  if (dia) {
+    data_emit (dia, layer, obj, "object-changed");
+  }
+  image_update_data (image);
+  if (dia) {
+    data_emit (dia, layer, obj, "object-changed");
+  }
+}
+
+
+/* the picture looks better now, only the display needs to know */
+static void
+_image_level_ready (DiaImage *dia_image, Image *image)
+{
+  DiaObject *obj = &image->element.object;
+  DiaLayer *layer = dia_object_get_parent_layer (obj);
+  DiagramData *dia = layer ? dia_layer_get_parent_diagram (layer) : NULL;
+
+  if (dia) {
+    data_emit (dia, layer, obj, "object-changed");
+  }
+}
+
+
+static void
+_image_unwatch (Image *image)
+{
+  g_clear_signal_handler (&image->ready_id, image->image);
+  g_clear_signal_handler (&image->level_id, image->image);
+}
+
+
+static void
+_image_watch (Image *image)
+{
+  if (image->image && !dia_image_is_ready (image->image)) {
+    image->ready_id = g_signal_connect (image->image,
+                                        "ready",
+                                        G_CALLBACK (_image_ready),
+                                        image);
+  }
+  if (image->image) {
+    image->level_id = g_signal_connect (image->image,
+                                        "level-ready",
+                                        G_CALLBACK (_image_level_ready),
+                                        image);
+  }
+}
+
+
 /*!
  * \brief Get properties of the _Image
  * \memberof _Image
@@ -222,9 +290,13 @@ image_set_props (Image *image, GPtrArray *props)
   GStatBuf st;
   time_t mtime = 0;
   char *old_file = image->file ? g_strdup (image->file) : NULL;
-  const GdkPixbuf *old_pixbuf = dia_image_pixbuf (image->image);
+  const GdkPixbuf *old_pixbuf;
   gboolean was_inline = image->inline_data;
 
+  /* the image is needed now, so it will be ready before any redraw */
+  _image_unwatch (image);
+  old_pixbuf = dia_image_pixbuf (image->image);
+
   object_set_props_from_offsets (&image->element.object, image_offsets, props);
 
   /* use old value on error */
@@ -242,8 +314,9 @@ image_set_props (Image *image, GPtrArray *props)
       image->inline_data = TRUE;
     } else if (old_pixbuf != image->pixbuf && image->pixbuf) { /* substitute the image and pixbuf */
       DiaImage *old_image = image->image;
-      image->image = dia_image_new_from_pixbuf (image->pixbuf);
-      image->pixbuf = g_object_ref ((GdkPixbuf *)dia_image_pixbuf (image->image));
+      image->image = dia_image_intern (dia_image_new_from_pixbuf (image->pixbuf));
+      /* an equal, already shared image might bring its own pixbuf */
+      g_set_object (&image->pixbuf, (GdkPixbuf *) dia_image_pixbuf (image->image));
       g_clear_object (&old_image);
       image->inline_data = TRUE;
     } else {
@@ -252,8 +325,16 @@ image_set_props (Image *image, GPtrArray *props)
     }
   } else if (was_inline && !image->inline_data) { /* switch off inline */
     if (old_file && image->file && strcmp (old_file, image->file) != 0) {
-       /* export inline data, if saving fails we keep it inline */
-       image->inline_data = !dia_image_save (image->image, image->file);
+       /* export inline data, if saving fails we keep it inline. Saving
+        * renames the image, so don't do it on the shared instance */
+       DiaImage *own = dia_image_new_from_pixbuf ((GdkPixbuf *) old_pixbuf);
+
+       image->inline_data = !dia_image_save (own, image->file);
+       if (!image->inline_data) {
+         g_clear_object (&image->image);
+         image->image = dia_image_intern (g_steal_pointer (&own));
+       }
+       g_clear_object (&own);
     } else if (!image->file) {
        message_warning (_("Can't save image without filename"));
        image->inline_data = TRUE; /* keep inline */
@@ -268,10 +349,13 @@ image_set_props (Image *image, GPtrArray *props)
     Element *elem = &image->element;
     DiaImage *img = NULL;
 
-    if ((img = dia_image_load(image->file)) != NULL)
+    if ((img = dia_image_intern (dia_image_load (image->file))) != NULL) {
+      g_clear_object (&image->image);
       image->image = img;
-    else if (!image->pixbuf) /* dont overwrite inlined */
+    } else if (!image->pixbuf) { /* dont overwrite inlined */
+      g_clear_object (&image->image);
       image->image = dia_image_get_broken();
+    }
     elem->height = (elem->width*(float)dia_image_height(image->image))/
       (float)dia_image_width(image->image);
     /* release image->pixbuf? */
@@ -291,6 +375,7 @@ image_set_props (Image *image, GPtrArray *props)
   /* remember modification time */
   image->mtime = mtime;
 
+  _image_watch (image);
   image_update_data(image);
 }
 
@@ -483,8 +568,9 @@ image_draw (Image *image, DiaRenderer *renderer)
                               &image->border_color);
     }
   }
-  /* Draw the image */
-  if (image->image) {
+  /* Draw the image, on screen don't wait for it to be decoded */
+  if (image->image &&
+      (dia_image_is_ready (image->image) || !DIA_IS_INTERACTIVE_RENDERER (renderer))) {
     if (image->angle == 0.0) {
       dia_renderer_draw_image (renderer,
                                &elem->corner,
@@ -540,6 +626,28 @@ image_transform(Image *image, const DiaMatrix *m)
 }
 
 
+
+static gsize
+image_get_memory_size (Image *image, GHashTable *shared)
+{
+  gsize size = object_get_memory_size (&image->element.object, sizeof (Image));
+
+  if (image->file) {
+    size += strlen (image->file) + 1;
+  }
+  if (image->image) {
+    size += dia_image_get_memory_size (image->image, shared);
+  }
+  /* usually the pixbuf of the image, only known when sharing is tracked */
+  if (image->pixbuf && shared && !g_hash_table_contains (shared, image->pixbuf)) {
+    g_hash_table_add (shared, image->pixbuf);
+    size += gdk_pixbuf_get_byte_length (image->pixbuf);
+  }
+
+  return size;
+}
+
+
 static void
 image_update_data (Image *image)
 {
@@ -547,7 +655,8 @@ image_update_data (Image *image)
   ElementBBExtras *extra = &elem->extra_spacing;
   DiaObject *obj = &elem->object;
 
-  if (image->keep_aspect && image->image) {
+  /* a deferred image doesn't know its size yet */
+  if (image->keep_aspect && image->image && dia_image_is_ready (image->image)) {
     /* maybe the image got changes since */
     real aspect_org = (float) dia_image_width (image->image)
                     / (float) dia_image_height (image->image);
@@ -627,7 +736,8 @@ image_create(Point *startpoint,
 
   if (strcmp(default_properties.file, "")) {
     image->file = g_strdup(default_properties.file);
-    image->image = dia_image_load(image->file);
+    image->image = dia_image_intern (dia_image_load (image->file));
+    _image_watch (image);
 
     if (image->image) {
       elem->width = (elem->width*(float)dia_image_width(image->image))/
@@ -654,6 +764,7 @@ image_destroy (Image *image)
 {
   g_clear_pointer (&image->file, g_free);
 
+  _image_unwatch (image);
   g_clear_object (&image->image);
   g_clear_object (&image->pixbuf);
 
@@ -708,6 +819,8 @@ image_copy(Image *image)
   newimage->draw_border = image->draw_border;
   newimage->keep_aspect = image->keep_aspect;
 
+  _image_watch (newimage);
+
   return &newimage->element.object;
 }
 
@@ -761,6 +874,9 @@ image_save(Image *image, ObjectNode obj_node, DiaContext *ctx)
     pixbuf = (GdkPixbuf *)dia_image_pixbuf (image->image);
     if (pixbuf != image->pixbuf && image->pixbuf != NULL)
       message_warning (_("Inconsistent pixbuf during image save."));
+    /* never replace the real data with the placeholder */
+    if (image->image && dia_image_is_broken (image->image))
+      pixbuf = NULL;
     if (pixbuf)
       data_add_pixbuf (new_attribute(obj_node, "pixbuf"), pixbuf, ctx);
   }
@@ -850,12 +966,12 @@ image_load (ObjectNode obj_node, int version, DiaContext *ctx)
     if (   g_path_is_absolute (image->file)
         && g_file_test (image->file, G_FILE_TEST_IS_REGULAR)) {
       /* Absolute pathname */
-      image->image = dia_image_load (image->file);
+      image->image = dia_image_load_deferred (image->file);
     } else { /* build from relative pathname */
       char *image_filename = dia_absolutize_filename (dia_context_get_filename (ctx),
                                                       image->file);
 
-      image->image = dia_image_load (image_filename);
+      image->image = dia_image_load_deferred (image_filename);
       if (image->image != NULL) {
         /* Found file in same directory as diagram. */
         g_clear_pointer (&image->file, g_free);
@@ -864,7 +980,7 @@ image_load (ObjectNode obj_node, int version, DiaContext *ctx)
         /* not found as relative path, try literally */
         g_clear_pointer (&image_filename, g_free);
 
-        image->image = dia_image_load (image->file);
+        image->image = dia_image_load_deferred (image->file);
         if (image->image == NULL) {
           /* Didn't find file in current directory. */
           dia_context_add_message (ctx,
@@ -879,13 +995,11 @@ image_load (ObjectNode obj_node, int version, DiaContext *ctx)
   if (!image->image) {
     attr = object_find_attribute (obj_node, "pixbuf");
     if (attr != NULL) {
-      GdkPixbuf *pixbuf = data_pixbuf (attribute_first_data (attr), ctx);
+      image->image = data_image_deferred (attribute_first_data (attr), ctx);
 
-      if (pixbuf) {
-        image->image = dia_image_new_from_pixbuf (pixbuf);
+      if (image->image) {
         image->inline_data = TRUE; /* avoid loosing it */
         /* FIXME: should we reset the filename? */
-        g_clear_object (&pixbuf);
       }
     }
   } else {
@@ -896,6 +1010,11 @@ image_load (ObjectNode obj_node, int version, DiaContext *ctx)
     /* Should be set pixbuf, too? Or leave it till the first get. */
   }
 
+  /* share the image with every other object showing the same, deferred
+   * images are already shared by file or within the document */
+  image->image = dia_image_intern (image->image);
+  _image_watch (image);
+
   /* update mtime */
   if (g_stat (image->file, &st) != 0) {
     st.st_mtime = 0;
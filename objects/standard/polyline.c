@@ -72,6 +72,7 @@ static real polyline_distance_from(Polyline *polyline, Point *point);
 static void polyline_update_data(Polyline *polyline);
 static void polyline_destroy(Polyline *polyline);
 static DiaObject *polyline_copy(Polyline *polyline);
+static gsize polyline_get_memory_size(Polyline *polyline, GHashTable *shared);
 
 static void polyline_set_props(Polyline *polyline, GPtrArray *props);
 
@@ -165,6 +166,7 @@ static ObjectOps polyline_ops = {
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
   (TransformFunc)       polyline_transform,
+  (GetMemorySizeFunc)   polyline_get_memory_size,
 };
 
 static void
@@ -379,6 +381,12 @@ polyline_destroy(Polyline *polyline)
   polyconn_destroy(&polyline->poly);
 }
 
+static gsize
+polyline_get_memory_size (Polyline *polyline, GHashTable *shared)
+{
+  return polyconn_get_memory_size (&polyline->poly, sizeof (Polyline));
+}
+
 static DiaObject *
 polyline_copy(Polyline *polyline)
 {
@@ -102,6 +102,7 @@ static void textobj_save(Textobj *textobj, ObjectNode obj_node,
 static DiaObject *textobj_load(ObjectNode obj_node, int version, DiaContext *ctx);
 static DiaMenu *textobj_get_object_menu(Textobj *textobj, Point *clickedpoint);
 static gboolean textobj_transform(Textobj *textobj, const DiaMatrix *m);
+static gsize textobj_get_memory_size(Textobj *textobj, GHashTable *shared);
 
 static void textobj_valign_point(Textobj *textobj, Point* p);
 
@@ -191,6 +192,7 @@ static ObjectOps textobj_ops = {
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
   (TransformFunc)       textobj_transform,
+  (GetMemorySizeFunc)   textobj_get_memory_size,
 };
 
 static void
@@ -651,3 +653,10 @@ textobj_transform(Textobj *textobj, const DiaMatrix *m)
   textobj_update_data(textobj);
   return TRUE;
 }
+
+static gsize
+textobj_get_memory_size (Textobj *textobj, GHashTable *shared)
+{
+  return object_get_memory_size (&textobj->object, sizeof (Textobj))
+         + text_get_memory_size (textobj->text, shared);
+}
@@ -73,6 +73,7 @@ static real zigzagline_distance_from(Zigzagline *zigzagline, Point *point);
 static void zigzagline_update_data(Zigzagline *zigzagline);
 static void zigzagline_destroy(Zigzagline *zigzagline);
 static DiaObject *zigzagline_copy(Zigzagline *zigzagline);
+static gsize zigzagline_get_memory_size(Zigzagline *zigzagline, GHashTable *shared);
 static DiaMenu *zigzagline_get_object_menu(Zigzagline *zigzagline,
 					   Point *clickedpoint);
 
@@ -153,6 +154,8 @@ static ObjectOps zigzagline_ops = {
   (SetPropsFunc)        zigzagline_set_props,
   (TextEditFunc) 0,
   (ApplyPropertiesListFunc) object_apply_props,
+  (TransformFunc)       NULL,
+  (GetMemorySizeFunc)   zigzagline_get_memory_size,
 };
 
 static void
@@ -293,6 +296,12 @@ zigzagline_destroy(Zigzagline *zigzagline)
   orthconn_destroy(&zigzagline->orth);
 }
 
+static gsize
+zigzagline_get_memory_size (Zigzagline *zigzagline, GHashTable *shared)
+{
+  return orthconn_get_memory_size (&zigzagline->orth, sizeof (Zigzagline));
+}
+
 static DiaObject *
 zigzagline_copy(Zigzagline *zigzagline)
 {
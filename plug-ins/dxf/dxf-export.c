@@ -603,6 +603,7 @@ export_dxf (DiagramData *data,
   FILE *file;
   gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
   gchar buf2[G_ASCII_DTOSTR_BUF_SIZE];
+  real size;
 
   file = g_fopen(filename, "w");
 
@@ -616,6 +617,13 @@ export_dxf (DiagramData *data,
 
     renderer->file = file;
 
+    /* Beziers are flattened by the base class. Coordinates are written
+     * with six significant digits, anything finer than that is lost. */
+    size = MAX (data->extents.right - data->extents.left,
+                data->extents.bottom - data->extents.top);
+    if (size > 0.0)
+      g_object_set (renderer, "tolerance", MAX (size * 5e-6, 1e-6), NULL);
+
     /* drawing limits */
     fprintf(file, "  0\nSECTION\n  2\nHEADER\n");
     fprintf(file, "  9\n$EXTMIN\n 10\n%s\n 20\n%s\n",
@@ -1331,9 +1331,13 @@ import_dxf (const char  *filename,
 
   data = g_new0 (DxfData, 1);
 
+  /* entities are added one by one, announce them together */
+  dia_diagram_data_begin_bulk_add (dia);
+
   do {
     if (read_dxf_codes (filedxf, data) == FALSE) {
       g_clear_pointer (&data, g_free);
+      dia_diagram_data_end_bulk_add (dia);
       dia_context_add_message (ctx,
                                 _("read_dxf_codes failed on '%s'"),
                                 dia_context_get_filename (ctx));
@@ -1341,6 +1345,7 @@ import_dxf (const char  *filename,
     } else {
       if (0 == data->code && strstr (data->codeline, "AutoCAD Binary DXF")) {
         g_clear_pointer (&data, g_free);
+        dia_diagram_data_end_bulk_add (dia);
         dia_context_add_message (ctx,
                                   _("Binary DXF from '%s' not supported"),
                                   dia_context_get_filename (ctx));
@@ -1391,6 +1396,7 @@ import_dxf (const char  *filename,
     }while((data->code != 0) || (strcmp(data->value, "EOF") != 0));
 
     g_clear_pointer (&data, g_free);
+    dia_diagram_data_end_bulk_add (dia);
     if (_color_by_layer_ht) {
         g_hash_table_destroy (_color_by_layer_ht);
         _color_by_layer_ht = NULL;
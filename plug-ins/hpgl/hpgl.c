@@ -763,6 +763,8 @@ export_data(DiagramData *data, DiaContext *ctx,
     else
         while (renderer->scale * height < 3276.7) renderer->scale *= 10.0;
     renderer->offset = 0.0; /* just to have one */
+    /* no need to flatten curves finer than the plotter resolution */
+    g_object_set (renderer, "tolerance", 0.5 / renderer->scale, NULL);
 
     renderer->size.x = width * renderer->scale;
     renderer->size.y = height * renderer->scale;
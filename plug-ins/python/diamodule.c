@@ -322,6 +322,10 @@ PyDia_import_data (const gchar* filename, DiagramData *dia, DiaContext *ctx, voi
     /* Python tries to guarantee this, make it work for these plugins too */
     old_locale = setlocale(LC_NUMERIC, "C");
 
+    /* the script adds objects one by one, announce them together */
+    if (dia)
+        dia_diagram_data_begin_bulk_add (dia);
+
     arg = Py_BuildValue ("(sO)", filename, diaobj);
     if (arg) {
       PyObject *res = PyObject_CallObject (func, arg);
@@ -330,6 +334,9 @@ PyDia_import_data (const gchar* filename, DiagramData *dia, DiaContext *ctx, voi
     }
     Py_XDECREF (arg);
 
+    if (dia)
+        dia_diagram_data_end_bulk_add (dia);
+
     Py_DECREF(func);
     Py_XDECREF(diaobj);
 
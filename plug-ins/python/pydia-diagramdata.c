@@ -32,6 +32,7 @@
 
 #include "app/diagram.h"
 #include "dia-layer.h"
+#include "dia-memory-usage.h"
 #include "pydia-diagram.h" /* support dynamic_cast */
 
 
@@ -291,6 +292,31 @@ PyDiaDiagramData_CallbackObject (DiagramData *dia,
 }
 
 
+/**
+ * PyDiaDiagramData_CallbackObjects:
+ * @dia: The DiagramData that emitted the signal.
+ * @layer: The Layer that the objects were added to.
+ * @objects: (element-type Dia.Object): The objects added in one go.
+ * @user_data: The python function to be called by the callback.
+ *
+ * Callback for the "objects-added" signal. Bulk insertion does not emit
+ * "object_add" per object, so python listeners of "object_add" are called
+ * once for every object in the list instead.
+ */
+static void
+PyDiaDiagramData_CallbackObjects (DiagramData *dia,
+                                  DiaLayer    *layer,
+                                  GList       *objects,
+                                  void        *user_data)
+{
+  GList *list;
+
+  for (list = objects; list != NULL; list = g_list_next (list)) {
+    PyDiaDiagramData_CallbackObject (dia, layer, list->data, user_data);
+  }
+}
+
+
 /** Connects a python function to a signal.
  *  @param self The PyDiaDiagramData this is a method of.
  *  @param args A tuple containing the arguments, a str for signal name
@@ -319,6 +345,9 @@ PyDiaDiagramData_ConnectAfter(PyDiaDiagramData *self, PyObject *args)
 
         /* connect to signal */
         g_signal_connect_after(DIA_DIAGRAM_DATA(self->data),signal,G_CALLBACK(PyDiaDiagramData_CallbackObject), func);
+        /* objects added in bulk arrive as one "objects-added" */
+        if (strcmp("object_add",signal) == 0)
+            g_signal_connect_after(DIA_DIAGRAM_DATA(self->data),"objects-added",G_CALLBACK(PyDiaDiagramData_CallbackObjects), func);
 
         Py_INCREF(Py_None);
         return Py_None;
@@ -330,6 +359,64 @@ PyDiaDiagramData_ConnectAfter(PyDiaDiagramData *self, PyObject *args)
 }
 
 
+static PyObject *
+_memory_usage_items (GPtrArray *items)
+{
+  PyObject *list = PyList_New (items->len);
+  guint i;
+
+  for (i = 0; i < items->len; i++) {
+    DiaMemoryUsageItem *item = g_ptr_array_index (items, i);
+
+    PyList_SetItem (list, i, Py_BuildValue ("(sIK)",
+                                            item->name ? item->name : "",
+                                            item->n_objects,
+                                            (unsigned long long) item->size));
+  }
+
+  return list;
+}
+
+
+static PyObject *
+PyDiaDiagramData_GetMemoryUsage (PyDiaDiagramData *self, PyObject *args)
+{
+  DiaMemoryUsage *usage;
+  PyObject *dict, *value;
+
+  if (!PyArg_ParseTuple (args, ":DiagramData.get_memory_usage")) {
+    return NULL;
+  }
+
+  usage = dia_memory_usage_new (self->data);
+  if (DIA_IS_DIAGRAM (self->data)) {
+    usage->undo = undo_get_memory_size (DIA_DIAGRAM (self->data)->undo,
+                                        usage->shared);
+  }
+
+  dict = PyDict_New ();
+  value = PyLong_FromUnsignedLongLong (usage->total);
+  PyDict_SetItemString (dict, "total", value);
+  Py_DECREF (value);
+  value = PyLong_FromUnsignedLong (usage->n_objects);
+  PyDict_SetItemString (dict, "objects", value);
+  Py_DECREF (value);
+  value = PyLong_FromUnsignedLongLong (usage->undo);
+  PyDict_SetItemString (dict, "undo", value);
+  Py_DECREF (value);
+  value = _memory_usage_items (usage->layers);
+  PyDict_SetItemString (dict, "layers", value);
+  Py_DECREF (value);
+  value = _memory_usage_items (usage->types);
+  PyDict_SetItemString (dict, "types", value);
+  Py_DECREF (value);
+
+  dia_memory_usage_free (usage);
+
+  return dict;
+}
+
+
 static PyMethodDef PyDiaDiagramData_Methods[] = {
     {"update_extents", (PyCFunction)PyDiaDiagramData_UpdateExtents, METH_VARARGS,
      "update_extents() -> None.  Recalculation of the diagram extents."},
@@ -349,6 +436,9 @@ static PyMethodDef PyDiaDiagramData_Methods[] = {
     {"connect_after", (PyCFunction)PyDiaDiagramData_ConnectAfter, METH_VARARGS,
      "connect_after(string: signal_name, Callback: func) -> None."
      "  Listen to diagram events in ['object_add', 'object_remove']."},
+    {"get_memory_usage", (PyCFunction)PyDiaDiagramData_GetMemoryUsage, METH_VARARGS,
+     "get_memory_usage() -> dict.  The bytes used by the objects as 'total', 'objects',"
+     " 'undo' and lists of (name, objects, bytes) for 'layers' and 'types'."},
     {NULL, 0, 0, NULL}
 };
 
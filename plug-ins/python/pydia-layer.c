@@ -127,6 +127,46 @@ PyDiaLayer_AddObject (PyDiaLayer *self, PyObject *args)
 }
 
 
+static PyObject *
+PyDiaLayer_AddObjects (PyDiaLayer *self, PyObject *args)
+{
+  DiagramData *dia = dia_layer_get_parent_diagram (self->layer);
+  PyObject *lst;
+  GList *list = NULL;
+  Py_ssize_t i, len;
+
+  if (!PyArg_ParseTuple (args, "O!:Layer.add_objects",
+                         &PyList_Type, &lst)) {
+    return NULL;
+  }
+
+  len = PyList_Size (lst);
+  for (i = 0; i < len; i++) {
+    PyObject *o = PyList_GetItem (lst, i);
+
+    if (!PyDiaObject_Check (o)) {
+      PyErr_SetString (PyExc_TypeError, "Only DiaObjects can be added.");
+      g_list_free (list);
+      return NULL;
+    }
+
+    list = g_list_prepend (list, ((PyDiaObject *) o)->object);
+  }
+  list = g_list_reverse (list);
+
+  if (dia) {
+    dia_diagram_data_begin_bulk_add (dia);
+  }
+  /* the layer takes the list */
+  dia_layer_add_objects (self->layer, list);
+  if (dia) {
+    dia_diagram_data_end_bulk_add (dia);
+  }
+
+  Py_RETURN_NONE;
+}
+
+
 static PyObject *
 PyDiaLayer_RemoveObject (PyDiaLayer *self, PyObject *args)
 {
@@ -274,6 +314,9 @@ static PyMethodDef PyDiaLayer_Methods[] = {
   { "add_object", (PyCFunction) PyDiaLayer_AddObject, METH_VARARGS,
     "add_object(Object: o[, int: position]) -> None."
     "  Add the object to the layer at the top or the given position counting from bottom."},
+  { "add_objects", (PyCFunction) PyDiaLayer_AddObjects, METH_VARARGS,
+    "add_objects(list: objects) -> None."
+    "  Add the objects to the top of the layer, with a single notification."},
   { "remove_object", (PyCFunction) PyDiaLayer_RemoveObject, METH_VARARGS,
     "remove_object(Object: o) -> None"
     "  Remove the object from the layer and delete it."},
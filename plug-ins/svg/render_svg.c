@@ -189,7 +189,8 @@ end_render (DiaRenderer *self)
  * Some objects drawing adapts to capabilities advertised by the respective
  * renderer. Usually there is a fallback, but generally the real thing should
  * be better. The SVG renderer preserves holes, transparency, handles affine
- * transformation and also gradients.
+ * transformation and also gradients. Repeated drawings can be shared as
+ * symbols referenced by <use>.
  *
  * \memberof _SvgRenderer
  */
@@ -204,6 +205,8 @@ is_capable_to (DiaRenderer *renderer, RenderCapability cap)
     return TRUE;
   else if (RENDER_PATTERN == cap)
     return TRUE;
+  else if (RENDER_SYMBOLS == cap)
+    return TRUE;
   return FALSE;
 }
 
@@ -323,10 +326,21 @@ draw_layer (DiaRenderer  *self,
                 (xmlChar *) dia_layer_get_name (layer));
   }
 
+  /* when streaming the objects are written by draw_object() */
+  if (renderer->output) {
+    dia_svg_renderer_stream_start_tag (renderer, layer_group);
+  }
+
   DIA_RENDERER_CLASS (parent_class)->draw_layer (self, layer, active, update);
 
   renderer->root = g_queue_pop_tail (svg_renderer->parents);
-  xmlAddChild (renderer->root, layer_group);
+  if (renderer->output) {
+    dia_svg_renderer_stream_children (renderer, layer_group);
+    dia_svg_renderer_stream_end_tag (renderer, layer_group);
+    xmlFreeNode (layer_group);
+  } else {
+    xmlAddChild (renderer->root, layer_group);
+  }
 }
 /*!
  * \brief Wrap every object in \<g\>\</g\> and apply transformation
@@ -411,6 +425,11 @@ draw_object(DiaRenderer *self,
       xmlAddChild (renderer->root, group);
     }
   }
+
+  /* a top level object is done, no need to keep it around */
+  if (renderer->output && g_queue_get_length (svg_renderer->parents) == 1) {
+    dia_svg_renderer_stream_children (renderer, renderer->root);
+  }
 }
 
 #define dia_svg_dtostr(buf,d) \
@@ -476,7 +495,7 @@ node_set_text_style (xmlNodePtr      node,
                              dia_font_get_slant_string (font),
                              dia_font_get_weight_string (font));
   }
-  xmlSetProp (node, (xmlChar *) "style", (xmlChar *) style->str);
+  dia_svg_renderer_set_style (renderer, node, style->str);
   g_string_free (style, TRUE);
 }
 
@@ -683,8 +702,24 @@ export_svg (DiagramData *data,
             void        *user_data)
 {
   DiaSvgRenderer *renderer;
+  gboolean compact = GPOINTER_TO_INT (user_data);
 
   if ((renderer = new_svg_renderer (data, filename))) {
+    if (compact) {
+      dia_svg_renderer_set_share_styles (renderer, TRUE);
+      if (!dia_svg_renderer_open_stream (renderer)) {
+        dia_context_add_message_with_errno (ctx,
+                                            errno,
+                                            _("Can't open output file %s"),
+                                            dia_context_get_filename (ctx));
+        xmlFreeDoc (renderer->doc);
+        g_clear_pointer (&renderer->filename, g_free);
+        g_clear_object (&renderer);
+
+        return FALSE;
+      }
+    }
+
     data_render (data, DIA_RENDERER (renderer), NULL, NULL, NULL);
 
     g_clear_object (&renderer);
@@ -704,3 +739,14 @@ DiaExportFilter svg_export_filter = {
   NULL, /* user_data */
   "dia-svg"
 };
+
+/* The same, but written while rendering and with styles as classes,
+ * for big diagrams */
+DiaExportFilter svg_compact_export_filter = {
+  N_("Scalable Vector Graphics (compact)"),
+  extensions,
+  export_svg,
+  GINT_TO_POINTER (TRUE), /* user_data */
+  "dia-svg-compact",
+  FILTER_DONT_GUESS
+};
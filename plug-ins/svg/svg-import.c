@@ -2240,6 +2240,8 @@ import_svg (xmlDocPtr doc, DiagramData *dia,
     else
       groups_to_layers = FALSE;
   }
+  /* one notification and extents update for all of them */
+  dia_diagram_data_begin_bulk_add (dia);
   for (item = items; item != NULL; item = g_list_next (item)) {
     DiaObject *obj = (DiaObject *)item->data;
 
@@ -2258,7 +2260,6 @@ import_svg (xmlDocPtr doc, DiagramData *dia,
       DiaLayer *active = dia_diagram_data_get_active_layer (dia);
       /* Just as before: throw it in the active layer */
       dia_layer_add_object (active, obj);
-      dia_layer_update_extents (active);
     }
   }
 
@@ -2266,6 +2267,7 @@ import_svg (xmlDocPtr doc, DiagramData *dia,
 
   if (shape_root)
     import_shape_info (shape_root->xmlChildrenNode, dia, ctx);
+  dia_diagram_data_end_bulk_add (dia);
 
   xmlFreeDoc(doc);
   /* set 'display' setting */
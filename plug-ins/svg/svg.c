@@ -38,6 +38,7 @@
  */
 
 extern DiaExportFilter svg_export_filter;
+extern DiaExportFilter svg_compact_export_filter;
 extern DiaImportFilter svg_import_filter;
 
 DIA_PLUGIN_CHECK_INIT
@@ -52,6 +53,7 @@ static void
 _plugin_unload (PluginInfo *info)
 {
   filter_unregister_export(&svg_export_filter);
+  filter_unregister_export(&svg_compact_export_filter);
   filter_unregister_import(&svg_import_filter);
 }
 
@@ -65,6 +67,7 @@ dia_plugin_init(PluginInfo *info)
     return DIA_PLUGIN_INIT_ERROR;
 
   filter_register_export(&svg_export_filter);
+  filter_register_export(&svg_compact_export_filter);
   filter_register_import(&svg_import_filter);
 
   return DIA_PLUGIN_INIT_OK;
@@ -33,6 +33,7 @@
 #include <ctype.h>
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include <libxml/xmlmemory.h>
 #include <float.h>
 #include <locale.h>
@@ -43,6 +44,7 @@
 #include "properties.h"
 #include "propinternals.h"
 #include "dia_xml_libxml.h"
+#include "dia_xml.h"
 #include "create.h"
 #include "group.h"
 #include "font.h"
@@ -2848,51 +2850,102 @@ vdx_setup_layers (struct vdx_PageSheet *PageSheet,
   g_clear_object (&diaLayer);
 }
 
+/** Move the reader to the next child element
+ * @param reader the reader, on the parent element or a previous child
+ * @param depth the depth of the parent element
+ * @param first TRUE if the reader is still on the parent element
+ * @returns TRUE if the reader is on a child element, FALSE at the end of the parent
+ */
+static gboolean
+vdx_reader_next_child(xmlTextReaderPtr reader, int depth, gboolean first)
+{
+    int ret;
+
+    if (first)
+        ret = xmlTextReaderIsEmptyElement(reader) ? 0 : xmlTextReaderRead(reader);
+    else
+        ret = xmlTextReaderNext(reader); /* skips what's left of the child */
+
+    while (ret == 1 && xmlTextReaderDepth(reader) > depth)
+    {
+        if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
+            return TRUE;
+        ret = xmlTextReaderNext(reader);
+    }
+    return FALSE;
+}
+
+/** Parse the current element completely and keep it until the import is done
+ * @param reader the reader
+ * @returns the element, the internal representations point into it
+ */
+static xmlNodePtr
+vdx_reader_keep(xmlTextReaderPtr reader)
+{
+    if (!xmlTextReaderExpand(reader))
+        return NULL;
+    return xmlTextReaderPreserve(reader);
+}
+
 /** Parse the pages of the VDX
- * @param cur current XML node
+ * Only the page sheets are kept, every shape is converted and forgotten
+ * before the next one is read. Shapes are where the size of a document is.
+ * @param reader the reader, on the Pages element
  * @param theDoc the document
  * @param dia the growing diagram
  * @param ctx the context for error/warning messages
  */
 static void
-vdx_get_pages(xmlNodePtr cur, VDXDocument* theDoc, DiagramData *dia, DiaContext *ctx)
+vdx_get_pages(xmlTextReaderPtr reader, VDXDocument* theDoc, DiagramData *dia, DiaContext *ctx)
 {
-    xmlNodePtr Page;
-    xmlNodePtr Shapes;
+    int pages_depth = xmlTextReaderDepth(reader);
+    gboolean more;
 
-    for (Page = cur->xmlChildrenNode; Page; Page = Page->next)
+    for (more = vdx_reader_next_child(reader, pages_depth, TRUE); more;
+         more = vdx_reader_next_child(reader, pages_depth, FALSE))
     {
         struct vdx_PageSheet PageSheet;
-        xmlAttrPtr attr;
+        xmlChar *attr;
         gboolean background = FALSE;
+        int page_depth = xmlTextReaderDepth(reader);
+        gboolean more_shapes;
         memset(&PageSheet, 0, sizeof(PageSheet));
-        if (xmlIsBlankNode(Page)) { continue; }
 
-        for (Shapes = Page->xmlChildrenNode; Shapes; Shapes = Shapes->next)
+        attr = xmlTextReaderGetAttribute(reader, (const xmlChar *)"Background");
+        if (attr)
+        {
+            background = TRUE;
+            xmlFree(attr);
+        }
+
+        for (more_shapes = vdx_reader_next_child(reader, page_depth, TRUE); more_shapes;
+             more_shapes = vdx_reader_next_child(reader, page_depth, FALSE))
         {
-            xmlNodePtr Shape;
-            if (xmlIsBlankNode(Shapes)) { continue; }
-            if (!strcmp((char *)Shapes->name, "PageSheet")) {
-                vdx_read_object(Shapes, theDoc, &PageSheet, ctx);
-                vdx_setup_layers(&PageSheet, theDoc, dia);
+            const char *name = (const char *)xmlTextReaderConstLocalName(reader);
+            int shapes_depth = xmlTextReaderDepth(reader);
+            gboolean more_shape;
+
+            if (!strcmp(name, "PageSheet")) {
+                xmlNodePtr Shapes = vdx_reader_keep(reader);
+                if (Shapes)
+                {
+                    vdx_read_object(Shapes, theDoc, &PageSheet, ctx);
+                    vdx_setup_layers(&PageSheet, theDoc, dia);
+                }
                 continue;
             }
 
-            if (strcmp((char *)Shapes->name, "Shapes")) {
+            if (strcmp(name, "Shapes")) {
                 /* Ignore non-shapes for now */
                 continue;
             }
-            for (Shape = Shapes->xmlChildrenNode; Shape; Shape=Shape->next)
-            {
-                if (xmlIsBlankNode(Shape)) { continue; }
-                vdx_parse_shape(Shape, &PageSheet, theDoc, dia, ctx);
-            }
-        }
-        for (attr = Page->properties; attr; attr = attr->next)
-        {
-            if (!strcmp((char *)attr->name, "Background"))
+            for (more_shape = vdx_reader_next_child(reader, shapes_depth, TRUE); more_shape;
+                 more_shape = vdx_reader_next_child(reader, shapes_depth, FALSE))
             {
-                background = TRUE;
+                /* freed by the reader when moving on */
+                xmlNodePtr Shape = xmlTextReaderExpand(reader);
+                if (Shape)
+                    vdx_parse_shape(Shape, &PageSheet, theDoc, dia, ctx);
             }
         }
         if (!background) theDoc->Page++;
@@ -2940,7 +2993,24 @@ vdx_free(VDXDocument *theDoc)
 }
 
 
+/** Free the reader and the copy of the file it was reading, if any
+ * @param reader the reader
+ * @param fixed the copy from dia_xml_file_fix_encoding() or NULL
+ */
+static void
+vdx_reader_close(xmlTextReaderPtr reader, char *fixed)
+{
+    if (reader) xmlFreeTextReader(reader);
+    if (fixed)
+    {
+        g_unlink(fixed);
+        g_free(fixed);
+    }
+}
+
 /** Imports the given file
+ * The file is read as a stream, only the document level sections are
+ * kept while the pages are converted.
  * @param filename the file to read
  * @param dia the diagram
  * @param user_data unused
@@ -2949,46 +3019,53 @@ vdx_free(VDXDocument *theDoc)
 static gboolean
 import_vdx (const char *filename, DiagramData *dia, DiaContext *ctx, void* user_data)
 {
-    const xmlError *error_xml = NULL;
-    xmlDocPtr doc = xmlDoParseFile(filename, &error_xml);
-    xmlNodePtr root, cur;
+    /* like diaXmlParseFile() for files without encoding declaration */
+    char *fixed = dia_xml_file_fix_encoding(filename, ctx);
+    xmlTextReaderPtr reader = xmlReaderForFile(fixed ? fixed : filename, NULL, 0);
+    xmlDocPtr doc;
+    xmlNodePtr cur;
     struct VDXDocument *theDoc;
     const char *s;
+    const char *ns;
     int visio_version = 0;
     const char *debug = 0;
     unsigned int debug_shapes = 0;
     char* old_locale;
+    gboolean more;
+    gboolean ok;
+    int ret = -1;
 
-    if (!doc) {
-        dia_context_add_message(ctx, _("VDX parser error for %s\n%s"),
-				error_xml ? error_xml->message : "",
-				dia_context_get_filename(ctx));
-        return FALSE;
-    }
     /* skip comments */
-    for (root = doc->xmlRootNode; root; root = root->next)
+    while (reader && (ret = xmlTextReaderRead(reader)) == 1)
     {
-        if (root->type == XML_ELEMENT_NODE) { break; }
+        if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) { break; }
     }
-    if (!root || xmlIsBlankNode(root))
+    if (ret != 1)
     {
-        dia_context_add_message(ctx, _("Nothing in document!"));
+        const xmlError *error_xml = xmlGetLastError();
+
+        if (ret == 0)
+            dia_context_add_message(ctx, _("Nothing in document!"));
+        else
+            dia_context_add_message(ctx, _("VDX parser error for %s\n%s"),
+                                    error_xml ? error_xml->message : "",
+                                    dia_context_get_filename(ctx));
+        vdx_reader_close(reader, fixed);
         return FALSE;
     }
-    if (strcmp((char *)root->name, "VisioDocument"))
+    s = (const char *)xmlTextReaderConstLocalName(reader);
+    if (strcmp(s, "VisioDocument"))
     {
-        dia_context_add_message(ctx, _("Expecting VisioDocument, got %s"), root->name);
+        dia_context_add_message(ctx, _("Expecting VisioDocument, got %s"), s);
+        vdx_reader_close(reader, fixed);
         return FALSE;
     }
-    if (root->ns && root->ns->href &&
-        !strcmp((char *)root->ns->href,
-               "urn:schemas-microsoft-com:office:visio"))
+    ns = (const char *)xmlTextReaderConstNamespaceUri(reader);
+    if (ns && !strcmp(ns, "urn:schemas-microsoft-com:office:visio"))
     {
         visio_version = 2002;
     }
-    if (root->ns && root->ns->href &&
-        !strcmp((char *)root->ns->href,
-                "http://schemas.microsoft.com/visio/2003/core"))
+    if (ns && !strcmp(ns, "http://schemas.microsoft.com/visio/2003/core"))
     {
         visio_version = 2003;
     }
@@ -3034,27 +3111,51 @@ import_vdx (const char *filename, DiagramData *dia, DiaContext *ctx, void* user_
     if (theDoc->debug_comments)
         g_debug("Visio version = %d", visio_version);
 
-    for (cur = root->xmlChildrenNode; cur; cur = cur->next)
+    for (more = vdx_reader_next_child(reader, 0, TRUE); more;
+         more = vdx_reader_next_child(reader, 0, FALSE))
     {
-        if (xmlIsBlankNode(cur)) { continue; }
-        s = (const char *)cur->name;
+        s = (const char *)xmlTextReaderConstLocalName(reader);
+        if (!strcmp(s, "Pages")) {
+            /* shapes are added one by one, announce them together */
+            dia_diagram_data_begin_bulk_add(dia);
+            vdx_get_pages(reader, theDoc, dia, ctx);
+            dia_diagram_data_end_bulk_add(dia);
+            continue;
+        }
+        if (strcmp(s, "Colors") && strcmp(s, "FaceNames") && strcmp(s, "Fonts") &&
+            strcmp(s, "Masters") && strcmp(s, "StyleSheets"))
+            continue;
+        /* the shapes refer to these */
+        cur = vdx_reader_keep(reader);
+        if (!cur) break;
         if (!strcmp(s, "Colors")) vdx_get_colors(cur, theDoc, ctx);
         if (!strcmp(s, "FaceNames")) vdx_get_facenames(cur, theDoc, ctx);
         if (!strcmp(s, "Fonts")) vdx_get_fonts(cur, theDoc, ctx);
         if (!strcmp(s, "Masters")) vdx_get_masters(cur, theDoc, ctx);
         if (!strcmp(s, "StyleSheets")) vdx_get_stylesheets(cur, theDoc, ctx);
-        if (!strcmp(s, "Pages")) vdx_get_pages(cur, theDoc, dia, ctx);
         /* if (!theDoc->ok) break; */
     }
 
+    ok = xmlTextReaderReadState(reader) != XML_TEXTREADER_MODE_ERROR;
+    if (!ok) {
+        const xmlError *error_xml = xmlGetLastError();
+
+        dia_context_add_message(ctx, _("VDX parser error for %s\n%s"),
+                                error_xml ? error_xml->message : "",
+                                dia_context_get_filename(ctx));
+    }
+
     /* Get rid of internal strings before returning */
     vdx_free(theDoc);
-    xmlFreeDoc(doc);
+    /* with preserved nodes the document is ours */
+    doc = xmlTextReaderCurrentDoc(reader);
+    vdx_reader_close(reader, fixed);
+    if (doc) xmlFreeDoc(doc);
 
     /* dont screw Dia's global state */
     setlocale(LC_NUMERIC, old_locale);
 
-    return TRUE;
+    return ok;
 }
 
 /* interface from filter.h */
@@ -1180,6 +1180,9 @@ export_data(DiagramData *data, DiaContext *ctx,
   renderer->XOffset = - extent->left;
   renderer->YOffset =   extent->bottom;
 #endif
+  /* Poly Curves are written as they are, only the filled beziergon
+   * is flattened by the base class, no need to be finer than a WPU */
+  g_object_set (renderer, "tolerance", 0.5 / renderer->Scale, NULL);
   renderer->Box.Width  = width * renderer->Scale;
   renderer->Box.Height = height * renderer->Scale;
   renderer->Box.Flag   = 0;
@@ -1275,6 +1275,8 @@ export_fig (DiagramData *data,
   }
 
   renderer = g_object_new (DIA_XFIG_TYPE_RENDERER, NULL);
+  /* no need to flatten curves finer than half a FIG unit */
+  g_object_set (renderer, "tolerance", 0.5 / figCoord (renderer, 1.0), NULL);
 
   renderer->file = file;
 
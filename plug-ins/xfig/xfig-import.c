@@ -1374,13 +1374,15 @@ import_fig(const gchar *filename, DiagramData *dia, DiaContext *ctx, void* user_
     }
   } while (TRUE);
 
-  /* Now we can reorder for the depth fields */
+  /* Now we can reorder for the depth fields, with a single notification */
+  dia_diagram_data_begin_bulk_add (dia);
   for (i = 0; i < FIG_MAX_DEPTHS; i++) {
     if (depths[i] != NULL) {
       dia_layer_add_objects_first (dia_diagram_data_get_active_layer (dia),
                                    depths[i]);
     }
   }
+  dia_diagram_data_end_bulk_add (dia);
 
   return TRUE;
 }
@@ -0,0 +1,1201 @@
+/* dia-bench.c -- Benchmarks on generated diagrams
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Generates a diagram with a configurable number and mix of objects and
+ * measures loading, saving, rendering, hit-testing, selection, the
+ * diagram tree, undo/redo and every export filter on it, as well as
+ * importing its Visio XML export and editing a single big UML class. The
+ * results are written as JSON, so they can be compared between releases:
+ *
+ *   dia-bench --objects 5000 --mix standard=4,uml=1 --output results.json
+ *
+ * Like the tests it needs DIA_LIB_PATH etc. to find the objects and
+ * plug-ins from the build tree, 'ninja bench' takes care of that.
+ */
+
+#include "config.h"
+
+#include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gtk/gtk.h>
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include "dialib.h"
+#include "plug-ins.h"
+#include "persistence.h"
+#include "preferences.h"
+#include "diagram.h"
+#include "load_save.h"
+#include "undo.h"
+#include "object_ops.h"
+#include "connectionpoint_ops.h"
+#include "properties.h"
+#include "dia-layer.h"
+#include "diagram_tree_model.h"
+#include "dia-version-info.h"
+#include "renderer/diacairo.h"
+
+/* the PNG export uses the same resolution */
+#define RENDER_PIXELS_PER_CM 20.0
+#define RENDER_MAX_PIXELS 4096
+#define HIT_TESTS_PER_ITERATION 1000
+#define UML_EDIT_MEMBERS 200
+#define UML_EDIT_RENAMES 20
+
+typedef enum {
+  BENCH_STANDARD,
+  BENCH_UML,
+  BENCH_CUSTOM,
+  BENCH_ORTHCONN,
+  BENCH_TEXT,
+  BENCH_N_KINDS
+} BenchKind;
+
+static const char *kind_names[BENCH_N_KINDS] = {
+  "standard", "uml", "custom", "orthconn", "text"
+};
+
+typedef struct _BenchMix {
+  const char *name;
+  int weights[BENCH_N_KINDS];
+} BenchMix;
+
+static const BenchMix mix_presets[] = {
+  { "mixed",    { 4, 1, 2, 2, 1 } },
+  { "standard", { 1, 0, 0, 0, 0 } },
+  { "uml",      { 0, 1, 0, 0, 0 } },
+  { "custom",   { 0, 0, 1, 0, 0 } },
+  { "orthconn", { 0, 0, 0, 1, 0 } },
+  { "text",     { 0, 0, 0, 0, 1 } },
+};
+
+static const char *custom_shapes[] = {
+  "Flowchart - Document",
+  "Flowchart - Terminal",
+  "Flowchart - Magnetic Disk",
+  "Flowchart - Predefined Process",
+};
+
+static const char *words[] = {
+  "diagram", "object", "layer", "connection", "handle", "renderer",
+  "export", "property", "text", "shape", "arrow", "line", "box",
+  "ellipse", "class", "attribute", "operation", "parameter", "zoom",
+  "grid", "guide", "page", "font", "color",
+};
+
+static const char *fill_colors[] = {
+  "#ffffff", "#ffe0e0", "#e0ffe0", "#e0e0ff", "#ffffc0",
+};
+
+typedef struct _BenchRun {
+  int          iterations;
+  char        *tmpdir;
+  char        *filename;
+  DiagramData *data;     /* for the read-only benchmarks */
+  Diagram     *diagram;  /* for selection and undo, which need the app */
+  GString     *results;
+  int          n_results;
+} BenchRun;
+
+typedef void (*BenchFunc) (BenchRun *run);
+
+static int      opt_objects = 1000;
+static char    *opt_mix = NULL;
+static int      opt_seed = 1;
+static int      opt_iterations = 5;
+static char    *opt_output = NULL;
+static char    *opt_generate = NULL;
+static char   **opt_benchmarks = NULL;
+static char   **opt_filters = NULL;
+
+static GOptionEntry entries[] = {
+  { "objects", 'n', 0, G_OPTION_ARG_INT, &opt_objects,
+    "Number of generated objects (connections come with two boxes)", "N" },
+  { "mix", 'm', 0, G_OPTION_ARG_STRING, &opt_mix,
+    "Preset (mixed, standard, uml, custom, orthconn, text) or weights like standard=4,text=1", "MIX" },
+  { "seed", 's', 0, G_OPTION_ARG_INT, &opt_seed,
+    "Seed for the generator", "SEED" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &opt_iterations,
+    "Repetitions of every benchmark", "N" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
+    "Write the JSON results to FILE instead of stdout", "FILE" },
+  { "generate", 'g', 0, G_OPTION_ARG_FILENAME, &opt_generate,
+    "Only write the generated diagram to FILE", "FILE" },
+  { "benchmark", 'b', 0, G_OPTION_ARG_STRING_ARRAY, &opt_benchmarks,
+    "Run only the given benchmark, may be repeated", "NAME" },
+  { "filter", 'f', 0, G_OPTION_ARG_STRING_ARRAY, &opt_filters,
+    "Export only with the given filter, may be repeated", "NAME" },
+  { NULL }
+};
+
+
+/* Generators, writing the diagram in the native format */
+
+static void
+_append_real (GString *xml, double val)
+{
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_string_append (xml, g_ascii_formatd (buf, sizeof (buf), "%g", val));
+}
+
+static void
+_begin_object (GString *xml, const char *type, int version, int id)
+{
+  g_string_append_printf (xml,
+                          "    <dia:object type=\"%s\" version=\"%d\" id=\"O%d\">\n",
+                          type, version, id);
+}
+
+static void
+_end_object (GString *xml)
+{
+  g_string_append (xml, "    </dia:object>\n");
+}
+
+static void
+_append_point (GString *xml, double x, double y)
+{
+  g_string_append (xml, "<dia:point val=\"");
+  _append_real (xml, x);
+  g_string_append_c (xml, ',');
+  _append_real (xml, y);
+  g_string_append (xml, "\"/>");
+}
+
+static void
+_attr_point (GString *xml, const char *name, double x, double y)
+{
+  g_string_append_printf (xml, "      <dia:attribute name=\"%s\">", name);
+  _append_point (xml, x, y);
+  g_string_append (xml, "</dia:attribute>\n");
+}
+
+static void
+_attr_points (GString *xml, const char *name, const double *xy, int n)
+{
+  int i;
+
+  g_string_append_printf (xml, "      <dia:attribute name=\"%s\">", name);
+  for (i = 0; i < n; i++) {
+    _append_point (xml, xy[2 * i], xy[2 * i + 1]);
+  }
+  g_string_append (xml, "</dia:attribute>\n");
+}
+
+static void
+_attr_real (GString *xml, const char *name, double val)
+{
+  g_string_append_printf (xml, "      <dia:attribute name=\"%s\"><dia:real val=\"", name);
+  _append_real (xml, val);
+  g_string_append (xml, "\"/></dia:attribute>\n");
+}
+
+static void
+_attr_color (GString *xml, const char *name, const char *color)
+{
+  g_string_append_printf (xml,
+                          "      <dia:attribute name=\"%s\"><dia:color val=\"%s\"/></dia:attribute>\n",
+                          name, color);
+}
+
+static void
+_attr_element (GString *xml, double x, double y, double width, double height)
+{
+  _attr_point (xml, "elem_corner", x, y);
+  _attr_real (xml, "elem_width", width);
+  _attr_real (xml, "elem_height", height);
+}
+
+/* the strings only consist of words[], nothing to escape */
+static void
+_append_words (GString *str, GRand *rand, int count, int per_line)
+{
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (i > 0) {
+      g_string_append_c (str, (i % per_line) == 0 ? '\n' : ' ');
+    }
+    g_string_append (str, words[g_rand_int_range (rand, 0, G_N_ELEMENTS (words))]);
+  }
+}
+
+static int
+_gen_standard (GString *xml, GRand *rand, int id, double x, double y)
+{
+  switch (id % 4) {
+    case 0:
+      _begin_object (xml, "Standard - Box", 0, id);
+      _attr_element (xml, x, y, 4.0, 2.5);
+      _attr_color (xml, "inner_color",
+                   fill_colors[g_rand_int_range (rand, 0, G_N_ELEMENTS (fill_colors))]);
+      break;
+    case 1:
+      _begin_object (xml, "Standard - Ellipse", 0, id);
+      _attr_element (xml, x, y, 4.0, 3.0);
+      break;
+    case 2:
+      {
+        double xy[] = { x, y, x + 5.0, y + g_rand_double_range (rand, 0.0, 4.0) };
+
+        _begin_object (xml, "Standard - Line", 0, id);
+        _attr_points (xml, "conn_endpoints", xy, 2);
+      }
+      break;
+    default:
+      {
+        double xy[10];
+        int i;
+
+        for (i = 0; i < 5; i++) {
+          xy[2 * i] = x + 2.5 + 2.5 * cos (i * 4.0 * G_PI / 5.0);
+          xy[2 * i + 1] = y + 2.5 + 2.5 * sin (i * 4.0 * G_PI / 5.0);
+        }
+        _begin_object (xml, "Standard - Polygon", 0, id);
+        _attr_points (xml, "poly_points", xy, 5);
+      }
+      break;
+  }
+  _end_object (xml);
+
+  return 1;
+}
+
+static void
+_gen_uml_class (GString *xml,
+                GRand   *rand,
+                int      id,
+                double   x,
+                double   y,
+                int      n_attributes,
+                int      n_operations)
+{
+  int i;
+
+  _begin_object (xml, "UML - Class", 0, id);
+  _attr_point (xml, "elem_corner", x, y);
+  g_string_append_printf (xml,
+                          "      <dia:attribute name=\"name\"><dia:string>#Class%d#</dia:string></dia:attribute>\n",
+                          id);
+
+  g_string_append (xml, "      <dia:attribute name=\"attributes\">\n");
+  for (i = 0; i < n_attributes; i++) {
+    g_string_append_printf (xml,
+                            "        <dia:composite type=\"umlattribute\">"
+                            "<dia:attribute name=\"name\"><dia:string>#%s%d#</dia:string></dia:attribute>"
+                            "<dia:attribute name=\"type\"><dia:string>#int#</dia:string></dia:attribute>"
+                            "<dia:attribute name=\"visibility\"><dia:enum val=\"%d\"/></dia:attribute>"
+                            "</dia:composite>\n",
+                            words[g_rand_int_range (rand, 0, G_N_ELEMENTS (words))], i,
+                            i % 3);
+  }
+  g_string_append (xml, "      </dia:attribute>\n");
+
+  g_string_append (xml, "      <dia:attribute name=\"operations\">\n");
+  for (i = 0; i < n_operations; i++) {
+    g_string_append_printf (xml,
+                            "        <dia:composite type=\"umloperation\">"
+                            "<dia:attribute name=\"name\"><dia:string>#%s%d#</dia:string></dia:attribute>"
+                            "<dia:attribute name=\"type\"><dia:string>#void#</dia:string></dia:attribute>"
+                            "<dia:attribute name=\"parameters\">"
+                            "<dia:composite type=\"umlparameter\">"
+                            "<dia:attribute name=\"name\"><dia:string>#arg#</dia:string></dia:attribute>"
+                            "<dia:attribute name=\"type\"><dia:string>#double#</dia:string></dia:attribute>"
+                            "</dia:composite>"
+                            "</dia:attribute>"
+                            "</dia:composite>\n",
+                            words[g_rand_int_range (rand, 0, G_N_ELEMENTS (words))], i);
+  }
+  g_string_append (xml, "      </dia:attribute>\n");
+  _end_object (xml);
+}
+
+static int
+_gen_uml (GString *xml, GRand *rand, int id, double x, double y)
+{
+  int n_attributes = g_rand_int_range (rand, 2, 8);
+  int n_operations = g_rand_int_range (rand, 1, 6);
+
+  _gen_uml_class (xml, rand, id, x, y, n_attributes, n_operations);
+
+  return 1;
+}
+
+static int
+_gen_custom (GString *xml, GRand *rand, int id, double x, double y)
+{
+  _begin_object (xml, custom_shapes[id % G_N_ELEMENTS (custom_shapes)], 1, id);
+  _attr_element (xml, x, y, 4.0, 3.0);
+  _attr_color (xml, "inner_color",
+               fill_colors[g_rand_int_range (rand, 0, G_N_ELEMENTS (fill_colors))]);
+  _end_object (xml);
+
+  return 1;
+}
+
+/* two boxes and a zigzagline connecting the right side of the first with
+ * the left side of the second */
+static int
+_gen_orthconn (GString *xml, GRand *rand, int id, double x, double y)
+{
+  double dy = g_rand_double_range (rand, 0.0, 4.0);
+  double xy[] = {
+    x + 2.0, y + 0.5,
+    x + 3.5, y + 0.5,
+    x + 3.5, y + dy + 0.5,
+    x + 5.0, y + dy + 0.5
+  };
+
+  _begin_object (xml, "Standard - Box", 0, id);
+  _attr_element (xml, x, y, 2.0, 1.0);
+  _end_object (xml);
+
+  _begin_object (xml, "Standard - Box", 0, id + 1);
+  _attr_element (xml, x + 5.0, y + dy, 2.0, 1.0);
+  _end_object (xml);
+
+  _begin_object (xml, "Standard - ZigZagLine", 1, id + 2);
+  _attr_points (xml, "orth_points", xy, 4);
+  g_string_append (xml,
+                   "      <dia:attribute name=\"orth_orient\">"
+                   "<dia:enum val=\"0\"/><dia:enum val=\"1\"/><dia:enum val=\"0\"/>"
+                   "</dia:attribute>\n"
+                   "      <dia:attribute name=\"autorouting\"><dia:boolean val=\"false\"/></dia:attribute>\n"
+                   "      <dia:attribute name=\"end_arrow\"><dia:enum val=\"3\"/></dia:attribute>\n");
+  g_string_append_printf (xml,
+                          "      <dia:connections>\n"
+                          "        <dia:connection handle=\"0\" to=\"O%d\" connection=\"4\"/>\n"
+                          "        <dia:connection handle=\"1\" to=\"O%d\" connection=\"3\"/>\n"
+                          "      </dia:connections>\n",
+                          id, id + 1);
+  _end_object (xml);
+
+  return 3;
+}
+
+static int
+_gen_text (GString *xml, GRand *rand, int id, double x, double y)
+{
+  GString *str = g_string_new (NULL);
+
+  _append_words (str, rand, g_rand_int_range (rand, 20, 60), 6);
+
+  _begin_object (xml, "Standard - Text", 1, id);
+  g_string_append (xml,
+                   "      <dia:attribute name=\"text\"><dia:composite type=\"text\">\n"
+                   "        <dia:attribute name=\"string\"><dia:string>#");
+  g_string_append (xml, str->str);
+  g_string_append (xml,
+                   "#</dia:string></dia:attribute>\n"
+                   "        <dia:attribute name=\"font\"><dia:font family=\"sans\" style=\"0\" name=\"Helvetica\"/></dia:attribute>\n");
+  _attr_real (xml, "height", 0.5);
+  _attr_point (xml, "pos", x, y + 0.5);
+  g_string_append (xml, "      </dia:composite></dia:attribute>\n");
+  _end_object (xml);
+
+  g_string_free (str, TRUE);
+
+  return 1;
+}
+
+static gboolean
+_parse_mix (const char *spec, int weights[BENCH_N_KINDS])
+{
+  char **parts;
+  int total = 0;
+  guint i;
+  int k;
+
+  for (i = 0; i < G_N_ELEMENTS (mix_presets); i++) {
+    if (g_strcmp0 (spec, mix_presets[i].name) == 0) {
+      memcpy (weights, mix_presets[i].weights, sizeof (int) * BENCH_N_KINDS);
+      return TRUE;
+    }
+  }
+
+  memset (weights, 0, sizeof (int) * BENCH_N_KINDS);
+  parts = g_strsplit (spec, ",", -1);
+  for (i = 0; parts[i] != NULL; i++) {
+    char **kv = g_strsplit (parts[i], "=", 2);
+    gboolean found = FALSE;
+
+    for (k = 0; k < BENCH_N_KINDS && kv[0] && kv[1]; k++) {
+      if (g_strcmp0 (g_strstrip (kv[0]), kind_names[k]) == 0) {
+        weights[k] = MAX (0, atoi (kv[1]));
+        total += weights[k];
+        found = TRUE;
+      }
+    }
+    g_strfreev (kv);
+
+    if (!found) {
+      g_printerr ("Unknown mix '%s'\n", parts[i]);
+      g_strfreev (parts);
+      return FALSE;
+    }
+  }
+  g_strfreev (parts);
+
+  return total > 0;
+}
+
+static char *
+_generate_diagram (int n_objects, const int weights[BENCH_N_KINDS], guint32 seed)
+{
+  GRand *rand = g_rand_new_with_seed (seed);
+  GString *xml = g_string_sized_new (n_objects * 600);
+  int columns = MAX (1, (int) ceil (sqrt (n_objects)));
+  int total = 0;
+  int id = 0;
+  int cell;
+  int k;
+
+  for (k = 0; k < BENCH_N_KINDS; k++) {
+    total += weights[k];
+  }
+
+  g_string_append (xml,
+                   "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<dia:diagram xmlns:dia=\"http://www.lysator.liu.se/~alla/dia/\">\n"
+                   "  <dia:layer name=\"Background\" visible=\"true\" active=\"true\">\n");
+
+  for (cell = 0; id < n_objects; cell++) {
+    double x = (cell % columns) * 10.0;
+    double y = (cell / columns) * 8.0;
+    int pick = g_rand_int_range (rand, 0, total);
+
+    for (k = 0; k < BENCH_N_KINDS - 1; k++) {
+      if (pick < weights[k]) {
+        break;
+      }
+      pick -= weights[k];
+    }
+
+    switch (k) {
+      case BENCH_STANDARD:
+        id += _gen_standard (xml, rand, id, x, y);
+        break;
+      case BENCH_UML:
+        id += _gen_uml (xml, rand, id, x, y);
+        break;
+      case BENCH_CUSTOM:
+        id += _gen_custom (xml, rand, id, x, y);
+        break;
+      case BENCH_ORTHCONN:
+        id += _gen_orthconn (xml, rand, id, x, y);
+        break;
+      case BENCH_TEXT:
+      default:
+        id += _gen_text (xml, rand, id, x, y);
+        break;
+    }
+  }
+
+  g_string_append (xml,
+                   "  </dia:layer>\n"
+                   "</dia:diagram>\n");
+
+  g_rand_free (rand);
+
+  return g_string_free (xml, FALSE);
+}
+
+
+/* Results */
+
+static void
+_json_string (GString *json, const char *str)
+{
+  const char *p;
+
+  g_string_append_c (json, '"');
+  for (p = str; *p; p++) {
+    if (*p == '"' || *p == '\\') {
+      g_string_append_c (json, '\\');
+      g_string_append_c (json, *p);
+    } else if ((guchar) *p < 0x20) {
+      g_string_append_printf (json, "\\u%04x", (guchar) *p);
+    } else {
+      g_string_append_c (json, *p);
+    }
+  }
+  g_string_append_c (json, '"');
+}
+
+static int
+_compare_double (gconstpointer a, gconstpointer b)
+{
+  double da = *(const double *) a;
+  double db = *(const double *) b;
+
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static void
+_report (BenchRun   *run,
+         const char *name,
+         const char *filter,
+         double     *seconds,
+         int         n,
+         int         operations)
+{
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+  double sum = 0.0;
+  int i;
+
+  if (n == 0) {
+    return;
+  }
+
+  for (i = 0; i < n; i++) {
+    sum += seconds[i];
+  }
+  qsort (seconds, n, sizeof (double), _compare_double);
+
+  g_string_append (run->results, run->n_results++ > 0 ? ",\n    {" : "\n    {");
+  g_string_append (run->results, "\"name\": ");
+  _json_string (run->results, name);
+  if (filter) {
+    g_string_append (run->results, ", \"filter\": ");
+    _json_string (run->results, filter);
+  }
+  g_string_append_printf (run->results,
+                          ", \"iterations\": %d, \"operations\": %d", n, operations);
+  g_string_append_printf (run->results, ", \"min\": %s",
+                          g_ascii_formatd (buf, sizeof (buf), "%.6f", seconds[0]));
+  g_string_append_printf (run->results, ", \"median\": %s",
+                          g_ascii_formatd (buf, sizeof (buf), "%.6f", seconds[n / 2]));
+  g_string_append_printf (run->results, ", \"mean\": %s}",
+                          g_ascii_formatd (buf, sizeof (buf), "%.6f", sum / n));
+
+  g_printerr ("%-24s %10.3f ms (min %.3f ms, %d x %d)\n",
+              filter ? filter : name,
+              seconds[n / 2] * 1000.0, seconds[0] * 1000.0, n, operations);
+}
+
+static DiaLayer *
+_bench_layer (DiagramData *data)
+{
+  return dia_diagram_data_get_active_layer (data);
+}
+
+
+/* Benchmarks */
+
+static void
+_bench_load (BenchRun *run)
+{
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  int i;
+
+  for (i = 0; i < run->iterations; i++) {
+    DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+    DiaContext *ctx = dia_context_new (_("Import"));
+    gboolean ok;
+
+    g_timer_start (timer);
+    ok = dia_import_filter.import_func (run->filename, data, ctx,
+                                        dia_import_filter.user_data);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+
+    g_clear_object (&data);
+    dia_context_release (ctx);
+
+    if (!ok) {
+      g_critical ("Loading '%s' failed", run->filename);
+      break;
+    }
+  }
+
+  _report (run, "load", NULL, seconds, i, 1);
+
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static void
+_bench_save (BenchRun *run)
+{
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  char *outname = g_build_filename (run->tmpdir, "save.dia", NULL);
+  int i;
+
+  for (i = 0; i < run->iterations; i++) {
+    DiaContext *ctx = dia_context_new (_("Export"));
+
+    dia_context_set_filename (ctx, outname);
+    g_timer_start (timer);
+    dia_export_filter.export_func (run->data, ctx, outname, run->filename,
+                                   dia_export_filter.user_data);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+    dia_context_release (ctx);
+  }
+
+  _report (run, "save", NULL, seconds, i, 1);
+
+  g_free (outname);
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static void
+_bench_render (BenchRun *run)
+{
+  DiagramData *data = run->data;
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  double width = data->extents.right - data->extents.left;
+  double height = data->extents.bottom - data->extents.top;
+  double scale = RENDER_PIXELS_PER_CM;
+  int i;
+
+  if (width * scale > RENDER_MAX_PIXELS) {
+    scale = RENDER_MAX_PIXELS / width;
+  }
+  if (height * scale > RENDER_MAX_PIXELS) {
+    scale = RENDER_MAX_PIXELS / height;
+  }
+
+  for (i = 0; i < run->iterations; i++) {
+    DiaCairoRenderer *renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+
+    renderer->dia = data;
+    renderer->scale = scale;
+    renderer->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                    (int) ceil (width * scale) + 1,
+                                                    (int) ceil (height * scale) + 1);
+
+    g_timer_start (timer);
+    data_render (data, DIA_RENDERER (renderer), NULL, NULL, NULL);
+    cairo_surface_flush (renderer->surface);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+
+    g_clear_object (&renderer);
+  }
+
+  _report (run, "render", NULL, seconds, i, 1);
+
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static void
+_bench_hit_test (BenchRun *run)
+{
+  DiagramData *data = run->data;
+  DiaLayer *layer = _bench_layer (data);
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  GRand *rand = g_rand_new_with_seed (opt_seed);
+  Point *points = g_new (Point, HIT_TESTS_PER_ITERATION);
+  int hits = 0;
+  int i, j;
+
+  for (j = 0; j < HIT_TESTS_PER_ITERATION; j++) {
+    points[j].x = g_rand_double_range (rand, data->extents.left, data->extents.right);
+    points[j].y = g_rand_double_range (rand, data->extents.top, data->extents.bottom);
+  }
+
+  for (i = 0; i < run->iterations; i++) {
+    g_timer_start (timer);
+    for (j = 0; j < HIT_TESTS_PER_ITERATION; j++) {
+      if (dia_layer_find_closest_object (layer, &points[j], 0.5)) {
+        hits++;
+      }
+    }
+    seconds[i] = g_timer_elapsed (timer, NULL);
+  }
+
+  _report (run, "hit-test", NULL, seconds, i, HIT_TESTS_PER_ITERATION);
+  g_debug ("%d hits", hits);
+
+  g_free (points);
+  g_rand_free (rand);
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static void
+_bench_select (BenchRun *run)
+{
+  Diagram *dia = run->diagram;
+  GList *objects = dia_layer_get_object_list (_bench_layer (DIA_DIAGRAM_DATA (dia)));
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  int i;
+
+  for (i = 0; i < run->iterations; i++) {
+    GList *list;
+
+    g_timer_start (timer);
+    for (list = objects; list != NULL; list = g_list_next (list)) {
+      diagram_select (dia, list->data);
+    }
+    diagram_remove_all_selected (dia, TRUE);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+  }
+
+  _report (run, "select", NULL, seconds, i, g_list_length (objects));
+
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static gboolean
+_tree_visit (GtkTreeModel *model,
+             GtkTreePath  *path,
+             GtkTreeIter  *iter,
+             gpointer      user_data)
+{
+  int *rows = user_data;
+  char *name = NULL;
+
+  gtk_tree_model_get (model, iter, NAME_COLUMN, &name, -1);
+  g_free (name);
+  (*rows)++;
+
+  return FALSE;
+}
+
+/* what the Diagram Tree does when opened and sorted by name */
+static void
+_bench_tree (BenchRun *run)
+{
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  int rows = 0;
+  int i;
+
+  for (i = 0; i < run->iterations; i++) {
+    GtkTreeModel *model;
+
+    rows = 0;
+    g_timer_start (timer);
+    model = diagram_tree_model_new ();
+    gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
+                                          NAME_COLUMN,
+                                          GTK_SORT_ASCENDING);
+    gtk_tree_model_foreach (model, _tree_visit, &rows);
+    g_clear_object (&model);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+  }
+
+  _report (run, "tree", NULL, seconds, i, rows);
+
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+/* move everything, the same as the arrow keys do, and measure undoing and
+ * redoing it */
+static void
+_bench_undo (BenchRun *run)
+{
+  Diagram *dia = run->diagram;
+  GList *objects = dia_layer_get_object_list (_bench_layer (DIA_DIAGRAM_DATA (dia)));
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  GList *list;
+  int i;
+
+  for (list = objects; list != NULL; list = g_list_next (list)) {
+    diagram_select (dia, list->data);
+  }
+  object_list_nudge (dia->data->selected, dia, DIR_RIGHT, 1.0);
+  diagram_update_connections_selection (dia);
+  undo_set_transactionpoint (dia->undo);
+
+  for (i = 0; i < run->iterations; i++) {
+    g_timer_start (timer);
+    undo_revert_to_last_tp (dia->undo);
+    undo_apply_to_next_tp (dia->undo);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+  }
+
+  _report (run, "undo-redo", NULL, seconds, i, g_list_length (objects));
+
+  undo_revert_to_last_tp (dia->undo);
+  undo_clear (dia->undo);
+  diagram_remove_all_selected (dia, TRUE);
+
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+/* rename a single class with many members, what the properties dialog does
+ * on every apply */
+static void
+_bench_uml_edit (BenchRun *run)
+{
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  GRand *rand = g_rand_new_with_seed (opt_seed);
+  GString *xml = g_string_new (NULL);
+  char *filename = g_build_filename (run->tmpdir, "uml-edit.dia", NULL);
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaContext *ctx = dia_context_new (_("Import"));
+  DiaObject *obj = NULL;
+  int i = 0;
+  int j;
+
+  g_string_append (xml,
+                   "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<dia:diagram xmlns:dia=\"http://www.lysator.liu.se/~alla/dia/\">\n"
+                   "  <dia:layer name=\"Background\" visible=\"true\" active=\"true\">\n");
+  _gen_uml_class (xml, rand, 0, 0.0, 0.0,
+                  UML_EDIT_MEMBERS / 4, UML_EDIT_MEMBERS);
+  g_string_append (xml,
+                   "  </dia:layer>\n"
+                   "</dia:diagram>\n");
+  g_file_set_contents (filename, xml->str, xml->len, NULL);
+
+  if (dia_import_filter.import_func (filename, data, ctx,
+                                     dia_import_filter.user_data)) {
+    obj = dia_layer_object_get_nth (_bench_layer (data), 0);
+  }
+
+  if (!obj) {
+    g_critical ("Loading '%s' failed", filename);
+  } else {
+    for (i = 0; i < run->iterations; i++) {
+      g_timer_start (timer);
+      for (j = 0; j < UML_EDIT_RENAMES; j++) {
+        char *name = g_strdup_printf ("Class%d", j);
+        DiaObjectChange *change = dia_object_set_string (obj, "name", name);
+
+        g_clear_pointer (&change, dia_object_change_unref);
+        g_free (name);
+      }
+      seconds[i] = g_timer_elapsed (timer, NULL);
+    }
+
+    _report (run, "uml-edit", NULL, seconds, i, UML_EDIT_RENAMES);
+  }
+
+  dia_context_release (ctx);
+  g_clear_object (&data);
+  g_free (filename);
+  g_string_free (xml, TRUE);
+  g_rand_free (rand);
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static void
+_bench_export (BenchRun *run)
+{
+  double *seconds = g_new0 (double, run->iterations);
+  GTimer *timer = g_timer_new ();
+  GList *list;
+
+  for (list = filter_get_export_filters (); list != NULL; list = g_list_next (list)) {
+    DiaExportFilter *ef = list->data;
+    const char *name = ef->unique_name ? ef->unique_name : ef->extensions[0];
+    char *outname;
+    int i;
+
+    if (!ef->extensions || !ef->extensions[0]) {
+      continue;
+    }
+    if (opt_filters) {
+      if (!g_strv_contains ((const char * const *) opt_filters, name)) {
+        continue;
+      }
+    } else if (ef->hints & FILTER_DONT_GUESS) {
+      /* the variants, e.g. for the clipboard */
+      continue;
+    }
+
+    outname = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "export-%s.%s",
+                               run->tmpdir, name, ef->extensions[0]);
+
+    for (i = 0; i < run->iterations; i++) {
+      DiaContext *ctx = dia_context_new (_("Export"));
+
+      dia_context_set_filename (ctx, outname);
+      g_timer_start (timer);
+      ef->export_func (run->data, ctx, outname, run->filename, ef->user_data);
+      seconds[i] = g_timer_elapsed (timer, NULL);
+      dia_context_release (ctx);
+    }
+
+    _report (run, "export", name, seconds, i, 1);
+
+    g_free (outname);
+  }
+
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+#ifdef G_OS_UNIX
+static long
+_peak_resident_kb (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss;
+}
+#endif
+
+/* import a Visio XML export of the generated diagram; the peak memory
+ * growth is only meaningful with --benchmark vdx-import alone */
+static void
+_bench_vdx_import (BenchRun *run)
+{
+  DiaExportFilter *ef = filter_guess_export_filter ("bench.vdx");
+  DiaImportFilter *ifilter = filter_guess_import_filter ("bench.vdx");
+  double *seconds;
+  GTimer *timer;
+  char *vdxname;
+  DiaContext *ctx;
+  int i;
+#ifdef G_OS_UNIX
+  long peak = _peak_resident_kb ();
+#endif
+
+  if (!ef || !ifilter) {
+    g_message ("No VDX filters, skipping vdx-import");
+    return;
+  }
+
+  vdxname = g_build_filename (run->tmpdir, "bench.vdx", NULL);
+  ctx = dia_context_new (_("Export"));
+  dia_context_set_filename (ctx, vdxname);
+  ef->export_func (run->data, ctx, vdxname, run->filename, ef->user_data);
+  dia_context_release (ctx);
+
+  seconds = g_new0 (double, run->iterations);
+  timer = g_timer_new ();
+
+  for (i = 0; i < run->iterations; i++) {
+    DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+    gboolean ok;
+
+    ctx = dia_context_new (_("Import"));
+    g_timer_start (timer);
+    ok = ifilter->import_func (vdxname, data, ctx, ifilter->user_data);
+    seconds[i] = g_timer_elapsed (timer, NULL);
+
+    g_clear_object (&data);
+    dia_context_release (ctx);
+
+    if (!ok) {
+      g_critical ("Loading '%s' failed", vdxname);
+      break;
+    }
+  }
+
+  _report (run, "import", "vdx", seconds, i, 1);
+#ifdef G_OS_UNIX
+  g_printerr ("%-24s %10ld kB peak resident growth\n", "vdx",
+              _peak_resident_kb () - peak);
+#endif
+
+  g_free (vdxname);
+  g_timer_destroy (timer);
+  g_free (seconds);
+}
+
+static const struct {
+  const char *name;
+  BenchFunc   func;
+} benchmarks[] = {
+  { "load", _bench_load },
+  { "save", _bench_save },
+  { "render", _bench_render },
+  { "hit-test", _bench_hit_test },
+  { "select", _bench_select },
+  { "tree", _bench_tree },
+  { "undo-redo", _bench_undo },
+  { "uml-edit", _bench_uml_edit },
+  { "vdx-import", _bench_vdx_import },
+  { "export", _bench_export },
+};
+
+
+static void
+_remove_tmpdir (const char *tmpdir)
+{
+  GDir *dir = g_dir_open (tmpdir, 0, NULL);
+  const char *name;
+
+  if (!dir) {
+    return;
+  }
+
+  while ((name = g_dir_read_name (dir)) != NULL) {
+    char *path = g_build_filename (tmpdir, name, NULL);
+
+    g_unlink (path);
+    g_free (path);
+  }
+  g_dir_close (dir);
+  g_rmdir (tmpdir);
+}
+
+static gboolean
+_load_reference (BenchRun *run)
+{
+  DiaContext *ctx = dia_context_new (_("Import"));
+  gboolean ok;
+
+  run->data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  ok = dia_import_filter.import_func (run->filename, run->data, ctx,
+                                      dia_import_filter.user_data);
+  if (ok) {
+    run->diagram = g_object_new (DIA_TYPE_DIAGRAM, NULL);
+    ok = dia_import_filter.import_func (run->filename, DIA_DIAGRAM_DATA (run->diagram),
+                                        ctx, dia_import_filter.user_data);
+  }
+  dia_context_release (ctx);
+
+  if (ok) {
+    data_update_extents (run->data);
+    data_update_extents (DIA_DIAGRAM_DATA (run->diagram));
+  }
+
+  return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  BenchRun run = { 0, };
+  int weights[BENCH_N_KINDS];
+  char *xml;
+  int n_objects = 0;
+  guint i;
+  int k;
+
+  context = g_option_context_new ("- benchmark Dia on generated diagrams");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_option_context_free (context);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  if (!_parse_mix (opt_mix ? opt_mix : "mixed", weights)) {
+    return 1;
+  }
+
+  xml = _generate_diagram (MAX (1, opt_objects), weights, opt_seed);
+
+  if (opt_generate) {
+    if (!g_file_set_contents (opt_generate, xml, -1, &error)) {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+      g_free (xml);
+      return 1;
+    }
+    g_free (xml);
+    return 0;
+  }
+
+  run.iterations = MAX (1, opt_iterations);
+  run.tmpdir = g_dir_make_tmp ("dia-bench-XXXXXX", &error);
+  if (!run.tmpdir) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_free (xml);
+    return 1;
+  }
+  run.filename = g_build_filename (run.tmpdir, "bench.dia", NULL);
+  g_file_set_contents (run.filename, xml, -1, NULL);
+  g_free (xml);
+
+  if (!gtk_init_check (NULL, NULL)) {
+    g_message ("Running without display");
+  }
+
+  libdia_init (DIA_MESSAGE_STDERR);
+  /* avoid loading objects/plug-ins form the users home directory */
+  g_setenv ("HOME", g_get_tmp_dir (), TRUE);
+  dia_register_plugins ();
+  persistence_load ();
+  dia_preferences_init ();
+
+  if (!_load_reference (&run)) {
+    g_printerr ("Can't load the generated diagram, are the objects on DIA_LIB_PATH?\n");
+    _remove_tmpdir (run.tmpdir);
+    return 1;
+  }
+
+  DIA_FOR_LAYER_IN_DIAGRAM (run.data, layer, j, {
+    n_objects += dia_layer_object_count (layer);
+  });
+
+  run.results = g_string_new (NULL);
+  g_string_append (run.results, "{\n  \"version\": ");
+  _json_string (run.results, dia_version_string ());
+  g_string_append (run.results, ",\n  \"diagram\": {\"mix\": {");
+  for (k = 0; k < BENCH_N_KINDS; k++) {
+    g_string_append_printf (run.results, "%s\"%s\": %d",
+                            k > 0 ? ", " : "", kind_names[k], weights[k]);
+  }
+  g_string_append_printf (run.results, "}, \"objects\": %d, \"seed\": %d},\n",
+                          n_objects, opt_seed);
+  g_string_append (run.results, "  \"results\": [");
+
+  for (i = 0; i < G_N_ELEMENTS (benchmarks); i++) {
+    if (opt_benchmarks &&
+        !g_strv_contains ((const char * const *) opt_benchmarks, benchmarks[i].name)) {
+      continue;
+    }
+    benchmarks[i].func (&run);
+  }
+
+  g_string_append (run.results, "\n  ]\n}\n");
+
+  if (opt_output) {
+    if (!g_file_set_contents (opt_output, run.results->str, run.results->len, &error)) {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+    }
+  } else {
+    fputs (run.results->str, stdout);
+  }
+
+  g_string_free (run.results, TRUE);
+  g_clear_object (&run.diagram);
+  g_clear_object (&run.data);
+  _remove_tmpdir (run.tmpdir);
+  g_free (run.filename);
+  g_free (run.tmpdir);
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+#!/usr/bin/env sh
+# Compare speed and size of the plain and the compact SVG export
+# on a generated diagram of boxes connected by lines.
+DIA=$1
+COUNT=${2:-10000}
+
+WORKDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "${WORKDIR}"' EXIT
+
+awk -v n="${COUNT}" 'BEGIN {
+  colors[0] = "ffffff"; colors[1] = "ffe0e0"; colors[2] = "e0ffe0"; colors[3] = "e0e0ff";
+  print "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+  print "<dia:diagram xmlns:dia=\"http://www.lysator.liu.se/~alla/dia/\">"
+  print "  <dia:layer name=\"Background\" visible=\"true\">"
+  for (i = 0; i < n; i++) {
+    x = (i % 100) * 4; y = int(i / 100) * 3
+    printf "    <dia:object type=\"Standard - Box\" version=\"0\" id=\"B%d\">\n", i
+    printf "      <dia:attribute name=\"elem_corner\"><dia:point val=\"%g,%g\"/></dia:attribute>\n", x, y
+    print  "      <dia:attribute name=\"elem_width\"><dia:real val=\"2\"/></dia:attribute>"
+    print  "      <dia:attribute name=\"elem_height\"><dia:real val=\"1\"/></dia:attribute>"
+    printf "      <dia:attribute name=\"inner_color\"><dia:color val=\"#%s\"/></dia:attribute>\n", colors[i % 4]
+    print  "    </dia:object>"
+    printf "    <dia:object type=\"Standard - Line\" version=\"0\" id=\"L%d\">\n", i
+    printf "      <dia:attribute name=\"conn_endpoints\"><dia:point val=\"%g,%g\"/><dia:point val=\"%g,%g\"/></dia:attribute>\n", x + 2, y + 0.5, x + 4, y + 0.5
+    print  "    </dia:object>"
+  }
+  print "  </dia:layer>"
+  print "</dia:diagram>"
+}' > "${WORKDIR}/bench.dia"
+
+for FILTER in dia-svg dia-svg-compact; do
+  START=$(date +%s.%N)
+  ${DIA} -t ${FILTER} -e "${WORKDIR}/${FILTER}.svg" "${WORKDIR}/bench.dia" > /dev/null || exit 1
+  END=$(date +%s.%N)
+  SIZE=$(wc -c < "${WORKDIR}/${FILTER}.svg")
+  echo "${FILTER}: $(echo "${START} ${END}" | awk '{ printf "%.2f", $2 - $1 }')s ${SIZE} bytes for ${COUNT} boxes and lines"
+done
+
+exit 0
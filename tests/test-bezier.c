@@ -0,0 +1,269 @@
+/* test-bezier.c -- Unit test and benchmark for the fallback bezier flattening
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <math.h>
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "diarenderer.h"
+#include "geometry.h"
+
+/*
+ * A renderer only implementing the primitives the base class falls back to,
+ * collecting the approximated polyline instead of drawing it.
+ */
+#define TEST_TYPE_RENDERER test_renderer_get_type ()
+G_DECLARE_FINAL_TYPE (TestRenderer, test_renderer, TEST, RENDERER, DiaRenderer)
+
+struct _TestRenderer {
+  DiaRenderer parent_instance;
+
+  GArray *points;
+};
+
+G_DEFINE_TYPE (TestRenderer, test_renderer, DIA_TYPE_RENDERER)
+
+static void
+test_renderer_draw_polyline (DiaRenderer *self,
+                             Point       *points,
+                             int          num_points,
+                             Color       *color)
+{
+  TestRenderer *renderer = TEST_RENDERER (self);
+
+  g_array_set_size (renderer->points, 0);
+  g_array_append_vals (renderer->points, points, num_points);
+}
+
+static void
+test_renderer_draw_polygon (DiaRenderer *self,
+                            Point       *points,
+                            int          num_points,
+                            Color       *fill,
+                            Color       *stroke)
+{
+  test_renderer_draw_polyline (self, points, num_points, stroke);
+}
+
+static void
+test_renderer_finalize (GObject *object)
+{
+  TestRenderer *renderer = TEST_RENDERER (object);
+
+  g_array_unref (renderer->points);
+
+  G_OBJECT_CLASS (test_renderer_parent_class)->finalize (object);
+}
+
+static void
+test_renderer_class_init (TestRendererClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  DiaRendererClass *renderer_class = DIA_RENDERER_CLASS (klass);
+
+  object_class->finalize = test_renderer_finalize;
+
+  renderer_class->draw_polyline = test_renderer_draw_polyline;
+  renderer_class->draw_polygon = test_renderer_draw_polygon;
+}
+
+static void
+test_renderer_init (TestRenderer *self)
+{
+  self->points = g_array_new (FALSE, FALSE, sizeof (Point));
+}
+
+
+/* shapes borrowed from test-boundingbox.c */
+static BezPoint _circle[] = {
+  { BEZ_MOVE_TO, {1.0, 2.0} },
+  { BEZ_CURVE_TO, {0.0, 2.0}, {0.0, 0.0}, {1.0, 0.0} },
+  { BEZ_CURVE_TO, {2.0, 0.0}, {2.0, 2.0}, {1.0, 2.0} },
+};
+static BezPoint _swapped[] = {
+  { BEZ_MOVE_TO, {0.0, 2.0} },
+  { BEZ_CURVE_TO, {2.0, 0.0}, {0.0, 0.0}, {2.0, 2.0} },
+};
+static BezPoint _loops[] = {
+  { BEZ_MOVE_TO, {1,1} },
+  { BEZ_CURVE_TO, {0,0}, {0,2}, {1,1} },
+  { BEZ_CURVE_TO, {2,0}, {2,2}, {1,1} },
+  { BEZ_CURVE_TO, {0,0}, {2,0}, {1,1} },
+  { BEZ_CURVE_TO, {0,2}, {2,2}, {1,1} },
+};
+static BezPoint _heart[] = {
+  { BEZ_MOVE_TO, {0.219064,0.919322} },
+  { BEZ_CURVE_TO, {-0.563306,-0.0586407}, {1.00143,-0.449826}, {1.00143,0.723729} },
+  { BEZ_CURVE_TO, {1.00143,0.723729}, {1.00143,0.723729}, {1.00143,0.723729} },
+  { BEZ_CURVE_TO, {1.00143,-0.449826}, {2.56617,-0.0586407}, {1.7838,0.919322} },
+  { BEZ_CURVE_TO, {1.7838,0.919322}, {1.00143,1.89728}, {1.00143,1.89728} },
+  { BEZ_CURVE_TO, {1.00143,1.89728}, {0.219064,0.919322}, {0.219064,0.919322} },
+};
+static BezPoint _ying[] = {
+  { BEZ_MOVE_TO, {2,0} },
+  { BEZ_CURVE_TO, {1.2855,0}, {0.6252,0.3812}, {0.2679,1} },
+  { BEZ_CURVE_TO, {-0.0893,1.6188}, {-0.0893,2.3812}, {0.2679,3} },
+  { BEZ_CURVE_TO, {0.6252,3.6188}, {1.2855,4}, {2,4} },
+  { BEZ_CURVE_TO, {1.6427,4}, {1.3126,3.8094}, {1.134,3.5} },
+  { BEZ_CURVE_TO, {0.9553,3.1906}, {0.9553,2.8094}, {1.134,2.5} },
+  { BEZ_CURVE_TO, {1.3126,2.1906}, {1.6427,2}, {2,2} },
+  { BEZ_CURVE_TO, {2.3573,2}, {2.6874,1.8094}, {2.866,1.5} },
+  { BEZ_CURVE_TO, {3.0447,1.1906}, {3.0447,0.8094}, {2.866,0.5} },
+  { BEZ_CURVE_TO, {2.6874,0.1906}, {2.3573,0}, {2,0} },
+};
+
+static struct {
+  const char *name;
+  BezPoint   *points;
+  int         num;
+} _shapes[] = {
+  { "circle",  _circle,  G_N_ELEMENTS (_circle) },
+  { "swapped", _swapped, G_N_ELEMENTS (_swapped) },
+  { "loops",   _loops,   G_N_ELEMENTS (_loops) },
+  { "heart",   _heart,   G_N_ELEMENTS (_heart) },
+  { "ying",    _ying,    G_N_ELEMENTS (_ying) },
+};
+
+static const double _tolerances[] = { 0.1, 0.01, 0.001, 0.0001 };
+
+static Point
+_bezier_eval (const Point *p0, const BezPoint *bp, double t)
+{
+  double mt = 1.0 - t;
+  double a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t, d = t * t * t;
+  Point p;
+
+  p.x = a * p0->x + b * bp->p1.x + c * bp->p2.x + d * bp->p3.x;
+  p.y = a * p0->y + b * bp->p1.y + c * bp->p2.y + d * bp->p3.y;
+
+  return p;
+}
+
+static double
+_distance_to_polyline (GArray *points, const Point *pt)
+{
+  double dist = G_MAXDOUBLE;
+  guint i;
+
+  for (i = 1; i < points->len; i++) {
+    double d = distance_line_point (&g_array_index (points, Point, i - 1),
+                                    &g_array_index (points, Point, i),
+                                    0.0, pt);
+    dist = MIN (dist, d);
+  }
+
+  return dist;
+}
+
+static void
+_check_tolerance (gconstpointer data)
+{
+  int n = GPOINTER_TO_INT (data);
+  TestRenderer *renderer;
+  guint t;
+
+  for (t = 0; t < G_N_ELEMENTS (_tolerances); t++) {
+    const double tol = _tolerances[t];
+    const Point *start = &_shapes[n].points[0].p1;
+    int i;
+
+    renderer = g_object_new (TEST_TYPE_RENDERER, "tolerance", tol, NULL);
+    dia_renderer_draw_bezier (DIA_RENDERER (renderer),
+                              _shapes[n].points, _shapes[n].num, NULL);
+
+    g_assert_cmpint (renderer->points->len, >=, 2);
+
+    for (i = 1; i < _shapes[n].num; i++) {
+      const BezPoint *bp = &_shapes[n].points[i];
+      int j;
+
+      for (j = 0; j <= 32; j++) {
+        Point pt = _bezier_eval (start, bp, j / 32.0);
+
+        g_assert_cmpfloat (_distance_to_polyline (renderer->points, &pt),
+                           <=, tol * 1.01);
+      }
+      start = &bp->p3;
+    }
+
+    g_clear_object (&renderer);
+  }
+}
+
+static void
+_bench_flatten (void)
+{
+  TestRenderer *renderer;
+  guint t, s;
+
+  if (!g_test_perf ())
+    return;
+
+  for (t = 0; t < G_N_ELEMENTS (_tolerances); t++) {
+    const int rounds = 20000;
+    guint64 n_points = 0;
+    double elapsed;
+    int r;
+
+    renderer = g_object_new (TEST_TYPE_RENDERER,
+                             "tolerance", _tolerances[t],
+                             NULL);
+
+    g_test_timer_start ();
+    for (r = 0; r < rounds; r++) {
+      for (s = 0; s < G_N_ELEMENTS (_shapes); s++) {
+        dia_renderer_draw_bezier (DIA_RENDERER (renderer),
+                                  _shapes[s].points, _shapes[s].num, NULL);
+        n_points += renderer->points->len;
+      }
+    }
+    elapsed = g_test_timer_elapsed ();
+
+    g_test_minimized_result (elapsed * 1e9 / (rounds * G_N_ELEMENTS (_shapes)),
+                             "tolerance %g: %.0f ns per shape, %.1f points",
+                             _tolerances[t],
+                             elapsed * 1e9 / (rounds * G_N_ELEMENTS (_shapes)),
+                             (double) n_points / (rounds * G_N_ELEMENTS (_shapes)));
+
+    g_clear_object (&renderer);
+  }
+}
+
+int
+main (int argc, char** argv)
+{
+  guint i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (_shapes); i++) {
+    char *testpath = g_strdup_printf ("/Dia/Renderer/Bezier/%s", _shapes[i].name);
+
+    g_test_add_data_func (testpath, GINT_TO_POINTER (i), _check_tolerance);
+
+    g_clear_pointer (&testpath, g_free);
+  }
+  g_test_add_func ("/Dia/Renderer/Bezier/Benchmark", _bench_flatten);
+
+  return g_test_run ();
+}
@@ -0,0 +1,261 @@
+/* test-export-png.c -- Unit test for exporting big PNG in bands
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <math.h>
+#include <glib/gstdio.h>
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "object.h"
+#include "dialib.h"
+#include "diagramdata.h"
+#include "dia-layer.h"
+#include "diacontext.h"
+#include "renderer/diacairo.h"
+
+/* as in diacairo.c: bigger than this is exported in bands */
+#define BAND_BYTES (8 * 1024 * 1024)
+
+/* the diagram, in cm, is 20 pixels per cm in the PNG */
+#define WIDTH 100.0
+#define HEIGHT 120.0
+#define PIXELS_PER_CM 20.0
+
+static Color red = { 1.0, 0.0, 0.0, 1.0 };
+static Color blue = { 0.0, 0.0, 1.0, 1.0 };
+
+/* where the band edges are, in rows */
+static int
+_band_height (int width)
+{
+  return MAX (BAND_BYTES / (width * 4), 16);
+}
+
+/*
+ * A red area leaving a margin, with a blue stripe across every band edge
+ * to show that the bands join without a gap or offset.
+ */
+static void
+_stripes_draw (DiaObject *obj, DiaRenderer *renderer)
+{
+  int width = ceil (WIDTH * PIXELS_PER_CM) + 1;
+  int band_height = _band_height (width);
+  Point ul = { 1.0, 1.0 };
+  Point lr = { WIDTH - 1.0, HEIGHT - 1.0 };
+  int edge;
+
+  dia_renderer_draw_rect (renderer, &ul, &lr, &red, NULL);
+  for (edge = band_height; edge < HEIGHT * PIXELS_PER_CM; edge += band_height) {
+    ul.x = 10.0;
+    ul.y = edge / PIXELS_PER_CM - 0.5;
+    lr.x = 20.0;
+    lr.y = edge / PIXELS_PER_CM + 0.5;
+    dia_renderer_draw_rect (renderer, &ul, &lr, &blue, NULL);
+  }
+}
+
+static void
+_stripes_destroy (DiaObject *obj)
+{
+}
+
+static ObjectOps stripes_ops = {
+  .destroy = _stripes_destroy,
+  .draw = _stripes_draw,
+};
+
+static DiagramData *
+_diagram_new (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaObject *obj = g_new0 (DiaObject, 1);
+  DiaRectangle extents = { 0.0, 0.0, WIDTH, HEIGHT };
+
+  obj->ops = &stripes_ops;
+  obj->bounding_box = extents;
+  dia_layer_add_object (dia_diagram_data_get_active_layer (data), obj);
+
+  data->extents = extents;
+  data->paper.scaling = 1.0;
+  data->bg_color = color_white;
+
+  return data;
+}
+
+/* what the PNG should show: the diagram rendered to a single surface */
+static cairo_surface_t *
+_render_reference (DiagramData *data, gboolean alpha, int width, int height)
+{
+  cairo_surface_t *surface;
+  DiaCairoRenderer *renderer;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+  renderer->dia = data;
+  renderer->scale = PIXELS_PER_CM;
+  renderer->with_alpha = alpha;
+  renderer->surface = cairo_surface_reference (surface);
+
+  data_render (data, DIA_RENDERER (renderer), NULL, NULL, NULL);
+  g_clear_object (&renderer);
+  cairo_surface_flush (surface);
+
+  return surface;
+}
+
+/* the unpremultiplied RGBA of a pixel in an ARGB32 surface */
+static void
+_surface_pixel (cairo_surface_t *surface, int x, int y, guint8 rgba[4])
+{
+  const guint8 *data = cairo_image_surface_get_data (surface);
+  int stride = cairo_image_surface_get_stride (surface);
+  guint32 p = ((const guint32 *) (data + y * stride))[x];
+  guint a = p >> 24;
+  int i;
+
+  rgba[0] = (p >> 16) & 0xff;
+  rgba[1] = (p >> 8) & 0xff;
+  rgba[2] = p & 0xff;
+  rgba[3] = a;
+  if (a != 0 && a != 0xff) {
+    for (i = 0; i < 3; i++) {
+      rgba[i] = (rgba[i] * 0xff + a / 2) / a;
+    }
+  }
+}
+
+static const guint8 *
+_pixbuf_pixel (GdkPixbuf *pixbuf, int x, int y)
+{
+  return gdk_pixbuf_get_pixels (pixbuf)
+         + y * gdk_pixbuf_get_rowstride (pixbuf)
+         + x * gdk_pixbuf_get_n_channels (pixbuf);
+}
+
+static void
+_check_color (GdkPixbuf *pixbuf, int x, int y, const Color *color)
+{
+  const guint8 *p = _pixbuf_pixel (pixbuf, x, y);
+
+  g_assert_cmpuint (p[0], ==, (guint8) (color->red * 255));
+  g_assert_cmpuint (p[1], ==, (guint8) (color->green * 255));
+  g_assert_cmpuint (p[2], ==, (guint8) (color->blue * 255));
+  if (gdk_pixbuf_get_has_alpha (pixbuf)) {
+    g_assert_cmpuint (p[3], ==, (guint8) (color->alpha * 255));
+  }
+}
+
+static void
+_test_bands (gconstpointer user_data)
+{
+  gboolean alpha = GPOINTER_TO_INT (user_data);
+  int width = ceil (WIDTH * PIXELS_PER_CM) + 1;
+  int height = ceil (HEIGHT * PIXELS_PER_CM) + 1;
+  int band_height = _band_height (width);
+  DiagramData *data = _diagram_new ();
+  DiaContext *ctx = dia_context_new ("test");
+  cairo_surface_t *reference;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  char *filename;
+  int edge, x, y;
+  int fd;
+
+  /* more than one band, more than one edge */
+  g_assert_cmpint (width * height * 4, >, BAND_BYTES);
+  g_assert_cmpint (height, >, 2 * band_height);
+
+  fd = g_file_open_tmp ("dia-bands-XXXXXX.png", &filename, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+  dia_context_set_filename (ctx, filename);
+
+  g_assert_true (cairo_export_data (data, ctx, filename, NULL,
+                                    GINT_TO_POINTER (alpha ? OUTPUT_PNGA : OUTPUT_PNG)));
+
+  pixbuf = gdk_pixbuf_new_from_file (filename, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, width);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, height);
+  g_assert_cmpint (gdk_pixbuf_get_has_alpha (pixbuf), ==, alpha);
+
+  /* the same as rendered in one piece, band edges included */
+  reference = _render_reference (data, alpha, width, height);
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      const guint8 *p = _pixbuf_pixel (pixbuf, x, y);
+      guint8 expected[4];
+
+      _surface_pixel (reference, x, y, expected);
+      if (alpha) {
+        g_assert_cmpuint (p[3], ==, expected[3]);
+        if (expected[3] == 0) {
+          continue;
+        }
+      }
+      if (p[0] != expected[0] || p[1] != expected[1] || p[2] != expected[2]) {
+        g_error ("pixel %d,%d is %02x%02x%02x instead of %02x%02x%02x",
+                 x, y, p[0], p[1], p[2], expected[0], expected[1], expected[2]);
+      }
+    }
+  }
+  cairo_surface_destroy (reference);
+
+  /* and it is what was drawn: the stripes cross the edges unbroken */
+  for (edge = band_height; edge < height; edge += band_height) {
+    for (y = edge - 5; y < edge + 5; y++) {
+      _check_color (pixbuf, 15 * PIXELS_PER_CM, y, &blue);
+      _check_color (pixbuf, 50 * PIXELS_PER_CM, y, &red);
+    }
+    _check_color (pixbuf, 15 * PIXELS_PER_CM, edge - 15, &red);
+    _check_color (pixbuf, 15 * PIXELS_PER_CM, edge + 15, &red);
+  }
+  /* the margin shows the background */
+  if (alpha) {
+    g_assert_cmpuint (_pixbuf_pixel (pixbuf, 5, 5)[3], ==, 0);
+    g_assert_cmpuint (_pixbuf_pixel (pixbuf, width - 5, height - 5)[3], ==, 0);
+  } else {
+    _check_color (pixbuf, 5, 5, &color_white);
+    _check_color (pixbuf, width - 5, height - 5, &color_white);
+  }
+
+  g_clear_object (&pixbuf);
+  g_unlink (filename);
+  g_clear_pointer (&filename, g_free);
+  dia_context_release (ctx);
+  g_clear_object (&data);
+}
+
+int
+main (int argc, char** argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  libdia_init (DIA_MESSAGE_STDERR);
+
+  g_test_add_data_func ("/Dia/Export/PngBands", GINT_TO_POINTER (FALSE), _test_bands);
+  g_test_add_data_func ("/Dia/Export/PngBandsAlpha", GINT_TO_POINTER (TRUE), _test_bands);
+
+  return g_test_run ();
+}
@@ -0,0 +1,138 @@
+/* test-font.c -- Unit test for the text measurement cache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "dialib.h"
+#include "font.h"
+
+static void
+_check_stats (guint hits, guint misses, guint n_entries)
+{
+  guint h, m, n;
+
+  dia_font_sizes_cache_stats (&h, &m, &n);
+  g_assert_cmpuint (h, ==, hits);
+  g_assert_cmpuint (m, ==, misses);
+  g_assert_cmpuint (n, ==, n_entries);
+}
+
+/* equal text in an equal font is measured once, whatever the DiaFont */
+static void
+_test_shared (void)
+{
+  DiaFont *font = dia_font_new_from_style (DIA_FONT_SANS, 0.8);
+  DiaFont *other = dia_font_new_from_style (DIA_FONT_SANS, 0.8);
+  DiaFontSizes *a, *b, *c;
+
+  dia_font_sizes_cache_clear ();
+
+  a = dia_font_sizes_lookup ("Dia", font, 0.8);
+  g_assert_cmpfloat (a->width, >, 0.0);
+  g_assert_cmpint (a->n_offsets, ==, 3);
+  _check_stats (0, 1, 1);
+
+  b = dia_font_sizes_lookup ("Dia", other, 0.8);
+  g_assert_true (a == b);
+  _check_stats (1, 1, 1);
+
+  /* the height is part of the key */
+  c = dia_font_sizes_lookup ("Dia", font, 1.6);
+  g_assert_true (a != c);
+  g_assert_cmpfloat (c->width, >, a->width);
+  _check_stats (1, 2, 2);
+  g_assert_cmpfloat (dia_font_string_width ("Dia", font, 1.6), ==, c->width);
+  _check_stats (2, 2, 2);
+
+  dia_font_sizes_unref (a);
+  dia_font_sizes_unref (b);
+  dia_font_sizes_unref (c);
+  dia_font_sizes_cache_clear ();
+  _check_stats (0, 0, 0);
+
+  g_clear_object (&other);
+  g_clear_object (&font);
+}
+
+static DiaFontSizes *
+_lookup (const char *string, DiaFont *font)
+{
+  return dia_font_sizes_lookup (string, font, 0.8);
+}
+
+/* beyond the limit the least recently used entry goes first */
+static void
+_test_lru (void)
+{
+  DiaFont *font = dia_font_new_from_style (DIA_FONT_SANS, 0.8);
+  DiaFontSizes *kept;
+  double width;
+
+  dia_font_sizes_cache_clear ();
+  dia_font_sizes_cache_set_limit (3);
+
+  kept = _lookup ("b", font);
+  width = kept->width;
+  dia_font_sizes_unref (_lookup ("a", font));
+  dia_font_sizes_unref (_lookup ("c", font));
+  _check_stats (0, 3, 3);
+
+  /* a is used again, so b is the oldest */
+  dia_font_sizes_unref (_lookup ("a", font));
+  dia_font_sizes_unref (_lookup ("d", font));
+  _check_stats (1, 4, 3);
+  dia_font_sizes_unref (_lookup ("a", font));
+  dia_font_sizes_unref (_lookup ("c", font));
+  dia_font_sizes_unref (_lookup ("d", font));
+  _check_stats (4, 4, 3);
+  dia_font_sizes_unref (_lookup ("b", font));
+  _check_stats (4, 5, 3);
+
+  /* a reference outlives its entry */
+  g_assert_cmpfloat (kept->width, ==, width);
+  dia_font_sizes_unref (kept);
+
+  /* a smaller limit applies right away, keeping the recent ones */
+  dia_font_sizes_cache_set_limit (1);
+  _check_stats (4, 5, 1);
+  dia_font_sizes_unref (_lookup ("b", font));
+  _check_stats (5, 5, 1);
+
+  dia_font_sizes_cache_set_limit (4096);
+  dia_font_sizes_cache_clear ();
+  g_clear_object (&font);
+}
+
+int
+main (int argc, char** argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  libdia_init (DIA_MESSAGE_STDERR);
+
+  g_test_add_func ("/Dia/Font/SizesShared", _test_shared);
+  g_test_add_func ("/Dia/Font/SizesLRU", _test_lru);
+
+  return g_test_run ();
+}
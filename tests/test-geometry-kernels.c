@@ -0,0 +1,241 @@
+/* test-geometry-kernels.c -- Unit test and benchmark for the batch geometry
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <math.h>
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+
+#include "geometry.h"
+#include "boundingbox.h"
+#include "dia-geometry-kernels.h"
+
+#define EPSILON 1e-9
+
+/* coordinates on a coarse grid, so there are plenty of horizontal and
+ * degenerated segments and points at the height of a vertex */
+static Point *
+_random_polyline (GRand *rand, int npoints)
+{
+  Point *pts = g_new (Point, npoints);
+  int i;
+
+  for (i = 0; i < npoints; i++) {
+    if (i > 0 && g_rand_int_range (rand, 0, 10) == 0) {
+      pts[i] = pts[i - 1];
+    } else {
+      pts[i].x = g_rand_int_range (rand, 0, 40) / 4.0;
+      pts[i].y = g_rand_int_range (rand, 0, 40) / 4.0;
+    }
+  }
+
+  return pts;
+}
+
+static void
+_check_distance (gconstpointer data)
+{
+  const DiaGeometryKernels *kernels = data;
+  const DiaGeometryKernels *scalar = dia_geometry_kernels_list ()[0];
+  GRand *rand = g_rand_new_with_seed (42);
+  int i;
+
+  for (i = 0; i < 2000; i++) {
+    int n = g_rand_int_range (rand, 0, 40);
+    Point *pts = _random_polyline (rand, n);
+    Point point;
+    guint crossings = 0, expected_crossings = 0;
+    double dist, expected;
+
+    point.x = g_rand_int_range (rand, -10, 110) / 10.0;
+    point.y = n > 0 && g_rand_boolean (rand)
+                ? pts[g_rand_int_range (rand, 0, n)].y
+                : g_rand_int_range (rand, -10, 110) / 10.0;
+
+    expected = scalar->segments_distance (pts, n, 0.25, &point, &expected_crossings);
+    dist = kernels->segments_distance (pts, n, 0.25, &point, &crossings);
+
+    g_assert_cmpfloat_with_epsilon (dist, expected, EPSILON);
+    g_assert_cmpuint (crossings, ==, expected_crossings);
+
+    /* without crossings */
+    dist = kernels->segments_distance (pts, n, 0.25, &point, NULL);
+    g_assert_cmpfloat_with_epsilon (dist, expected, EPSILON);
+
+    g_free (pts);
+  }
+
+  g_rand_free (rand);
+}
+
+static void
+_check_extents (gconstpointer data)
+{
+  const DiaGeometryKernels *kernels = data;
+  const DiaGeometryKernels *scalar = dia_geometry_kernels_list ()[0];
+  GRand *rand = g_rand_new_with_seed (23);
+  int i;
+
+  for (i = 0; i < 2000; i++) {
+    int n = g_rand_int_range (rand, 1, 40);
+    Point *pts = _random_polyline (rand, n);
+    DiaRectangle rect, expected;
+
+    expected.left = expected.right = rect.left = rect.right = pts[0].x;
+    expected.top = expected.bottom = rect.top = rect.bottom = pts[0].y;
+
+    scalar->polyline_extents (pts, n, 0.2, 0.1, &expected);
+    kernels->polyline_extents (pts, n, 0.2, 0.1, &rect);
+
+    g_assert_cmpfloat_with_epsilon (rect.left, expected.left, EPSILON);
+    g_assert_cmpfloat_with_epsilon (rect.top, expected.top, EPSILON);
+    g_assert_cmpfloat_with_epsilon (rect.right, expected.right, EPSILON);
+    g_assert_cmpfloat_with_epsilon (rect.bottom, expected.bottom, EPSILON);
+
+    g_free (pts);
+  }
+
+  g_rand_free (rand);
+}
+
+/* polyline_bbox() takes the kernel shortcut, polybezier_bbox() doesn't */
+static void
+_check_polyline_bbox (void)
+{
+  static const PolyBBExtras extras[] = {
+    { 0, 0.1, 0.1, 0.1, 0 },
+    { 0, 0.1, 0.05, 0.1, 0 },
+    { 0.5, 0.3, 0.1, 0.2, 0.4 },
+  };
+  GRand *rand = g_rand_new_with_seed (7);
+  int i;
+
+  for (i = 0; i < 500; i++) {
+    int n = g_rand_int_range (rand, 2, 40);
+    Point *pts = _random_polyline (rand, n);
+    BezPoint *bpts = g_new (BezPoint, n + 1);
+    guint e;
+    int j;
+
+    bpts[0].type = BEZ_MOVE_TO;
+    bpts[0].p1 = pts[0];
+    for (j = 1; j <= n; j++) {
+      bpts[j].type = BEZ_LINE_TO;
+      bpts[j].p1 = pts[j % n];
+    }
+
+    for (e = 0; e < G_N_ELEMENTS (extras); e++) {
+      int closed;
+
+      for (closed = 0; closed < 2; closed++) {
+        DiaRectangle rect, expected;
+
+        polyline_bbox (pts, n, &extras[e], closed, &rect);
+        polybezier_bbox (bpts, closed ? n + 1 : n, &extras[e], closed, &expected);
+
+        g_assert_cmpfloat_with_epsilon (rect.left, expected.left, EPSILON);
+        g_assert_cmpfloat_with_epsilon (rect.top, expected.top, EPSILON);
+        g_assert_cmpfloat_with_epsilon (rect.right, expected.right, EPSILON);
+        g_assert_cmpfloat_with_epsilon (rect.bottom, expected.bottom, EPSILON);
+      }
+    }
+
+    g_free (bpts);
+    g_free (pts);
+  }
+
+  g_rand_free (rand);
+}
+
+static void
+_bench_kernels (void)
+{
+  const DiaGeometryKernels **list = dia_geometry_kernels_list ();
+  const int npoints = 1000;
+  const int rounds = 2000;
+  GRand *rand;
+  Point *pts;
+  Point point = { 5.0, 5.0 };
+  int k;
+
+  if (!g_test_perf ())
+    return;
+
+  rand = g_rand_new_with_seed (1);
+  pts = _random_polyline (rand, npoints);
+
+  for (k = 0; list[k] != NULL; k++) {
+    DiaRectangle rect = { 0, 0, 0, 0 };
+    guint crossings = 0;
+    double dist = 0.0, elapsed;
+    int r;
+
+    g_test_timer_start ();
+    for (r = 0; r < rounds; r++) {
+      dist += list[k]->segments_distance (pts, npoints, 0.1, &point, &crossings);
+    }
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed * 1e9 / ((double) rounds * npoints),
+                             "%s distance: %.2f ns per segment (%g)",
+                             list[k]->name,
+                             elapsed * 1e9 / ((double) rounds * npoints),
+                             dist);
+
+    g_test_timer_start ();
+    for (r = 0; r < rounds; r++) {
+      list[k]->polyline_extents (pts, npoints, 0.1, 0.1, &rect);
+    }
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed * 1e9 / ((double) rounds * npoints),
+                             "%s extents: %.2f ns per segment",
+                             list[k]->name,
+                             elapsed * 1e9 / ((double) rounds * npoints));
+  }
+
+  g_free (pts);
+  g_rand_free (rand);
+}
+
+int
+main (int argc, char** argv)
+{
+  const DiaGeometryKernels **list;
+  guint i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  list = dia_geometry_kernels_list ();
+  for (i = 0; list[i] != NULL; i++) {
+    char *testpath;
+
+    testpath = g_strdup_printf ("/Dia/Geometry/Kernels/%s/Distance", list[i]->name);
+    g_test_add_data_func (testpath, list[i], _check_distance);
+    g_clear_pointer (&testpath, g_free);
+
+    testpath = g_strdup_printf ("/Dia/Geometry/Kernels/%s/Extents", list[i]->name);
+    g_test_add_data_func (testpath, list[i], _check_extents);
+    g_clear_pointer (&testpath, g_free);
+  }
+  g_test_add_func ("/Dia/Geometry/Kernels/PolylineBBox", _check_polyline_bbox);
+  g_test_add_func ("/Dia/Geometry/Kernels/Benchmark", _bench_kernels);
+
+  return g_test_run ();
+}
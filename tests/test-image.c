@@ -0,0 +1,357 @@
+/* test-image.c -- Unit test for the sharing and caches of DiaImage
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "dialib.h"
+#include "dia_image.h"
+
+static DiaImage *
+_image_new (int width, int height, guint32 rgba)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, width, height);
+  DiaImage *image;
+
+  gdk_pixbuf_fill (pixbuf, rgba);
+  image = dia_image_new_from_pixbuf (pixbuf);
+  g_clear_object (&pixbuf);
+
+  return image;
+}
+
+/* equal pixels share one instance, whatever the row padding */
+static void
+_test_store (void)
+{
+  guint base = dia_image_store_size ();
+  GdkPixbuf *wide = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 32, 16);
+  GdkPixbuf *padded;
+  DiaImage *a, *b, *c, *d;
+
+  gdk_pixbuf_fill (wide, 0xff0000ff);
+  padded = gdk_pixbuf_new_subpixbuf (wide, 0, 0, 16, 16);
+
+  a = dia_image_intern (_image_new (16, 16, 0xff0000ff));
+  b = dia_image_intern (dia_image_new_from_pixbuf (padded));
+  g_assert_true (a == b);
+  g_assert_cmpstr (dia_image_pixbuf_checksum (dia_image_pixbuf (a)), ==,
+                   dia_image_pixbuf_checksum (padded));
+  g_assert_cmpuint (dia_image_store_size (), ==, base + 1);
+
+  c = dia_image_intern (_image_new (16, 16, 0x0000ffff));
+  g_assert_true (c != a);
+  g_assert_cmpuint (dia_image_store_size (), ==, base + 2);
+  /* already shared */
+  g_assert_true (dia_image_intern (c) == c);
+  g_assert_null (dia_image_intern (NULL));
+
+  /* the store doesn't keep them alive */
+  g_clear_object (&b);
+  g_assert_cmpuint (dia_image_store_size (), ==, base + 2);
+  g_clear_object (&a);
+  g_clear_object (&c);
+  g_assert_cmpuint (dia_image_store_size (), ==, base);
+
+  d = dia_image_intern (_image_new (16, 16, 0xff0000ff));
+  g_assert_cmpuint (dia_image_store_size (), ==, base + 1);
+
+  g_clear_object (&d);
+  g_clear_object (&padded);
+  g_clear_object (&wide);
+}
+
+static void
+_count (DiaImage *image, gpointer user_data)
+{
+  int *count = user_data;
+
+  (*count)++;
+}
+
+/* a decode that only finishes when the test lets it */
+typedef struct _Gate {
+  GMutex   lock;
+  GCond    cond;
+  gboolean open;
+  int      calls;
+} Gate;
+
+static GdkPixbuf *
+_gate_decode (gpointer data, GError **error)
+{
+  Gate *gate = data;
+  GdkPixbuf *pixbuf;
+
+  g_mutex_lock (&gate->lock);
+  gate->calls++;
+  while (!gate->open) {
+    g_cond_wait (&gate->cond, &gate->lock);
+  }
+  g_mutex_unlock (&gate->lock);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 8, 4);
+  gdk_pixbuf_fill (pixbuf, 0x00ff00ff);
+
+  return pixbuf;
+}
+
+static GdkPixbuf *
+_fail_decode (gpointer data, GError **error)
+{
+  g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "test");
+
+  return NULL;
+}
+
+static void
+_gate_init (Gate *gate, gboolean open)
+{
+  g_mutex_init (&gate->lock);
+  g_cond_init (&gate->cond);
+  gate->open = open;
+  gate->calls = 0;
+}
+
+static void
+_gate_clear (Gate *gate)
+{
+  g_cond_clear (&gate->cond);
+  g_mutex_clear (&gate->lock);
+}
+
+static void
+_gate_open (Gate *gate)
+{
+  g_mutex_lock (&gate->lock);
+  gate->open = TRUE;
+  g_cond_broadcast (&gate->cond);
+  g_mutex_unlock (&gate->lock);
+}
+
+/* without a main loop the pixels are decoded right away */
+static void
+_test_deferred_sync (void)
+{
+  Gate gate;
+  DiaImage *image;
+
+  _gate_init (&gate, TRUE);
+  image = dia_image_new_deferred (_gate_decode, &gate, NULL, NULL, NULL);
+  g_assert_true (dia_image_is_ready (image));
+  g_assert_cmpint (gate.calls, ==, 1);
+  g_assert_cmpint (dia_image_width (image), ==, 8);
+  g_assert_false (dia_image_is_broken (image));
+  g_clear_object (&image);
+  _gate_clear (&gate);
+
+  /* failing shows the placeholder */
+  image = dia_image_new_deferred (_fail_decode, NULL, NULL, NULL, NULL);
+  g_assert_true (dia_image_is_ready (image));
+  g_assert_true (dia_image_is_broken (image));
+  g_clear_object (&image);
+}
+
+/* in the background DiaImage::ready tells when the pixels are there */
+static void
+_test_deferred_ready (void)
+{
+  gint64 end = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  Gate gate;
+  DiaImage *image;
+  int count = 0;
+
+  _gate_init (&gate, FALSE);
+  dia_image_set_decode_async (TRUE);
+  image = dia_image_new_deferred (_gate_decode, &gate, NULL, "gate.png", "image/png");
+  g_signal_connect (image, "ready", G_CALLBACK (_count), &count);
+  g_assert_false (dia_image_is_ready (image));
+  /* not interned before the content is known */
+  g_assert_true (dia_image_intern (image) == image);
+  g_assert_cmpstr (dia_image_filename (image), ==, "gate.png");
+
+  _gate_open (&gate);
+  while (count == 0 && g_get_monotonic_time () < end) {
+    g_main_context_iteration (NULL, FALSE);
+  }
+  g_assert_cmpint (count, ==, 1);
+  g_assert_true (dia_image_is_ready (image));
+  g_assert_cmpint (dia_image_width (image), ==, 8);
+  g_assert_cmpint (dia_image_height (image), ==, 4);
+  g_assert_cmpint (gate.calls, ==, 1);
+  g_clear_object (&image);
+  _gate_clear (&gate);
+
+  dia_image_set_decode_async (FALSE);
+}
+
+/* asking for the pixels waits for them, the signal still comes once */
+static void
+_test_deferred_wait (void)
+{
+  gint64 end = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  Gate gate;
+  DiaImage *image;
+  int count = 0;
+
+  _gate_init (&gate, TRUE);
+  dia_image_set_decode_async (TRUE);
+  image = dia_image_new_deferred (_gate_decode, &gate, NULL, NULL, NULL);
+  g_signal_connect (image, "ready", G_CALLBACK (_count), &count);
+  g_assert_cmpint (dia_image_width (image), ==, 8);
+  g_assert_true (dia_image_is_ready (image));
+
+  /* a worker might still be about to queue it */
+  while (count == 0 && g_get_monotonic_time () < end) {
+    g_main_context_iteration (NULL, FALSE);
+  }
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (count, ==, 1);
+  g_assert_cmpint (gate.calls, ==, 1);
+  g_clear_object (&image);
+  _gate_clear (&gate);
+
+  dia_image_set_decode_async (FALSE);
+}
+
+/* the width of the surface drawn for a width x height device size */
+static int
+_surface_width (DiaImage *image, int width, int height)
+{
+  cairo_surface_t *surface = dia_image_get_surface_for_size (image, width, height);
+  int result = cairo_image_surface_get_width (surface);
+
+  cairo_surface_destroy (surface);
+
+  return result;
+}
+
+/* the smallest power-of-two level still covering the size */
+static void
+_test_level (void)
+{
+  DiaImage *image = _image_new (256, 256, 0xff0000ff);
+  DiaImage *wide = _image_new (256, 64, 0x00ff00ff);
+
+  g_assert_cmpint (_surface_width (image, 300, 300), ==, 256);
+  g_assert_cmpint (_surface_width (image, 256, 256), ==, 256);
+  g_assert_cmpint (_surface_width (image, 200, 200), ==, 256);
+  g_assert_cmpint (_surface_width (image, 128, 128), ==, 128);
+  g_assert_cmpint (_surface_width (image, 100, 100), ==, 128);
+  g_assert_cmpint (_surface_width (image, 64, 64), ==, 64);
+  g_assert_cmpint (_surface_width (image, 1, 1), ==, 1);
+  /* both directions need to be covered */
+  g_assert_cmpint (_surface_width (image, 32, 200), ==, 256);
+  g_assert_cmpint (_surface_width (wide, 32, 32), ==, 128);
+  g_assert_cmpint (_surface_width (wide, 32, 16), ==, 64);
+  g_assert_cmpint (_surface_width (wide, 32, 8), ==, 32);
+
+  g_clear_object (&wide);
+  g_clear_object (&image);
+  g_assert_cmpuint (dia_image_get_cache_size (), ==, 0);
+}
+
+/* only the least recently used levels are dropped to stay in budget */
+static void
+_test_lru (void)
+{
+  DiaImage *a = _image_new (256, 256, 0xff0000ff);
+  DiaImage *b = _image_new (256, 256, 0x00ff00ff);
+  DiaImage *c = _image_new (256, 256, 0x0000ffff);
+  gsize level, bare;
+
+  bare = dia_image_get_memory_size (a, NULL);
+  _surface_width (a, 128, 128);
+  level = dia_image_get_cache_size ();
+  g_assert_cmpuint (level, >, 0);
+  g_assert_cmpuint (dia_image_get_memory_size (a, NULL), >=, bare + level);
+
+  /* room for two of them */
+  dia_image_set_cache_budget (2 * level);
+  _surface_width (b, 128, 128);
+  _surface_width (c, 128, 128);
+  g_assert_cmpuint (dia_image_get_cache_size (), <=, 2 * level);
+  g_assert_cmpuint (dia_image_get_memory_size (a, NULL), <, dia_image_get_memory_size (b, NULL));
+  g_assert_cmpuint (dia_image_get_memory_size (b, NULL), ==, dia_image_get_memory_size (c, NULL));
+
+  /* b is used again, so c is the oldest when a comes back */
+  _surface_width (b, 128, 128);
+  _surface_width (a, 128, 128);
+  g_assert_cmpuint (dia_image_get_cache_size (), <=, 2 * level);
+  g_assert_cmpuint (dia_image_get_memory_size (c, NULL), <, dia_image_get_memory_size (b, NULL));
+  g_assert_cmpuint (dia_image_get_memory_size (a, NULL), ==, dia_image_get_memory_size (b, NULL));
+
+  /* a smaller budget applies right away */
+  dia_image_set_cache_budget (level);
+  g_assert_cmpuint (dia_image_get_cache_size (), <=, level);
+
+  dia_image_set_cache_budget (64 * 1024 * 1024);
+  g_clear_object (&a);
+  g_clear_object (&b);
+  g_clear_object (&c);
+  g_assert_cmpuint (dia_image_get_cache_size (), ==, 0);
+}
+
+/* in the background the finer level is drawn until the wanted one is done */
+static void
+_test_level_async (void)
+{
+  DiaImage *image = _image_new (256, 256, 0xff0000ff);
+  gint64 end = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  int count = 0;
+
+  g_signal_connect (image, "level-ready", G_CALLBACK (_count), &count);
+  dia_image_set_mipmap_async (TRUE);
+
+  g_assert_cmpint (_surface_width (image, 64, 64), ==, 256);
+  while (count == 0 && g_get_monotonic_time () < end) {
+    g_main_context_iteration (NULL, FALSE);
+  }
+  g_assert_cmpint (count, ==, 1);
+  g_assert_cmpint (_surface_width (image, 64, 64), ==, 64);
+  /* nothing left to build */
+  g_assert_cmpint (_surface_width (image, 100, 100), ==, 128);
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (count, ==, 1);
+
+  dia_image_set_mipmap_async (FALSE);
+  g_clear_object (&image);
+}
+
+int
+main (int argc, char** argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  libdia_init (DIA_MESSAGE_STDERR);
+
+  g_test_add_func ("/Dia/Image/Store", _test_store);
+  g_test_add_func ("/Dia/Image/DeferredSync", _test_deferred_sync);
+  g_test_add_func ("/Dia/Image/DeferredReady", _test_deferred_ready);
+  g_test_add_func ("/Dia/Image/DeferredWait", _test_deferred_wait);
+  g_test_add_func ("/Dia/Image/Level", _test_level);
+  g_test_add_func ("/Dia/Image/LRU", _test_lru);
+  g_test_add_func ("/Dia/Image/LevelAsync", _test_level_async);
+
+  return g_test_run ();
+}
@@ -0,0 +1,361 @@
+/* test-layer.c -- Unit test for the object storage of DiaLayer
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "object.h"
+#include "dialib.h"
+#include "diagramdata.h"
+#include "dia-layer.h"
+
+/* the layer only needs something to destroy */
+static void
+_dummy_destroy (DiaObject *obj)
+{
+}
+
+static ObjectOps dummy_ops = { .destroy = _dummy_destroy };
+
+static DiaObject *
+_dummy_new (void)
+{
+  DiaObject *obj = g_new0 (DiaObject, 1);
+
+  obj->ops = &dummy_ops;
+
+  return obj;
+}
+
+static GList *
+_dummy_list (int n)
+{
+  GList *list = NULL;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    list = g_list_prepend (list, _dummy_new ());
+  }
+
+  return list;
+}
+
+/* the list view and the positions must agree */
+static void
+_check_layer (DiaLayer *layer)
+{
+  GList *list = dia_layer_get_object_list (layer);
+  GList *prev = NULL;
+  int i = 0;
+
+  for (; list != NULL; list = g_list_next (list), i++) {
+    DiaObject *obj = list->data;
+
+    g_assert_true (list->prev == prev);
+    g_assert_true (dia_object_get_parent_layer (obj) == layer);
+    g_assert_cmpint (dia_layer_object_get_index (layer, obj), ==, i);
+    g_assert_true (dia_layer_object_get_nth (layer, i) == obj);
+    prev = list;
+  }
+  g_assert_cmpint (dia_layer_object_count (layer), ==, i);
+  g_assert_null (dia_layer_object_get_nth (layer, i));
+}
+
+static DiaLayer *
+_new_layer (DiagramData *data)
+{
+  DiaLayer *layer = dia_layer_new ("test", data);
+
+  dia_layer_add_objects (layer, _dummy_list (100));
+  _check_layer (layer);
+
+  return layer;
+}
+
+static void
+_test_add (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = _new_layer (data);
+  DiaObject *first = _dummy_new ();
+  DiaObject *middle = _dummy_new ();
+  DiaObject *last = _dummy_new ();
+  DiaObject *beyond = _dummy_new ();
+  DiaObject *top = _dummy_new ();
+  GList *bottom = _dummy_list (10);
+  DiaObject *bottom_first = bottom->data;
+
+  dia_layer_add_object_at (layer, first, 0);
+  dia_layer_add_object_at (layer, middle, 50);
+  dia_layer_add_object_at (layer, last, -1);
+  dia_layer_add_object_at (layer, beyond, 1000);
+  dia_layer_add_object (layer, top);
+  _check_layer (layer);
+
+  g_assert_cmpint (dia_layer_object_get_index (layer, first), ==, 0);
+  g_assert_cmpint (dia_layer_object_get_index (layer, middle), ==, 50);
+  g_assert_cmpint (dia_layer_object_get_index (layer, last), ==, 102);
+  g_assert_cmpint (dia_layer_object_get_index (layer, beyond), ==, 103);
+  g_assert_cmpint (dia_layer_object_get_index (layer, top), ==, 104);
+
+  dia_layer_add_objects_first (layer, bottom);
+  _check_layer (layer);
+  g_assert_true (dia_layer_object_get_nth (layer, 0) == bottom_first);
+  g_assert_cmpint (dia_layer_object_get_index (layer, first), ==, 10);
+
+  g_clear_object (&layer);
+  g_clear_object (&data);
+}
+
+static void
+_test_remove (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = _new_layer (data);
+  GList *remove = NULL;
+  GList *l;
+  int i = 0;
+
+  for (l = dia_layer_get_object_list (layer); l != NULL; l = g_list_next (l), i++) {
+    if (i % 3 == 0) {
+      remove = g_list_prepend (remove, l->data);
+    }
+  }
+
+  dia_layer_remove_objects (layer, remove);
+  _check_layer (layer);
+  g_assert_cmpint (dia_layer_object_count (layer), ==, 100 - 34);
+  for (l = remove; l != NULL; l = g_list_next (l)) {
+    g_assert_cmpint (dia_layer_object_get_index (layer, l->data), ==, -1);
+    g_assert_null (dia_object_get_parent_layer (l->data));
+  }
+
+  /* the first and the last */
+  dia_layer_remove_object (layer, dia_layer_object_get_nth (layer, 0));
+  dia_layer_remove_object (layer, dia_layer_object_get_nth (layer, 64));
+  _check_layer (layer);
+
+  g_list_free_full (remove, g_free);
+  g_clear_object (&layer);
+  g_clear_object (&data);
+}
+
+static void
+_test_replace (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = _new_layer (data);
+  DiaObject *replaced = dia_layer_object_get_nth (layer, 20);
+  DiaObject *first;
+  GList *list = _dummy_list (5);
+
+  dia_layer_replace_object_with_list (layer, replaced, list);
+  _check_layer (layer);
+  g_assert_true (dia_layer_object_get_nth (layer, 20) == list->data);
+  g_assert_cmpint (dia_layer_object_count (layer), ==, 104);
+  g_clear_pointer (&replaced, g_free);
+
+  first = dia_layer_object_get_nth (layer, 0);
+  dia_layer_replace_object_with_list (layer, first, _dummy_list (2));
+  _check_layer (layer);
+  g_clear_pointer (&first, g_free);
+
+  g_clear_object (&layer);
+  g_clear_object (&data);
+}
+
+static void
+_test_set_list (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = _new_layer (data);
+  GList *reversed = g_list_reverse (g_list_copy (dia_layer_get_object_list (layer)));
+  DiaObject *old_top = dia_layer_object_get_nth (layer, 99);
+  DiaObject *dropped = dia_layer_object_get_nth (layer, 50);
+
+  /* one left out, one new */
+  reversed = g_list_remove (reversed, dropped);
+  reversed = g_list_append (reversed, _dummy_new ());
+
+  dia_layer_set_object_list (layer, reversed);
+  _check_layer (layer);
+  g_assert_true (dia_layer_object_get_nth (layer, 0) == old_top);
+  g_assert_cmpint (dia_layer_object_count (layer), ==, 100);
+  g_assert_cmpint (dia_layer_object_get_index (layer, dropped), ==, -1);
+  g_clear_pointer (&dropped, g_free);
+
+  g_clear_object (&layer);
+  g_clear_object (&data);
+}
+
+static void
+_test_sort (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = _new_layer (data);
+  DiaObject *stranger = _dummy_new ();
+  GList *selected = NULL;
+  GList *sorted;
+  GList *l;
+  int last = -1;
+
+  selected = g_list_prepend (selected, dia_layer_object_get_nth (layer, 7));
+  selected = g_list_prepend (selected, dia_layer_object_get_nth (layer, 90));
+  selected = g_list_prepend (selected, stranger);
+  selected = g_list_prepend (selected, dia_layer_object_get_nth (layer, 3));
+  selected = g_list_prepend (selected, dia_layer_object_get_nth (layer, 42));
+  selected = g_list_prepend (selected, dia_layer_object_get_nth (layer, 7));
+
+  sorted = dia_layer_sort_objects (layer, selected);
+  g_assert_cmpint (g_list_length (sorted), ==, 4);
+  for (l = sorted; l != NULL; l = g_list_next (l)) {
+    int index = dia_layer_object_get_index (layer, l->data);
+
+    g_assert_cmpint (index, >, last);
+    last = index;
+  }
+  g_assert_cmpint (last, ==, 90);
+
+  g_list_free (sorted);
+  g_list_free (selected);
+  g_clear_pointer (&stranger, g_free);
+  g_clear_object (&layer);
+  g_clear_object (&data);
+}
+
+static void
+_count_object_add (DiagramData *data,
+                   DiaLayer    *layer,
+                   DiaObject   *obj,
+                   int         *count)
+{
+  (*count)++;
+}
+
+static void
+_count_objects_added (DiagramData *data,
+                      DiaLayer    *layer,
+                      GList       *objects,
+                      int         *count)
+{
+  GList *l;
+  int i = 0;
+
+  /* in order of addition */
+  for (l = objects; l != NULL; l = g_list_next (l), i++) {
+    g_assert_cmpint (dia_layer_object_get_index (layer, l->data), ==, 100 + i);
+  }
+  *count += i;
+}
+
+static void
+_test_bulk_add (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = dia_diagram_data_get_active_layer (data);
+  DiaLayer *extra = dia_layer_new ("extra", data);
+  DiaObject *dropped;
+  int adds = 0;
+  int added = 0;
+  int i;
+
+  dia_layer_add_objects (layer, _dummy_list (100));
+  g_signal_connect (data, "object_add", G_CALLBACK (_count_object_add), &adds);
+  g_signal_connect (data, "objects-added", G_CALLBACK (_count_objects_added), &added);
+
+  dia_diagram_data_begin_bulk_add (data);
+  dia_layer_add_objects (layer, _dummy_list (10));
+  dia_diagram_data_begin_bulk_add (data);
+  for (i = 0; i < 10; i++) {
+    dia_layer_add_object (layer, _dummy_new ());
+  }
+  dia_diagram_data_end_bulk_add (data);
+  g_assert_cmpint (added, ==, 0);
+
+  /* never announced, so nothing to take back */
+  dropped = dia_layer_object_get_nth (layer, 105);
+  dia_layer_remove_object (layer, dropped);
+  g_clear_pointer (&dropped, g_free);
+
+  /* the layer covers its objects */
+  dia_layer_add_objects (extra, _dummy_list (10));
+  data_add_layer (data, extra);
+  dia_diagram_data_end_bulk_add (data);
+  _check_layer (layer);
+
+  g_assert_cmpint (adds, ==, 1);
+  g_assert_cmpint (added, ==, 19);
+
+  /* and back to one by one */
+  dia_layer_add_object (layer, _dummy_new ());
+  g_assert_cmpint (adds, ==, 2);
+  g_assert_cmpint (added, ==, 19);
+
+  g_clear_object (&extra);
+  g_clear_object (&data);
+}
+
+/* positions of a big layer must not be linear, this would time out */
+static void
+_test_large (void)
+{
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = dia_layer_new ("large", data);
+  int n = 100000;
+  GList *l;
+  int i;
+
+  dia_layer_add_objects (layer, _dummy_list (n));
+
+  for (i = 0, l = dia_layer_get_object_list (layer); l != NULL; l = g_list_next (l), i++) {
+    g_assert_cmpint (dia_layer_object_get_index (layer, l->data), ==, i);
+  }
+  for (i = 0; i < n / 2; i++) {
+    DiaObject *obj = dia_layer_object_get_nth (layer, n / 4);
+
+    dia_layer_remove_object (layer, obj);
+    g_free (obj);
+  }
+  g_assert_cmpint (dia_layer_object_count (layer), ==, n / 2);
+
+  g_clear_object (&layer);
+  g_clear_object (&data);
+}
+
+int
+main (int argc, char** argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  libdia_init (DIA_MESSAGE_STDERR);
+
+  g_test_add_func ("/Dia/Layer/Add", _test_add);
+  g_test_add_func ("/Dia/Layer/Remove", _test_remove);
+  g_test_add_func ("/Dia/Layer/Replace", _test_replace);
+  g_test_add_func ("/Dia/Layer/SetList", _test_set_list);
+  g_test_add_func ("/Dia/Layer/Sort", _test_sort);
+  g_test_add_func ("/Dia/Layer/BulkAdd", _test_bulk_add);
+  g_test_add_func ("/Dia/Layer/Large", _test_large);
+
+  return g_test_run ();
+}
@@ -34,6 +34,11 @@
 #include "create.h"
 #include "properties.h"
 #include "diapathrenderer.h"
+#include "diagramdata.h"
+#include "dia-layer.h"
+#include "group.h"
+#include "dia-object-profile.h"
+#include "dia-memory-usage.h"
 
 const real EPSILON = 1e-6;
 int num_objects = 0;
@@ -982,6 +987,28 @@ _test_segments (gconstpointer user_data)
   o->ops->destroy (o);
   g_clear_pointer (&o, g_free);
 }
+static void
+_test_memory_size (gconstpointer user_data)
+{
+  const DiaObjectType *type = (const DiaObjectType *)user_data;
+  Handle *h1 = NULL, *h2 = NULL;
+  Point from = {0, 0};
+  DiaObject *o = type->ops->create (&from, type->default_user_data, &h1, &h2);
+  GHashTable *shared = g_hash_table_new (g_direct_hash, g_direct_equal);
+  gsize size, again;
+
+  size = dia_object_get_memory_size (o, shared);
+  g_assert_cmpuint (size, >=, sizeof (DiaObject));
+  /* the shared data is not counted twice */
+  again = dia_object_get_memory_size (o, shared);
+  g_assert_cmpuint (again, <=, size);
+  g_assert_cmpuint (again, >=, sizeof (DiaObject));
+
+  g_hash_table_destroy (shared);
+  /* finally */
+  o->ops->destroy (o);
+  g_clear_pointer (&o, g_free);
+}
 /*
  * A dictionary interface to all registered object(-types)
  */
@@ -1035,9 +1062,112 @@ _ot_item (gpointer key,
   g_test_add_data_func (testpath, type, _test_segments);
   g_clear_pointer (&testpath, g_free);
 
+  testpath = g_strdup_printf ("%s/%s/%s", base, name, "MemorySize");
+  g_test_add_data_func (testpath, type, _test_memory_size);
+  g_clear_pointer (&testpath, g_free);
+
   ++num_objects;
 }
 
+/* counted by type, reported with the objects of the diagram */
+static void
+_test_profile (void)
+{
+  DiaObjectType *type = object_get_type ("Standard - Box");
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  Handle *h1 = NULL, *h2 = NULL;
+  Point pos = { 1.0, 1.0 };
+  DiaObject *o;
+  DiaObjectChange *change;
+  char *report;
+
+  if (!type) {
+    g_test_skip ("Standard - Box not loaded");
+    g_clear_object (&data);
+    return;
+  }
+  o = type->ops->create (&pos, type->default_user_data, &h1, &h2);
+  dia_layer_add_object (dia_diagram_data_get_active_layer (data), o);
+
+  dia_object_profile_set_enabled (TRUE);
+  dia_object_profile_reset ();
+  change = dia_object_move (o, &pos);
+  g_clear_pointer (&change, dia_object_change_unref);
+  change = dia_object_move (o, &pos);
+  g_clear_pointer (&change, dia_object_change_unref);
+  dia_object_distance_from (o, &pos);
+  dia_object_profile_set_enabled (FALSE);
+  /* not counted anymore */
+  dia_object_distance_from (o, &pos);
+
+  report = dia_object_profile_report (data);
+  g_assert_nonnull (strstr (report, "Standard - Box: 1 objects"));
+  g_assert_true (g_regex_match_simple ("move +2 calls", report, 0, 0));
+  g_assert_true (g_regex_match_simple ("distance +1 calls", report, 0, 0));
+  g_assert_null (strstr (report, "draw"));
+  g_free (report);
+
+  dia_object_profile_reset ();
+  report = dia_object_profile_report (data);
+  g_assert_null (strstr (report, "Standard - Box"));
+  g_free (report);
+
+  g_clear_object (&data);
+}
+
+/* aggregated by layer and type, inside groups, too */
+static void
+_test_memory_usage (void)
+{
+  DiaObjectType *type = object_get_type ("Standard - Box");
+  DiagramData *data = g_object_new (DIA_TYPE_DIAGRAM_DATA, NULL);
+  DiaLayer *layer = dia_diagram_data_get_active_layer (data);
+  Handle *h1 = NULL, *h2 = NULL;
+  Point pos = { 1.0, 1.0 };
+  DiaMemoryUsage *usage;
+  DiaMemoryUsageItem *item;
+  GList *list = NULL;
+  char *report;
+  guint i;
+
+  if (!type) {
+    g_test_skip ("Standard - Box not loaded");
+    g_clear_object (&data);
+    return;
+  }
+  for (i = 0; i < 3; i++) {
+    list = g_list_append (list, type->ops->create (&pos, type->default_user_data, &h1, &h2));
+  }
+  dia_layer_add_object (layer, list->data);
+  dia_layer_add_object (layer, group_create (g_list_copy (list->next)));
+  g_list_free (list);
+
+  usage = dia_memory_usage_new (data);
+  g_assert_cmpuint (usage->n_objects, ==, 4);
+  g_assert_cmpuint (usage->layers->len, ==, 1);
+  item = g_ptr_array_index (usage->layers, 0);
+  g_assert_cmpuint (item->n_objects, ==, 4);
+  g_assert_cmpuint (item->size, ==, usage->total);
+  g_assert_cmpuint (usage->types->len, ==, 2);
+  for (i = 0; i < usage->types->len; i++) {
+    item = g_ptr_array_index (usage->types, i);
+    if (strcmp (item->name, "Group") == 0) {
+      g_assert_cmpuint (item->n_objects, ==, 1);
+    } else {
+      g_assert_cmpstr (item->name, ==, "Standard - Box");
+      g_assert_cmpuint (item->n_objects, ==, 3);
+      g_assert_cmpuint (item->size, >=, 3 * sizeof (DiaObject));
+    }
+  }
+
+  report = dia_memory_usage_to_string (usage);
+  g_assert_nonnull (strstr (report, "Objects: 4"));
+  g_free (report);
+
+  dia_memory_usage_free (usage);
+  g_clear_object (&data);
+}
+
 #ifdef G_OS_WIN32
 #include <windows.h>
 #endif
@@ -1078,6 +1208,8 @@ main (int argc, char** argv)
   g_assert (g_list_length (plugins) > 0);
 
   object_registry_foreach (_ot_item, "/Dia/Objects");
+  g_test_add_func ("/Dia/ObjectProfile", _test_profile);
+  g_test_add_func ("/Dia/MemoryUsage", _test_memory_usage);
 
   ret = g_test_run ();
   g_printerr ("%d objects.\n", num_objects);
@@ -0,0 +1,503 @@
+/* test-render-objects.c -- Draw cost of every object type
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Every registered object type gets created at a few sizes and drawn
+ * repeatedly with the cairo image renderer and the DiaPathRenderer. The
+ * time and the number of allocations per draw are compared against a
+ * baseline, if one is given:
+ *
+ *   test-render-objects <objects-dir> -m perf --baseline=render.ini --update-baseline
+ *   test-render-objects <objects-dir> -m perf --baseline=render.ini --threshold=1.2
+ *
+ * Allocations are compared in every run, timings only with -m perf.
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "Dia"
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "object.h"
+#include "plug-ins.h"
+#include "dialib.h"
+#include "diapathrenderer.h"
+#include "renderer/diacairo.h"
+
+#define PIXELS_PER_CM 20.0
+#define MAX_PIXELS 2048
+
+/* the handle returned by create() is moved this far, like the create tool does */
+static const double sizes[] = { 1.0, 5.0, 20.0 };
+
+static GKeyFile *baseline = NULL;
+static GKeyFile *results = NULL;
+static double threshold = 1.5;
+static int iterations = 5;
+
+
+/*
+ * Counting allocations by interposing malloc(), everything GLib, cairo and
+ * pango allocate goes through here. Only with glibc, elsewhere the
+ * allocations are not checked.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define HAVE_ALLOC_COUNTER 1
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static int alloc_count = 0;
+
+void *
+malloc (size_t size)
+{
+  g_atomic_int_inc (&alloc_count);
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  g_atomic_int_inc (&alloc_count);
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  g_atomic_int_inc (&alloc_count);
+  return __libc_realloc (ptr, size);
+}
+
+static int
+_get_alloc_count (void)
+{
+  return g_atomic_int_get (&alloc_count);
+}
+#else
+static int
+_get_alloc_count (void)
+{
+  return 0;
+}
+#endif
+
+
+typedef struct _DrawCost {
+  double ns;      /* per draw */
+  double allocs;  /* per draw */
+} DrawCost;
+
+static DiaObject *
+_create_sized (const DiaObjectType *type, double size, gboolean *resizable)
+{
+  Handle *h1 = NULL, *h2 = NULL;
+  Point from = { 0, 0 };
+  DiaObject *o = type->ops->create (&from, type->default_user_data, &h1, &h2);
+
+  *resizable = (h2 != NULL);
+  if (h2) {
+    Point to = h2->pos;
+    DiaObjectChange *change;
+
+    to.x += size;
+    to.y += size;
+    change = dia_object_move_handle (o, h2, &to, NULL, HANDLE_MOVE_CREATE_FINAL, 0);
+    g_clear_pointer (&change, dia_object_change_unref);
+  }
+
+  return o;
+}
+
+static void
+_measure_cairo (DiaObject *o, DrawCost *cost)
+{
+  const DiaRectangle *bb = dia_object_get_bounding_box (o);
+  double width = MAX (bb->right - bb->left, 0.1);
+  double height = MAX (bb->bottom - bb->top, 0.1);
+  double scale = PIXELS_PER_CM;
+  DiaCairoRenderer *renderer;
+  cairo_surface_t *surface;
+  GTimer *timer = g_timer_new ();
+  int allocs;
+  int i;
+
+  scale = MIN (scale, MAX_PIXELS / width);
+  scale = MIN (scale, MAX_PIXELS / height);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        (int) ceil (width * scale) + 2,
+                                        (int) ceil (height * scale) + 2);
+
+  renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+  renderer->scale = scale;
+  renderer->cr = cairo_create (surface);
+  cairo_translate (renderer->cr, -bb->left * scale + 1, -bb->top * scale + 1);
+
+  dia_renderer_begin_render (DIA_RENDERER (renderer), NULL);
+  /* fill font and pattern caches first */
+  dia_renderer_draw_object (DIA_RENDERER (renderer), o, NULL);
+
+  allocs = _get_alloc_count ();
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++) {
+    dia_renderer_draw_object (DIA_RENDERER (renderer), o, NULL);
+  }
+  cairo_surface_flush (surface);
+  cost->ns += g_timer_elapsed (timer, NULL) * 1e9 / iterations;
+  cost->allocs += (double) (_get_alloc_count () - allocs) / iterations;
+
+  dia_renderer_end_render (DIA_RENDERER (renderer));
+
+  g_clear_object (&renderer);
+  cairo_surface_destroy (surface);
+  g_timer_destroy (timer);
+}
+
+/* the DiaPathRenderer collects everything, so it is created per draw as
+ * create_standard_path_from_object() does */
+static void
+_measure_path (DiaObject *o, DrawCost *cost)
+{
+  GTimer *timer = g_timer_new ();
+  DiaRenderer *renderer;
+  int allocs;
+  int i;
+
+  renderer = g_object_new (DIA_TYPE_PATH_RENDERER, NULL);
+  dia_object_draw (o, renderer);
+  g_clear_object (&renderer);
+
+  allocs = _get_alloc_count ();
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++) {
+    renderer = g_object_new (DIA_TYPE_PATH_RENDERER, NULL);
+    dia_object_draw (o, renderer);
+    g_clear_object (&renderer);
+  }
+  cost->ns += g_timer_elapsed (timer, NULL) * 1e9 / iterations;
+  cost->allocs += (double) (_get_alloc_count () - allocs) / iterations;
+
+  g_timer_destroy (timer);
+}
+
+static void
+_check_baseline (const char *type_name, const char *key, double value, double slack)
+{
+  GError *error = NULL;
+  double base;
+
+  if (!baseline || !g_key_file_has_key (baseline, type_name, key, NULL)) {
+    return;
+  }
+
+  base = g_key_file_get_double (baseline, type_name, key, &error);
+  if (error) {
+    g_test_message ("%s: bad baseline for %s: %s", type_name, key, error->message);
+    g_clear_error (&error);
+    return;
+  }
+
+  if (value > base * threshold + slack) {
+    g_test_message ("%s: %s regressed from %.1f to %.1f", type_name, key, base, value);
+    g_test_fail ();
+  }
+}
+
+static void
+_test_render (gconstpointer user_data)
+{
+  const DiaObjectType *type = (const DiaObjectType *) user_data;
+  DrawCost cairo_cost = { 0, 0 };
+  DrawCost path_cost = { 0, 0 };
+  int n_sizes = 0;
+  guint s;
+
+  for (s = 0; s < G_N_ELEMENTS (sizes); s++) {
+    gboolean resizable;
+    DiaObject *o = _create_sized (type, sizes[s], &resizable);
+
+    _measure_cairo (o, &cairo_cost);
+    _measure_path (o, &path_cost);
+    n_sizes++;
+
+    o->ops->destroy (o);
+    g_clear_pointer (&o, g_free);
+
+    if (!resizable) {
+      break;
+    }
+  }
+
+  cairo_cost.ns /= n_sizes;
+  cairo_cost.allocs /= n_sizes;
+  path_cost.ns /= n_sizes;
+  path_cost.allocs /= n_sizes;
+
+  if (g_test_perf ()) {
+    g_test_minimized_result (cairo_cost.ns, "%s cairo: %.0f ns/draw, %.1f allocs/draw",
+                             type->name, cairo_cost.ns, cairo_cost.allocs);
+    g_test_minimized_result (path_cost.ns, "%s path: %.0f ns/draw, %.1f allocs/draw",
+                             type->name, path_cost.ns, path_cost.allocs);
+  } else {
+    g_test_message ("%s cairo: %.0f ns/draw, %.1f allocs/draw",
+                    type->name, cairo_cost.ns, cairo_cost.allocs);
+    g_test_message ("%s path: %.0f ns/draw, %.1f allocs/draw",
+                    type->name, path_cost.ns, path_cost.allocs);
+  }
+
+#ifdef HAVE_ALLOC_COUNTER
+  /* a few allocations more are in the noise of caches getting filled */
+  _check_baseline (type->name, "cairo-allocs", cairo_cost.allocs, 2.0);
+  _check_baseline (type->name, "path-allocs", path_cost.allocs, 2.0);
+  g_key_file_set_double (results, type->name, "cairo-allocs", cairo_cost.allocs);
+  g_key_file_set_double (results, type->name, "path-allocs", path_cost.allocs);
+#endif
+  /* without -m perf there are not enough iterations for stable timings */
+  if (g_test_perf ()) {
+    _check_baseline (type->name, "cairo-ns", cairo_cost.ns, 1000.0);
+    _check_baseline (type->name, "path-ns", path_cost.ns, 1000.0);
+    g_key_file_set_double (results, type->name, "cairo-ns", cairo_cost.ns);
+    g_key_file_set_double (results, type->name, "path-ns", path_cost.ns);
+  }
+}
+
+static void
+_test_scratch (void)
+{
+  DiaRenderer *renderer = g_object_new (DIA_TYPE_PATH_RENDERER, NULL);
+  int frame;
+
+  for (frame = 0; frame < 3; frame++) {
+    int i;
+
+    dia_renderer_begin_render (renderer, NULL);
+    /* more than the initial block holds */
+    for (i = 1; i < 64; i++) {
+      guint8 *mem = dia_renderer_scratch_alloc (renderer, i * 7);
+
+      g_assert_cmpuint (GPOINTER_TO_SIZE (mem) % sizeof (double), ==, 0);
+      memset (mem, 0xaa, i * 7);
+    }
+    if (frame > 0) {
+      g_assert_cmpuint (dia_renderer_get_scratch_allocations (renderer), ==, 0);
+    }
+    dia_renderer_end_render (renderer);
+  }
+
+  g_clear_object (&renderer);
+}
+
+static void
+_add_sized (gpointer key,
+            gpointer value,
+            gpointer user_data)
+{
+  GPtrArray *objects = user_data;
+  gboolean resizable;
+
+  g_ptr_array_add (objects, _create_sized (value, sizes[1], &resizable));
+}
+
+/* the second frame of the same diagram must not need new scratch memory */
+static void
+_test_scratch_steady (void)
+{
+  GPtrArray *objects = g_ptr_array_new ();
+  cairo_surface_t *surface;
+  DiaCairoRenderer *renderer;
+  int frame;
+  guint i;
+
+  object_registry_foreach (_add_sized, objects);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 256, 256);
+  renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+  renderer->scale = PIXELS_PER_CM;
+  renderer->cr = cairo_create (surface);
+
+  for (frame = 0; frame < 2; frame++) {
+    dia_renderer_begin_render (DIA_RENDERER (renderer), NULL);
+    for (i = 0; i < objects->len; i++) {
+      dia_renderer_draw_object (DIA_RENDERER (renderer), objects->pdata[i], NULL);
+    }
+    if (frame > 0) {
+      g_assert_cmpuint (dia_renderer_get_scratch_allocations (DIA_RENDERER (renderer)), ==, 0);
+    }
+    dia_renderer_end_render (DIA_RENDERER (renderer));
+  }
+
+  g_clear_object (&renderer);
+  cairo_surface_destroy (surface);
+
+  for (i = 0; i < objects->len; i++) {
+    DiaObject *o = objects->pdata[i];
+
+    o->ops->destroy (o);
+    g_free (o);
+  }
+  g_ptr_array_free (objects, TRUE);
+}
+
+/* what an object takes from the scratch memory is given back after it */
+static void
+_test_scratch_per_object (void)
+{
+  GPtrArray *objects = g_ptr_array_new ();
+  cairo_surface_t *surface;
+  DiaCairoRenderer *renderer;
+  int frame;
+  guint i;
+
+  object_registry_foreach (_add_sized, objects);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 256, 256);
+  renderer = g_object_new (DIA_CAIRO_TYPE_RENDERER, NULL);
+  renderer->scale = PIXELS_PER_CM;
+  renderer->cr = cairo_create (surface);
+
+  for (frame = 0; frame < 2; frame++) {
+    guint8 *before, *after;
+
+    dia_renderer_begin_render (DIA_RENDERER (renderer), NULL);
+    before = dia_renderer_scratch_alloc (DIA_RENDERER (renderer), 16);
+    memset (before, 0x55, 16);
+    for (i = 0; i < objects->len; i++) {
+      dia_renderer_draw_object (DIA_RENDERER (renderer), objects->pdata[i], NULL);
+    }
+    after = dia_renderer_scratch_alloc (DIA_RENDERER (renderer), 16);
+    if (frame > 0) {
+      /* the block only needs to hold the biggest object */
+      g_assert_cmpuint (dia_renderer_get_scratch_allocations (DIA_RENDERER (renderer)), ==, 0);
+      g_assert_true (after == before + 16);
+    }
+    for (i = 0; i < 16; i++) {
+      g_assert_cmpuint (before[i], ==, 0x55);
+    }
+    dia_renderer_end_render (DIA_RENDERER (renderer));
+  }
+
+  g_clear_object (&renderer);
+  cairo_surface_destroy (surface);
+
+  for (i = 0; i < objects->len; i++) {
+    DiaObject *o = objects->pdata[i];
+
+    o->ops->destroy (o);
+    g_free (o);
+  }
+  g_ptr_array_free (objects, TRUE);
+}
+
+static void
+_ot_item (gpointer key,
+          gpointer value,
+          gpointer user_data)
+{
+  gchar *name = (gchar *) key;
+  DiaObjectType *type = (DiaObjectType *) value;
+  const gchar *base = (const gchar *) user_data;
+  gchar *testpath;
+
+  testpath = g_strdup_printf ("%s/%s", base, name);
+  g_test_add_data_func (testpath, type, _test_render);
+  g_clear_pointer (&testpath, g_free);
+}
+
+int
+main (int argc, char** argv)
+{
+  const char *baseline_file = NULL;
+  const char *path = NULL;
+  gboolean update = FALSE;
+  int ret;
+  int i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  /* g_test_init() leaves what it doesn't know */
+  for (i = 1; i < argc; i++) {
+    if (g_str_has_prefix (argv[i], "--baseline=")) {
+      baseline_file = argv[i] + strlen ("--baseline=");
+    } else if (g_str_has_prefix (argv[i], "--threshold=")) {
+      threshold = g_ascii_strtod (argv[i] + strlen ("--threshold="), NULL);
+    } else if (strcmp (argv[i], "--update-baseline") == 0) {
+      update = TRUE;
+    } else {
+      path = argv[i];
+    }
+  }
+  g_assert_cmpfloat (threshold, >=, 1.0);
+
+  iterations = g_test_perf () ? 100 : 5;
+
+  results = g_key_file_new ();
+  if (baseline_file && !update && g_file_test (baseline_file, G_FILE_TEST_EXISTS)) {
+    GError *error = NULL;
+
+    baseline = g_key_file_new ();
+    if (!g_key_file_load_from_file (baseline, baseline_file, G_KEY_FILE_NONE, &error)) {
+      g_printerr ("Can't read the baseline: %s\n", error->message);
+      g_clear_error (&error);
+      g_clear_pointer (&baseline, g_key_file_free);
+    }
+  }
+
+  libdia_init (DIA_MESSAGE_STDERR);
+
+  if (path) {
+    if (g_file_test (path, G_FILE_TEST_IS_DIR))
+      dia_register_plugins_in_dir (path);
+    else
+      dia_register_plugin (path);
+  } else {
+    /* avoid loading objects/plug-ins form the users home directory */
+    g_setenv ("HOME", "/tmp", TRUE);
+    dia_register_plugins ();
+  }
+  g_assert (g_list_length (dia_list_plugins ()) > 0);
+
+  g_test_add_func ("/Dia/Render/Scratch", _test_scratch);
+  g_test_add_func ("/Dia/Render/ScratchSteady", _test_scratch_steady);
+  g_test_add_func ("/Dia/Render/ScratchPerObject", _test_scratch_per_object);
+  object_registry_foreach (_ot_item, "/Dia/Render");
+
+  ret = g_test_run ();
+
+  if (update && baseline_file) {
+    GError *error = NULL;
+
+    if (!g_key_file_save_to_file (results, baseline_file, &error)) {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+      ret = 1;
+    }
+  }
+
+  g_clear_pointer (&baseline, g_key_file_free);
+  g_clear_pointer (&results, g_key_file_free);
+
+  return ret;
+}